@@ -1014,6 +1014,7 @@ int ApiGen::genDecoderImpl(const std::string &filename)
     fprintf(fp, "#include \"%s_dec.h\"\n\n\n", m_basename.c_str());
     fprintf(fp, "#include \"ProtocolUtils.h\"\n\n");
     fprintf(fp, "#include \"ChecksumCalculatorThreadInfo.h\"\n\n");
+    fprintf(fp, "#include \"DecoderStats.h\"\n\n");
     fprintf(fp, "#include \"host-common/logging.h\"\n\n");
     fprintf(fp, "#include <stdio.h>\n\n");
 
@@ -1061,6 +1062,7 @@ R"(        // Do this on every iteration, as some commands may change the checks
         const bool useChecksum = checksumSize > 0;
 )");
     }
+    fprintf(fp, "\t\tconst uint64_t statsStartNs = DecoderStats::start();\n");
     fprintf(fp, "\t\tswitch(opcode) {\n");
 
     for (size_t f = 0; f < n; f++) {
@@ -1497,6 +1499,7 @@ R"(        // Do this on every iteration, as some commands may change the checks
         fprintf(fp, "\t\t#endif\n");
     }
 
+    fprintf(fp, "\t\tDecoderStats::finish(opcode, statsStartNs);\n");
     fprintf(fp, "\t\tptr += packetLen;\n");
     fprintf(fp, "\t} // while\n");
     fprintf(fp, "\treturn ptr - (unsigned char*)buf;\n");
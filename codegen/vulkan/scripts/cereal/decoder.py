@@ -93,6 +93,7 @@ private:
     android::base::BumpPool m_pool;
     BoxedHandleUnwrapAndDeletePreserveBoxedMapping m_boxedHandleUnwrapAndDeletePreserveBoxedMapping;
     std::optional<uint32_t> m_prevSeqno;
+    PacketHangAnnotations m_hangAnnotations{"opcode", "packet_length"};
 };
 
 VkDecoder::VkDecoder() :
@@ -439,7 +440,7 @@ def emit_pool_free(cgen):
     cgen.stmt("%s->clearPool()" % READ_STREAM)
 
 def emit_seqno_incr(api, cgen):
-    cgen.stmt("if (queueSubmitWithCommandsEnabled) seqnoPtr->fetch_add(1, std::memory_order_seq_cst)")
+    cgen.stmt("if (queueSubmitWithCommandsEnabled) seqnoPtr->complete()")
 
 def emit_snapshot(typeInfo, api, cgen):
 
@@ -646,6 +647,7 @@ custom_decodes = {
     "vkCreatePipelineCache": emit_global_state_wrapped_decoding,
     "vkDestroyPipelineCache": emit_global_state_wrapped_decoding,
     "vkCreateGraphicsPipelines": emit_global_state_wrapped_decoding,
+    "vkCreateComputePipelines": emit_global_state_wrapped_decoding,
     "vkDestroyPipeline": emit_global_state_wrapped_decoding,
 
     "vkAllocateMemory" : emit_global_state_wrapped_decoding,
@@ -774,6 +776,10 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
         self.cgen.beginIf("m_forSnapshotLoad")
         self.cgen.stmt("ptr += m_state->setCreatedHandlesForSnapshotLoad(ptr)");
         self.cgen.endIf()
+        self.cgen.beginIf("healthMonitor")
+        self.cgen.stmt("m_hangAnnotations.setProcessName(processName)")
+        self.cgen.stmt("m_hangAnnotations.setGfxApiLogger(&gfx_logger)")
+        self.cgen.endIf()
         self.cgen.line("while (end - ptr >= 8)")
         self.cgen.beginBlock() # while loop
 
@@ -797,28 +803,16 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
         self.cgen.stmt("uint8_t* snapshotTraceBegin = %s->beginTrace()" % READ_STREAM)
         self.cgen.stmt("%s->setHandleMapping(&m_boxedHandleUnwrapMapping)" % READ_STREAM)
         self.cgen.line("""
-        std::unique_ptr<EventHangMetadata::HangAnnotations> executionData =
-            std::make_unique<EventHangMetadata::HangAnnotations>();
-        if (healthMonitor) {
-            executionData->insert(
-                 {{"packet_length", std::to_string(packetLen)},
-                 {"opcode", std::to_string(opcode)}});
-            if (processName) {
-                executionData->insert(
-                    {{"renderthread_guest_process", std::string(processName)}});
-            }
-            if (m_prevSeqno) {
-                executionData->insert({{"previous_seqno", std::to_string(m_prevSeqno.value())}});
-            }
-        }
+        // Hang annotations are only turned into strings if a watchdog fires.
+        if (healthMonitor) m_hangAnnotations.setPacket(opcode, packetLen);
 
-        std::atomic<uint32_t>* seqnoPtr = processResources ?
-                processResources->getSequenceNumberPtr() : nullptr;
+        SequenceNumberOrdering* seqnoPtr = processResources ?
+                processResources->getSequenceNumberOrdering() : nullptr;
 
         if (queueSubmitWithCommandsEnabled && ((opcode >= OP_vkFirst && opcode < OP_vkLast) || (opcode >= OP_vkFirst_old && opcode < OP_vkLast_old))) {
             uint32_t seqno;
             memcpy(&seqno, *readStreamPtrPtr, sizeof(uint32_t)); *readStreamPtrPtr += sizeof(uint32_t);
-            if (healthMonitor) executionData->insert({{"seqno", std::to_string(seqno)}});
+            if (healthMonitor) m_hangAnnotations.setSeqno(seqno);
             if (m_prevSeqno  && seqno == m_prevSeqno.value()) {
                 WARN(
                     "Seqno %d is the same as previously processed on thread %d. It might be a "
@@ -828,25 +822,18 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
             }
             if (seqnoPtr && !m_forSnapshotLoad) {
                 {
-                    auto seqnoWatchdog =
+                    auto seqnoWatchdog = healthMonitor ?
                         WATCHDOG_BUILDER(healthMonitor,
                                          "RenderThread seqno loop")
                             .setHangType(EventHangMetadata::HangType::kRenderThread)
-                            .setAnnotations(std::make_unique<EventHangMetadata::HangAnnotations>(*executionData))
                             /* Data gathered if this hangs*/
-                            .setOnHangCallback([=]() {
-                                auto annotations = std::make_unique<EventHangMetadata::HangAnnotations>();
-                                annotations->insert({{"seqnoPtr", std::to_string(seqnoPtr->load(std::memory_order_seq_cst))}});
+                            .setOnHangCallback([this, seqnoPtr]() {
+                                auto annotations = m_hangAnnotations.build();
+                                annotations->insert({{"seqnoPtr", std::to_string(seqnoPtr->current())}});
                                 return annotations;
                             })
-                            .build();
-                    while ((seqno - seqnoPtr->load(std::memory_order_seq_cst) != 1)) {
-                        #if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
-                        _mm_pause();
-                        #elif (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
-                        __asm__ __volatile__("pause;");
-                        #endif
-                    }
+                            .build() : nullptr;
+                    seqnoPtr->waitForTurn(seqno);
                     m_prevSeqno = seqno;
                 }
             }
@@ -858,15 +845,17 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
         """)
 
         self.cgen.line("""
-        auto executionWatchdog =
+        auto executionWatchdog = healthMonitor ?
             WATCHDOG_BUILDER(healthMonitor, "RenderThread VkDecoder command execution")
                 .setHangType(EventHangMetadata::HangType::kRenderThread)
-                .setAnnotations(std::move(executionData))
-                .build();
+                .setOnHangCallback(m_hangAnnotations.getOnHangCallback())
+                .build() : nullptr;
         """)
 
         self.cgen.stmt("auto vk = m_vk")
 
+        # Times the execution of the command, not the wait for its turn.
+        self.cgen.stmt("const uint64_t statsStartNs = DecoderStats::start()")
         self.cgen.line("switch (opcode)")
         self.cgen.beginBlock()  # switch stmt
 
@@ -900,6 +889,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
 
         self.cgen.endBlock() # switch stmt
 
+        self.cgen.stmt("DecoderStats::finish(opcode, statsStartNs)")
         self.cgen.stmt("ptr += packetLen")
         self.cgen.endBlock() # while loop
 
@@ -428,10 +428,12 @@ class BumpPool;
 #include "{self.baseLibDirPrefix}/Metrics.h"
 #include "render-utils/IOStream.h"
 #include "host/FrameBuffer.h"
+#include "host/PacketHangAnnotations.h"
 #include "host-common/feature_control.h"
 #include "host-common/GfxstreamFatalError.h"
 #include "host-common/logging.h"
 
+#include "DecoderStats.h"
 #include "VkDecoderGlobalState.h"
 #include "VkDecoderSnapshot.h"
 
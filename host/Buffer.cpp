@@ -61,8 +61,9 @@ std::shared_ptr<Buffer> Buffer::create(gl::EmulationGl* emulationGl, vk::VkEmula
 }
 
 /*static*/
-std::shared_ptr<Buffer> Buffer::onLoad(gl::EmulationGl* emulationGl, vk::VkEmulation*,
-                                       android::base::Stream* stream) {
+std::shared_ptr<Buffer> Buffer::onLoad(gl::EmulationGl* emulationGl, vk::VkEmulation* emulationVk,
+                                       android::base::Stream* stream,
+                                       SnapshotCompressor* compressor) {
     const auto handle = static_cast<HandleType>(stream->getBe32());
     const auto size = static_cast<uint64_t>(stream->getBe64());
 
@@ -76,11 +77,51 @@ std::shared_ptr<Buffer> Buffer::onLoad(gl::EmulationGl* emulationGl, vk::VkEmula
         }
     }
 
+    const bool hasVkOnlyBacking = stream->getByte();
+    if (hasVkOnlyBacking) {
+        if (emulationGl || !emulationVk || !emulationVk->live) {
+            ERR("Failed to load Buffer:%d, saved with Vulkan only.", handle);
+            return nullptr;
+        }
+        buffer->mBufferVk = vk::BufferVk::create(handle, size, /*vulkanOnly=*/true);
+        if (!buffer->mBufferVk) {
+            ERR("Failed to load BufferVk.");
+            return nullptr;
+        }
+
+        const bool hasVkContents = stream->getByte();
+        if (hasVkContents) {
+            std::optional<CompressedPayload> contents = loadCompressedPayload(stream, size);
+            if (!contents) {
+                ERR("Failed to load BufferVk:%d, its contents are corrupt.", handle);
+                return nullptr;
+            }
+            buffer->mVkContentsToRestore = compressor->decompress(std::move(*contents));
+        } else {
+            WARN("BufferVk:%d was saved without its contents.", handle);
+        }
+    }
+
     buffer->mNeedRestore = true;
 
     return buffer;
 }
 
+void Buffer::onPreSave(SnapshotCompressor* compressor) {
+    if (mBufferGl || !mBufferVk) {
+        return;
+    }
+
+    touch();
+
+    std::vector<uint8_t> contents(mSize);
+    if (!mBufferVk->readToBytes(0, mSize, contents.data())) {
+        ERR("Failed to read BufferVk:%d for snapshot.", mHandle);
+        return;
+    }
+    mVkContentsToSave = compressor->compress(std::move(contents));
+}
+
 void Buffer::onSave(android::base::Stream* stream) {
     stream->putBe32(mHandle);
     stream->putBe64(mSize);
@@ -88,9 +129,29 @@ void Buffer::onSave(android::base::Stream* stream) {
     if (mBufferGl) {
         mBufferGl->onSave(stream);
     }
+
+    const bool hasVkOnlyBacking = !mBufferGl && mBufferVk;
+    stream->putByte(hasVkOnlyBacking);
+    if (!hasVkOnlyBacking) {
+        return;
+    }
+    const bool hasVkContents = mVkContentsToSave.valid();
+    stream->putByte(hasVkContents);
+    if (hasVkContents) {
+        saveCompressedPayload(stream, mVkContentsToSave.get());
+    }
 }
 
-void Buffer::restore() {}
+void Buffer::restore() {
+    if (mVkContentsToRestore.valid()) {
+        std::optional<std::vector<uint8_t>> contents = mVkContentsToRestore.get();
+        if (!contents) {
+            ERR("Failed to decompress BufferVk:%d from snapshot.", mHandle);
+        } else if (!mBufferVk->updateFromBytes(0, contents->size(), contents->data())) {
+            ERR("Failed to restore BufferVk:%d from snapshot.", mHandle);
+        }
+    }
+}
 
 void Buffer::readToBytes(uint64_t offset, uint64_t size, void* outBytes) {
     touch();
@@ -14,12 +14,16 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include "Handle.h"
 #include "aemu/base/files/Stream.h"
 #include "gl/BufferGl.h"
 #include "snapshot/LazySnapshotObj.h"
+#include "snapshotCompression/SnapshotCompressor.h"
 
 namespace gfxstream {
 namespace gl {
@@ -42,10 +46,15 @@ class Buffer : public android::snapshot::LazySnapshotObj<Buffer> {
                                           vk::VkEmulation* emulationVk, uint64_t size,
                                           HandleType handle);
 
+    // Starts decompressing the contents of a Vk only Buffer on |compressor| for restore().
     static std::shared_ptr<Buffer> onLoad(gl::EmulationGl* emulationGl,
                                           vk::VkEmulation* emulationVk,
-                                          android::base::Stream* stream);
+                                          android::base::Stream* stream,
+                                          SnapshotCompressor* compressor);
 
+    // Reads back the contents of a Vk only Buffer and starts compressing them on |compressor|
+    // before onSave().
+    void onPreSave(SnapshotCompressor* compressor);
     void onSave(android::base::Stream* stream);
     void restore();
 
@@ -66,6 +75,11 @@ class Buffer : public android::snapshot::LazySnapshotObj<Buffer> {
 
     // If Vk emulation is enabled.
     std::unique_ptr<vk::BufferVk> mBufferVk;
+
+    // The contents of the Vk backing being compressed for onSave() if there is no GL backing.
+    std::future<CompressedPayload> mVkContentsToSave;
+    // And being decompressed for restore() after onLoad().
+    std::future<std::optional<std::vector<uint8_t>>> mVkContentsToRestore;
 };
 
 typedef std::shared_ptr<Buffer> BufferPtr;
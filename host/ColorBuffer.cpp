@@ -14,6 +14,9 @@
 
 #include "ColorBuffer.h"
 
+#include <algorithm>
+#include <atomic>
+
 #include "gl/EmulationGl.h"
 #include "host-common/GfxstreamFatalError.h"
 #include "host-common/logging.h"
@@ -36,6 +39,18 @@ bool shouldAttemptExternalMemorySharing(FrameworkFormat format) {
     return format == FrameworkFormat::FRAMEWORK_FORMAT_GL_COMPATIBLE;
 }
 
+std::atomic<uint64_t> sNumSyncs{0};
+std::atomic<uint64_t> sBytesCopied{0};
+std::atomic<uint64_t> sBytesAvoided{0};
+
+// Holds the contents copied between the GL and Vk backings, reused by the syncs of each thread
+// rather than allocated for each.
+std::vector<uint8_t>& getSyncBuffer(size_t size) {
+    static thread_local std::vector<uint8_t> sSyncBuffer;
+    sSyncBuffer.resize(size);
+    return sSyncBuffer;
+}
+
 }  // namespace
 
 ColorBuffer::ColorBuffer(HandleType handle, uint32_t width, uint32_t height, GLenum format,
@@ -44,7 +59,34 @@ ColorBuffer::ColorBuffer(HandleType handle, uint32_t width, uint32_t height, GLe
       mWidth(width),
       mHeight(height),
       mFormat(format),
-      mFrameworkFormat(frameworkFormat) {}
+      mFrameworkFormat(frameworkFormat),
+      mGlDirtyForVk(width, height) {}
+
+/*static*/
+ColorBuffer::SyncStats ColorBuffer::getSyncStats() {
+    return SyncStats{
+        .numSyncs = sNumSyncs.load(std::memory_order_relaxed),
+        .bytesCopied = sBytesCopied.load(std::memory_order_relaxed),
+        .bytesAvoided = sBytesAvoided.load(std::memory_order_relaxed),
+    };
+}
+
+void ColorBuffer::markGlDirty(int x, int y, int width, int height) {
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlDirtyForVk.add(x, y, width, height);
+    mGlWrites++;
+}
+
+void ColorBuffer::markGlDirty() {
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlDirtyForVk.addAll();
+    mGlWrites++;
+}
+
+void ColorBuffer::markGlWritesUntracked() {
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlWritesUntracked = true;
+}
 
 /*static*/
 std::shared_ptr<ColorBuffer> ColorBuffer::create(gl::EmulationGl* emulationGl,
@@ -98,12 +140,19 @@ std::shared_ptr<ColorBuffer> ColorBuffer::create(gl::EmulationGl* emulationGl,
         }
     }
 
+    // Vk writes to shared memory aren't tracked, so what was read ahead could be stale.
+    colorBuffer->mGlCanPrefetch = colorBuffer->mColorBufferGl &&
+                                  !colorBuffer->mGlAndVkAreSharingExternalMemory &&
+                                  emulationGl->isAsyncReadbackSupported();
+
     return colorBuffer;
 }
 
 /*static*/
-std::shared_ptr<ColorBuffer> ColorBuffer::onLoad(gl::EmulationGl* emulationGl, vk::VkEmulation*,
-                                                 android::base::Stream* stream) {
+std::shared_ptr<ColorBuffer> ColorBuffer::onLoad(gl::EmulationGl* emulationGl,
+                                                 vk::VkEmulation* emulationVk,
+                                                 android::base::Stream* stream,
+                                                 SnapshotCompressor* compressor) {
     const auto handle = static_cast<HandleType>(stream->getBe32());
     const auto width = static_cast<uint32_t>(stream->getBe32());
     const auto height = static_cast<uint32_t>(stream->getBe32());
@@ -119,6 +168,42 @@ std::shared_ptr<ColorBuffer> ColorBuffer::onLoad(gl::EmulationGl* emulationGl, v
             ERR("Failed to load ColorBufferGl.");
             return nullptr;
         }
+        colorBuffer->mGlCanPrefetch = emulationGl->isAsyncReadbackSupported();
+    }
+
+    // The contents are missing if they couldn't be read back, but the ColorBufferVk is still
+    // needed.
+    const bool hasVkOnlyBacking = stream->getByte();
+    if (hasVkOnlyBacking) {
+        if (emulationGl || !emulationVk || !emulationVk->live) {
+            ERR("Failed to load ColorBuffer:%d, saved with Vulkan only.", handle);
+            return nullptr;
+        }
+        colorBuffer->mColorBufferVk =
+            vk::ColorBufferVk::create(handle, width, height, format, frameworkFormat,
+                                      /*vulkanOnly=*/true, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!colorBuffer->mColorBufferVk) {
+            ERR("Failed to load ColorBufferVk.");
+            return nullptr;
+        }
+
+        const bool hasVkContents = stream->getByte();
+        if (hasVkContents) {
+            size_t contentsSize = 0;
+            if (!colorBuffer->mColorBufferVk->getContentsSize(&contentsSize)) {
+                ERR("Failed to get the size of ColorBufferVk:%d.", handle);
+                return nullptr;
+            }
+            std::optional<CompressedPayload> contents =
+                loadCompressedPayload(stream, contentsSize);
+            if (!contents) {
+                ERR("Failed to load ColorBufferVk:%d, its contents are corrupt.", handle);
+                return nullptr;
+            }
+            colorBuffer->mVkContentsToRestore = compressor->decompress(std::move(*contents));
+        } else {
+            WARN("ColorBufferVk:%d was saved without its contents.", handle);
+        }
     }
 
     colorBuffer->mNeedRestore = true;
@@ -126,6 +211,21 @@ std::shared_ptr<ColorBuffer> ColorBuffer::onLoad(gl::EmulationGl* emulationGl, v
     return colorBuffer;
 }
 
+void ColorBuffer::onPreSave(SnapshotCompressor* compressor) {
+    if (mColorBufferGl || !mColorBufferVk) {
+        return;
+    }
+
+    touch();
+
+    std::vector<uint8_t> contents;
+    if (!mColorBufferVk->readToBytes(&contents)) {
+        ERR("Failed to read ColorBufferVk:%d for snapshot.", mHandle);
+        return;
+    }
+    mVkContentsToSave = compressor->compress(std::move(contents));
+}
+
 void ColorBuffer::onSave(android::base::Stream* stream) {
     stream->putBe32(getHndl());
     stream->putBe32(mWidth);
@@ -136,11 +236,31 @@ void ColorBuffer::onSave(android::base::Stream* stream) {
     if (mColorBufferGl) {
         mColorBufferGl->onSave(stream);
     }
+
+    const bool hasVkOnlyBacking = !mColorBufferGl && mColorBufferVk;
+    stream->putByte(hasVkOnlyBacking);
+    if (!hasVkOnlyBacking) {
+        return;
+    }
+    const bool hasVkContents = mVkContentsToSave.valid();
+    stream->putByte(hasVkContents);
+    if (hasVkContents) {
+        saveCompressedPayload(stream, mVkContentsToSave.get());
+    }
 }
 
 void ColorBuffer::restore() {
     if (mColorBufferGl) {
         mColorBufferGl->restore();
+        markGlDirty();
+    }
+    if (mVkContentsToRestore.valid()) {
+        std::optional<std::vector<uint8_t>> contents = mVkContentsToRestore.get();
+        if (!contents) {
+            ERR("Failed to decompress ColorBufferVk:%d from snapshot.", mHandle);
+        } else if (!mColorBufferVk->updateFromBytes(*contents)) {
+            ERR("Failed to restore ColorBufferVk:%d from snapshot.", mHandle);
+        }
     }
 }
 
@@ -149,6 +269,11 @@ void ColorBuffer::readToBytes(int x, int y, int width, int height, GLenum pixels
     touch();
 
     if (mColorBufferGl) {
+        if (beginGuestRead(GuestRead::kBytes) &&
+            mColorBufferGl->readPrefetchedPixels(x, y, width, height, pixelsFormat, pixelsType,
+                                                 outPixels)) {
+            return;
+        }
         mColorBufferGl->readPixels(x, y, width, height, pixelsFormat, pixelsType, outPixels);
         return;
     }
@@ -179,6 +304,10 @@ void ColorBuffer::readYuvToBytes(int x, int y, int width, int height, void* outP
     touch();
 
     if (mColorBufferGl) {
+        if (beginGuestRead(GuestRead::kYuvBytes) &&
+            mColorBufferGl->readPrefetchedPixelsYUV(outPixels, pixelsSize)) {
+            return;
+        }
         mColorBufferGl->readPixelsYUVCached(x, y, width, height, outPixels, pixelsSize);
         return;
     }
@@ -198,6 +327,7 @@ bool ColorBuffer::updateFromBytes(int x, int y, int width, int height,
     if (mColorBufferGl) {
         mColorBufferGl->subUpdateFromFrameworkFormat(x, y, width, height, frameworkFormat,
                                                      pixelsFormat, pixelsType, pixels, metadata);
+        markGlDirty(x, y, width, height);
         return true;
     }
     if (mColorBufferVk) {
@@ -213,7 +343,10 @@ bool ColorBuffer::updateFromBytes(int x, int y, int width, int height, GLenum pi
     touch();
 
     if (mColorBufferGl) {
-        return mColorBufferGl->subUpdate(x, y, width, height, pixelsFormat, pixelsType, pixels);
+        const bool result =
+            mColorBufferGl->subUpdate(x, y, width, height, pixelsFormat, pixelsType, pixels);
+        markGlDirty(x, y, width, height);
+        return result;
     }
     if (mColorBufferVk) {
         return mColorBufferVk->updateFromBytes(x, y, width, height, pixels);
@@ -227,7 +360,9 @@ bool ColorBuffer::updateGlFromBytes(const void* bytes, std::size_t bytesSize) {
     if (mColorBufferGl) {
         touch();
 
-        return mColorBufferGl->replaceContents(bytes, bytesSize);
+        const bool result = mColorBufferGl->replaceContents(bytes, bytesSize);
+        markGlDirty();
+        return result;
     }
 
     return true;
@@ -239,6 +374,10 @@ std::unique_ptr<BorrowedImageInfo> ColorBuffer::borrowForComposition(UsedApi api
             if (!mColorBufferGl) {
                 GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER)) << "ColorBufferGl not available.";
             }
+            if (isTarget) {
+                // Composed into right after.
+                markGlDirty();
+            }
             return mColorBufferGl->getBorrowedImageInfo();
         }
         case UsedApi::kVk: {
@@ -271,6 +410,43 @@ std::unique_ptr<BorrowedImageInfo> ColorBuffer::borrowForDisplay(UsedApi api) {
     return nullptr;
 }
 
+bool ColorBuffer::beginGuestRead(GuestRead read) {
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mLastGuestRead = read;
+    return !mGlWritesUntracked && mGlWritesPrefetched == mGlWrites && mPrefetchedGuestRead == read;
+}
+
+void ColorBuffer::prefetchForReads() {
+    if (!mGlCanPrefetch) {
+        return;
+    }
+
+    uint64_t writes = 0;
+    GuestRead read = GuestRead::kNone;
+    {
+        std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+        // Buffers the guest never read, or renders to without telling, aren't worth reading ahead.
+        if (mLastGuestRead == GuestRead::kNone || mGlWritesUntracked) {
+            return;
+        }
+        if (mGlWritesPrefetched == mGlWrites && mPrefetchedGuestRead == mLastGuestRead) {
+            return;
+        }
+        writes = mGlWrites;
+        read = mLastGuestRead;
+        mGlWritesPrefetched.reset();
+    }
+
+    if (!mColorBufferGl->prefetchPixels(read == GuestRead::kYuvBytes)) {
+        return;
+    }
+
+    // Writes since |writes| was taken leave it behind, so the copy is only used if there were none.
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlWritesPrefetched = writes;
+    mPrefetchedGuestRead = read;
+}
+
 bool ColorBuffer::flushFromGl() {
     if (!(mColorBufferGl && mColorBufferVk)) {
         return true;
@@ -294,7 +470,8 @@ bool ColorBuffer::flushFromVk() {
         return true;
     }
 
-    std::vector<uint8_t> contents;
+    // The parts of the Vk backing written to aren't known, so all of it is copied.
+    std::vector<uint8_t>& contents = getSyncBuffer(0);
     if (!vk::readColorBufferToBytes(mHandle, &contents)) {
         ERR("Failed to get VK contents for ColorBuffer:%d", mHandle);
         return false;
@@ -309,6 +486,9 @@ bool ColorBuffer::flushFromVk() {
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlDirtyForVk.clear();
+    mGlWrites++;
     return true;
 }
 
@@ -328,6 +508,9 @@ bool ColorBuffer::flushFromVkBytes(const void* bytes, size_t bytesSize) {
         }
     }
 
+    std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+    mGlDirtyForVk.clear();
+    mGlWrites++;
     return true;
 }
 
@@ -354,24 +537,86 @@ bool ColorBuffer::invalidateForVk() {
         return true;
     }
 
+    std::vector<DirtyRegion::Rect> rects;
+    bool isAll = false;
+    {
+        std::lock_guard<std::mutex> lock(mGlDirtyMutex);
+        if (mGlWritesUntracked) {
+            mGlDirtyForVk.addAll();
+        }
+        rects = mGlDirtyForVk.rects();
+        isAll = mGlDirtyForVk.isAll();
+        mGlDirtyForVk.clear();
+    }
+
     std::size_t contentsSize = 0;
     if (!mColorBufferGl->readContents(&contentsSize, nullptr)) {
         ERR("Failed to get GL contents size for ColorBuffer:%d", mHandle);
+        markGlDirty();
         return false;
     }
 
-    std::vector<uint8_t> contents(contentsSize, 0);
+    size_t bytesCopied = 0;
+    if (!isAll && !copyGlRectsToVk(rects, contentsSize, &bytesCopied)) {
+        // Such as for YUV ColorBuffers, whose GL contents are only read whole.
+        isAll = !rects.empty();
+    }
 
-    if (!mColorBufferGl->readContents(&contentsSize, contents.data())) {
-        ERR("Failed to get GL contents for ColorBuffer:%d", mHandle);
-        return false;
+    if (isAll) {
+        std::vector<uint8_t>& contents = getSyncBuffer(contentsSize);
+
+        if (!mColorBufferGl->readContents(&contentsSize, contents.data())) {
+            ERR("Failed to get GL contents for ColorBuffer:%d", mHandle);
+            markGlDirty();
+            return false;
+        }
+
+        if (!mColorBufferVk->updateFromBytes(contents)) {
+            ERR("Failed to set VK contents for ColorBuffer:%d", mHandle);
+            markGlDirty();
+            return false;
+        }
+        bytesCopied = contentsSize;
     }
 
-    if (!mColorBufferVk->updateFromBytes(contents)) {
-        ERR("Failed to set VK contents for ColorBuffer:%d", mHandle);
+    sNumSyncs.fetch_add(1, std::memory_order_relaxed);
+    sBytesCopied.fetch_add(bytesCopied, std::memory_order_relaxed);
+    sBytesAvoided.fetch_add(contentsSize - std::min(bytesCopied, contentsSize),
+                            std::memory_order_relaxed);
+    return true;
+}
+
+bool ColorBuffer::copyGlRectsToVk(const std::vector<DirtyRegion::Rect>& rects,
+                                  size_t contentsSize, size_t* outBytesCopied) {
+    *outBytesCopied = 0;
+    if (rects.empty()) {
+        return true;
+    }
+
+    // The rectangles are only copied in the same layout in both.
+    size_t vkContentsSize = 0;
+    if (!mColorBufferVk->getContentsSize(&vkContentsSize) || vkContentsSize != contentsSize) {
         return false;
     }
 
+    for (const DirtyRegion::Rect& rect : rects) {
+        size_t rectSize = 0;
+        if (!mColorBufferGl->readContents(rect.x, rect.y, rect.width, rect.height, &rectSize,
+                                          nullptr)) {
+            return false;
+        }
+
+        std::vector<uint8_t>& contents = getSyncBuffer(rectSize);
+        mColorBufferGl->readContents(rect.x, rect.y, rect.width, rect.height, &rectSize,
+                                     contents.data());
+
+        if (!mColorBufferVk->updateFromBytes(rect.x, rect.y, rect.width, rect.height,
+                                             contents.data())) {
+            // Also for formats the Vk backing can only update whole.
+            return false;
+        }
+        *outBytesCopied += rectSize;
+    }
     return true;
 }
 
@@ -382,7 +627,10 @@ bool ColorBuffer::glOpBlitFromCurrentReadBuffer() {
 
     touch();
 
-    return mColorBufferGl->blitFromCurrentReadBuffer();
+    const bool result = mColorBufferGl->blitFromCurrentReadBuffer();
+    markGlDirty();
+    prefetchForReads();
+    return result;
 }
 
 bool ColorBuffer::glOpBindToTexture() {
@@ -392,6 +640,7 @@ bool ColorBuffer::glOpBindToTexture() {
 
     touch();
 
+    markGlWritesUntracked();
     return mColorBufferGl->bindToTexture();
 }
 
@@ -400,6 +649,7 @@ bool ColorBuffer::glOpBindToTexture2() {
         GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER)) << "ColorBufferGl not available.";
     }
 
+    markGlWritesUntracked();
     return mColorBufferGl->bindToTexture2();
 }
 
@@ -410,6 +660,7 @@ bool ColorBuffer::glOpBindToRenderbuffer() {
 
     touch();
 
+    markGlWritesUntracked();
     return mColorBufferGl->bindToRenderbuffer();
 }
 
@@ -420,6 +671,7 @@ GLuint ColorBuffer::glOpGetTexture() {
 
     touch();
 
+    markGlWritesUntracked();
     return mColorBufferGl->getTexture();
 }
 
@@ -448,6 +700,7 @@ bool ColorBuffer::glOpImportEglImage(void* image, bool preserveContent) {
         GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER)) << "ColorBufferGl not available.";
     }
 
+    markGlWritesUntracked();
     return mColorBufferGl->importEglImage(image, preserveContent);
 }
 
@@ -456,6 +709,7 @@ bool ColorBuffer::glOpImportEglNativePixmap(void* pixmap, bool preserveContent)
         GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER)) << "ColorBufferGl not available.";
     }
 
+    markGlWritesUntracked();
     return mColorBufferGl->importEglNativePixmap(pixmap, preserveContent);
 }
 
@@ -470,6 +724,7 @@ void ColorBuffer::glOpSwapYuvTexturesAndUpdate(GLenum format, GLenum type,
     // This makes ColorBufferGl regenerate the RGBA texture using
     // YUVConverter::drawConvert() with the updated YUV textures.
     mColorBufferGl->subUpdate(0, 0, mWidth, mHeight, format, type, nullptr);
+    markGlDirty();
 
     flushFromGl();
 }
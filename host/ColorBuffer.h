@@ -14,9 +14,14 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 #include "BorrowedImage.h"
+#include "DirtyRegion.h"
 #include "FrameworkFormats.h"
 #include "Handle.h"
 #include "Hwc2.h"
@@ -24,6 +29,7 @@
 #include "gl/ColorBufferGl.h"
 #include "render-utils/Renderer.h"
 #include "snapshot/LazySnapshotObj.h"
+#include "snapshotCompression/SnapshotCompressor.h"
 
 namespace gfxstream {
 namespace gl {
@@ -47,9 +53,14 @@ class ColorBuffer : public android::snapshot::LazySnapshotObj<ColorBuffer> {
                                                uint32_t height, GLenum format,
                                                FrameworkFormat frameworkFormat, HandleType handle);
 
+    // Starts decompressing the contents of a Vk only ColorBuffer on |compressor| for restore().
     static std::shared_ptr<ColorBuffer> onLoad(gl::EmulationGl* emulationGl,
                                                vk::VkEmulation* emulationVk,
-                                               android::base::Stream* stream);
+                                               android::base::Stream* stream,
+                                               SnapshotCompressor* compressor);
+    // Reads back the contents of a Vk only ColorBuffer and starts compressing them on
+    // |compressor|, so that it overlaps reading back the next ones before onSave().
+    void onPreSave(SnapshotCompressor* compressor);
     void onSave(android::base::Stream* stream);
     void restore();
 
@@ -79,6 +90,21 @@ class ColorBuffer : public android::snapshot::LazySnapshotObj<ColorBuffer> {
     std::unique_ptr<BorrowedImageInfo> borrowForComposition(UsedApi api, bool isTarget);
     std::unique_ptr<BorrowedImageInfo> borrowForDisplay(UsedApi api);
 
+    // Without external memory shared between the GL and Vk backings, invalidateForVk() copies the
+    // parts of the GL backing changed since the last sync to the Vk one. Sampling them each frame
+    // tells how much that copies, and how much copying the whole ColorBuffers each time would have.
+    struct SyncStats {
+        uint64_t numSyncs = 0;
+        uint64_t bytesCopied = 0;
+        uint64_t bytesAvoided = 0;
+    };
+    static SyncStats getSyncStats();
+
+    // Starts reading the contents ahead if the guest read them before and they changed since, so
+    // that the next guest read completes from that copy rather than waits for the GPU. Called once
+    // the contents are likely final, when the ColorBuffer is flushed or posted.
+    void prefetchForReads();
+
     bool flushFromGl();
     bool flushFromVk();
     bool flushFromVkBytes(const void* bytes, size_t bytesSize);
@@ -105,6 +131,21 @@ class ColorBuffer : public android::snapshot::LazySnapshotObj<ColorBuffer> {
     ColorBuffer(HandleType, uint32_t width, uint32_t height, GLenum format,
                 FrameworkFormat frameworkFormat);
 
+    enum class GuestRead {
+        kNone,
+        kBytes,
+        kYuvBytes,
+    };
+    // Records the read and returns whether the contents prefetched for it are still current.
+    bool beginGuestRead(GuestRead read);
+
+    void markGlDirty(int x, int y, int width, int height);
+    void markGlDirty();
+    // For uses of the GL backing which may write anywhere in it at any time later.
+    void markGlWritesUntracked();
+    bool copyGlRectsToVk(const std::vector<DirtyRegion::Rect>& rects, size_t contentsSize,
+                         size_t* outBytesCopied);
+
     const HandleType mHandle;
     const uint32_t mWidth;
     const uint32_t mHeight;
@@ -118,6 +159,23 @@ class ColorBuffer : public android::snapshot::LazySnapshotObj<ColorBuffer> {
     std::unique_ptr<vk::ColorBufferVk> mColorBufferVk;
 
     bool mGlAndVkAreSharingExternalMemory = false;
+    // If the GL backing can read its contents ahead.
+    bool mGlCanPrefetch = false;
+
+    std::mutex mGlDirtyMutex;
+    // The parts of the GL backing which changed since the Vk backing was last updated from it.
+    DirtyRegion mGlDirtyForVk;
+    bool mGlWritesUntracked = false;
+    // Counts the writes to the GL backing, to tell whether what was read ahead is still current.
+    uint64_t mGlWrites = 0;
+    std::optional<uint64_t> mGlWritesPrefetched;
+    GuestRead mLastGuestRead = GuestRead::kNone;
+    GuestRead mPrefetchedGuestRead = GuestRead::kNone;
+
+    // The contents of the Vk backing being compressed for onSave() if there is no GL backing.
+    std::future<CompressedPayload> mVkContentsToSave;
+    // And being decompressed for restore() after onLoad().
+    std::future<std::optional<std::vector<uint8_t>>> mVkContentsToRestore;
 };
 
 typedef std::shared_ptr<ColorBuffer> ColorBufferPtr;
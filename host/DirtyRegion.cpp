@@ -0,0 +1,121 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "DirtyRegion.h"
+
+#include <algorithm>
+
+namespace gfxstream {
+namespace {
+
+using Rect = DirtyRegion::Rect;
+
+uint64_t areaOf(const Rect& rect) { return uint64_t(rect.width) * rect.height; }
+
+Rect boundsOf(const Rect& a, const Rect& b) {
+    const uint32_t left = std::min(a.x, b.x);
+    const uint32_t top = std::min(a.y, b.y);
+    const uint32_t right = std::max(a.x + a.width, b.x + b.width);
+    const uint32_t bottom = std::max(a.y + a.height, b.y + b.height);
+    return Rect{left, top, right - left, bottom - top};
+}
+
+// Whether the rectangles overlap or share an edge.
+bool overlapsOrTouches(const Rect& a, const Rect& b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height &&
+           b.y <= a.y + a.height;
+}
+
+}  // namespace
+
+DirtyRegion::DirtyRegion(uint32_t width, uint32_t height) : mWidth(width), mHeight(height) {
+    addAll();
+}
+
+void DirtyRegion::add(int x, int y, int width, int height) {
+    const int64_t left = std::max<int64_t>(x, 0);
+    const int64_t top = std::max<int64_t>(y, 0);
+    const int64_t right = std::min<int64_t>(int64_t(x) + width, mWidth);
+    const int64_t bottom = std::min<int64_t>(int64_t(y) + height, mHeight);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+
+    mRects.push_back(Rect{uint32_t(left), uint32_t(top), uint32_t(right - left),
+                          uint32_t(bottom - top)});
+    mergeOverlapping();
+    while (mRects.size() > kMaxRects) {
+        mergeClosest();
+    }
+}
+
+void DirtyRegion::addAll() {
+    mRects.clear();
+    if (mWidth && mHeight) {
+        mRects.push_back(Rect{0, 0, mWidth, mHeight});
+    }
+}
+
+void DirtyRegion::clear() { mRects.clear(); }
+
+bool DirtyRegion::isAll() const {
+    return mRects.size() == 1 && mRects[0].width == mWidth && mRects[0].height == mHeight;
+}
+
+uint64_t DirtyRegion::area() const {
+    uint64_t area = 0;
+    for (const Rect& rect : mRects) {
+        area += areaOf(rect);
+    }
+    return area;
+}
+
+void DirtyRegion::mergeOverlapping() {
+    // Merging may make the bounds overlap others, so this repeats until no two do.
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < mRects.size() && !merged; i++) {
+            for (size_t j = i + 1; j < mRects.size(); j++) {
+                if (overlapsOrTouches(mRects[i], mRects[j])) {
+                    mRects[i] = boundsOf(mRects[i], mRects[j]);
+                    mRects.erase(mRects.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void DirtyRegion::mergeClosest() {
+    size_t bestI = 0;
+    size_t bestJ = 1;
+    uint64_t bestExtraArea = UINT64_MAX;
+    for (size_t i = 0; i < mRects.size(); i++) {
+        for (size_t j = i + 1; j < mRects.size(); j++) {
+            const uint64_t extraArea = areaOf(boundsOf(mRects[i], mRects[j])) -
+                                       areaOf(mRects[i]) - areaOf(mRects[j]);
+            if (extraArea < bestExtraArea) {
+                bestExtraArea = extraArea;
+                bestI = i;
+                bestJ = j;
+            }
+        }
+    }
+    mRects[bestI] = boundsOf(mRects[bestI], mRects[bestJ]);
+    mRects.erase(mRects.begin() + bestJ);
+    mergeOverlapping();
+}
+
+}  // namespace gfxstream
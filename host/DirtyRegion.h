@@ -0,0 +1,62 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace gfxstream {
+
+// The parts of an image which changed since it was last synchronized, as a few rectangles.
+//
+// Rectangles which overlap or touch are merged, and once there are more than kMaxRects, the two
+// whose bounds cover the least extra pixels are merged, so copying the region never copies much
+// more than what changed, in a few copies. The rectangles don't overlap.
+class DirtyRegion {
+   public:
+    struct Rect {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    static constexpr size_t kMaxRects = 4;
+
+    // Starts out as the whole image, whose contents were never synchronized.
+    DirtyRegion(uint32_t width, uint32_t height);
+
+    // Adds the part of the rectangle which is in the image.
+    void add(int x, int y, int width, int height);
+    void addAll();
+    void clear();
+
+    bool empty() const { return mRects.empty(); }
+    bool isAll() const;
+    const std::vector<Rect>& rects() const { return mRects; }
+    // The number of pixels in the region.
+    uint64_t area() const;
+
+   private:
+    void mergeOverlapping();
+    void mergeClosest();
+
+    const uint32_t mWidth;
+    const uint32_t mHeight;
+    std::vector<Rect> mRects;
+};
+
+}  // namespace gfxstream
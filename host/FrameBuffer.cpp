@@ -57,6 +57,7 @@
 #include "host-common/opengl/misc.h"
 #include "host-common/vm_operations.h"
 #include "render-utils/MediaNative.h"
+#include "snapshotCompression/SnapshotCompressor.h"
 #include "vulkan/DisplayVk.h"
 #include "vulkan/PostWorkerVk.h"
 #include "vulkan/VkCommonOperations.h"
@@ -1692,6 +1693,19 @@ std::unique_ptr<ProcessResources> FrameBuffer::removeGraphicsProcessResources(ui
     return res;
 }
 
+std::vector<FrameBuffer::ProcessSequenceNumberStats> FrameBuffer::getSequenceNumberStats() {
+    AutoLock mutex(m_lock);
+    std::vector<ProcessSequenceNumberStats> stats;
+    stats.reserve(m_procOwnedResources.size());
+    for (const auto& [puid, resources] : m_procOwnedResources) {
+        stats.push_back({
+            .puid = puid,
+            .stats = resources->getSequenceNumberOrdering()->getStats(),
+        });
+    }
+    return stats;
+}
+
 void FrameBuffer::cleanupProcGLObjects(uint64_t puid) {
     bool renderThreadWithThisPuidExists = false;
 
@@ -2457,6 +2471,8 @@ AsyncResult FrameBuffer::postImpl(HandleType p_colorbuffer,
     m_lastPostedColorBuffer = p_colorbuffer;
 
     colorBuffer->touch();
+    // Screen recording and screenshots read posted buffers back.
+    colorBuffer->prefetchForReads();
     if (m_subWin) {
         Post postCmd;
         postCmd.cmd = PostCmd::Post;
@@ -2957,6 +2973,16 @@ void FrameBuffer::onSave(Stream* stream,
 
     {
         AutoLock colorBufferMapLock(m_colorBufferMapLock);
+
+        // Reads back the contents only kept in Vk while compressing what was read before.
+        SnapshotCompressor compressor;
+        for (auto& it : m_colorbuffers) {
+            it.second.cb->onPreSave(&compressor);
+        }
+        for (auto& it : m_buffers) {
+            it.second.buffer->onPreSave(&compressor);
+        }
+
         stream->putByte(m_guestManagedColorBufferLifetime);
         saveCollection(stream, m_colorbuffers,
                        [now](Stream* s, const ColorBufferMap::value_type& pair) {
@@ -2965,6 +2991,9 @@ void FrameBuffer::onSave(Stream* stream,
                            s->putByte(pair.second.opened);
                            s->putBe32(std::max<uint64_t>(0, now - pair.second.closedTs));
                        });
+        saveCollection(stream, m_buffers, [](Stream* s, const BufferMap::value_type& pair) {
+            pair.second.buffer->onSave(s);
+        });
     }
     stream->putBe32(m_lastPostedColorBuffer);
     saveCollection(stream, m_windows,
@@ -3149,21 +3178,48 @@ bool FrameBuffer::onLoad(Stream* stream,
     assert(!android::base::find(m_contexts, 0));
 
     auto now = android::base::getUnixTimeUs();
+    // Decompresses the contents only kept in Vk while loading the rest.
+    SnapshotCompressor compressor;
     {
         AutoLock colorBufferMapLock(m_colorBufferMapLock);
         m_guestManagedColorBufferLifetime = stream->getByte();
-        loadCollection(
-            stream, &m_colorbuffers, [this, now](Stream* stream) -> ColorBufferMap::value_type {
-                ColorBufferPtr cb = ColorBuffer::onLoad(m_emulationGl.get(), m_emulationVk, stream);
-                const HandleType handle = cb->getHndl();
-                const unsigned refCount = stream->getBe32();
-                const bool opened = stream->getByte();
-                const uint64_t closedTs = now - stream->getBe32();
-                if (refCount == 0) {
-                    m_colorBufferDelayedCloseList.push_back({closedTs, handle});
-                }
-                return {handle, ColorBufferRef{std::move(cb), refCount, opened, closedTs}};
-            });
+        // Unlike loadCollection(), stops at the first object that fails to
+        // load, since the rest of the stream can't be read after it.
+        const uint32_t colorBufferCount = stream->getBe32();
+        for (uint32_t i = 0; i < colorBufferCount; ++i) {
+            ColorBufferPtr cb =
+                ColorBuffer::onLoad(m_emulationGl.get(), m_emulationVk, stream, &compressor);
+            if (!cb) {
+                ERR("Failed to load ColorBuffer %u of %u from snapshot.", i, colorBufferCount);
+                m_colorbuffers.clear();
+                m_colorBufferDelayedCloseList.clear();
+                return false;
+            }
+            const HandleType handle = cb->getHndl();
+            const unsigned refCount = stream->getBe32();
+            const bool opened = stream->getByte();
+            const uint64_t closedTs = now - stream->getBe32();
+            if (refCount == 0) {
+                m_colorBufferDelayedCloseList.push_back({closedTs, handle});
+            }
+            m_colorbuffers.emplace(handle,
+                                   ColorBufferRef{std::move(cb), refCount, opened, closedTs});
+        }
+        m_buffers.clear();
+        const uint32_t bufferCount = stream->getBe32();
+        for (uint32_t i = 0; i < bufferCount; ++i) {
+            BufferPtr buffer =
+                Buffer::onLoad(m_emulationGl.get(), m_emulationVk, stream, &compressor);
+            if (!buffer) {
+                ERR("Failed to load Buffer %u of %u from snapshot.", i, bufferCount);
+                m_colorbuffers.clear();
+                m_colorBufferDelayedCloseList.clear();
+                m_buffers.clear();
+                return false;
+            }
+            const HandleType handle = buffer->getHndl();
+            m_buffers.emplace(handle, BufferRef{std::move(buffer)});
+        }
     }
     m_lastPostedColorBuffer = static_cast<HandleType>(stream->getBe32());
     GL_LOG("Got lasted posted color buffer from snapshot");
@@ -3211,12 +3267,19 @@ bool FrameBuffer::onLoad(Stream* stream,
             }
         }
 
+        // The Vk decoder uses the Vk backings without going through ColorBuffer or Buffer, so the
+        // contents are restored before it loads.
         AutoLock colorBufferMapLock(m_colorBufferMapLock);
         for (auto& it : m_colorbuffers) {
             if (it.second.cb) {
                 it.second.cb->touch();
             }
         }
+        for (auto& it : m_buffers) {
+            if (it.second.buffer) {
+                it.second.buffer->touch();
+            }
+        }
     }
 
     // Restore Vulkan state
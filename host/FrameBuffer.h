@@ -37,6 +37,7 @@
 #include "PostCommands.h"
 #include "PostWorker.h"
 #include "ReadbackWorker.h"
+#include "SequenceNumberOrdering.h"
 #include "VsyncThread.h"
 #include "aemu/base/AsyncResult.h"
 #include "aemu/base/EventNotificationSupport.h"
@@ -85,20 +86,20 @@ struct BufferRef {
 class ProcessResources {
    public:
     // We only allow ProcessResources to be created on the heap, because the pointer to
-    // mSequenceNumber shouldn't change until ProcessResources is destroyed.
+    // mSequenceNumberOrdering shouldn't change until ProcessResources is destroyed.
     static std::unique_ptr<ProcessResources> create() {
         return std::unique_ptr<ProcessResources>(new ProcessResources());
     }
     DISALLOW_COPY_ASSIGN_AND_MOVE(ProcessResources);
 
     ~ProcessResources() = default;
-    std::atomic<uint32_t>* getSequenceNumberPtr() const {
-        return &mSequenceNumber;
+    SequenceNumberOrdering* getSequenceNumberOrdering() const {
+        return &mSequenceNumberOrdering;
     }
 
    private:
-    ProcessResources() : mSequenceNumber(0) {}
-    mutable std::atomic<uint32_t> mSequenceNumber;
+    ProcessResources() = default;
+    mutable SequenceNumberOrdering mSequenceNumberOrdering;
 };
 
 typedef std::unordered_map<uint64_t, gl::EmulatedEglWindowSurfaceSet>
@@ -298,6 +299,14 @@ class FrameBuffer : public android::base::EventNotificationSupport<FrameBufferCh
     // TODO(kaiyili): retire cleanupProcGLObjects in favor of removeGraphicsProcessResources.
     void cleanupProcGLObjects(uint64_t puid);
 
+    struct ProcessSequenceNumberStats {
+        uint64_t puid;
+        SequenceNumberOrdering::Stats stats;
+    };
+    // How long the render threads of each live guest process waited for the
+    // order of its Vulkan commands.
+    std::vector<ProcessSequenceNumberStats> getSequenceNumberStats();
+
     // Equivalent for eglMakeCurrent() for the current display.
     // |p_context|, |p_drawSurface| and |p_readSurface| are the handle values
     // of the context, the draw surface and the read surface, respectively.
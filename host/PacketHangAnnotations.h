@@ -0,0 +1,118 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "aemu/base/HealthMonitor.h"
+#include "aemu/base/Metrics.h"
+#include "utils/GfxApiLogger.h"
+
+namespace gfxstream {
+
+// Describes the packet a decoder thread is working on, for hang reports.
+//
+// Decoders used to fill an EventHangMetadata::HangAnnotations map for every
+// packet, which costs several allocations even though the map is only looked
+// at when a hang is detected. Instead, each decoder thread owns one of these,
+// records a few integers per packet, and hands getOnHangCallback() to its
+// watchdogs. The strings are built by the health monitor thread when it
+// reports a hang, so the fields are atomics.
+class PacketHangAnnotations {
+   public:
+    // |opcodeKey| and |lengthKey| name the annotations of the current opcode
+    // and length, and must be string literals.
+    PacketHangAnnotations(const char* opcodeKey, const char* lengthKey)
+        : mOpcodeKey(opcodeKey), mLengthKey(lengthKey) {}
+    PacketHangAnnotations(const PacketHangAnnotations&) = delete;
+    PacketHangAnnotations& operator=(const PacketHangAnnotations&) = delete;
+
+    // |processName| has to stay valid until it is replaced, or until the
+    // watchdogs using this object are gone.
+    void setProcessName(const char* processName) {
+        mProcessName.store(processName, std::memory_order_relaxed);
+    }
+
+    // Starts a new packet. The sequence number of the previous packet, if it
+    // had one, is reported as the previous sequence number from now on.
+    void setPacket(uint32_t opcode, uint64_t length) {
+        mOpcode.store(opcode, std::memory_order_relaxed);
+        mLength.store(length, std::memory_order_relaxed);
+        const uint64_t seqno = mSeqno.load(std::memory_order_relaxed);
+        if (seqno != kNoSeqno) {
+            mPreviousSeqno.store(seqno, std::memory_order_relaxed);
+            mSeqno.store(kNoSeqno, std::memory_order_relaxed);
+        }
+    }
+
+    void setSeqno(uint32_t seqno) { mSeqno.store(seqno, std::memory_order_relaxed); }
+
+    // Adds the last commands recorded by |logger| to the annotations. Same
+    // lifetime requirements as |processName|.
+    void setGfxApiLogger(const emugl::GfxApiLogger* logger) {
+        mGfxApiLogger.store(logger, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<android::base::EventHangMetadata::HangAnnotations> build() const {
+        auto annotations = std::make_unique<android::base::EventHangMetadata::HangAnnotations>();
+        if (const char* processName = mProcessName.load(std::memory_order_relaxed)) {
+            annotations->insert({{"renderthread_guest_process", processName}});
+        }
+        const uint64_t length = mLength.load(std::memory_order_relaxed);
+        if (length != kNoPacket) {
+            annotations->insert(
+                {{mOpcodeKey, std::to_string(mOpcode.load(std::memory_order_relaxed))},
+                 {mLengthKey, std::to_string(length)}});
+        }
+        const uint64_t seqno = mSeqno.load(std::memory_order_relaxed);
+        if (seqno != kNoSeqno) {
+            annotations->insert({{"seqno", std::to_string(seqno)}});
+        }
+        const uint64_t previousSeqno = mPreviousSeqno.load(std::memory_order_relaxed);
+        if (previousSeqno != kNoSeqno) {
+            annotations->insert({{"previous_seqno", std::to_string(previousSeqno)}});
+        }
+        if (const emugl::GfxApiLogger* logger = mGfxApiLogger.load(std::memory_order_relaxed)) {
+            annotations->insert(
+                {{"recent_commands", logger->dumpRecentCommands(kNumRecentCommands)}});
+        }
+        return annotations;
+    }
+
+    // Only captures |this|, so std::function keeps it inline and setting it on
+    // a watchdog doesn't allocate.
+    auto getOnHangCallback() const {
+        return [this]() { return build(); };
+    }
+
+   private:
+    static constexpr uint64_t kNoPacket = std::numeric_limits<uint64_t>::max();
+    static constexpr uint64_t kNoSeqno = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t kNumRecentCommands = 16;
+
+    const char* const mOpcodeKey;
+    const char* const mLengthKey;
+    std::atomic<const char*> mProcessName{nullptr};
+    std::atomic<uint32_t> mOpcode{0};
+    std::atomic<uint64_t> mLength{kNoPacket};
+    std::atomic<uint64_t> mSeqno{kNoSeqno};
+    std::atomic<uint64_t> mPreviousSeqno{kNoSeqno};
+    std::atomic<const emugl::GfxApiLogger*> mGfxApiLogger{nullptr};
+};
+
+}  // namespace gfxstream
@@ -111,6 +111,85 @@ void ReadBuffer::consume(size_t amount) {
     m_readPtr += amount;
 }
 
+void ReadBuffer::beginExternalView(const unsigned char* data, size_t size) {
+    assert(!m_externalView);
+    assert(m_validData == 0);
+    m_externalView = true;
+    m_readPtr = m_buf;
+    m_viewPtr = data;
+    m_viewLeft = size;
+}
+
+size_t ReadBuffer::stageExternalView() {
+    assert(m_externalView);
+    size_t staged = 0;
+    while (m_viewLeft >= 2 * sizeof(uint32_t)) {
+        // The opcode and the size of the packet.
+        uint32_t header[2];
+        memcpy(header, m_viewPtr, sizeof(header));
+        const uint32_t packetSize = header[1];
+        if (packetSize < sizeof(header) || packetSize > m_viewLeft) {
+            // Left for endExternalView() and the regular path.
+            break;
+        }
+        const size_t freeTailSize = m_buf + m_size - (m_readPtr + m_validData);
+        if (staged && packetSize > freeTailSize) {
+            break;
+        }
+        if (!reserveTail(packetSize)) {
+            break;
+        }
+        unsigned char* const dst = m_readPtr + m_validData;
+        memcpy(dst, header, sizeof(header));
+        memcpy(dst + sizeof(header), m_viewPtr + sizeof(header),
+               packetSize - sizeof(header));
+        m_validData += packetSize;
+        m_viewPtr += packetSize;
+        m_viewLeft -= packetSize;
+        staged += packetSize;
+    }
+    return staged;
+}
+
+int ReadBuffer::endExternalView() {
+    assert(m_externalView);
+    m_externalView = false;
+    if (m_viewLeft) {
+        if (!reserveTail(m_viewLeft)) {
+            m_viewLeft = 0;
+            return -1;
+        }
+        memcpy(m_readPtr + m_validData, m_viewPtr, m_viewLeft);
+        m_validData += m_viewLeft;
+    }
+    m_viewPtr = nullptr;
+    m_viewLeft = 0;
+    return m_validData;
+}
+
+bool ReadBuffer::reserveTail(size_t size) {
+    if (m_buf + m_size - (m_readPtr + m_validData) >= size) {
+        return true;
+    }
+    if (m_size - m_validData >= size) {
+        memmove(m_buf, m_readPtr, m_validData);
+        m_readPtr = m_buf;
+        return true;
+    }
+    const size_t new_size = std::max(m_validData + size, 2 * m_size);
+    const auto new_buf = (unsigned char*)malloc(new_size);
+    if (!new_buf) {
+        ERR("Failed to alloc %zu bytes for ReadBuffer\n", new_size);
+        return false;
+    }
+    memcpy(new_buf, m_readPtr, m_validData);
+    free(m_buf);
+    m_buf = new_buf;
+    m_size = new_size;
+    m_readPtr = m_buf;
+    return true;
+}
+
 void ReadBuffer::onSave(android::base::Stream* stream) {
     stream->putBe32(m_size);
     stream->putBe32(m_validData);
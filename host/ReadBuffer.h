@@ -30,15 +30,35 @@ public:
     size_t validData() const { return m_validData; } // return the amount of valid data in readptr
     void consume(size_t amount); // notify that 'amount' data has been consumed;
 
+    // Makes stageExternalView() take packets from |data|, which the guest may
+    // still write to. Only allowed while there is no valid data left.
+    void beginExternalView(const unsigned char* data, size_t size);
+    // Copies the complete packets at the front of the external view that fit
+    // in the buffer, or the first one if none does, into the buffer, so that
+    // the decoders never read memory the guest can change under them. Each
+    // packet header is read once, and its size checked against the view.
+    // Returns the number of bytes copied.
+    size_t stageExternalView();
+    // Copies whatever wasn't staged from the external view into the buffer.
+    int endExternalView();
+    bool hasExternalView() const { return m_externalView; }
+    size_t externalViewLeft() const { return m_viewLeft; }
+
     void onLoad(android::base::Stream* stream);
     void onSave(android::base::Stream* stream);
 
     void printStats();
 private:
+    // Makes room for |size| more bytes after the valid data.
+    bool reserveTail(size_t size);
+
     unsigned char *m_buf;
     unsigned char *m_readPtr;
     size_t m_size;
     size_t m_validData;
+    bool m_externalView = false;
+    const unsigned char* m_viewPtr = nullptr;
+    size_t m_viewLeft = 0;
 
     uint64_t m_tailMoveTimeUs = 0;
     size_t m_neededFreeTailSize = 0;
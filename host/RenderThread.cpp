@@ -17,6 +17,7 @@
 
 #include "ChannelStream.h"
 #include "FrameBuffer.h"
+#include "PacketHangAnnotations.h"
 #include "ReadBuffer.h"
 #include "RenderChannelImpl.h"
 #include "RenderControl.h"
@@ -68,6 +69,13 @@ static bool getBenchmarkEnabledFromEnv() {
     return false;
 }
 
+// Stage type 1 xfers into the ReadBuffer a batch of packets at a time, straight
+// from the address space graphics buffer, instead of reading them through the
+// RingStream.
+static bool getZeroCopyDecodeEnabledFromEnv() {
+    return android::base::getEnvironmentVariable("ANDROID_EMUGL_RENDERTHREAD_ZERO_COPY") == "1";
+}
+
 // Start with a smaller buffer to not waste memory on a low-used render threads.
 static constexpr int kStreamBufferSize = 128 * 1024;
 
@@ -327,6 +335,7 @@ intptr_t RenderThread::main() {
     uint64_t stats_progressTimeUs = 0;
     auto stats_t0 = android::base::getHighResTimeUs() / 1000;
     bool benchmarkEnabled = getBenchmarkEnabledFromEnv();
+    const bool zeroCopyEnabled = mRingStream && getZeroCopyDecodeEnabledFromEnv();
 
     //
     // open dump file if RENDER_DUMP_DIR is defined
@@ -349,13 +358,30 @@ intptr_t RenderThread::main() {
     auto& metricsLogger = FrameBuffer::getFB()->getMetricsLogger();
 
     const ProcessResources* processResources = nullptr;
+    PacketHangAnnotations hangAnnotations("first_opcode", "buffer_length");
+    hangAnnotations.setGfxApiLogger(&gfxLogger);
 
     while (true) {
+        if (zeroCopyEnabled && !readBuf.validData()) {
+            if (!readBuf.hasExternalView()) {
+                size_t viewSize = 0;
+                const unsigned char* view = mRingStream->beginZeroCopyRead(&viewSize);
+                if (view) {
+                    readBuf.beginExternalView(view, viewSize);
+                }
+            }
+            if (readBuf.hasExternalView()) {
+                // The decoders read the lengths in a packet more than once, so
+                // they only get packets copied out of the memory the guest maps.
+                readBuf.stageExternalView();
+            }
+        }
+
         // Let's make sure we read enough data for at least some processing.
         uint32_t packetSize;
         if (readBuf.validData() >= 8) {
             // We know that packet size is the second int32_t from the start.
-            packetSize = *(uint32_t*)(readBuf.buf() + 4);
+            memcpy(&packetSize, readBuf.buf() + 4, sizeof(packetSize));
             if (!packetSize) {
                 // Emulator will get live-stuck here if packet size is read to be zero;
                 // crash right away so we can see these events.
@@ -370,6 +396,12 @@ intptr_t RenderThread::main() {
 
         int stat = 0;
         if (packetSize > readBuf.validData()) {
+            if (readBuf.hasExternalView()) {
+                // The packet continues past the zero-copy view; fall back to
+                // copying it together with the rest of the stream.
+                readBuf.endExternalView();
+                mRingStream->endZeroCopyRead();
+            }
             stat = readBuf.getData(ioStream, packetSize);
             if (stat <= 0) {
                 if (doSnapshotOperation(snapshotObjects, SnapshotState::StartSaving)) {
@@ -403,6 +435,9 @@ intptr_t RenderThread::main() {
                         stats_progressTimeUs / 1000.0f,
                         (float)dt);
                 readBuf.printStats();
+                if (mRingStream) {
+                    mRingStream->printStats();
+                }
                 stats_t0 = android::base::getHighResTimeUs() / 1000;
                 stats_progressTimeUs = 0;
                 stats_totalBytes = 0;
@@ -421,30 +456,25 @@ intptr_t RenderThread::main() {
         bool progress;
 
         do {
-            std::unique_ptr<EventHangMetadata::HangAnnotations> renderThreadData =
-                std::make_unique<EventHangMetadata::HangAnnotations>();
-
             const char* processName = nullptr;
             if (tInfo.m_processName) {
                 processName = tInfo.m_processName.value().c_str();
             }
 
+            // Annotations are only turned into strings if this actually hangs.
             auto* healthMonitor = FrameBuffer::getFB()->getHealthMonitor();
             if (healthMonitor) {
-                if (processName) {
-                    renderThreadData->insert(
-                        {{"renderthread_guest_process", processName}});
-                }
+                hangAnnotations.setProcessName(processName);
                 if (readBuf.validData() >= 4) {
-                    renderThreadData->insert(
-                        {{"first_opcode", std::to_string(*(uint32_t*)readBuf.buf())},
-                         {"buffer_length", std::to_string(readBuf.validData())}});
+                    hangAnnotations.setPacket(*(uint32_t*)readBuf.buf(), readBuf.validData());
                 }
             }
-            auto watchdog = WATCHDOG_BUILDER(healthMonitor, "RenderThread decode operation")
-                                .setHangType(EventHangMetadata::HangType::kRenderThread)
-                                .setAnnotations(std::move(renderThreadData))
-                                .build();
+            auto watchdog = healthMonitor
+                                ? WATCHDOG_BUILDER(healthMonitor, "RenderThread decode operation")
+                                      .setHangType(EventHangMetadata::HangType::kRenderThread)
+                                      .setOnHangCallback(hangAnnotations.getOnHangCallback())
+                                      .build()
+                                : nullptr;
 
             if (!processResources && tInfo.m_puid) {
                 processResources = FrameBuffer::getFB()->getProcessResources(tInfo.m_puid);
@@ -559,6 +589,13 @@ intptr_t RenderThread::main() {
             }
 
         } while (progress);
+
+        // Keep the xfers held while the rest of the view can still be staged.
+        if (readBuf.hasExternalView() &&
+            (readBuf.validData() || !readBuf.externalViewLeft())) {
+            readBuf.endExternalView();
+            mRingStream->endZeroCopyRead();
+        }
     }
 
     if (dumpFP) {
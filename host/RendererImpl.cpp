@@ -14,6 +14,7 @@
 #include "RendererImpl.h"
 
 #include <assert.h>
+#include <inttypes.h>
 
 #include <algorithm>
 #include <utility>
@@ -63,6 +64,9 @@ public:
             struct {
                 WorkerProcessingResult operator()(CleanProcessResources resources) {
                     FrameBuffer::getFB()->cleanupProcGLObjects(resources.puid);
+                    if (resources.resource) {
+                        logSequenceNumberStats(resources.puid, *resources.resource);
+                    }
                     // resources.resource are destroyed automatically when going out of the scope.
                     return WorkerProcessingResult::Continue;
                 }
@@ -95,6 +99,15 @@ public:
     }
 
 private:
+    static void logSequenceNumberStats(uint64_t puid, const ProcessResources& resources) {
+        const SequenceNumberOrdering::Stats stats =
+            resources.getSequenceNumberOrdering()->getStats();
+        if (!stats.waits) return;
+        INFO("Process %" PRIu64 " waited %" PRIu64 " times for its Vulkan command order (%" PRIu64
+             " slept), %" PRIu64 " us in total, %" PRIu64 " us at most.",
+             puid, stats.waits, stats.parkedWaits, stats.totalWaitUs, stats.maxWaitUs);
+    }
+
     struct CleanProcessResources {
         uint64_t puid;
         std::unique_ptr<ProcessResources> resource;
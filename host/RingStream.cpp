@@ -23,13 +23,41 @@
 #include "host-common/GfxstreamFatalError.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <memory.h>
 
+#include <algorithm>
+#include <atomic>
+
 using emugl::ABORT_REASON_OTHER;
 using emugl::FatalError;
 
 namespace gfxstream {
 
+namespace {
+
+// Bounds of the time readRaw() spins before parking in onUnavailableRead().
+constexpr uint64_t kMinReadSpinUs = 2;
+constexpr uint64_t kMaxReadSpinUs = 100;
+
+// commitBuffer() spins this long for the guest to make room in the from_host
+// ring, then sleeps with an exponential backoff up to kMaxCommitSleepUs.
+constexpr uint64_t kCommitSpinUs = 200;
+constexpr uint64_t kMinCommitSleepUs = 10;
+constexpr uint64_t kMaxCommitSleepUs = 1000;
+
+struct WaitCounters {
+    std::atomic<uint64_t> spinWaits{0};
+    std::atomic<uint64_t> parkedWaits{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> spinTimeUs{0};
+    std::atomic<uint64_t> commitBackoffs{0};
+};
+
+WaitCounters sWaitCounters;
+
+}  // namespace
+
 RingStream::RingStream(
     struct asg_context context,
     android::emulation::asg::ConsumerCallbacks callbacks,
@@ -51,14 +79,24 @@ void* RingStream::allocBuffer(size_t minSize) {
 }
 
 int RingStream::commitBuffer(size_t size) {
+    if (mZeroCopyXfersHeld) {
+        // Replies go through the same shared buffer as the xfers, which the
+        // decoder is still reading, and the guest only reads them once every
+        // type 1 xfer was consumed anyway.
+        mPendingReplies.insert(mPendingReplies.end(), mWriteBuffer.data(),
+                               mWriteBuffer.data() + size);
+        return size;
+    }
+    return writeToGuest(mWriteBuffer.data(), size);
+}
+
+int RingStream::writeToGuest(const char* data, size_t size) {
     size_t sent = 0;
-    auto data = mWriteBuffer.data();
 
-    size_t iters = 0;
+    uint64_t waitStartUs = 0;
+    uint64_t sleepUs = kMinCommitSleepUs;
     size_t backedOffIters = 0;
-    const size_t kBackoffIters = 10000000ULL;
     while (sent < size) {
-        ++iters;
         auto avail = ring_buffer_available_write(
             mContext.from_host_large_xfer.ring,
             &mContext.from_host_large_xfer.view);
@@ -67,16 +105,26 @@ int RingStream::commitBuffer(size_t size) {
         if (!avail) {
             if (*(mContext.host_state) == ASG_HOST_STATE_EXIT) {
                 return sent;
-            } else {
+            }
+
+            const uint64_t nowUs = android::base::getHighResTimeUs();
+            if (!waitStartUs) {
+                waitStartUs = nowUs;
+            }
+
+            if (nowUs - waitStartUs < kCommitSpinUs) {
                 ring_buffer_yield();
-                if (iters > kBackoffIters) {
-                    android::base::sleepUs(10);
-                    ++backedOffIters;
-                }
+            } else {
+                android::base::sleepUs(sleepUs);
+                sleepUs = std::min(sleepUs * 2, kMaxCommitSleepUs);
+                ++backedOffIters;
             }
             continue;
         }
 
+        waitStartUs = 0;
+        sleepUs = kMinCommitSleepUs;
+
         auto remaining = size - sent;
         auto todo = remaining < avail ? remaining : avail;
 
@@ -89,6 +137,7 @@ int RingStream::commitBuffer(size_t size) {
     }
 
     if (backedOffIters > 0) {
+        sWaitCounters.commitBackoffs.fetch_add(backedOffIters, std::memory_order_relaxed);
         fprintf(stderr, "%s: warning: backed off %zu times due to guest slowness.\n",
                 __func__,
                 backedOffIters);
@@ -97,6 +146,11 @@ int RingStream::commitBuffer(size_t size) {
 }
 
 const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
+    if (mZeroCopyReadActive) {
+        GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER))
+            << "readRaw() called before the zero-copy read was ended";
+    }
+
     size_t wanted = *inout_len;
     size_t count = 0U;
     auto dst = static_cast<char*>(buf);
@@ -104,8 +158,11 @@ const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
     uint32_t ringAvailable = 0;
     uint32_t ringLargeXferAvailable = 0;
 
-    const uint32_t maxSpins = 30;
-    uint32_t spins = 0;
+    // Spin for about as long as data has recently taken to show up, and park
+    // right away if the guest is idle.
+    const uint64_t spinBudgetUs = getReadSpinBudgetUs();
+    uint64_t waitStartUs = 0;
+    bool parked = false;
     bool inLargeXfer = true;
 
     *(mContext.host_state) = ASG_HOST_STATE_CAN_CONSUME;
@@ -151,6 +208,12 @@ const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
         auto current = dst + count;
         auto ptrEnd = dst + wanted;
 
+        if (waitStartUs && (ringAvailable || ringLargeXferAvailable)) {
+            onWaitFinished(android::base::getHighResTimeUs() - waitStartUs, parked);
+            waitStartUs = 0;
+            parked = false;
+        }
+
         if (ringAvailable) {
             inLargeXfer = false;
             uint32_t transferMode =
@@ -188,11 +251,14 @@ const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
                 inLargeXfer = false;
             }
 
-            if (++spins < maxSpins) {
+            const uint64_t nowUs = android::base::getHighResTimeUs();
+            if (!waitStartUs) {
+                waitStartUs = nowUs;
+            }
+
+            if (!parked && nowUs - waitStartUs < spinBudgetUs) {
                 ring_buffer_yield();
                 continue;
-            } else {
-                spins = 0;
             }
 
             if (mShouldExit) {
@@ -203,6 +269,12 @@ const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
                 return nullptr;
             }
 
+            if (!parked) {
+                sWaitCounters.spinTimeUs.fetch_add(nowUs - waitStartUs, std::memory_order_relaxed);
+                parked = true;
+            }
+            sWaitCounters.parks.fetch_add(1, std::memory_order_relaxed);
+
             int unavailReadResult = mCallbacks.onUnavailableRead();
 
             if (-1 == unavailReadResult) {
@@ -232,6 +304,67 @@ const unsigned char* RingStream::readRaw(void* buf, size_t* inout_len) {
     return (const unsigned char*)buf;
 }
 
+uint64_t RingStream::getReadSpinBudgetUs() const {
+    if (mAvgWaitUs > kMaxReadSpinUs) {
+        return kMinReadSpinUs;
+    }
+    return std::clamp<uint64_t>(2 * mAvgWaitUs, kMinReadSpinUs, kMaxReadSpinUs);
+}
+
+void RingStream::onWaitFinished(uint64_t waitUs, bool parked) {
+    // Exponential moving average of how long the guest takes to send more.
+    mAvgWaitUs = (7 * mAvgWaitUs + waitUs) / 8;
+
+    if (parked) {
+        ++mParkedWaits;
+        sWaitCounters.parkedWaits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        ++mSpinWaits;
+        sWaitCounters.spinWaits.fetch_add(1, std::memory_order_relaxed);
+        sWaitCounters.spinTimeUs.fetch_add(waitUs, std::memory_order_relaxed);
+    }
+}
+
+RingStream::WaitStats RingStream::getWaitStats() {
+    return {
+        .spinWaits = sWaitCounters.spinWaits.load(std::memory_order_relaxed),
+        .parkedWaits = sWaitCounters.parkedWaits.load(std::memory_order_relaxed),
+        .parks = sWaitCounters.parks.load(std::memory_order_relaxed),
+        .spinTimeUs = sWaitCounters.spinTimeUs.load(std::memory_order_relaxed),
+        .commitBackoffs = sWaitCounters.commitBackoffs.load(std::memory_order_relaxed),
+    };
+}
+
+void RingStream::printStats() {
+    printf("RingStream::%s: %zu reads, %zu bytes, %" PRIu64 " waits spun, %" PRIu64
+           " waits parked, average wait %" PRIu64 " us\n",
+           __func__, mXmits, mTotalRecv, mSpinWaits, mParkedWaits, mAvgWaitUs);
+    mXmits = 0;
+    mTotalRecv = 0;
+    mSpinWaits = 0;
+    mParkedWaits = 0;
+}
+
+// Copies the first |bytes| of pending descriptors out of |to_host|.
+//
+// ring_buffer_copy_contents() locates the end of a view-less ring using
+// |write_pos| instead of |read_pos|, so as soon as the pending descriptors wrap
+// around the end of |to_host| every descriptor past the first one is read from
+// beyond |buf|. That is what used to corrupt the stream when more than one xfer
+// was consumed per pass.
+static void copyType1Xfers(const struct ring_buffer* r, uint32_t bytes, uint8_t* dst) {
+    const uint32_t readPos =
+        __atomic_load_n(&r->read_pos, __ATOMIC_ACQUIRE) & (RING_BUFFER_SIZE - 1);
+    const uint32_t availableAtEnd = RING_BUFFER_SIZE - readPos;
+
+    if (bytes > availableAtEnd) {
+        memcpy(dst, &r->buf[readPos], availableAtEnd);
+        memcpy(dst + availableAtEnd, &r->buf[0], bytes - availableAtEnd);
+    } else {
+        memcpy(dst, &r->buf[readPos], bytes);
+    }
+}
+
 void RingStream::type1Read(
     uint32_t available,
     char* begin,
@@ -245,35 +378,129 @@ void RingStream::type1Read(
 
     auto xfersPtr = mType1Xfers.data();
 
-    ring_buffer_copy_contents(
-        mContext.to_host, 0, xferTotal * sizeof(struct asg_type1_xfer), (uint8_t*)xfersPtr);
+    copyType1Xfers(mContext.to_host, xferTotal * sizeof(struct asg_type1_xfer),
+                   (uint8_t*)xfersPtr);
+
+    // Drain every xfer that fits in the caller's buffer. The guest reuses the
+    // write buffer slot of an xfer as soon as it is popped off |to_host|, so
+    // the ring and |host_consumed_pos| are only advanced once all the copies
+    // of this pass are done.
+    uint32_t xfersConsumed = 0;
+    uint32_t bytesConsumed = 0;
 
     for (uint32_t i = 0; i < xferTotal; ++i) {
-        if (*current + xfersPtr[i].size > ptrEnd) {
+        const char* src = mContext.buffer + xfersPtr[i].offset;
+        const uint32_t size = xfersPtr[i].size;
+
+        if (*current + size > ptrEnd) {
             // Save in a temp buffer or we'll get stuck
             if (begin == *current && i == 0) {
-                const char* src = mContext.buffer + xfersPtr[i].offset;
-                mReadBuffer.resize_noinit(xfersPtr[i].size);
-                memcpy(mReadBuffer.data(), src, xfersPtr[i].size);
-                mReadBufferLeft = xfersPtr[i].size;
-                ring_buffer_advance_read(
-                        mContext.to_host, sizeof(struct asg_type1_xfer), 1);
-                __atomic_fetch_add(&mContext.ring_config->host_consumed_pos, xfersPtr[i].size, __ATOMIC_RELEASE);
+                mReadBuffer.resize_noinit(size);
+                memcpy(mReadBuffer.data(), src, size);
+                mReadBufferLeft = size;
+                ++xfersConsumed;
+                bytesConsumed += size;
             }
-            return;
+            break;
         }
-        const char* src = mContext.buffer + xfersPtr[i].offset;
-        memcpy(*current, src, xfersPtr[i].size);
-        ring_buffer_advance_read(
-                mContext.to_host, sizeof(struct asg_type1_xfer), 1);
-        __atomic_fetch_add(&mContext.ring_config->host_consumed_pos, xfersPtr[i].size, __ATOMIC_RELEASE);
-        *current += xfersPtr[i].size;
-        *count += xfersPtr[i].size;
 
-        // TODO: Figure out why running multiple xfers here can result in data
-        // corruption.
+        memcpy(*current, src, size);
+        *current += size;
+        *count += size;
+        ++xfersConsumed;
+        bytesConsumed += size;
+    }
+
+    if (!xfersConsumed) {
+        return;
+    }
+
+    ring_buffer_advance_read(
+            mContext.to_host, sizeof(struct asg_type1_xfer), xfersConsumed);
+    __atomic_fetch_add(&mContext.ring_config->host_consumed_pos, bytesConsumed, __ATOMIC_RELEASE);
+}
+
+const unsigned char* RingStream::beginZeroCopyRead(size_t* size) {
+    if (mZeroCopyReadActive) {
+        GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER)) << "nested zero-copy read";
+    }
+
+    if (mReadBufferLeft || mShouldExit) {
+        return nullptr;
+    }
+
+    if (1 != __atomic_load_n(&mContext.ring_config->transfer_mode, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+
+    uint32_t xferTotal = ring_buffer_available_read(mContext.to_host, 0) /
+                         sizeof(struct asg_type1_xfer);
+    if (!xferTotal) {
+        return nullptr;
+    }
+
+    if (mType1Xfers.size() < xferTotal) {
+        mType1Xfers.resize(xferTotal * 2);
+    }
+
+    auto xfersPtr = mType1Xfers.data();
+
+    copyType1Xfers(mContext.to_host, xferTotal * sizeof(struct asg_type1_xfer),
+                   (uint8_t*)xfersPtr);
+
+    const uint64_t bufferSize = mContext.ring_config->buffer_size;
+    const uint32_t begin = xfersPtr[0].offset;
+    uint64_t end = begin;
+    uint32_t xfers = 0;
+
+    for (uint32_t i = 0; i < xferTotal; ++i) {
+        if (xfersPtr[i].offset != end ||
+            end + xfersPtr[i].size > bufferSize) {
+            break;
+        }
+        end += xfersPtr[i].size;
+        ++xfers;
+    }
+
+    if (!xfers) {
+        return nullptr;
+    }
+
+    mZeroCopyReadActive = true;
+    mZeroCopyXfersHeld = xfers;
+    mZeroCopyBytesHeld = static_cast<uint32_t>(end - begin);
+
+    ++mXmits;
+    mTotalRecv += mZeroCopyBytesHeld;
+
+    *(mContext.host_state) = ASG_HOST_STATE_RENDERING;
+
+    *size = mZeroCopyBytesHeld;
+    return reinterpret_cast<const unsigned char*>(mContext.buffer + begin);
+}
+
+void RingStream::endZeroCopyRead() {
+    releaseZeroCopyXfers();
+    mZeroCopyReadActive = false;
+
+    if (!mPendingReplies.empty()) {
+        writeToGuest(mPendingReplies.data(), mPendingReplies.size());
+        mPendingReplies.clear();
+    }
+}
+
+void RingStream::releaseZeroCopyXfers() {
+    if (!mZeroCopyXfersHeld) {
         return;
     }
+
+    ring_buffer_advance_read(
+            mContext.to_host, sizeof(struct asg_type1_xfer), mZeroCopyXfersHeld);
+    __atomic_fetch_add(&mContext.ring_config->host_consumed_pos, mZeroCopyBytesHeld,
+                       __ATOMIC_RELEASE);
+
+    mZeroCopyXfersHeld = 0;
+    mZeroCopyBytesHeld = 0;
 }
 
 void RingStream::type2Read(
@@ -47,6 +47,30 @@ public:
 
     void printStats();
 
+    // Process-wide counters of how render threads wait for the guest.
+    struct WaitStats {
+        // Reads satisfied while spinning.
+        uint64_t spinWaits;
+        // Reads satisfied after parking in onUnavailableRead().
+        uint64_t parkedWaits;
+        // Calls to onUnavailableRead().
+        uint64_t parks;
+        // Time spent spinning before data arrived or the thread parked.
+        uint64_t spinTimeUs;
+        // Sleeps in commitBuffer() while the guest wasn't reading replies.
+        uint64_t commitBackoffs;
+    };
+    static WaitStats getWaitStats();
+
+    // Zero-copy reads: returns the pending type 1 xfers at the head of |to_host|
+    // that are contiguous in the shared buffer as a single view into it, or
+    // nullptr if there are none or previously staged data must be read first.
+    // The xfers stay on |to_host|, so the guest can't reuse their slots, until
+    // endZeroCopyRead(). Replies committed meanwhile are only written to the
+    // guest then, since they would overwrite the view.
+    const unsigned char* beginZeroCopyRead(size_t* size);
+    void endZeroCopyRead();
+
     void pausePreSnapshot() {
         mInSnapshotOperation = true;
     }
@@ -72,6 +96,10 @@ protected:
     void type1Read(uint32_t available, char* begin, size_t* count, char** current, const char* ptrEnd);
     void type2Read(uint32_t available, size_t* count, char** current, const char* ptrEnd);
     void type3Read(uint32_t available, size_t* count, char** current, const char* ptrEnd);
+    int writeToGuest(const char* data, size_t size);
+    void releaseZeroCopyXfers();
+    uint64_t getReadSpinBudgetUs() const;
+    void onWaitFinished(uint64_t waitUs, bool parked);
 
     struct asg_context mContext;
     android::emulation::asg::ConsumerCallbacks mCallbacks;
@@ -83,8 +111,16 @@ protected:
     RenderChannel::Buffer mWriteBuffer;
     size_t mReadBufferLeft = 0;
 
+    bool mZeroCopyReadActive = false;
+    uint32_t mZeroCopyXfersHeld = 0;
+    uint32_t mZeroCopyBytesHeld = 0;
+    std::vector<char> mPendingReplies;
+
     size_t mXmits = 0;
     size_t mTotalRecv = 0;
+    uint64_t mAvgWaitUs = 0;
+    uint64_t mSpinWaits = 0;
+    uint64_t mParkedWaits = 0;
     bool mBenchmarkEnabled = false;
     bool mShouldExit = false;
     bool mShouldExitForSnapshot = false;
@@ -0,0 +1,105 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "SequenceNumberOrdering.h"
+
+#include "aemu/base/system/System.h"
+
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
+#include <intrin.h>
+#endif
+
+namespace gfxstream {
+namespace {
+
+// Most of the time the previous command is already being executed by another
+// render thread and completes within a few microseconds; only go to sleep if
+// it doesn't.
+constexpr int kSpinIterations = 1024;
+
+inline void cpuRelax() {
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
+    _mm_pause();
+#elif (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+    __asm__ __volatile__("pause;");
+#endif
+}
+
+}  // namespace
+
+void SequenceNumberOrdering::waitForTurn(uint32_t seqno) {
+    if (isTurn(seqno)) return;
+
+    const uint64_t startUs = android::base::getHighResTimeUs();
+
+    for (int i = 0; i < kSpinIterations; ++i) {
+        cpuRelax();
+        if (isTurn(seqno)) {
+            recordWait(android::base::getHighResTimeUs() - startUs, false);
+            return;
+        }
+    }
+
+    // complete() checks |waiters| after bumping |mCurrent|, and we check
+    // |mCurrent| after bumping |waiters|. With both being sequentially
+    // consistent, either complete() sees us and notifies under the lock, or we
+    // see the new sequence number before going to sleep.
+    WaiterSlot& slot = mWaiterSlots[seqno % kNumWaiterSlots];
+    slot.waiters.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(slot.lock);
+        slot.cv.wait(lock, [this, seqno] { return isTurn(seqno); });
+    }
+    slot.waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    recordWait(android::base::getHighResTimeUs() - startUs, true);
+}
+
+void SequenceNumberOrdering::complete() {
+    const uint32_t next = mCurrent.fetch_add(1, std::memory_order_seq_cst) + 2;
+
+    WaiterSlot& slot = mWaiterSlots[next % kNumWaiterSlots];
+    if (slot.waiters.load(std::memory_order_seq_cst) == 0) return;
+
+    {
+        // Makes sure a waiter that saw the old sequence number is blocked in
+        // wait() before it gets notified.
+        std::lock_guard<std::mutex> lock(slot.lock);
+    }
+    // Slots are shared by sequence numbers that are kNumWaiterSlots apart.
+    slot.cv.notify_all();
+}
+
+SequenceNumberOrdering::Stats SequenceNumberOrdering::getStats() const {
+    Stats stats;
+    stats.waits = mWaits.load(std::memory_order_relaxed);
+    stats.parkedWaits = mParkedWaits.load(std::memory_order_relaxed);
+    stats.totalWaitUs = mTotalWaitUs.load(std::memory_order_relaxed);
+    stats.maxWaitUs = mMaxWaitUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SequenceNumberOrdering::recordWait(uint64_t waitUs, bool parked) {
+    mWaits.fetch_add(1, std::memory_order_relaxed);
+    if (parked) {
+        mParkedWaits.fetch_add(1, std::memory_order_relaxed);
+    }
+    mTotalWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+
+    uint64_t maxWaitUs = mMaxWaitUs.load(std::memory_order_relaxed);
+    while (waitUs > maxWaitUs &&
+           !mMaxWaitUs.compare_exchange_weak(maxWaitUs, waitUs, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace gfxstream
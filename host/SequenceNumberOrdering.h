@@ -0,0 +1,80 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace gfxstream {
+
+// Orders the Vulkan commands that a guest process sends over several render
+// threads, using the sequence number the guest attached to each command.
+//
+// A render thread whose command isn't next spins for a short while and then
+// goes to sleep. Completing a command only wakes up the thread that waits for
+// the command right after it, so render threads of a process that are far
+// behind don't burn CPU and aren't woken up for nothing.
+class SequenceNumberOrdering {
+   public:
+    struct Stats {
+        // Commands that weren't next when they were decoded.
+        uint64_t waits = 0;
+        // Of those, the ones that had to go to sleep.
+        uint64_t parkedWaits = 0;
+        uint64_t totalWaitUs = 0;
+        uint64_t maxWaitUs = 0;
+    };
+
+    SequenceNumberOrdering() = default;
+    SequenceNumberOrdering(const SequenceNumberOrdering&) = delete;
+    SequenceNumberOrdering& operator=(const SequenceNumberOrdering&) = delete;
+
+    // Blocks until the command right before |seqno| has been completed.
+    void waitForTurn(uint32_t seqno);
+
+    // Marks the command whose turn it is as completed.
+    void complete();
+
+    // Sequence number of the last completed command.
+    uint32_t current() const { return mCurrent.load(std::memory_order_seq_cst); }
+
+    Stats getStats() const;
+
+   private:
+    // Waiters are spread over a few slots keyed by the sequence number they
+    // wait for, so that a wakeup only concerns the waiter(s) of one slot.
+    static constexpr size_t kNumWaiterSlots = 64;
+
+    struct WaiterSlot {
+        std::atomic<uint32_t> waiters{0};
+        std::mutex lock;
+        std::condition_variable cv;
+    };
+
+    bool isTurn(uint32_t seqno) const { return seqno - current() == 1; }
+    void recordWait(uint64_t waitUs, bool parked);
+
+    std::atomic<uint32_t> mCurrent{0};
+    std::array<WaiterSlot, kNumWaiterSlots> mWaiterSlots;
+
+    std::atomic<uint64_t> mWaits{0};
+    std::atomic<uint64_t> mParkedWaits{0};
+    std::atomic<uint64_t> mTotalWaitUs{0};
+    std::atomic<uint64_t> mMaxWaitUs{0};
+};
+
+}  // namespace gfxstream
@@ -0,0 +1,96 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "VirtioGpuIovs.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace gfxstream {
+namespace {
+
+// Consecutive rows usually land in the same or the next few iovecs; only
+// binary search for rows further away.
+constexpr size_t kMaxLinearSteps = 4;
+
+}  // namespace
+
+VirtioGpuIovs::VirtioGpuIovs(const iovec* iovs, uint32_t numIovs) {
+    mEntries.reserve(numIovs);
+    for (uint32_t i = 0; i < numIovs; ++i) {
+        if (iovs[i].iov_len == 0) {
+            continue;
+        }
+        mEntries.push_back(Entry{
+            .base = static_cast<char*>(iovs[i].iov_base),
+            .size = iovs[i].iov_len,
+            .offset = mSize,
+        });
+        mSize += iovs[i].iov_len;
+    }
+}
+
+size_t VirtioGpuIovs::findEntry(size_t offset, size_t first) const {
+    for (size_t i = first; i < mEntries.size() && i < first + kMaxLinearSteps; ++i) {
+        if (offset < mEntries[i].offset + mEntries[i].size) {
+            return i;
+        }
+    }
+    auto it = std::upper_bound(mEntries.begin() + first, mEntries.end(), offset,
+                               [](size_t offset, const Entry& entry) {
+                                   return offset < entry.offset;
+                               });
+    return static_cast<size_t>(it - mEntries.begin()) - 1;
+}
+
+bool VirtioGpuIovs::copyRows(Direction direction, size_t offset, size_t rowSize, size_t stride,
+                             size_t numRows, void* linear) const {
+    return copyRowsAt(direction, offset, rowSize, stride, numRows, static_cast<char*>(linear), 0);
+}
+
+bool VirtioGpuIovs::copyRowsAt(Direction direction, size_t offset, size_t rowSize, size_t stride,
+                               size_t numRows, char* linear, size_t linearOffset) const {
+    if (numRows == 0 || rowSize == 0) {
+        return true;
+    }
+    if (offset > mSize || rowSize > mSize - offset ||
+        (numRows - 1) * stride > mSize - offset - rowSize) {
+        return false;
+    }
+
+    size_t entryIndex = 0;
+    for (size_t row = 0; row < numRows; ++row) {
+        size_t rowOffset = offset + row * stride;
+        size_t remaining = rowSize;
+        entryIndex = findEntry(rowOffset, entryIndex);
+        while (remaining > 0) {
+            const Entry& entry = mEntries[entryIndex];
+            const size_t offsetInEntry = rowOffset - entry.offset;
+            const size_t toCopy = std::min(remaining, entry.size - offsetInEntry);
+            if (direction == Direction::kIovsToLinear) {
+                memcpy(linear + (rowOffset - linearOffset), entry.base + offsetInEntry, toCopy);
+            } else {
+                memcpy(entry.base + offsetInEntry, linear + (rowOffset - linearOffset), toCopy);
+            }
+            rowOffset += toCopy;
+            remaining -= toCopy;
+            if (remaining > 0) {
+                ++entryIndex;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace gfxstream
@@ -0,0 +1,89 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#if defined(_WIN32)
+struct iovec {
+    void* iov_base; /* Starting address */
+    size_t iov_len; /* Length in bytes */
+};
+#else
+#include <sys/uio.h>
+#endif  // _WIN32
+
+namespace gfxstream {
+
+// The guest memory backing a virtio-gpu resource: a list of iovecs, which can
+// be long since guest RAM is not physically contiguous.
+//
+// Where each iovec starts in the resource is computed once, when the iovecs
+// are attached, so that a transfer finds the first iovec it touches with a
+// binary search instead of walking the whole list, and only copies the rows
+// of its box instead of the whole linear range they span.
+class VirtioGpuIovs {
+   public:
+    enum class Direction {
+        kIovsToLinear,
+        kLinearToIovs,
+    };
+
+    VirtioGpuIovs() = default;
+    VirtioGpuIovs(const iovec* iovs, uint32_t numIovs);
+
+    // Total size of the iovecs.
+    size_t size() const { return mSize; }
+
+    // Copies |numRows| rows of |rowSize| bytes, |stride| bytes apart and
+    // starting at |offset| in the resource, between the iovecs and the same
+    // offsets in |linear|. Returns false, without copying anything, if the
+    // rows don't fit in the iovecs.
+    bool copyRows(Direction direction, size_t offset, size_t rowSize, size_t stride,
+                  size_t numRows, void* linear) const;
+
+    bool copy(Direction direction, size_t offset, size_t size, void* linear) const {
+        return copyRows(direction, offset, size, size, 1, linear);
+    }
+
+    // Like copy(), but |data| only holds the |size| bytes starting at
+    // |offset| rather than the whole resource.
+    bool copyRange(Direction direction, size_t offset, size_t size, void* data) const {
+        return copyRowsAt(direction, offset, size, size, 1, static_cast<char*>(data), offset);
+    }
+
+   private:
+    struct Entry {
+        char* base;
+        size_t size;
+        // Offset of the iovec in the resource.
+        size_t offset;
+    };
+
+    // Index of the last entry starting at or before |offset|, looking no
+    // further back than |first|.
+    size_t findEntry(size_t offset, size_t first) const;
+
+    // Offset |offset| in the resource is at |linear| - |linearOffset|.
+    bool copyRowsAt(Direction direction, size_t offset, size_t rowSize, size_t stride,
+                    size_t numRows, char* linear, size_t linearOffset) const;
+
+    std::vector<Entry> mEntries;
+    size_t mSize = 0;
+};
+
+}  // namespace gfxstream
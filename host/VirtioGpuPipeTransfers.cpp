@@ -0,0 +1,254 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "VirtioGpuPipeTransfers.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "host-common/logging.h"
+
+namespace gfxstream {
+
+using android::base::AutoLock;
+
+VirtioGpuPipeTransfers::VirtioGpuPipeTransfers(const GoldfishPipeServiceOps* ops)
+    : mOps(ops), mThread([this]() -> intptr_t {
+          threadFunc();
+          return 0;
+      }) {
+    mThread.start();
+}
+
+VirtioGpuPipeTransfers::~VirtioGpuPipeTransfers() {
+    {
+        AutoLock lock(mLock);
+        mExiting = true;
+        mCv.broadcast();
+    }
+    mThread.wait();
+
+    for (auto& [hostPipe, transfers] : mPending) {
+        for (auto& transfer : transfers) {
+            transfer->callback(false, transfer->data);
+        }
+    }
+}
+
+bool VirtioGpuPipeTransfers::hasPending(GoldfishHostPipe* hostPipe) {
+    AutoLock lock(mLock);
+    return mPending.find(hostPipe) != mPending.end();
+}
+
+void VirtioGpuPipeTransfers::enqueue(Direction direction, GoldfishHostPipe* hostPipe,
+                                     uint32_t resourceId, std::vector<char> data, size_t done,
+                                     CompletionCallback callback) {
+    auto transfer = std::make_unique<Transfer>(Transfer{
+        .direction = direction,
+        .hostPipe = hostPipe,
+        .resourceId = resourceId,
+        .data = std::move(data),
+        .done = done,
+        .callback = std::move(callback),
+    });
+
+    AutoLock lock(mLock);
+    mPending[hostPipe].push_back(std::move(transfer));
+    ++mWakeCount;
+    mCv.broadcast();
+}
+
+void VirtioGpuPipeTransfers::wake() {
+    AutoLock lock(mLock);
+    ++mWakeCount;
+    mCv.broadcast();
+}
+
+template <class Matches>
+std::vector<std::unique_ptr<VirtioGpuPipeTransfers::Transfer>> VirtioGpuPipeTransfers::takeLocked(
+    Matches&& matches) {
+    // The worker keeps using the transfer it is attempting, and the ones whose
+    // callbacks it runs, without holding |mLock|.
+    auto busy = [&]() {
+        if (mBusyTransfer && matches(*mBusyTransfer)) {
+            return true;
+        }
+        return std::any_of(mFinished.begin(), mFinished.end(),
+                           [&](const auto& finished) { return matches(*finished.first); });
+    };
+    while (busy()) {
+        mCv.wait(&mLock);
+    }
+
+    std::vector<std::unique_ptr<Transfer>> taken;
+    for (auto it = mPending.begin(); it != mPending.end();) {
+        auto& transfers = it->second;
+        for (auto& transfer : transfers) {
+            if (matches(*transfer)) {
+                taken.push_back(std::move(transfer));
+            }
+        }
+        transfers.erase(std::remove(transfers.begin(), transfers.end(), nullptr),
+                        transfers.end());
+        if (transfers.empty()) {
+            it = mPending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return taken;
+}
+
+void VirtioGpuPipeTransfers::cancel(GoldfishHostPipe* hostPipe) {
+    std::vector<std::unique_ptr<Transfer>> cancelled;
+    {
+        AutoLock lock(mLock);
+        cancelled =
+            takeLocked([hostPipe](const Transfer& transfer) { return transfer.hostPipe == hostPipe; });
+    }
+
+    for (auto& transfer : cancelled) {
+        transfer->callback(false, transfer->data);
+    }
+}
+
+void VirtioGpuPipeTransfers::cancelResource(uint32_t resourceId) {
+    std::vector<std::unique_ptr<Transfer>> cancelled;
+    {
+        AutoLock lock(mLock);
+        cancelled = takeLocked(
+            [resourceId](const Transfer& transfer) { return transfer.resourceId == resourceId; });
+    }
+
+    for (auto& transfer : cancelled) {
+        transfer->callback(false, transfer->data);
+    }
+}
+
+VirtioGpuPipeTransfers::Progress VirtioGpuPipeTransfers::attempt(Transfer& transfer) {
+    GoldfishHostPipe* hostPipe = transfer.hostPipe;
+    bool moved = false;
+    while (transfer.done < transfer.data.size()) {
+        GoldfishPipeBuffer buf = {
+            transfer.data.data() + transfer.done,
+            transfer.data.size() - transfer.done,
+        };
+
+        int status;
+        if (transfer.direction == Direction::kRecv) {
+            status = mOps->guest_recv(hostPipe, &buf, 1);
+        } else {
+            // Only the first write to a pipe can reallocate it, and that one
+            // is done by the renderer before anything gets queued here.
+            GoldfishHostPipe* sendPipe = hostPipe;
+            status = mOps->guest_send(&sendPipe, &buf, 1);
+            if (sendPipe != hostPipe) {
+                ERR("Pipe %p was reallocated by a queued transfer", hostPipe);
+                return Progress::kFailed;
+            }
+        }
+
+        if (status > 0) {
+            transfer.done += status;
+            moved = true;
+        } else if (status == kPipeTryAgain) {
+            // The pipe signals the wake up right away if it became ready in
+            // the meantime.
+            mOps->guest_wake_on(hostPipe, transfer.direction == Direction::kRecv
+                                              ? GOLDFISH_PIPE_WAKE_READ
+                                              : GOLDFISH_PIPE_WAKE_WRITE);
+            return moved ? Progress::kPartial : Progress::kNone;
+        } else {
+            return Progress::kFailed;
+        }
+    }
+    return Progress::kCompleted;
+}
+
+void VirtioGpuPipeTransfers::threadFunc() {
+    std::vector<GoldfishHostPipe*> pipes;
+
+    AutoLock lock(mLock);
+    while (!mExiting) {
+        if (mPending.empty()) {
+            mCv.wait(&mLock);
+            continue;
+        }
+        const uint64_t wakeCount = mWakeCount;
+
+        // Only the transfer at the front of each pipe's queue can make
+        // progress. |mPending| may change while unlocked, so go over a copy
+        // of its keys.
+        pipes.clear();
+        for (const auto& [hostPipe, transfers] : mPending) {
+            pipes.push_back(hostPipe);
+        }
+
+        bool progressed = false;
+        for (GoldfishHostPipe* hostPipe : pipes) {
+            auto it = mPending.find(hostPipe);
+            if (it == mPending.end()) {
+                continue;
+            }
+            Transfer* transfer = it->second.front().get();
+
+            mBusyTransfer = transfer;
+            lock.unlock();
+            const Progress progress = attempt(*transfer);
+            lock.lock();
+            mBusyTransfer = nullptr;
+            mCv.broadcast();
+
+            if (progress == Progress::kNone) {
+                continue;
+            }
+            progressed = true;
+            if (progress == Progress::kPartial) {
+                continue;
+            }
+
+            // Cancelling waits for |mBusyTransfer|, so the transfer is still at
+            // the front of the queue.
+            it = mPending.find(hostPipe);
+            mFinished.emplace_back(std::move(it->second.front()),
+                                  progress == Progress::kCompleted);
+            it->second.pop_front();
+            if (it->second.empty()) {
+                mPending.erase(it);
+            }
+        }
+
+        if (!mFinished.empty()) {
+            // Cancelling waits for these too, so nothing else touches them.
+            lock.unlock();
+            for (auto& [transfer, ok] : mFinished) {
+                transfer->callback(ok, transfer->data);
+            }
+            lock.lock();
+            mFinished.clear();
+            mCv.broadcast();
+        }
+
+        if (progressed) {
+            continue;
+        }
+
+        // Nothing could move. Sleep until a pipe signals it is ready, or more
+        // transfers get queued.
+        while (!mExiting && mWakeCount == wakeCount) {
+            mCv.wait(&mLock);
+        }
+    }
+}
+
+}  // namespace gfxstream
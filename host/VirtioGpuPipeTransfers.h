@@ -0,0 +1,127 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "aemu/base/synchronization/ConditionVariable.h"
+#include "aemu/base/synchronization/Lock.h"
+#include "aemu/base/threads/FunctorThread.h"
+#include "host-common/goldfish_pipe.h"
+
+namespace gfxstream {
+
+// Returned by guest_recv() and guest_send() when the pipe can't move any
+// bytes right now.
+constexpr int kPipeTryAgain = -2;
+
+// Pipe transfers that could not complete right away because the pipe service
+// was not ready to produce or consume the bytes.
+//
+// Rather than retrying on the virtio-gpu command thread, which would keep it
+// busy and stall every other context, such transfers are handed over to a
+// worker thread. The worker asks the pipe to wake up when it can make progress
+// and sleeps until wake() is called, then retries until the transfer
+// completes and runs its completion callback. Transfers on the same pipe
+// complete in the order they were queued.
+class VirtioGpuPipeTransfers {
+   public:
+    enum class Direction {
+        kRecv,
+        kSend,
+    };
+
+    // Called from the worker thread with whether the transfer completed, and
+    // the transfer buffer.
+    using CompletionCallback = std::function<void(bool ok, std::vector<char>& data)>;
+
+    explicit VirtioGpuPipeTransfers(const GoldfishPipeServiceOps* ops);
+    ~VirtioGpuPipeTransfers();
+
+    // Whether |hostPipe| has queued transfers. New transfers on such a pipe
+    // must be queued behind them instead of being attempted right away.
+    bool hasPending(GoldfishHostPipe* hostPipe);
+
+    // Queues moving the bytes of |data| from |done| on between |hostPipe| and
+    // |data|: received bytes are stored there and sent bytes are taken from
+    // there. |resourceId|, if not 0, is the resource whose memory |callback|
+    // writes to.
+    void enqueue(Direction direction, GoldfishHostPipe* hostPipe, uint32_t resourceId,
+                 std::vector<char> data, size_t done, CompletionCallback callback);
+
+    // Retries the queued transfers. Called when a pipe signals the wake up
+    // its transfers asked for.
+    void wake();
+
+    // Fails the queued transfers of |hostPipe|, so that it can be closed.
+    // Waits for an attempt in progress on the pipe, and for the callbacks of
+    // its transfers that already completed, to finish.
+    void cancel(GoldfishHostPipe* hostPipe);
+
+    // Fails the queued transfers into the memory of |resourceId|, so that the
+    // memory can be released, and waits like cancel().
+    void cancelResource(uint32_t resourceId);
+
+   private:
+    struct Transfer {
+        Direction direction;
+        GoldfishHostPipe* hostPipe;
+        uint32_t resourceId;
+        std::vector<char> data;
+        size_t done;
+        CompletionCallback callback;
+    };
+
+    enum class Progress {
+        kNone,
+        kPartial,
+        kCompleted,
+        kFailed,
+    };
+
+    // Moves as many bytes as the pipe takes without blocking.
+    Progress attempt(Transfer& transfer);
+    void threadFunc();
+
+    // Removes the queued transfers |matches| returns true for, once the
+    // worker is done with them.
+    template <class Matches>
+    std::vector<std::unique_ptr<Transfer>> takeLocked(Matches&& matches);
+
+    const GoldfishPipeServiceOps* mOps;
+
+    android::base::Lock mLock;
+    android::base::ConditionVariable mCv;
+    std::unordered_map<GoldfishHostPipe*, std::deque<std::unique_ptr<Transfer>>> mPending;
+    // The transfer the worker is attempting outside of |mLock|.
+    Transfer* mBusyTransfer = nullptr;
+    // The transfers whose callbacks the worker is running outside of |mLock|.
+    std::vector<std::pair<std::unique_ptr<Transfer>, bool>> mFinished;
+    // Bumped by wake() and enqueue(), so that the worker doesn't miss a wake
+    // up that comes while it is attempting the transfers.
+    uint64_t mWakeCount = 0;
+    bool mExiting = false;
+
+    android::base::FunctorThread mThread;
+};
+
+}  // namespace gfxstream
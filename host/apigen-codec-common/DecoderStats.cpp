@@ -0,0 +1,211 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "DecoderStats.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include "aemu/base/synchronization/Lock.h"
+
+namespace gfxstream {
+namespace {
+
+using android::base::AutoLock;
+using android::base::Lock;
+
+// A thread can record up to kTableSize distinct opcodes. Vulkan opcodes are
+// spread over a wide range, so they are hashed into the table.
+constexpr uint32_t kTableBits = 9;
+constexpr uint32_t kTableSize = 1u << kTableBits;
+
+struct Slot {
+    // kOtherOpcodes while the slot is unused.
+    std::atomic<uint32_t> opcode{DecoderStats::kOtherOpcodes};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> buckets[DecoderStats::kNumBuckets] = {};
+};
+
+// Only written by its thread, so the counters are updated without atomic
+// read-modify-writes. They are atomics for collect() to read them.
+struct ThreadTable {
+    // The reset() generation the counters belong to.
+    std::atomic<uint64_t> generation{0};
+    Slot slots[kTableSize];
+    Slot other;
+};
+
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void clear(Slot& slot) {
+    slot.opcode.store(DecoderStats::kOtherOpcodes, std::memory_order_relaxed);
+    slot.count.store(0, std::memory_order_relaxed);
+    slot.totalNs.store(0, std::memory_order_relaxed);
+    for (auto& bucket : slot.buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void addTo(std::unordered_map<uint32_t, DecoderStats::OpcodeStats>& stats, uint32_t opcode,
+           const Slot& slot) {
+    const uint64_t count = slot.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return;
+    }
+    DecoderStats::OpcodeStats& opcodeStats = stats[opcode];
+    opcodeStats.opcode = opcode;
+    opcodeStats.count += count;
+    opcodeStats.totalNs += slot.totalNs.load(std::memory_order_relaxed);
+    for (int i = 0; i < DecoderStats::kNumBuckets; ++i) {
+        opcodeStats.buckets[i] += slot.buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+void addTo(std::unordered_map<uint32_t, DecoderStats::OpcodeStats>& stats,
+           const ThreadTable& table) {
+    for (const Slot& slot : table.slots) {
+        const uint32_t opcode = slot.opcode.load(std::memory_order_acquire);
+        if (opcode != DecoderStats::kOtherOpcodes) {
+            addTo(stats, opcode, slot);
+        }
+    }
+    addTo(stats, DecoderStats::kOtherOpcodes, table.other);
+}
+
+struct Registry {
+    Lock lock;
+    std::vector<ThreadTable*> tables;
+    // What the threads that exited recorded in the current generation.
+    std::unordered_map<uint32_t, DecoderStats::OpcodeStats> retired;
+    std::atomic<uint64_t> generation{1};
+};
+
+Registry& registry() {
+    // Leaked, as threads may still exit after static destructors ran.
+    static Registry* sRegistry = new Registry;
+    return *sRegistry;
+}
+
+class ThreadTableHolder {
+   public:
+    ~ThreadTableHolder() {
+        if (!mTable) {
+            return;
+        }
+        Registry& reg = registry();
+        AutoLock lock(reg.lock);
+        if (mTable->generation.load(std::memory_order_relaxed) ==
+            reg.generation.load(std::memory_order_relaxed)) {
+            addTo(reg.retired, *mTable);
+        }
+        reg.tables.erase(std::find(reg.tables.begin(), reg.tables.end(), mTable.get()));
+    }
+
+    ThreadTable* get() {
+        if (!mTable) {
+            mTable = std::make_unique<ThreadTable>();
+            Registry& reg = registry();
+            AutoLock lock(reg.lock);
+            reg.tables.push_back(mTable.get());
+        }
+        return mTable.get();
+    }
+
+   private:
+    std::unique_ptr<ThreadTable> mTable;
+};
+
+thread_local ThreadTableHolder tThreadTable;
+
+Slot& findSlot(ThreadTable& table, uint32_t opcode) {
+    if (opcode == DecoderStats::kOtherOpcodes) {
+        return table.other;
+    }
+    uint32_t index = (opcode * 0x9E3779B1u) >> (32 - kTableBits);
+    for (uint32_t probe = 0; probe < kTableSize; ++probe, ++index) {
+        Slot& slot = table.slots[index & (kTableSize - 1)];
+        const uint32_t slotOpcode = slot.opcode.load(std::memory_order_relaxed);
+        if (slotOpcode == opcode) {
+            return slot;
+        }
+        if (slotOpcode == DecoderStats::kOtherOpcodes) {
+            // The counters are still zero, so readers may see it right away.
+            slot.opcode.store(opcode, std::memory_order_release);
+            return slot;
+        }
+    }
+    return table.other;
+}
+
+}  // namespace
+
+std::atomic<bool> DecoderStats::sEnabled{false};
+
+void DecoderStats::record(uint32_t opcode, uint64_t durationNs) {
+    ThreadTable& table = *tThreadTable.get();
+
+    // reset() doesn't touch the tables of the other threads, which are only
+    // written by their own thread. Each one clears its own the next time it
+    // records, and collect() ignores it until then.
+    const uint64_t generation = registry().generation.load(std::memory_order_relaxed);
+    if (table.generation.load(std::memory_order_relaxed) != generation) {
+        for (Slot& slot : table.slots) {
+            clear(slot);
+        }
+        clear(table.other);
+        table.generation.store(generation, std::memory_order_release);
+    }
+
+    Slot& slot = findSlot(table, opcode);
+    add(slot.count, 1);
+    add(slot.totalNs, durationNs);
+    add(slot.buckets[bucketOf(durationNs)], 1);
+}
+
+std::vector<DecoderStats::OpcodeStats> DecoderStats::collect() {
+    Registry& reg = registry();
+    std::unordered_map<uint32_t, OpcodeStats> stats;
+    {
+        AutoLock lock(reg.lock);
+        const uint64_t generation = reg.generation.load(std::memory_order_relaxed);
+        stats = reg.retired;
+        for (const ThreadTable* table : reg.tables) {
+            if (table->generation.load(std::memory_order_acquire) == generation) {
+                addTo(stats, *table);
+            }
+        }
+    }
+
+    std::vector<OpcodeStats> result;
+    result.reserve(stats.size());
+    for (const auto& [opcode, opcodeStats] : stats) {
+        result.push_back(opcodeStats);
+    }
+    std::sort(result.begin(), result.end(), [](const OpcodeStats& a, const OpcodeStats& b) {
+        return a.totalNs != b.totalNs ? a.totalNs > b.totalNs : a.opcode < b.opcode;
+    });
+    return result;
+}
+
+void DecoderStats::reset() {
+    Registry& reg = registry();
+    AutoLock lock(reg.lock);
+    reg.generation.fetch_add(1, std::memory_order_relaxed);
+    reg.retired.clear();
+}
+
+}  // namespace gfxstream
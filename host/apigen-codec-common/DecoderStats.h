@@ -0,0 +1,101 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace gfxstream {
+
+// Call counts and latency histograms of the commands executed by the
+// generated decoders, per opcode.
+//
+// Collection is off by default. Once enabled, the decoders time every command
+// they execute and record it in a table owned by the decoding thread, so
+// recording takes no locks and never writes to memory shared with another
+// writer. collect() adds up the tables of all the threads on demand.
+//
+// The generated decoders use it as:
+//
+//     const uint64_t statsStartNs = DecoderStats::start();
+//     switch (opcode) { ... }
+//     DecoderStats::finish(opcode, statsStartNs);
+class DecoderStats {
+   public:
+    static constexpr int kNumBuckets = 32;
+    // Commands decoded by a thread whose table is full are recorded under
+    // this opcode, which none of the decoders use.
+    static constexpr uint32_t kOtherOpcodes = 0;
+
+    struct OpcodeStats {
+        uint32_t opcode = 0;
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        // buckets[i] counts the commands that took [2^i, 2^(i+1))ns. The first
+        // one also counts those under 1ns, and the last one the longer ones.
+        uint64_t buckets[kNumBuckets] = {};
+    };
+
+    static void setEnabled(bool enabled) { sEnabled.store(enabled, std::memory_order_relaxed); }
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // Returns the time a command starts executing, or 0 if collection is
+    // disabled, in which case finish() doesn't record it.
+    static uint64_t start() { return isEnabled() ? nowNs() : 0; }
+    static void finish(uint32_t opcode, uint64_t startNs) {
+        if (startNs) {
+            record(opcode, nowNs() - startNs);
+        }
+    }
+
+    // Records that the calling thread executed |opcode| in |durationNs|.
+    static void record(uint32_t opcode, uint64_t durationNs);
+
+    // The stats of every opcode executed since the last reset(), by all the
+    // threads, sorted by decreasing total time. Can be called while threads
+    // are recording; it then misses some of the commands in progress.
+    static std::vector<OpcodeStats> collect();
+
+    // Forgets what was recorded so far.
+    static void reset();
+
+    static int bucketOf(uint64_t durationNs) {
+        if (durationNs < 2) {
+            return 0;
+        }
+#if defined(_MSC_VER)
+        int bucket = 0;
+        while (durationNs >>= 1) {
+            ++bucket;
+        }
+#else
+        const int bucket = 63 - __builtin_clzll(durationNs);
+#endif
+        return bucket < kNumBuckets ? bucket : kNumBuckets - 1;
+    }
+
+   private:
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static std::atomic<bool> sEnabled;
+};
+
+}  // namespace gfxstream
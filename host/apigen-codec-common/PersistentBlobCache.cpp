@@ -0,0 +1,501 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "PersistentBlobCache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "host-common/logging.h"
+
+namespace gfxstream {
+namespace {
+
+// The file starts with a FileHeader and the identity, followed by the entries, each of them an
+// EntryHeader, the key and the value. The checksum of the header covers all but the values, which
+// have their own.
+constexpr char kMagic[8] = {'G', 'F', 'X', 'B', 'L', 'O', 'B', 'S'};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t identitySize;
+    uint64_t numEntries;
+    uint64_t fileSize;
+    uint64_t indexChecksum;
+};
+
+struct EntryHeader {
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint64_t valueChecksum;
+};
+
+// How long to wait at most before retrying to write a file that couldn't be, doubling from the
+// writeback delay each time.
+constexpr std::chrono::milliseconds kMaxRetryDelay = std::chrono::minutes(1);
+
+// Only meant to catch corrupted files, and fast enough not to slow loading down.
+uint64_t checksum(const void* data, size_t size, uint64_t seed = 0) {
+    constexpr uint64_t kPrime = 0x100000001b3ull;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (size * 0x9e3779b97f4a7c15ull);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        h = (h ^ word) * kPrime;
+        h ^= h >> 29;
+    }
+    for (; i < size; i++) {
+        h = (h ^ bytes[i]) * kPrime;
+    }
+    return h ^ (h >> 32);
+}
+
+// A read-only mapping of a whole file.
+class MappedFile {
+   public:
+    static std::shared_ptr<MappedFile> open(const std::string& path) {
+#ifdef _WIN32
+        // Sharing deletion lets the file be renamed while mapped.
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return nullptr;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            return nullptr;
+        }
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data) {
+            return nullptr;
+        }
+        return std::shared_ptr<MappedFile>(
+            new MappedFile(static_cast<const uint8_t*>(data), size.QuadPart));
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        return std::shared_ptr<MappedFile>(
+            new MappedFile(static_cast<const uint8_t*>(data), st.st_size));
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+    }
+
+    const uint8_t* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+   private:
+    MappedFile(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+    const uint8_t* const mData;
+    const size_t mSize;
+};
+
+bool syncAndClose(FILE* file) {
+    bool ok = fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    return fclose(file) == 0 && ok;
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+std::string makePath(const PersistentBlobCache::Options& options) {
+    if (options.directory.empty()) {
+        return "";
+    }
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%016llx.bin",
+             static_cast<unsigned long long>(
+                 checksum(options.identity.data(), options.identity.size())));
+    return options.directory + "/" + options.name + suffix;
+}
+
+}  // namespace
+
+PersistentBlobCache::PersistentBlobCache(Options options)
+    : mPath(makePath(options)),
+      mIdentity(std::move(options.identity)),
+      mMaxBytes(options.maxBytes),
+      mWritebackDelay(options.writebackDelay) {
+    if (mPath.empty()) {
+        return;
+    }
+    load();
+    mWritebackThread = std::thread([this] { writebackLoop(); });
+}
+
+PersistentBlobCache::~PersistentBlobCache() {
+    if (!mWritebackThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mDirtyCv.notify_one();
+    mWritebackThread.join();
+    write();
+}
+
+void PersistentBlobCache::set(const void* key, size_t keySize, const void* value,
+                              size_t valueSize) {
+    if (keySize + valueSize > mMaxBytes || keySize > UINT32_MAX || valueSize > UINT32_MAX) {
+        return;
+    }
+    std::string keyString(static_cast<const char*>(key), keySize);
+    auto copy = std::make_shared<std::vector<uint8_t>>(static_cast<const uint8_t*>(value),
+                                                       static_cast<const uint8_t*>(value) +
+                                                           valueSize);
+    const uint64_t valueChecksum = checksum(value, valueSize);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mIndex.find(keyString);
+        if (it != mIndex.end()) {
+            const Entry& entry = *it->second;
+            // Drivers set the blobs they got again: don't write the file for nothing.
+            if (entry.size == valueSize && entry.checksum == valueChecksum &&
+                memcmp(entry.data, value, valueSize) == 0) {
+                mLru.splice(mLru.begin(), mLru, it->second);
+                return;
+            }
+            eraseLocked(it->second);
+        }
+        const uint8_t* data = copy->data();
+        mLru.push_front({
+            .key = keyString,
+            .storage = std::move(copy),
+            .data = data,
+            .size = valueSize,
+            .checksum = valueChecksum,
+            .verified = true,
+            .version = mNextVersion++,
+        });
+        mIndex.emplace(std::move(keyString), mLru.begin());
+        mSizeBytes += keySize + valueSize;
+        evictLocked();
+        if (mPath.empty()) {
+            return;
+        }
+        mDirty = true;
+    }
+    mDirtyCv.notify_one();
+}
+
+size_t PersistentBlobCache::get(const void* key, size_t keySize, void* value, size_t valueSize) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mIndex.find(std::string(static_cast<const char*>(key), keySize));
+    if (it == mIndex.end()) {
+        return 0;
+    }
+    Entry& entry = *it->second;
+    if (!entry.verified) {
+        if (checksum(entry.data, entry.size) != entry.checksum) {
+            WARN("Dropping corrupted entry of %s", mPath.c_str());
+            eraseLocked(it->second);
+            return 0;
+        }
+        entry.verified = true;
+    }
+    mLru.splice(mLru.begin(), mLru, it->second);
+    if (entry.size <= valueSize) {
+        memcpy(value, entry.data, entry.size);
+    }
+    return entry.size;
+}
+
+bool PersistentBlobCache::flush() {
+    if (mPath.empty()) {
+        return false;
+    }
+    return write();
+}
+
+size_t PersistentBlobCache::numEntries() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLru.size();
+}
+
+size_t PersistentBlobCache::sizeBytes() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSizeBytes;
+}
+
+void PersistentBlobCache::load() {
+    std::shared_ptr<MappedFile> file = MappedFile::open(mPath);
+    if (!file) {
+        return;
+    }
+    const uint8_t* const begin = file->data();
+    const uint8_t* const end = begin + file->size();
+
+    FileHeader header;
+    if (file->size() < sizeof(header)) {
+        WARN("Ignoring truncated %s", mPath.c_str());
+        return;
+    }
+    memcpy(&header, begin, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion) {
+        INFO("Ignoring %s, of another format version", mPath.c_str());
+        return;
+    }
+    const uint8_t* p = begin + sizeof(header);
+    if (header.fileSize != file->size() || header.identitySize != mIdentity.size() ||
+        size_t(end - p) < header.identitySize) {
+        WARN("Ignoring truncated %s", mPath.c_str());
+        return;
+    }
+    if (memcmp(p, mIdentity.data(), mIdentity.size()) != 0) {
+        INFO("Ignoring %s, of another identity", mPath.c_str());
+        return;
+    }
+    uint64_t indexChecksum = checksum(p, header.identitySize);
+    p += header.identitySize;
+
+    EntryList entries;
+    size_t sizeBytes = 0;
+    for (uint64_t i = 0; i < header.numEntries; i++) {
+        EntryHeader entryHeader;
+        if (size_t(end - p) < sizeof(entryHeader)) {
+            break;
+        }
+        memcpy(&entryHeader, p, sizeof(entryHeader));
+        indexChecksum = checksum(p, sizeof(entryHeader), indexChecksum);
+        p += sizeof(entryHeader);
+        if (size_t(end - p) < uint64_t(entryHeader.keySize) + entryHeader.valueSize) {
+            break;
+        }
+        indexChecksum = checksum(p, entryHeader.keySize, indexChecksum);
+        entries.push_back({
+            .key = std::string(reinterpret_cast<const char*>(p), entryHeader.keySize),
+            .storage = file,
+            .data = p + entryHeader.keySize,
+            .size = entryHeader.valueSize,
+            .checksum = entryHeader.valueChecksum,
+            .verified = false,
+            .version = mNextVersion++,
+        });
+        p += entryHeader.keySize + entryHeader.valueSize;
+        sizeBytes += entryHeader.keySize + entryHeader.valueSize;
+    }
+    if (entries.size() != header.numEntries || p != end || indexChecksum != header.indexChecksum) {
+        WARN("Ignoring corrupted %s", mPath.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLru = std::move(entries);
+    for (auto it = mLru.begin(); it != mLru.end(); ++it) {
+        mIndex[it->key] = it;
+    }
+    mSizeBytes = sizeBytes;
+    evictLocked();
+}
+
+bool PersistentBlobCache::write() {
+    std::lock_guard<std::mutex> writeLock(mWriteMutex);
+
+    struct WrittenEntry {
+        Entry entry;
+        size_t offset;
+    };
+    std::vector<WrittenEntry> written;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mDirty) {
+            return true;
+        }
+        mDirty = false;
+        written.reserve(mLru.size());
+        for (const Entry& entry : mLru) {
+            written.push_back({entry, 0});
+        }
+    }
+
+    // A name of its own, in case other processes write the same file.
+    std::random_device random;
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", random(), random());
+    const std::string tmpPath = mPath + suffix;
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        WARN("Failed to create %s", tmpPath.c_str());
+        markDirty();
+        return false;
+    }
+
+    FileHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.identitySize = mIdentity.size();
+    header.indexChecksum = checksum(mIdentity.data(), mIdentity.size());
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(mIdentity.data(), 1, mIdentity.size(), file) == mIdentity.size();
+    size_t offset = sizeof(header) + mIdentity.size();
+    for (WrittenEntry& w : written) {
+        // Don't spread the corruption of values never looked up.
+        if (!w.entry.verified && checksum(w.entry.data, w.entry.size) != w.entry.checksum) {
+            continue;
+        }
+        const EntryHeader entryHeader = {
+            .keySize = static_cast<uint32_t>(w.entry.key.size()),
+            .valueSize = static_cast<uint32_t>(w.entry.size),
+            .valueChecksum = w.entry.checksum,
+        };
+        header.indexChecksum = checksum(&entryHeader, sizeof(entryHeader), header.indexChecksum);
+        header.indexChecksum =
+            checksum(w.entry.key.data(), w.entry.key.size(), header.indexChecksum);
+        ok = ok && fwrite(&entryHeader, sizeof(entryHeader), 1, file) == 1 &&
+             fwrite(w.entry.key.data(), 1, w.entry.key.size(), file) == w.entry.key.size() &&
+             fwrite(w.entry.data, 1, w.entry.size, file) == w.entry.size;
+        w.offset = offset + sizeof(entryHeader) + w.entry.key.size();
+        offset = w.offset + w.entry.size;
+        header.numEntries++;
+    }
+    header.fileSize = offset;
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = syncAndClose(file) && ok;
+    std::shared_ptr<MappedFile> mapped = ok ? MappedFile::open(tmpPath) : nullptr;
+    if (!mapped || mapped->size() != offset) {
+        WARN("Failed to write %s", tmpPath.c_str());
+        remove(tmpPath.c_str());
+        markDirty();
+        return false;
+    }
+
+    // Read the values that didn't change since from the new file, and let go of the copies and of
+    // the old file.
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const WrittenEntry& w : written) {
+            auto it = mIndex.find(w.entry.key);
+            if (it == mIndex.end() || it->second->version != w.entry.version) {
+                continue;
+            }
+            if (w.offset == 0) {
+                // It was corrupted.
+                eraseLocked(it->second);
+                continue;
+            }
+            it->second->storage = mapped;
+            it->second->data = mapped->data() + w.offset;
+            it->second->verified = true;
+        }
+    }
+    written.clear();
+
+    if (!mOrphanPath.empty()) {
+        remove(mOrphanPath.c_str());
+        mOrphanPath.clear();
+    }
+    if (!replaceFile(tmpPath, mPath)) {
+        // Another process may be using it. The values are read from the new file meanwhile.
+        WARN("Failed to replace %s", mPath.c_str());
+        mOrphanPath = tmpPath;
+        markDirty();
+        return false;
+    }
+    return true;
+}
+
+void PersistentBlobCache::markDirty() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirty = true;
+}
+
+void PersistentBlobCache::writebackLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::chrono::milliseconds delay = mWritebackDelay;
+    while (true) {
+        mDirtyCv.wait(lock, [this] { return mDirty || mStopping; });
+        if (mStopping) {
+            return;
+        }
+        mDirtyCv.wait_for(lock, delay, [this] { return mStopping; });
+        lock.unlock();
+        const bool written = write();
+        lock.lock();
+        // A failed write left the cache dirty. Retry it less and less often, as the disk may be
+        // full or the directory read-only.
+        delay = written ? mWritebackDelay
+                        : std::min(std::max(delay * 2, std::chrono::milliseconds(1)),
+                                   kMaxRetryDelay);
+    }
+}
+
+void PersistentBlobCache::eraseLocked(EntryList::iterator it) {
+    mSizeBytes -= it->key.size() + it->size;
+    mIndex.erase(it->key);
+    mLru.erase(it);
+}
+
+void PersistentBlobCache::evictLocked() {
+    while (mSizeBytes > mMaxBytes) {
+        eraseLocked(std::prev(mLru.end()));
+        mDirty = !mPath.empty();
+    }
+}
+
+}  // namespace gfxstream
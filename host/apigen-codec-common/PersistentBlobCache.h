@@ -0,0 +1,124 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace gfxstream {
+
+// A key/value cache of opaque blobs, such as compiled shaders, which can be persisted to a file to
+// survive restarts.
+//
+// Loading the file maps it and indexes its entries, whose values are only read, and checked
+// against their checksums, when looked up. Changes are made in memory, and a background thread
+// writes the whole cache to a new file shortly after, which then replaces the old one: a crash at
+// any point, or another process writing the same file, leaves a complete file behind. A file of
+// another format version or identity, or which doesn't check out, is ignored and replaced.
+//
+// It is safe to use from any thread.
+class PersistentBlobCache {
+   public:
+    struct Options {
+        // The directory to persist the cache to, or empty to keep it in memory only.
+        std::string directory;
+        // The name of the file, to which a hash of |identity| is appended.
+        std::string name;
+        // What produced the blobs, such as the driver and its version, which can't use the blobs
+        // of another. Each identity gets its own file.
+        std::string identity;
+        // The least recently used entries are evicted to keep the keys and values below this size.
+        size_t maxBytes = 32 * 1024 * 1024;
+        // How long to wait after a change before writing the file, to write bursts of changes at
+        // once.
+        std::chrono::milliseconds writebackDelay = std::chrono::seconds(1);
+    };
+
+    static constexpr uint32_t kFormatVersion = 1;
+
+    explicit PersistentBlobCache(Options options);
+    // Writes the changes that weren't yet.
+    ~PersistentBlobCache();
+
+    void set(const void* key, size_t keySize, const void* value, size_t valueSize);
+
+    // Copies the value of |key| to |value| if it fits in its |valueSize| bytes, and returns the
+    // size of the value, or 0 if there is none.
+    size_t get(const void* key, size_t keySize, void* value, size_t valueSize);
+
+    // Writes the changes that weren't yet now, and returns whether the file is up to date.
+    bool flush();
+
+    // The file the cache is persisted to, or empty if none.
+    const std::string& path() const { return mPath; }
+
+    size_t numEntries() const;
+    // The size of the keys and values.
+    size_t sizeBytes() const;
+
+   private:
+    struct Entry {
+        std::string key;
+        // Keeps |data| alive: the mapping of the file it is in, or a copy of the value.
+        std::shared_ptr<const void> storage;
+        const uint8_t* data;
+        size_t size;
+        uint64_t checksum;
+        // Whether |data| was checked against |checksum| already.
+        bool verified;
+        // Changes with the value, to tell whether what was written is still current.
+        uint64_t version;
+    };
+    using EntryList = std::list<Entry>;
+
+    void load();
+    // Writes the file if the cache is dirty. Leaves the cache dirty if that fails, to retry later.
+    bool write();
+    void markDirty();
+    void writebackLoop();
+    void eraseLocked(EntryList::iterator it);
+    void evictLocked();
+
+    const std::string mPath;
+    const std::string mIdentity;
+    const size_t mMaxBytes;
+    const std::chrono::milliseconds mWritebackDelay;
+
+    mutable std::mutex mMutex;
+    // Most recently used first.
+    EntryList mLru;
+    std::unordered_map<std::string, EntryList::iterator> mIndex;
+    size_t mSizeBytes = 0;
+    uint64_t mNextVersion = 1;
+    bool mDirty = false;
+    bool mStopping = false;
+    std::condition_variable mDirtyCv;
+
+    // Serializes writing the file. Taken before |mMutex|.
+    std::mutex mWriteMutex;
+    // A file written but which couldn't replace the old one, to remove once unused.
+    std::string mOrphanPath;
+    std::thread mWritebackThread;
+};
+
+}  // namespace gfxstream
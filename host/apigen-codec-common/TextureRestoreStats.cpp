@@ -0,0 +1,75 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "TextureRestoreStats.h"
+
+namespace gfxstream {
+namespace {
+
+uint64_t elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                 start)
+        .count();
+}
+
+}  // namespace
+
+// static
+TextureRestoreStats& TextureRestoreStats::get() {
+    static TextureRestoreStats* stats = new TextureRestoreStats();
+    return *stats;
+}
+
+void TextureRestoreStats::start(uint64_t numTextures, uint64_t numPrioritized) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {
+        .numTextures = numTextures,
+        .numPrioritized = numPrioritized,
+        .inProgress = true,
+    };
+    mStart = Clock::now();
+}
+
+void TextureRestoreStats::onRestored(bool prioritized) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.numRestored++;
+    if (prioritized) {
+        mStats.numPrioritizedRestored++;
+        if (mStats.numPrioritizedRestored == mStats.numPrioritized) {
+            mStats.prioritizedRestoreMs = elapsedMs(mStart);
+        }
+    }
+}
+
+void TextureRestoreStats::finish() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.restoreMs = elapsedMs(mStart);
+    if (mStats.numPrioritizedRestored < mStats.numPrioritized) {
+        mStats.prioritizedRestoreMs = mStats.restoreMs;
+    }
+    mStats.inProgress = false;
+}
+
+TextureRestoreStats::Stats TextureRestoreStats::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats = mStats;
+    if (stats.inProgress) {
+        stats.restoreMs = elapsedMs(mStart);
+        if (stats.numPrioritizedRestored < stats.numPrioritized) {
+            stats.prioritizedRestoreMs = stats.restoreMs;
+        }
+    }
+    return stats;
+}
+
+}  // namespace gfxstream
@@ -0,0 +1,58 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <mutex>
+
+namespace gfxstream {
+
+// Progress of restoring the GLES textures of the last snapshot loaded. The textures are restored
+// in the background once the snapshot is loaded, those the guest's framebuffers use first, so that
+// the guest can show frames before all of them are.
+class TextureRestoreStats {
+   public:
+    struct Stats {
+        uint64_t numTextures = 0;
+        uint64_t numRestored = 0;
+        // The textures restored first.
+        uint64_t numPrioritized = 0;
+        uint64_t numPrioritizedRestored = 0;
+        // How long restoring the prioritized textures, and all of them, took, or has taken so
+        // far.
+        uint64_t prioritizedRestoreMs = 0;
+        uint64_t restoreMs = 0;
+        bool inProgress = false;
+    };
+
+    static TextureRestoreStats& get();
+
+    void start(uint64_t numTextures, uint64_t numPrioritized);
+    void onRestored(bool prioritized);
+    // Restoring may stop before all the textures are, if the snapshot is unloaded meanwhile.
+    void finish();
+
+    Stats getStats() const;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex mMutex;
+    Stats mStats;
+    Clock::time_point mStart;
+};
+
+}  // namespace gfxstream
@@ -49,6 +49,23 @@ class AstcCpuDecompressor {
                                uint32_t blockHeight, const uint8_t* astcData,
                                size_t astcDataLength, uint8_t* output) = 0;
 
+    // One of the images to decompress with decompressImages(). The arguments of decompress().
+    struct Image {
+        uint32_t width;
+        uint32_t height;
+        const uint8_t* astcData;
+        size_t astcDataLength;
+        uint8_t* output;
+    };
+
+    // Decompresses several images encoded with the same block size, such as the levels of a mip
+    // chain, all at once. This spreads the work better across threads than decompressing them
+    // one after the other.
+    //
+    // Returns 0 on success, or the status code of one of the images that failed.
+    virtual int32_t decompressImages(uint32_t blockWidth, uint32_t blockHeight,
+                                     const Image* images, size_t numImages) = 0;
+
     // Returns an error string for a given status code. Will always return non-null.
     virtual const char* getStatusString(int32_t statusCode) const = 0;
 };
@@ -12,17 +12,29 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <array>
-#include <future>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "AstcCpuDecompressor.h"
 #include "astcenc.h"
 
-namespace goldfish_vk {
+namespace gfxstream {
+namespace vk {
 namespace {
 
-constexpr uint32_t kNumThreads = 2;
+// Upper bound of the number of worker threads, on top of the threads calling decompress().
+constexpr uint32_t kMaxWorkerThreads = 8;
+
+// How many ASTC blocks a single task decodes. Images are split in bands of whole block rows of
+// about this size, so that even a 256x256 image of 4x4 blocks can be spread across 4 threads, while
+// keeping the scheduling overhead negligible compared to the decoding.
+constexpr uint32_t kBlocksPerBand = 1024;
 
 const astcenc_swizzle kSwizzle = {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A};
 
@@ -33,7 +45,7 @@ struct AstcencContextDeleter {
 
 using AstcencContextUniquePtr = std::unique_ptr<astcenc_context, AstcencContextDeleter>;
 
-// Creates a new astcenc_context and wraps it in a smart pointer.
+// Creates a new single-threaded astcenc_context and wraps it in a smart pointer.
 // It is not needed to call astcenc_context_free() on the returned pointer.
 // blockWith, blockSize: ASTC block size for the context
 // Error: (output param) Where to put the error status. Must not be null.
@@ -50,14 +62,13 @@ AstcencContextUniquePtr makeDecoderContext(uint32_t blockWidth, uint32_t blockHe
     }
 
     astcenc_context* context;
-    *error = astcenc_context_alloc(&config, kNumThreads, &context);
+    *error = astcenc_context_alloc(&config, 1, &context);
     if (*error != ASTCENC_SUCCESS) {
         return nullptr;
     }
     return AstcencContextUniquePtr(context);
 }
 
-
 #if !defined(__clang__) && defined(_MSC_VER)
 // AVX2 support detection for Visual Studio
 #include <intrin.h>
@@ -96,34 +107,67 @@ bool isAstcDecoderAvailable() {
     return context != nullptr;
 }
 
-// Caches and manages astcenc_context objects.
-//
-// Each context is fairly large (around 30 MB) and takes a while to construct, so it's important to
-// reuse them as much as possible.
-//
-// While context objects can be reused across multiple threads, they must be used sequentially. To
-// avoid having to lock and manage access between threads, we keep one cache per thread. This avoids
-// any concurrency issues, at the cost of extra memory.
+// Number of threads decoding in the background. Together with the calling thread, this keeps all
+// the cores busy when a single image is decoded.
+uint32_t numWorkerThreads() {
+    const uint32_t numCores = std::thread::hardware_concurrency();
+    return std::clamp(numCores > 1 ? numCores - 1 : 1, 1u, kMaxWorkerThreads);
+}
+
+// Pools of astcenc_context objects, one per ASTC block size.
 //
-// Currently, there is no eviction strategy. Each cache could grow to a maximum of ~400 MB in size
-// since they are 13 possible ASTC block sizes.
+// A context can only decode one image at a time, and each one is fairly large (from 4 MB for 4x4
+// blocks to 17 MB for 12x12 blocks) and takes a while to construct. Contexts are thus created on
+// demand, reused across calls, and there are at most |maxContexts| of them per block size. There
+// is no eviction.
 //
-// Thread-safety: not thread safe.
-class AstcDecoderContextCache {
+// Thread-safety: all public methods are thread-safe
+class AstcDecoderContextPool {
    public:
-    // Returns a context object for a given ASTC block size, along with the error code if the
-    // context initialization failed.
-    // In this case, the context will be null, and the status code will be non-zero.
-    std::pair<astcenc_context*, astcenc_error> get(uint32_t blockWidth, uint32_t blockHeight) {
-        Value& value = mContexts[{blockWidth, blockHeight}];
-        if (value.context == nullptr) {
-            value.context = makeDecoderContext(blockWidth, blockHeight, &value.error);
+    explicit AstcDecoderContextPool(uint32_t maxContexts) : mMaxContexts(maxContexts) {}
+
+    // Returns an unused context for the given block size, creating it if needed. Returns nullptr
+    // if all the contexts are in use, or if the context couldn't be created, in which case |error|
+    // is set to a non-zero status code.
+    AstcencContextUniquePtr tryAcquire(uint32_t blockWidth, uint32_t blockHeight,
+                                       astcenc_error* error) {
+        *error = ASTCENC_SUCCESS;
+        {
+            std::lock_guard lock(mMutex);
+            Contexts& contexts = mContexts[{blockWidth, blockHeight}];
+            if (contexts.error != ASTCENC_SUCCESS) {
+                *error = contexts.error;
+                return nullptr;
+            }
+            if (!contexts.unused.empty()) {
+                AstcencContextUniquePtr context = std::move(contexts.unused.back());
+                contexts.unused.pop_back();
+                return context;
+            }
+            if (contexts.numCreated == mMaxContexts) {
+                return nullptr;
+            }
+            ++contexts.numCreated;
+        }
+
+        // Don't block the other block sizes while creating it.
+        AstcencContextUniquePtr context = makeDecoderContext(blockWidth, blockHeight, error);
+        if (!context) {
+            std::lock_guard lock(mMutex);
+            Contexts& contexts = mContexts[{blockWidth, blockHeight}];
+            --contexts.numCreated;
+            contexts.error = *error;
         }
-        return {value.context.get(), value.error};
+        return context;
+    }
+
+    void release(uint32_t blockWidth, uint32_t blockHeight, AstcencContextUniquePtr context) {
+        std::lock_guard lock(mMutex);
+        mContexts[{blockWidth, blockHeight}].unused.push_back(std::move(context));
     }
 
    private:
-    // Holds the data we use as the cache key
+    // Holds the data we use as the pool key
     struct Key {
         uint32_t blockWidth;
         uint32_t blockHeight;
@@ -133,8 +177,11 @@ class AstcDecoderContextCache {
         }
     };
 
-    struct Value {
-        AstcencContextUniquePtr context = nullptr;
+    struct Contexts {
+        std::vector<AstcencContextUniquePtr> unused;
+        // Including the ones in use.
+        uint32_t numCreated = 0;
+        // Set if creating a context failed, in which case there won't be any further attempt.
         astcenc_error error = ASTCENC_SUCCESS;
     };
 
@@ -146,70 +193,61 @@ class AstcDecoderContextCache {
         }
     };
 
-    std::unordered_map<Key, Value, KeyHash> mContexts;
+    const uint32_t mMaxContexts;
+    std::mutex mMutex;
+    std::unordered_map<Key, Contexts, KeyHash> mContexts;
 };
 
-// Thread-safety: all public methods are thread-safe
-class WorkerThread {
-   public:
-    explicit WorkerThread() : mThread(&WorkerThread::main, this) {}
-
-    // Terminates the thread. Call wait() to wait until the thread fully exits.
-    void terminate() {
-        std::lock_guard lock(mWorkerMutex);
-        mTerminated = true;
-        mWorkerCondition.notify_one();
-    }
-
-    // Blocks until the thread exits.
-    void wait() { mThread.join(); }
-
-    std::future<astcenc_error> decompress(astcenc_context* context, uint32_t threadIndex,
-                                          const uint8_t* data, size_t dataLength,
-                                          astcenc_image* image) {
-        std::lock_guard lock(mWorkerMutex);
-        mTask = std::packaged_task<astcenc_error()>{[=] {
-            return astcenc_decompress_image(context, data, dataLength, image, &kSwizzle,
-                                            threadIndex);
-        }};
-        mWorkerCondition.notify_one();
-        return mTask.get_future();
-    }
-
-   private:
-    // Thread's main loop
-    void main() {
-        while (true) {
-            std::packaged_task<astcenc_error()> task;
-            {
-                std::unique_lock lock(mWorkerMutex);
-                mWorkerCondition.wait(lock, [this] { return mTask.valid() || mTerminated; });
-                if (mTerminated) return;
-                task = std::move(mTask);
-            }
-            task();
-        }
-    }
+// A range of whole block rows of an image, decoded as an image of its own.
+struct Band {
+    const uint8_t* astcData;
+    size_t astcDataLength;
+    uint32_t width;
+    uint32_t height;
+    uint8_t* output;
+};
 
-    bool mTerminated = false;
-    std::condition_variable mWorkerCondition = {};  // Signals availability of work
-    std::mutex mWorkerMutex = {};                   // Mutex used with mWorkerCondition.
-    std::packaged_task<astcenc_error()> mTask = {};
-    std::thread mThread = {};
+// The bands of the images passed to one decompressImages() call.
+//
+// Any thread holding a context for the block size can claim the next band with |nextBand|, so the
+// bands are decoded in parallel by the caller and by any idle worker thread.
+struct Job {
+    uint32_t blockWidth;
+    uint32_t blockHeight;
+    std::vector<Band> bands;
+    std::atomic<size_t> nextBand{0};
+    // Bands not decoded yet, including the ones being decoded.
+    std::atomic<size_t> remainingBands{0};
+    std::atomic<int32_t> status{ASTCENC_SUCCESS};
+
+    bool hasUnclaimedBands() const { return nextBand.load(std::memory_order_relaxed) < bands.size(); }
 };
 
-// Performs ASTC decompression of an image on the CPU
+// Performs ASTC decompression of images on the CPU.
+//
+// Images are split into bands of block rows which are decoded in parallel by the calling thread and
+// a pool of worker threads. Several threads can call decompress() at the same time: their images
+// are decoded concurrently, each thread with its own context, and idle worker threads help with
+// whichever image still has bands left.
 class AstcCpuDecompressorImpl : public AstcCpuDecompressor {
    public:
     AstcCpuDecompressorImpl()
-        : AstcCpuDecompressor(), mContextCache(std::make_unique<AstcDecoderContextCache>()) {}
+        : AstcCpuDecompressor(), mContextPool(numWorkerThreads() + 1) {
+        const uint32_t numWorkers = numWorkerThreads();
+        for (uint32_t i = 0; i < numWorkers; ++i) {
+            mWorkerThreads.emplace_back(&AstcCpuDecompressorImpl::workerMain, this);
+        }
+    }
 
     ~AstcCpuDecompressorImpl() override {
         // Stop the worker threads, otherwise the process would hang upon exit.
-        std::lock_guard global_lock(mMutex);
+        {
+            std::lock_guard lock(mMutex);
+            mTerminated = true;
+            mWorkAvailable.notify_all();
+        }
         for (auto& worker : mWorkerThreads) {
-            worker.terminate();
-            worker.wait();
+            worker.join();
         }
     }
 
@@ -221,49 +259,187 @@ class AstcCpuDecompressorImpl : public AstcCpuDecompressor {
     int32_t decompress(const uint32_t imgWidth, const uint32_t imgHeight, const uint32_t blockWidth,
                        const uint32_t blockHeight, const uint8_t* astcData, size_t astcDataLength,
                        uint8_t* output) override {
-        std::array<std::future<astcenc_error>, kNumThreads> futures;
+        const Image image = {
+            .width = imgWidth,
+            .height = imgHeight,
+            .astcData = astcData,
+            .astcDataLength = astcDataLength,
+            .output = output,
+        };
+        return decompressImages(blockWidth, blockHeight, &image, 1);
+    }
 
-        std::lock_guard global_lock(mMutex);
+    int32_t decompressImages(uint32_t blockWidth, uint32_t blockHeight, const Image* images,
+                             size_t numImages) override {
+        if (blockWidth == 0 || blockHeight == 0) return ASTCENC_ERR_BAD_BLOCK_SIZE;
 
-        auto [context, context_status] = mContextCache->get(blockWidth, blockHeight);
-        if (context_status != ASTCENC_SUCCESS) return context_status;
+        auto job = std::make_shared<Job>();
+        job->blockWidth = blockWidth;
+        job->blockHeight = blockHeight;
+        for (size_t i = 0; i < numImages; ++i) {
+            int32_t status = addBands(*job, images[i]);
+            if (status != ASTCENC_SUCCESS) return status;
+        }
+        if (job->bands.empty()) return ASTCENC_SUCCESS;
+        job->remainingBands.store(job->bands.size(), std::memory_order_relaxed);
+
+        astcenc_error error;
+        AstcencContextUniquePtr context = mContextPool.tryAcquire(blockWidth, blockHeight, &error);
+        if (error != ASTCENC_SUCCESS) return error;
+
+        // Small images aren't worth waking up another thread for.
+        if (context && job->bands.size() == 1) {
+            decodeBands(*job, context.get());
+            mContextPool.release(blockWidth, blockHeight, std::move(context));
+            return job->status.load(std::memory_order_relaxed);
+        }
 
-        astcenc_image image = {
-            .dim_x = imgWidth,
-            .dim_y = imgHeight,
-            .dim_z = 1,
-            .data_type = ASTCENC_TYPE_U8,
-            .data = reinterpret_cast<void**>(&output),
-        };
+        {
+            std::lock_guard lock(mMutex);
+            mJobs.push_back(job);
+            ++mWorkGeneration;
+            mWorkAvailable.notify_all();
+        }
 
-        for (uint32_t i = 0; i < kNumThreads; ++i) {
-            futures[i] = mWorkerThreads[i].decompress(context, i, astcData, astcDataLength, &image);
+        // Without a context, leave it all to the worker threads, which get one as soon as another
+        // image is done.
+        if (context) {
+            decodeBands(*job, context.get());
+            releaseContext(blockWidth, blockHeight, std::move(context));
         }
 
-        astcenc_error result = ASTCENC_SUCCESS;
+        std::unique_lock lock(mMutex);
+        mJobDone.wait(lock,
+                      [&job] { return job->remainingBands.load(std::memory_order_acquire) == 0; });
+        mJobs.erase(std::find(mJobs.begin(), mJobs.end(), job));
+        return job->status.load(std::memory_order_relaxed);
+    }
+
+    const char* getStatusString(int32_t statusCode) const override {
+        const char* msg = astcenc_get_error_string((astcenc_error)statusCode);
+        return msg ? msg : "ASTCENC_UNKNOWN_STATUS";
+    }
+
+   private:
+    // Splits |image| into bands of block rows and adds them to |job|.
+    static int32_t addBands(Job& job, const Image& image) {
+        if (image.width == 0 || image.height == 0) return ASTCENC_SUCCESS;
+
+        const uint32_t xBlocks = (image.width + job.blockWidth - 1) / job.blockWidth;
+        const uint32_t yBlocks = (image.height + job.blockHeight - 1) / job.blockHeight;
+        const size_t blockRowLength = size_t(xBlocks) * 16;
+        // astcenc would reject it too, but only once the worker threads are already involved.
+        if (image.astcDataLength < blockRowLength * yBlocks) return ASTCENC_ERR_OUT_OF_MEM;
+
+        const uint32_t blockRowsPerBand = std::max(1u, kBlocksPerBand / xBlocks);
+        const size_t outputRowLength = size_t(image.width) * 4;
+        for (uint32_t blockRow = 0; blockRow < yBlocks; blockRow += blockRowsPerBand) {
+            const uint32_t numBlockRows = std::min(blockRowsPerBand, yBlocks - blockRow);
+            const uint32_t row = blockRow * job.blockHeight;
+            job.bands.push_back({
+                .astcData = image.astcData + blockRow * blockRowLength,
+                .astcDataLength = numBlockRows * blockRowLength,
+                .width = image.width,
+                .height = std::min(numBlockRows * job.blockHeight, image.height - row),
+                .output = image.output + row * outputRowLength,
+            });
+        }
+        return ASTCENC_SUCCESS;
+    }
 
-        // Wait for all threads to be done
-        for (auto& future : futures) {
-            astcenc_error status = future.get();
+    // Decodes bands of |job| until there are none left to claim.
+    void decodeBands(Job& job, astcenc_context* context) {
+        for (size_t i = job.nextBand.fetch_add(1, std::memory_order_relaxed); i < job.bands.size();
+             i = job.nextBand.fetch_add(1, std::memory_order_relaxed)) {
+            const Band& band = job.bands[i];
+            uint8_t* output = band.output;
+            astcenc_image image = {
+                .dim_x = band.width,
+                .dim_y = band.height,
+                .dim_z = 1,
+                .data_type = ASTCENC_TYPE_U8,
+                .data = reinterpret_cast<void**>(&output),
+            };
+            // Single-threaded contexts reset themselves before each image.
+            astcenc_error status = astcenc_decompress_image(context, band.astcData,
+                                                            band.astcDataLength, &image, &kSwizzle,
+                                                            0);
             if (status != ASTCENC_SUCCESS) {
-                result = status;
+                job.status.store(status, std::memory_order_relaxed);
+            }
+            if (job.remainingBands.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(mMutex);
+                mJobDone.notify_all();
             }
         }
+    }
 
-        astcenc_decompress_reset(context);
+    // Fails the bands of |job| that no thread claimed yet.
+    void failBands(Job& job, astcenc_error error) {
+        job.status.store(error, std::memory_order_relaxed);
+        for (size_t i = job.nextBand.fetch_add(1, std::memory_order_relaxed); i < job.bands.size();
+             i = job.nextBand.fetch_add(1, std::memory_order_relaxed)) {
+            if (job.remainingBands.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard lock(mMutex);
+                mJobDone.notify_all();
+            }
+        }
+    }
 
-        return result;
+    // Gives back a context, and lets the worker threads waiting for one know about it.
+    void releaseContext(uint32_t blockWidth, uint32_t blockHeight,
+                        AstcencContextUniquePtr context) {
+        mContextPool.release(blockWidth, blockHeight, std::move(context));
+        std::lock_guard lock(mMutex);
+        ++mWorkGeneration;
+        mWorkAvailable.notify_all();
     }
 
-    const char* getStatusString(int32_t statusCode) const override {
-        const char* msg = astcenc_get_error_string((astcenc_error)statusCode);
-        return msg ? msg : "ASTCENC_UNKNOWN_STATUS";
+    // Worker threads' main loop: helps with the oldest image that still has bands to decode and for
+    // which there is a context available.
+    void workerMain() {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            std::vector<std::shared_ptr<Job>> jobs;
+            {
+                std::unique_lock lock(mMutex);
+                mWorkAvailable.wait(
+                    lock, [&] { return mTerminated || mWorkGeneration != seenGeneration; });
+                if (mTerminated) return;
+                seenGeneration = mWorkGeneration;
+                jobs = mJobs;
+            }
+
+            for (const auto& job : jobs) {
+                if (!job->hasUnclaimedBands()) continue;
+
+                astcenc_error error;
+                AstcencContextUniquePtr context =
+                    mContextPool.tryAcquire(job->blockWidth, job->blockHeight, &error);
+                if (!context) {
+                    if (error != ASTCENC_SUCCESS) failBands(*job, error);
+                    continue;
+                }
+
+                decodeBands(*job, context.get());
+                releaseContext(job->blockWidth, job->blockHeight, std::move(context));
+                // Other jobs may have been queued in the meantime.
+                seenGeneration = 0;
+                break;
+            }
+        }
     }
 
-   private:
-    std::unique_ptr<AstcDecoderContextCache> mContextCache;
-    std::mutex mMutex;  // Locked while calling `decompress()`
-    std::array<WorkerThread, kNumThreads> mWorkerThreads;
+    AstcDecoderContextPool mContextPool;
+    std::mutex mMutex;  // Protects the members below.
+    // Signaled whenever a job is queued or a context is released.
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mJobDone;  // Signaled whenever all the bands of a job are decoded.
+    // Incremented whenever mWorkAvailable is signaled.
+    uint64_t mWorkGeneration = 0;
+    std::vector<std::shared_ptr<Job>> mJobs;  // The jobs of the ongoing decompressImages() calls.
+    bool mTerminated = false;
+    std::vector<std::thread> mWorkerThreads;
 };
 
 }  // namespace
@@ -273,4 +449,5 @@ AstcCpuDecompressor& AstcCpuDecompressor::get() {
     return instance;
 }
 
-}  // namespace goldfish_vk
+}  // namespace vk
+}  // namespace gfxstream
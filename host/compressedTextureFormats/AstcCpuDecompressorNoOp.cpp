@@ -28,6 +28,11 @@ class AstcCpuDecompressorNoOp : public AstcCpuDecompressor {
         return -1;
     };
 
+    int32_t decompressImages(uint32_t blockWidth, uint32_t blockHeight, const Image* images,
+                             size_t numImages) override {
+        return -1;
+    }
+
     const char* getStatusString(int32_t statusCode) const override {
         return "ASTC CPU decomp not available";
     }
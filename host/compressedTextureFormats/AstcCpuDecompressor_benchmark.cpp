@@ -0,0 +1,109 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "AstcCpuDecompressor.h"
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+// An 8x8 block of a checkerboard pattern.
+const uint8_t kCheckerboardBlock[] = {0x44, 0x05, 0x00, 0xfe, 0x01, 0x00, 0x00, 0x00,
+                                      0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa};
+
+std::vector<uint8_t> makeAstcData(uint32_t width, uint32_t height) {
+    const size_t numBlocks = size_t((width + 7) / 8) * ((height + 7) / 8);
+    std::vector<uint8_t> data;
+    data.reserve(numBlocks * 16);
+    for (size_t i = 0; i < numBlocks; ++i) {
+        data.insert(data.end(), kCheckerboardBlock, kCheckerboardBlock + 16);
+    }
+    return data;
+}
+
+// Decompresses a square texture of state.range(0) pixels per side. With several benchmark threads,
+// each decompresses its own texture at the same time.
+void BM_Decompress(benchmark::State& state) {
+    auto& decompressor = AstcCpuDecompressor::get();
+    if (!decompressor.available()) {
+        state.SkipWithError("ASTC decompressor not available");
+        return;
+    }
+
+    const uint32_t size = state.range(0);
+    const std::vector<uint8_t> astcData = makeAstcData(size, size);
+    std::vector<uint8_t> output(size_t(size) * size * 4);
+    for (auto _ : state) {
+        int32_t status = decompressor.decompress(size, size, 8, 8, astcData.data(),
+                                                 astcData.size(), output.data());
+        if (status != 0) {
+            state.SkipWithError(decompressor.getStatusString(status));
+            break;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+    state.SetBytesProcessed(state.iterations() * output.size());
+}
+BENCHMARK(BM_Decompress)->Arg(64)->Arg(256)->Arg(1024)->Arg(2048)->UseRealTime();
+BENCHMARK(BM_Decompress)->Arg(1024)->ThreadRange(2, 8)->UseRealTime();
+
+// Decompresses a full mip chain of a square texture of state.range(0) pixels per side, all at once.
+void BM_DecompressMipChain(benchmark::State& state) {
+    auto& decompressor = AstcCpuDecompressor::get();
+    if (!decompressor.available()) {
+        state.SkipWithError("ASTC decompressor not available");
+        return;
+    }
+
+    std::vector<std::vector<uint8_t>> astcData;
+    std::vector<std::vector<uint8_t>> outputs;
+    std::vector<AstcCpuDecompressor::Image> images;
+    size_t numPixels = 0;
+    for (uint32_t size = state.range(0); size > 0; size /= 2) {
+        astcData.push_back(makeAstcData(size, size));
+        outputs.emplace_back(size_t(size) * size * 4);
+        numPixels += size_t(size) * size;
+    }
+    for (size_t i = 0; i < astcData.size(); ++i) {
+        const uint32_t size = state.range(0) >> i;
+        images.push_back({
+            .width = size,
+            .height = size,
+            .astcData = astcData[i].data(),
+            .astcDataLength = astcData[i].size(),
+            .output = outputs[i].data(),
+        });
+    }
+
+    for (auto _ : state) {
+        int32_t status = decompressor.decompressImages(8, 8, images.data(), images.size());
+        if (status != 0) {
+            state.SkipWithError(decompressor.getStatusString(status));
+            break;
+        }
+        benchmark::DoNotOptimize(outputs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numPixels);
+    state.SetBytesProcessed(state.iterations() * numPixels * 4);
+}
+BENCHMARK(BM_DecompressMipChain)->Arg(256)->Arg(1024)->UseRealTime();
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
@@ -14,6 +14,9 @@
 
 #include <gmock/gmock.h>
 
+#include <thread>
+#include <vector>
+
 #include "AstcCpuDecompressor.h"
 
 namespace gfxstream {
@@ -35,6 +38,30 @@ struct Rgba {
     bool operator==(const Rgba& o) const { return r == o.r && g == o.g && b == o.b && a == o.a; }
 };
 
+// The ASTC data of a |width|x|height| checkerboard, made of the 8x8 blocks of kCheckerboard.
+std::vector<uint8_t> makeCheckerboard(uint32_t width, uint32_t height) {
+    const size_t numBlocks = size_t((width + 7) / 8) * ((height + 7) / 8);
+    std::vector<uint8_t> data;
+    data.reserve(numBlocks * 16);
+    for (size_t i = 0; i < numBlocks; ++i) {
+        data.insert(data.end(), kCheckerboard, kCheckerboard + 16);
+    }
+    return data;
+}
+
+// Returns the number of pixels of |output| that don't match a checkerboard.
+size_t countCheckerboardErrors(const std::vector<Rgba>& output, uint32_t width, uint32_t height) {
+    const Rgba W = {0xFF, 0xFF, 0xFF, 0xFF};
+    const Rgba B = {0, 0, 0, 0xFF};
+    size_t errors = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            if (!(output[y * width + x] == ((x + y) % 2 == 0 ? W : B))) ++errors;
+        }
+    }
+    return errors;
+}
+
 TEST(AstcCpuDecompressor, Decompress) {
     auto& decompressor = AstcCpuDecompressor::get();
     if (!decompressor.available()) GTEST_SKIP() << "ASTC decompressor not available";
@@ -69,6 +96,82 @@ TEST(AstcCpuDecompressor, Decompress) {
     ASSERT_THAT(output, ElementsAreArray(expected));
 }
 
+TEST(AstcCpuDecompressor, DecompressImages) {
+    auto& decompressor = AstcCpuDecompressor::get();
+    if (!decompressor.available()) GTEST_SKIP() << "ASTC decompressor not available";
+
+    // A mip chain, whose first levels are split into several bands, and whose sizes aren't all
+    // multiples of the block size.
+    std::vector<uint32_t> sizes;
+    for (uint32_t size = 1000; size > 0; size /= 2) {
+        sizes.push_back(size);
+    }
+    std::vector<std::vector<uint8_t>> astcData;
+    std::vector<std::vector<Rgba>> outputs;
+    std::vector<AstcCpuDecompressor::Image> images;
+    for (uint32_t size : sizes) {
+        astcData.push_back(makeCheckerboard(size, size / 2 + 1));
+        outputs.emplace_back(size * (size / 2 + 1));
+    }
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        images.push_back({
+            .width = sizes[i],
+            .height = sizes[i] / 2 + 1,
+            .astcData = astcData[i].data(),
+            .astcDataLength = astcData[i].size(),
+            .output = reinterpret_cast<uint8_t*>(outputs[i].data()),
+        });
+    }
+
+    EXPECT_EQ(decompressor.decompressImages(8, 8, images.data(), images.size()), 0);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        EXPECT_EQ(countCheckerboardErrors(outputs[i], sizes[i], sizes[i] / 2 + 1), 0)
+            << "size " << sizes[i];
+    }
+}
+
+TEST(AstcCpuDecompressor, DecompressConcurrently) {
+    auto& decompressor = AstcCpuDecompressor::get();
+    if (!decompressor.available()) GTEST_SKIP() << "ASTC decompressor not available";
+
+    constexpr uint32_t kNumThreads = 8;
+    constexpr uint32_t kWidth = 512;
+    constexpr uint32_t kHeight = 256;
+    const std::vector<uint8_t> astcData = makeCheckerboard(kWidth, kHeight);
+    std::vector<std::vector<Rgba>> outputs(kNumThreads, std::vector<Rgba>(kWidth * kHeight));
+    std::vector<int32_t> statuses(kNumThreads, 0);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < 4; ++j) {
+                int32_t status = decompressor.decompress(kWidth, kHeight, 8, 8, astcData.data(),
+                                                         astcData.size(),
+                                                         (uint8_t*)outputs[i].data());
+                if (status != 0) statuses[i] = status;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (uint32_t i = 0; i < kNumThreads; ++i) {
+        EXPECT_EQ(statuses[i], 0);
+        EXPECT_EQ(countCheckerboardErrors(outputs[i], kWidth, kHeight), 0);
+    }
+}
+
+TEST(AstcCpuDecompressor, DecompressTruncatedData) {
+    auto& decompressor = AstcCpuDecompressor::get();
+    if (!decompressor.available()) GTEST_SKIP() << "ASTC decompressor not available";
+
+    std::vector<Rgba> output(16 * 16);
+    EXPECT_NE(decompressor.decompress(16, 16, 8, 8, kCheckerboard, sizeof(kCheckerboard) - 1,
+                                      (uint8_t*)output.data()),
+              0);
+}
+
 TEST(AstcCpuDecompressor, getStatusStringAlwaysNonNull) {
     EXPECT_THAT(AstcCpuDecompressor::get().getStatusString(-10000), NotNull());
 }
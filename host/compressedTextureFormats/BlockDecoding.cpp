@@ -0,0 +1,414 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlockDecoding.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BLOCK_DECODING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows any intrinsic in any function.
+#define BLOCK_DECODING_TARGET(isa)
+#else
+#define BLOCK_DECODING_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLOCK_DECODING_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace gfxstream {
+namespace {
+
+// Images smaller than this many blocks per thread aren't worth splitting: starting a thread costs
+// about as much as decoding a thousand blocks.
+constexpr uint64_t kMinBlocksPerThread = 16384;
+constexpr uint32_t kMaxThreads = 8;
+
+// Scalar kernels, which the other ones must match.
+
+void etcIndicesScalar(const uint8_t* block, bool flipped, uint8_t indices[16]) {
+    const uint32_t low = (block[4] << 24) | (block[5] << 16) | (block[6] << 8) | block[7];
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            // The pixel index bits are in column-major order.
+            const int k = y + x * 4;
+            const int msb = (low >> (k + 15)) & 2;
+            const int lsb = (low >> k) & 1;
+            const int subblock = (flipped ? y : x) >= 2 ? 4 : 0;
+            indices[y * 4 + x] = subblock | msb | lsb;
+        }
+    }
+}
+
+void eacIndicesScalar(const uint8_t* block, uint8_t indices[16]) {
+    // 16 3-bit indices, in column-major order, starting from the most significant bits of the last
+    // 6 bytes read as a big endian number.
+    uint64_t bits = 0;
+    for (int i = 2; i < 8; i++) {
+        bits = bits << 8 | block[i];
+    }
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            indices[y * 4 + x] = (bits >> (45 - 3 * (x * 4 + y))) & 7;
+        }
+    }
+}
+
+void rgtcIndicesScalar(const uint8_t* block, uint8_t indices[16]) {
+    // 16 3-bit indices, in row-major order, starting from the least significant bits of the last 6
+    // bytes read as a little endian number.
+    uint64_t bits = 0;
+    for (int i = 7; i >= 2; i--) {
+        bits = bits << 8 | block[i];
+    }
+    for (int i = 0; i < 16; i++) {
+        indices[i] = (bits >> (3 * i)) & 7;
+    }
+}
+
+void lookup8Scalar(const uint8_t palette[8], const uint8_t indices[16], uint8_t texels[16]) {
+    for (int i = 0; i < 16; i++) {
+        texels[i] = palette[indices[i]];
+    }
+}
+
+void lookup32Scalar(const uint32_t palette[8], const uint8_t indices[16], uint32_t texels[16]) {
+    for (int i = 0; i < 16; i++) {
+        texels[i] = palette[indices[i]];
+    }
+}
+
+const BlockKernels kScalarKernels = {
+    etcIndicesScalar, eacIndicesScalar, rgtcIndicesScalar, lookup8Scalar, lookup32Scalar,
+};
+
+#if defined(BLOCK_DECODING_X86) || defined(BLOCK_DECODING_NEON)
+
+// Byte shuffles gathering, for each texel, the bits of its index from the 8 bytes of a block.
+//
+// For ETC, each texel gets the bytes holding the least and the most significant bits of its index,
+// and the masks selecting these bits within them.
+struct EtcShuffle {
+    uint8_t lsbBytes[16];
+    uint8_t msbBytes[16];
+    uint8_t masks[16];
+    uint8_t subblocks[16];
+    uint8_t flippedSubblocks[16];
+};
+
+constexpr EtcShuffle makeEtcShuffle() {
+    EtcShuffle shuffle = {};
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            const int i = y * 4 + x;
+            const int k = y + x * 4;
+            // Bit k of the big endian number in bytes 4 to 7, and bit k + 16 for the msb.
+            shuffle.lsbBytes[i] = 7 - k / 8;
+            shuffle.msbBytes[i] = 7 - (k + 16) / 8;
+            shuffle.masks[i] = 1 << (k % 8);
+            shuffle.subblocks[i] = x >= 2 ? 4 : 0;
+            shuffle.flippedSubblocks[i] = y >= 2 ? 4 : 0;
+        }
+    }
+    return shuffle;
+}
+
+// For the 3-bit indices of EAC and RGTC, each texel gets the 16-bit window of the block whose least
+// significant byte holds the lsb of its index, as pairs of byte indices where 0xff stands for a
+// zero byte. The index is then at bit |shifts| of the window.
+struct ThreeBitShuffle {
+    uint8_t windows[32];
+    int16_t shifts[16];
+    // 1 << (8 - shift), to shift with a multiplication on SSE.
+    uint16_t multipliers[16];
+};
+
+constexpr ThreeBitShuffle makeThreeBitShuffle(bool eac) {
+    ThreeBitShuffle shuffle = {};
+    for (int i = 0; i < 16; i++) {
+        // Position of the lsb of the index, in the 48-bit number formed by the last 6 bytes, and
+        // which of these bytes hold it and the next byte, from the least significant one.
+        const int x = i % 4;
+        const int y = i / 4;
+        const int bit = eac ? 45 - 3 * (x * 4 + y) : 3 * i;
+        const int low = bit / 8;
+        const int high = low + 1;
+        shuffle.windows[2 * i] = eac ? 7 - low : 2 + low;
+        shuffle.windows[2 * i + 1] = high > 5 ? 0xff : (eac ? 7 - high : 2 + high);
+        shuffle.shifts[i] = bit % 8;
+        shuffle.multipliers[i] = 1 << (8 - bit % 8);
+    }
+    return shuffle;
+}
+
+// For 32-bit lookups, which texels' bytes to gather out of the palette.
+struct Lookup32Shuffle {
+    // Spreads the byte offsets of 4 texels to the 4 bytes of each.
+    uint8_t spreads[4][16];
+    // Added to these offsets.
+    uint8_t bytesOfTexel[16];
+};
+
+constexpr Lookup32Shuffle makeLookup32Shuffle() {
+    Lookup32Shuffle shuffle = {};
+    for (int i = 0; i < 16; i++) {
+        for (int group = 0; group < 4; group++) {
+            shuffle.spreads[group][i] = group * 4 + i / 4;
+        }
+        shuffle.bytesOfTexel[i] = i % 4;
+    }
+    return shuffle;
+}
+
+alignas(16) constexpr EtcShuffle kEtcShuffle = makeEtcShuffle();
+alignas(16) constexpr ThreeBitShuffle kEacShuffle = makeThreeBitShuffle(true);
+alignas(16) constexpr ThreeBitShuffle kRgtcShuffle = makeThreeBitShuffle(false);
+alignas(16) constexpr Lookup32Shuffle kLookup32Shuffle = makeLookup32Shuffle();
+
+#endif
+
+#if defined(BLOCK_DECODING_X86)
+
+#define LOAD128(p) _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))
+
+BLOCK_DECODING_TARGET("sse4.1")
+void etcIndicesSse41(const uint8_t* block, bool flipped, uint8_t indices[16]) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+    const __m128i masks = LOAD128(kEtcShuffle.masks);
+    const __m128i lsb = _mm_and_si128(_mm_shuffle_epi8(bytes, LOAD128(kEtcShuffle.lsbBytes)), masks);
+    const __m128i msb = _mm_and_si128(_mm_shuffle_epi8(bytes, LOAD128(kEtcShuffle.msbBytes)), masks);
+    __m128i result = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(lsb, masks), _mm_set1_epi8(1)),
+                                  _mm_and_si128(_mm_cmpeq_epi8(msb, masks), _mm_set1_epi8(2)));
+    result = _mm_or_si128(result, flipped ? LOAD128(kEtcShuffle.flippedSubblocks)
+                                          : LOAD128(kEtcShuffle.subblocks));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), result);
+}
+
+BLOCK_DECODING_TARGET("sse4.1")
+inline void threeBitIndicesSse41(const uint8_t* block, const ThreeBitShuffle& shuffle,
+                                 uint8_t indices[16]) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+    // Shifts the index to the second byte of each window, then moves it to the first one.
+    __m128i low = _mm_shuffle_epi8(bytes, LOAD128(shuffle.windows));
+    __m128i high = _mm_shuffle_epi8(bytes, LOAD128(shuffle.windows + 16));
+    low = _mm_srli_epi16(_mm_mullo_epi16(low, LOAD128(shuffle.multipliers)), 8);
+    high = _mm_srli_epi16(_mm_mullo_epi16(high, LOAD128(shuffle.multipliers + 8)), 8);
+    const __m128i result = _mm_and_si128(_mm_packus_epi16(low, high), _mm_set1_epi8(7));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), result);
+}
+
+BLOCK_DECODING_TARGET("sse4.1")
+void eacIndicesSse41(const uint8_t* block, uint8_t indices[16]) {
+    threeBitIndicesSse41(block, kEacShuffle, indices);
+}
+
+BLOCK_DECODING_TARGET("sse4.1")
+void rgtcIndicesSse41(const uint8_t* block, uint8_t indices[16]) {
+    threeBitIndicesSse41(block, kRgtcShuffle, indices);
+}
+
+BLOCK_DECODING_TARGET("sse4.1")
+void lookup8Sse41(const uint8_t palette[8], const uint8_t indices[16], uint8_t texels[16]) {
+    const __m128i paletteBytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(texels),
+                     _mm_shuffle_epi8(paletteBytes, LOAD128(indices)));
+}
+
+BLOCK_DECODING_TARGET("sse4.1")
+void lookup32Sse41(const uint32_t palette[8], const uint8_t indices[16], uint32_t texels[16]) {
+    // The palette takes 32 bytes, so each of them is gathered from both of its halves, and the
+    // right one is picked according to bit 4 of the offset.
+    const __m128i paletteLow = LOAD128(palette);
+    const __m128i paletteHigh = LOAD128(palette + 4);
+    const __m128i offsets = _mm_slli_epi16(LOAD128(indices), 2);
+    const __m128i bytesOfTexel = LOAD128(kLookup32Shuffle.bytesOfTexel);
+    for (int group = 0; group < 4; group++) {
+        const __m128i byteOffsets = _mm_or_si128(
+            _mm_shuffle_epi8(offsets, LOAD128(kLookup32Shuffle.spreads[group])), bytesOfTexel);
+        const __m128i result = _mm_blendv_epi8(_mm_shuffle_epi8(paletteLow, byteOffsets),
+                                               _mm_shuffle_epi8(paletteHigh, byteOffsets),
+                                               _mm_slli_epi16(byteOffsets, 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + group * 4), result);
+    }
+}
+
+BLOCK_DECODING_TARGET("avx2")
+void lookup32Avx2(const uint32_t palette[8], const uint8_t indices[16], uint32_t texels[16]) {
+    const __m256i paletteTexels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(palette));
+    const __m128i indexBytes = LOAD128(indices);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(texels),
+        _mm256_permutevar8x32_epi32(paletteTexels, _mm256_cvtepu8_epi32(indexBytes)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + 8),
+                        _mm256_permutevar8x32_epi32(
+                            paletteTexels, _mm256_cvtepu8_epi32(_mm_srli_si128(indexBytes, 8))));
+}
+
+#undef LOAD128
+
+const BlockKernels kSse41Kernels = {
+    etcIndicesSse41, eacIndicesSse41, rgtcIndicesSse41, lookup8Sse41, lookup32Sse41,
+};
+
+// The index kernels have nothing to gain from wider registers.
+const BlockKernels kAvx2Kernels = {
+    etcIndicesSse41, eacIndicesSse41, rgtcIndicesSse41, lookup8Sse41, lookup32Avx2,
+};
+
+bool cpuSupports(BlockKernelsIsa isa) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int data[4];
+    __cpuid(data, 1);
+    const bool sse41 = data[2] & (1 << 19);
+    if (isa == BlockKernelsIsa::kSse41) return sse41;
+    // AVX2 also needs the OS to save the YMM registers.
+    const bool osxsave = data[2] & (1 << 27);
+    const bool avx = data[2] & (1 << 28);
+    if (!sse41 || !osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(data, 7, 0);
+    return data[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return isa == BlockKernelsIsa::kSse41 ? __builtin_cpu_supports("sse4.1")
+                                           : __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(BLOCK_DECODING_NEON)
+
+void etcIndicesNeon(const uint8_t* block, bool flipped, uint8_t indices[16]) {
+    const uint8x16_t bytes = vcombine_u8(vld1_u8(block), vdup_n_u8(0));
+    const uint8x16_t masks = vld1q_u8(kEtcShuffle.masks);
+    const uint8x16_t lsb = vtstq_u8(vqtbl1q_u8(bytes, vld1q_u8(kEtcShuffle.lsbBytes)), masks);
+    const uint8x16_t msb = vtstq_u8(vqtbl1q_u8(bytes, vld1q_u8(kEtcShuffle.msbBytes)), masks);
+    uint8x16_t result = vorrq_u8(vandq_u8(lsb, vdupq_n_u8(1)), vandq_u8(msb, vdupq_n_u8(2)));
+    result = vorrq_u8(result, vld1q_u8(flipped ? kEtcShuffle.flippedSubblocks
+                                               : kEtcShuffle.subblocks));
+    vst1q_u8(indices, result);
+}
+
+inline void threeBitIndicesNeon(const uint8_t* block, const ThreeBitShuffle& shuffle,
+                                uint8_t indices[16]) {
+    const uint8x16_t bytes = vcombine_u8(vld1_u8(block), vdup_n_u8(0));
+    // Out of range table indices give zeros.
+    uint16x8_t low = vreinterpretq_u16_u8(vqtbl1q_u8(bytes, vld1q_u8(shuffle.windows)));
+    uint16x8_t high = vreinterpretq_u16_u8(vqtbl1q_u8(bytes, vld1q_u8(shuffle.windows + 16)));
+    // Shifting left by a negative amount shifts right.
+    low = vshlq_u16(low, vnegq_s16(vld1q_s16(shuffle.shifts)));
+    high = vshlq_u16(high, vnegq_s16(vld1q_s16(shuffle.shifts + 8)));
+    const uint8x16_t result = vandq_u8(vcombine_u8(vmovn_u16(low), vmovn_u16(high)), vdupq_n_u8(7));
+    vst1q_u8(indices, result);
+}
+
+void eacIndicesNeon(const uint8_t* block, uint8_t indices[16]) {
+    threeBitIndicesNeon(block, kEacShuffle, indices);
+}
+
+void rgtcIndicesNeon(const uint8_t* block, uint8_t indices[16]) {
+    threeBitIndicesNeon(block, kRgtcShuffle, indices);
+}
+
+void lookup8Neon(const uint8_t palette[8], const uint8_t indices[16], uint8_t texels[16]) {
+    vst1q_u8(texels, vqtbl1q_u8(vcombine_u8(vld1_u8(palette), vdup_n_u8(0)), vld1q_u8(indices)));
+}
+
+void lookup32Neon(const uint32_t palette[8], const uint8_t indices[16], uint32_t texels[16]) {
+    const uint8x16x2_t paletteBytes = {{
+        vld1q_u8(reinterpret_cast<const uint8_t*>(palette)),
+        vld1q_u8(reinterpret_cast<const uint8_t*>(palette + 4)),
+    }};
+    const uint8x16_t offsets = vshlq_n_u8(vld1q_u8(indices), 2);
+    const uint8x16_t bytesOfTexel = vld1q_u8(kLookup32Shuffle.bytesOfTexel);
+    for (int group = 0; group < 4; group++) {
+        const uint8x16_t byteOffsets =
+            vorrq_u8(vqtbl1q_u8(offsets, vld1q_u8(kLookup32Shuffle.spreads[group])), bytesOfTexel);
+        vst1q_u8(reinterpret_cast<uint8_t*>(texels + group * 4),
+                 vqtbl2q_u8(paletteBytes, byteOffsets));
+    }
+}
+
+const BlockKernels kNeonKernels = {
+    etcIndicesNeon, eacIndicesNeon, rgtcIndicesNeon, lookup8Neon, lookup32Neon,
+};
+
+#endif
+
+const BlockKernels& chooseBlockKernels() {
+    for (BlockKernelsIsa isa : {BlockKernelsIsa::kAvx2, BlockKernelsIsa::kSse41,
+                                BlockKernelsIsa::kNeon}) {
+        if (const BlockKernels* kernels = getBlockKernels(isa)) {
+            return *kernels;
+        }
+    }
+    return kScalarKernels;
+}
+
+}  // namespace
+
+const BlockKernels& getBlockKernels() {
+    static const BlockKernels& kernels = chooseBlockKernels();
+    return kernels;
+}
+
+const BlockKernels* getBlockKernels(BlockKernelsIsa isa) {
+    switch (isa) {
+        case BlockKernelsIsa::kScalar:
+            return &kScalarKernels;
+#if defined(BLOCK_DECODING_X86)
+        case BlockKernelsIsa::kSse41:
+            return cpuSupports(isa) ? &kSse41Kernels : nullptr;
+        case BlockKernelsIsa::kAvx2:
+            return cpuSupports(isa) ? &kAvx2Kernels : nullptr;
+#elif defined(BLOCK_DECODING_NEON)
+        case BlockKernelsIsa::kNeon:
+            return &kNeonKernels;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+void forEachBlockRows(uint32_t numBlockRows, uint32_t blocksPerRow,
+                      const std::function<void(uint32_t beginRow, uint32_t endRow)>& decodeRows) {
+    const uint64_t numBlocks = uint64_t(numBlockRows) * blocksPerRow;
+    const uint64_t numThreads =
+        std::min({uint64_t(std::max(1u, std::thread::hardware_concurrency())),
+                  uint64_t(kMaxThreads), numBlocks / kMinBlocksPerThread, uint64_t(numBlockRows)});
+    if (numThreads <= 1) {
+        decodeRows(0, numBlockRows);
+        return;
+    }
+
+    auto rowOf = [&](uint64_t thread) {
+        return static_cast<uint32_t>(numBlockRows * thread / numThreads);
+    };
+    std::vector<std::thread> threads;
+    for (uint64_t thread = 1; thread < numThreads; thread++) {
+        threads.emplace_back([&decodeRows, begin = rowOf(thread), end = rowOf(thread + 1)] {
+            decodeRows(begin, end);
+        });
+    }
+    decodeRows(0, rowOf(1));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace gfxstream
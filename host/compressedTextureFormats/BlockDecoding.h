@@ -0,0 +1,60 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+namespace gfxstream {
+
+// Building blocks of the software decoders of the formats made of 4x4 blocks whose texels are
+// indices into a palette of up to 8 values computed per block: ETC2 (except for its planar mode),
+// EAC and RGTC.
+//
+// The decoders compute the palette of each block, and the kernels below expand it into texels. The
+// kernels are picked at runtime according to what the CPU supports, and all of them give the same
+// results as the scalar ones.
+//
+// The texels of a block are always in row-major order.
+struct BlockKernels {
+    // Palette indices of the texels of an ETC1/ETC2 block in the individual, differential, T or H
+    // mode, given the 8 bytes of the block. The indices of the texels of the second subblock are
+    // offset by 4.
+    void (*etcIndices)(const uint8_t* block, bool flipped, uint8_t indices[16]);
+    // Palette indices of the texels of an 8-byte EAC block.
+    void (*eacIndices)(const uint8_t* block, uint8_t indices[16]);
+    // Palette indices of the texels of an 8-byte RGTC (BC4) block.
+    void (*rgtcIndices)(const uint8_t* block, uint8_t indices[16]);
+    // texels[i] = palette[indices[i]], for 8-bit and 32-bit texels.
+    void (*lookup8)(const uint8_t palette[8], const uint8_t indices[16], uint8_t texels[16]);
+    void (*lookup32)(const uint32_t palette[8], const uint8_t indices[16], uint32_t texels[16]);
+};
+
+enum class BlockKernelsIsa { kScalar, kSse41, kAvx2, kNeon };
+
+// The fastest kernels the CPU supports.
+const BlockKernels& getBlockKernels();
+
+// The kernels of a given instruction set, or null if the CPU or the build doesn't support it.
+const BlockKernels* getBlockKernels(BlockKernelsIsa isa);
+
+// Calls |decodeRows| with ranges of block rows covering [0, numBlockRows). Large images are split
+// across several threads, each decoding a range of rows, and small ones are decoded by the calling
+// thread in a single call.
+void forEachBlockRows(uint32_t numBlockRows, uint32_t blocksPerRow,
+                      const std::function<void(uint32_t beginRow, uint32_t endRow)>& decodeRows);
+
+}  // namespace gfxstream
@@ -0,0 +1,223 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BlockDecoding.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "etc.h"
+#include "rgtc.h"
+
+namespace gfxstream {
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> bytes(size);
+    for (auto& byte : bytes) {
+        byte = rng();
+    }
+    return bytes;
+}
+
+// The size of the images decoded by the tests, with some that aren't multiples of the block size.
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+const Size kSizes[] = {{1, 1}, {3, 5}, {4, 4}, {17, 9}, {64, 64}, {1030, 517}};
+
+TEST(BlockDecodingTest, KernelsMatchScalar) {
+    const BlockKernels& scalar = *getBlockKernels(BlockKernelsIsa::kScalar);
+    const std::vector<uint8_t> blocks = randomBytes(8 * 4096, 1);
+    const std::vector<uint8_t> paletteBytes = randomBytes(32, 2);
+    uint32_t palette32[8];
+    memcpy(palette32, paletteBytes.data(), sizeof(palette32));
+
+    for (BlockKernelsIsa isa :
+         {BlockKernelsIsa::kSse41, BlockKernelsIsa::kAvx2, BlockKernelsIsa::kNeon}) {
+        const BlockKernels* kernels = getBlockKernels(isa);
+        if (!kernels) continue;
+
+        for (size_t i = 0; i < blocks.size(); i += 8) {
+            const uint8_t* block = blocks.data() + i;
+            uint8_t expected[16];
+            uint8_t actual[16];
+            for (bool flipped : {false, true}) {
+                scalar.etcIndices(block, flipped, expected);
+                kernels->etcIndices(block, flipped, actual);
+                ASSERT_EQ(0, memcmp(expected, actual, 16)) << "etcIndices, isa " << int(isa);
+            }
+            scalar.eacIndices(block, expected);
+            kernels->eacIndices(block, actual);
+            ASSERT_EQ(0, memcmp(expected, actual, 16)) << "eacIndices, isa " << int(isa);
+            scalar.rgtcIndices(block, expected);
+            kernels->rgtcIndices(block, actual);
+            ASSERT_EQ(0, memcmp(expected, actual, 16)) << "rgtcIndices, isa " << int(isa);
+
+            uint8_t indices[16];
+            scalar.eacIndices(block, indices);
+            uint8_t expected8[16];
+            uint8_t actual8[16];
+            scalar.lookup8(paletteBytes.data(), indices, expected8);
+            kernels->lookup8(paletteBytes.data(), indices, actual8);
+            ASSERT_EQ(0, memcmp(expected8, actual8, 16)) << "lookup8, isa " << int(isa);
+            uint32_t expected32[16];
+            uint32_t actual32[16];
+            scalar.lookup32(palette32, indices, expected32);
+            kernels->lookup32(palette32, indices, actual32);
+            ASSERT_EQ(0, memcmp(expected32, actual32, 64)) << "lookup32, isa " << int(isa);
+        }
+    }
+}
+
+TEST(BlockDecodingTest, ForEachBlockRowsCoversAllRows) {
+    for (uint32_t numBlockRows : {0u, 1u, 7u, 1000u}) {
+        std::vector<std::atomic<int>> decoded(numBlockRows);
+        forEachBlockRows(numBlockRows, 1024, [&](uint32_t beginRow, uint32_t endRow) {
+            for (uint32_t row = beginRow; row < endRow; row++) {
+                decoded[row]++;
+            }
+        });
+        for (uint32_t row = 0; row < numBlockRows; row++) {
+            EXPECT_EQ(1, decoded[row]) << "row " << row << " of " << numBlockRows;
+        }
+    }
+}
+
+// Decodes an ETC2 image block by block with the scalar decoders.
+void referenceEtcDecode(const uint8_t* in, ETC2ImageFormat format, uint8_t* out, uint32_t width,
+                        uint32_t height, uint32_t stride) {
+    const int pixelSize = etc_get_decoded_pixel_size(format);
+    const bool isSigned = format == EtcSignedR11 || format == EtcSignedRG11;
+    for (uint32_t y = 0; y < height; y += 4) {
+        for (uint32_t x = 0; x < width; x += 4) {
+            uint8_t block[64];
+            uint8_t block2[64];
+            uint8_t alpha[16];
+            switch (format) {
+                case EtcRGB8:
+                    etc2_decode_rgb_block(in, false, block);
+                    in += 8;
+                    break;
+                case EtcRGB8A1:
+                    etc2_decode_rgb_block(in, true, block);
+                    in += 8;
+                    break;
+                case EtcRGBA8:
+                    eac_decode_single_channel_block(in, 1, false, alpha);
+                    etc2_decode_rgb_block(in + 8, false, block);
+                    in += 16;
+                    break;
+                case EtcR11:
+                case EtcSignedR11:
+                    eac_decode_single_channel_block(in, 4, isSigned, block);
+                    in += 8;
+                    break;
+                case EtcRG11:
+                case EtcSignedRG11:
+                    eac_decode_single_channel_block(in, 4, isSigned, block);
+                    eac_decode_single_channel_block(in + 8, 4, isSigned, block2);
+                    in += 16;
+                    break;
+            }
+            for (uint32_t cy = 0; cy < 4 && y + cy < height; cy++) {
+                for (uint32_t cx = 0; cx < 4 && x + cx < width; cx++) {
+                    uint8_t* p = out + (y + cy) * stride + (x + cx) * pixelSize;
+                    const int i = cy * 4 + cx;
+                    switch (format) {
+                        case EtcRGB8:
+                            memcpy(p, block + i * 3, 3);
+                            break;
+                        case EtcRGB8A1:
+                        case EtcR11:
+                        case EtcSignedR11:
+                            memcpy(p, block + i * 4, 4);
+                            break;
+                        case EtcRGBA8:
+                            memcpy(p, block + i * 3, 3);
+                            p[3] = alpha[i];
+                            break;
+                        case EtcRG11:
+                        case EtcSignedRG11:
+                            memcpy(p, block + i * 4, 4);
+                            memcpy(p + 4, block2 + i * 4, 4);
+                            break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(BlockDecodingTest, EtcImagesMatchBlockDecoders) {
+    for (ETC2ImageFormat format :
+         {EtcRGB8, EtcRGBA8, EtcR11, EtcSignedR11, EtcRG11, EtcSignedRG11, EtcRGB8A1}) {
+        for (const Size& size : kSizes) {
+            const std::vector<uint8_t> in = randomBytes(
+                etc_get_encoded_data_size(format, size.width, size.height), size.width + format);
+            // Some padding at the end of the rows, which must be left alone.
+            const uint32_t stride = size.width * etc_get_decoded_pixel_size(format) + 3;
+            std::vector<uint8_t> expected(stride * size.height, 0xcd);
+            std::vector<uint8_t> actual(stride * size.height, 0xcd);
+
+            referenceEtcDecode(in.data(), format, expected.data(), size.width, size.height,
+                               stride);
+            EXPECT_EQ(0, etc2_decode_image(in.data(), format, actual.data(), size.width,
+                                           size.height, stride));
+            EXPECT_TRUE(expected == actual)
+                << "format " << format << ", " << size.width << "x" << size.height;
+        }
+    }
+}
+
+TEST(BlockDecodingTest, RgtcImagesMatchBlockDecoder) {
+    for (RGTCImageFormat format : {BC4_UNORM, BC4_SNORM, BC5_UNORM, BC5_SNORM}) {
+        const size_t pixelSize = rgtc_get_decoded_pixel_size(format);
+        const size_t blockSize = format == BC4_UNORM || format == BC4_SNORM ? 8 : 16;
+        for (const Size& size : kSizes) {
+            const std::vector<uint8_t> in = randomBytes(
+                rgtc_get_encoded_image_size(format, size.width, size.height), size.width + format);
+            const uint32_t stride = size.width * pixelSize + 3;
+            std::vector<uint8_t> expected(stride * size.height, 0xcd);
+            std::vector<uint8_t> actual(stride * size.height, 0xcd);
+
+            const uint8_t* block = in.data();
+            for (uint32_t y = 0; y < size.height; y += 4) {
+                for (uint32_t x = 0; x < size.width; x += 4, block += blockSize) {
+                    uint8_t texels[32];
+                    rgtc_decode_block(block, format, texels);
+                    for (uint32_t cy = 0; cy < 4 && y + cy < size.height; cy++) {
+                        const uint32_t numTexels = std::min(4u, size.width - x);
+                        memcpy(expected.data() + (y + cy) * stride + x * pixelSize,
+                               texels + cy * 4 * pixelSize, numTexels * pixelSize);
+                    }
+                }
+            }
+            EXPECT_EQ(0, rgtc_decode_image(in.data(), format, actual.data(), size.width,
+                                           size.height, stride));
+            EXPECT_TRUE(expected == actual)
+                << "format " << format << ", " << size.width << "x" << size.height;
+        }
+    }
+}
+
+}  // namespace
+}  // namespace gfxstream
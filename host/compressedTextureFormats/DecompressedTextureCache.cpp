@@ -0,0 +1,243 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "DecompressedTextureCache.h"
+
+#include <string.h>
+
+namespace gfxstream {
+namespace {
+
+// XXH64, which hashes several GB/s, so that looking a texture up costs little next to
+// decompressing it.
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t accumulate(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    return rotl(acc, 31) * kPrime1;
+}
+
+uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= accumulate(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+uint64_t hash64(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* p = data;
+    const uint8_t* const end = data + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = accumulate(v1, read64(p));
+            v2 = accumulate(v2, read64(p + 8));
+            v3 = accumulate(v3, read64(p + 16));
+            v4 = accumulate(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += size;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= accumulate(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+}  // namespace
+
+bool DecompressedTextureCache::Key::operator==(const Key& other) const {
+    return format == other.format && width == other.width && height == other.height &&
+           compressedSize == other.compressedSize &&
+           decompressedSize == other.decompressedSize && hash == other.hash;
+}
+
+// static
+DecompressedTextureCache& DecompressedTextureCache::get() {
+    static DecompressedTextureCache* cache = new DecompressedTextureCache();
+    return *cache;
+}
+
+// static
+uint32_t DecompressedTextureCache::astcFormat(uint32_t blockWidth, uint32_t blockHeight) {
+    // Out of the range of the GL enums.
+    return 0xa5c00000u | (blockWidth << 8) | blockHeight;
+}
+
+// static
+DecompressedTextureCache::Key DecompressedTextureCache::makeKey(uint32_t format, uint32_t width,
+                                                                uint32_t height,
+                                                                const uint8_t* compressed,
+                                                                size_t compressedSize,
+                                                                size_t decompressedSize) {
+    const uint64_t seed = (uint64_t(format) << 32) ^ (uint64_t(width) << 16) ^ height ^
+                          (uint64_t(decompressedSize) * kPrime3);
+    return {
+        .format = format,
+        .width = width,
+        .height = height,
+        .compressedSize = compressedSize,
+        .decompressedSize = decompressedSize,
+        .hash = hash64(compressed, compressedSize, seed),
+    };
+}
+
+void DecompressedTextureCache::setMaxBytes(size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMaxBytes.store(maxBytes, std::memory_order_relaxed);
+    evictLocked(maxBytes);
+}
+
+bool DecompressedTextureCache::lookup(const Key& key, const uint8_t* compressed, uint8_t* output) {
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(key.hash);
+        if (it != mEntries.end()) {
+            mLru.splice(mLru.begin(), mLru, it->second);
+            entry = *it->second;
+        }
+    }
+
+    // The data is compared, and copied, out of the lock: the entry stays alive even if it gets
+    // evicted meanwhile. Comparing it rules out hash collisions and costs little next to
+    // decompressing.
+    if (!entry || !(entry->key == key) ||
+        memcmp(entry->compressed.data(), compressed, key.compressedSize) != 0) {
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    memcpy(output, entry->decompressed.data(), key.decompressedSize);
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void DecompressedTextureCache::insert(const Key& key, const uint8_t* compressed,
+                                      const uint8_t* decompressed) {
+    if (entrySize(key) > mMaxBytes.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->compressed.assign(compressed, compressed + key.compressedSize);
+    entry->decompressed.assign(decompressed, decompressed + key.decompressedSize);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    const size_t maxBytes = mMaxBytes.load(std::memory_order_relaxed);
+    if (entrySize(key) > maxBytes) {
+        return;
+    }
+    // Another thread may have added the same texture meanwhile, or one whose hash collides.
+    auto it = mEntries.find(key.hash);
+    if (it != mEntries.end()) {
+        mSizeBytes -= entrySize((*it->second)->key);
+        mLru.erase(it->second);
+        mEntries.erase(it);
+    }
+    evictLocked(maxBytes - entrySize(key));
+    mLru.push_front(std::move(entry));
+    mEntries[key.hash] = mLru.begin();
+    mSizeBytes += entrySize(key);
+}
+
+bool DecompressedTextureCache::getOrDecompress(uint32_t format, uint32_t width, uint32_t height,
+                                               const uint8_t* compressed, size_t compressedSize,
+                                               uint8_t* output, size_t decompressedSize,
+                                               const std::function<bool()>& decompress) {
+    if (!isEnabled()) {
+        return decompress();
+    }
+    const Key key = makeKey(format, width, height, compressed, compressedSize, decompressedSize);
+    if (lookup(key, compressed, output)) {
+        return true;
+    }
+    if (!decompress()) {
+        return false;
+    }
+    insert(key, compressed, output);
+    return true;
+}
+
+DecompressedTextureCache::Stats DecompressedTextureCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return {
+        .hits = mHits.load(std::memory_order_relaxed),
+        .misses = mMisses.load(std::memory_order_relaxed),
+        .evictions = mEvictions.load(std::memory_order_relaxed),
+        .numEntries = mLru.size(),
+        .sizeBytes = mSizeBytes,
+        .maxBytes = mMaxBytes.load(std::memory_order_relaxed),
+    };
+}
+
+void DecompressedTextureCache::resetStats() {
+    mHits.store(0, std::memory_order_relaxed);
+    mMisses.store(0, std::memory_order_relaxed);
+    mEvictions.store(0, std::memory_order_relaxed);
+}
+
+void DecompressedTextureCache::evictLocked(size_t maxBytes) {
+    while (mSizeBytes > maxBytes) {
+        const Key& key = mLru.back()->key;
+        mSizeBytes -= entrySize(key);
+        mEntries.erase(key.hash);
+        mLru.pop_back();
+        mEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace gfxstream
@@ -0,0 +1,121 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace gfxstream {
+
+// A bounded cache of the decompressed data of the textures we decompress on the CPU, keyed by
+// their contents. Guests upload the same compressed assets again and again, from different
+// contexts and processes, and this lets all of them skip decompressing what was decompressed
+// before.
+//
+// There is one cache per process, which is disabled until given a capacity, and evicts the least
+// recently used textures to stay within it. It is safe to use from any thread.
+class DecompressedTextureCache {
+   public:
+    // Identifies a texture by its format, dimensions and a hash of its compressed data. |format|
+    // can be any value that tells apart the formats and the layouts of the decompressed data, such
+    // as the GL internal format; astcFormat() gives the one to use for ASTC.
+    struct Key {
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        size_t compressedSize;
+        size_t decompressedSize;
+        uint64_t hash;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t numEntries;
+        // The memory the entries take, which includes their compressed data.
+        uint64_t sizeBytes;
+        uint64_t maxBytes;
+    };
+
+    static DecompressedTextureCache& get();
+
+    // The format of ASTC textures, which decompress to RGBA8 the same way whatever the API and
+    // color space, so that GLES and Vulkan share them.
+    static uint32_t astcFormat(uint32_t blockWidth, uint32_t blockHeight);
+
+    static Key makeKey(uint32_t format, uint32_t width, uint32_t height, const uint8_t* compressed,
+                       size_t compressedSize, size_t decompressedSize);
+
+    // Sets how much memory the cache may use, evicting what doesn't fit anymore. 0 empties and
+    // disables it.
+    void setMaxBytes(size_t maxBytes);
+
+    bool isEnabled() const { return mMaxBytes.load(std::memory_order_relaxed) != 0; }
+
+    // Copies the decompressed data of the texture to |output|, which holds
+    // |key.decompressedSize| bytes, and returns true if the cache has it.
+    bool lookup(const Key& key, const uint8_t* compressed, uint8_t* output);
+
+    // Adds a texture to the cache, unless it is disabled or the texture doesn't fit.
+    void insert(const Key& key, const uint8_t* compressed, const uint8_t* decompressed);
+
+    // Fills |output| from the cache, or by calling |decompress| if the cache doesn't have the
+    // texture, in which case the result is added to it if |decompress| returns true. Returns
+    // false if |decompress| failed.
+    bool getOrDecompress(uint32_t format, uint32_t width, uint32_t height,
+                         const uint8_t* compressed, size_t compressedSize, uint8_t* output,
+                         size_t decompressedSize, const std::function<bool()>& decompress);
+
+    Stats getStats() const;
+
+    // Forgets the hits, misses and evictions counted so far.
+    void resetStats();
+
+   private:
+    struct Entry {
+        Key key;
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> decompressed;
+    };
+    using EntryList = std::list<std::shared_ptr<const Entry>>;
+
+    static size_t entrySize(const Key& key) { return key.compressedSize + key.decompressedSize; }
+
+    void evictLocked(size_t maxBytes);
+
+    std::atomic<size_t> mMaxBytes{0};
+    std::atomic<uint64_t> mHits{0};
+    std::atomic<uint64_t> mMisses{0};
+    std::atomic<uint64_t> mEvictions{0};
+
+    mutable std::mutex mMutex;
+    // Most recently used first.
+    EntryList mLru;
+    std::unordered_map<uint64_t, EntryList::iterator> mEntries;
+    size_t mSizeBytes = 0;
+};
+
+}  // namespace gfxstream
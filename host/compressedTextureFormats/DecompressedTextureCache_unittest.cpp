@@ -0,0 +1,212 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "DecompressedTextureCache.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+constexpr uint32_t kFormat = 0x9274;  // GL_COMPRESSED_RGB8_ETC2
+
+// A fake decompression, which turns every compressed byte into 4 and counts how many times it
+// ran.
+struct FakeDecompressor {
+    bool decompress(const std::vector<uint8_t>& in, std::vector<uint8_t>* out) {
+        calls++;
+        for (size_t i = 0; i < out->size(); i++) {
+            (*out)[i] = in[i / 4] + i % 4;
+        }
+        return true;
+    }
+
+    int calls = 0;
+};
+
+std::vector<uint8_t> makeData(size_t size, uint8_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = seed + i * 7;
+    }
+    return data;
+}
+
+class DecompressedTextureCacheTest : public ::testing::Test {
+   protected:
+    // Decompresses |in|, as a |width|x|height| texture, through the cache.
+    std::vector<uint8_t> decompress(const std::vector<uint8_t>& in, uint32_t width,
+                                    uint32_t height, uint32_t format = kFormat) {
+        std::vector<uint8_t> out(in.size() * 4);
+        EXPECT_TRUE(mCache.getOrDecompress(format, width, height, in.data(), in.size(),
+                                           out.data(), out.size(), [&] {
+                                               return mDecompressor.decompress(in, &out);
+                                           }));
+        return out;
+    }
+
+    DecompressedTextureCache mCache;
+    FakeDecompressor mDecompressor;
+};
+
+TEST_F(DecompressedTextureCacheTest, DisabledByDefault) {
+    const std::vector<uint8_t> in = makeData(64, 1);
+    const std::vector<uint8_t> first = decompress(in, 8, 8);
+    EXPECT_EQ(first, decompress(in, 8, 8));
+    EXPECT_EQ(2, mDecompressor.calls);
+
+    const DecompressedTextureCache::Stats stats = mCache.getStats();
+    EXPECT_EQ(0, stats.hits);
+    EXPECT_EQ(0, stats.misses);
+    EXPECT_EQ(0, stats.numEntries);
+}
+
+TEST_F(DecompressedTextureCacheTest, Hits) {
+    mCache.setMaxBytes(1 << 20);
+    const std::vector<uint8_t> in = makeData(64, 1);
+    const std::vector<uint8_t> first = decompress(in, 8, 8);
+    EXPECT_EQ(first, decompress(in, 8, 8));
+    // Copies of the data hit too.
+    EXPECT_EQ(first, decompress(std::vector<uint8_t>(in), 8, 8));
+    EXPECT_EQ(1, mDecompressor.calls);
+
+    const DecompressedTextureCache::Stats stats = mCache.getStats();
+    EXPECT_EQ(2, stats.hits);
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(1, stats.numEntries);
+    EXPECT_EQ(64 + 256, stats.sizeBytes);
+
+    mCache.resetStats();
+    EXPECT_EQ(0, mCache.getStats().hits);
+    EXPECT_EQ(1, mCache.getStats().numEntries);
+}
+
+TEST_F(DecompressedTextureCacheTest, KeyedByFormatDimensionsAndData) {
+    mCache.setMaxBytes(1 << 20);
+    const std::vector<uint8_t> in = makeData(64, 1);
+    std::vector<uint8_t> changed = in;
+    changed[63]++;
+
+    decompress(in, 8, 8);
+    decompress(in, 16, 4);
+    decompress(in, 8, 8, kFormat + 1);
+    decompress(changed, 8, 8);
+    EXPECT_EQ(4, mDecompressor.calls);
+    EXPECT_EQ(4, mCache.getStats().numEntries);
+
+    decompress(in, 8, 8);
+    decompress(in, 16, 4);
+    decompress(in, 8, 8, kFormat + 1);
+    decompress(changed, 8, 8);
+    EXPECT_EQ(4, mDecompressor.calls);
+}
+
+TEST_F(DecompressedTextureCacheTest, HashCollisions) {
+    mCache.setMaxBytes(1 << 20);
+    const std::vector<uint8_t> in = makeData(64, 1);
+    std::vector<uint8_t> out(256);
+    DecompressedTextureCache::Key key =
+        DecompressedTextureCache::makeKey(kFormat, 8, 8, in.data(), in.size(), out.size());
+    mCache.insert(key, in.data(), decompress(in, 8, 8).data());
+
+    // Other data with the same key is told apart.
+    const std::vector<uint8_t> other = makeData(64, 2);
+    EXPECT_FALSE(mCache.lookup(key, other.data(), out.data()));
+    EXPECT_TRUE(mCache.lookup(key, in.data(), out.data()));
+}
+
+TEST_F(DecompressedTextureCacheTest, EvictsLeastRecentlyUsed) {
+    // Room for 3 textures of 64 + 256 bytes.
+    mCache.setMaxBytes(3 * 320 + 100);
+    const std::vector<uint8_t> a = makeData(64, 1);
+    const std::vector<uint8_t> b = makeData(64, 2);
+    const std::vector<uint8_t> c = makeData(64, 3);
+    const std::vector<uint8_t> d = makeData(64, 4);
+    decompress(a, 8, 8);
+    decompress(b, 8, 8);
+    decompress(c, 8, 8);
+    decompress(a, 8, 8);
+    // Evicts b.
+    decompress(d, 8, 8);
+    EXPECT_EQ(4, mDecompressor.calls);
+    EXPECT_EQ(1, mCache.getStats().evictions);
+
+    decompress(a, 8, 8);
+    decompress(c, 8, 8);
+    decompress(d, 8, 8);
+    EXPECT_EQ(4, mDecompressor.calls);
+    decompress(b, 8, 8);
+    EXPECT_EQ(5, mDecompressor.calls);
+    EXPECT_LE(mCache.getStats().sizeBytes, 3 * 320 + 100);
+
+    // Textures that don't fit aren't cached.
+    const std::vector<uint8_t> big = makeData(1024, 5);
+    decompress(big, 32, 32);
+    decompress(big, 32, 32);
+    EXPECT_EQ(7, mDecompressor.calls);
+
+    mCache.setMaxBytes(320);
+    EXPECT_EQ(1, mCache.getStats().numEntries);
+    mCache.setMaxBytes(0);
+    EXPECT_FALSE(mCache.isEnabled());
+    EXPECT_EQ(0, mCache.getStats().numEntries);
+    EXPECT_EQ(0, mCache.getStats().sizeBytes);
+}
+
+TEST_F(DecompressedTextureCacheTest, FailuresAreNotCached) {
+    mCache.setMaxBytes(1 << 20);
+    const std::vector<uint8_t> in = makeData(64, 1);
+    std::vector<uint8_t> out(256);
+    EXPECT_FALSE(mCache.getOrDecompress(kFormat, 8, 8, in.data(), in.size(), out.data(),
+                                        out.size(), [] { return false; }));
+    EXPECT_EQ(0, mCache.getStats().numEntries);
+}
+
+TEST_F(DecompressedTextureCacheTest, Concurrent) {
+    mCache.setMaxBytes(4 * 320);
+    std::vector<std::vector<uint8_t>> inputs;
+    for (int i = 0; i < 8; i++) {
+        inputs.push_back(makeData(64, i));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            FakeDecompressor decompressor;
+            for (int i = 0; i < 1000; i++) {
+                const std::vector<uint8_t>& in = inputs[(i * (t + 1)) % inputs.size()];
+                std::vector<uint8_t> out(256);
+                std::vector<uint8_t> expected(256);
+                decompressor.decompress(in, &expected);
+                ASSERT_TRUE(mCache.getOrDecompress(
+                    kFormat, 8, 8, in.data(), in.size(), out.data(), out.size(),
+                    [&] { return decompressor.decompress(in, &out); }));
+                ASSERT_EQ(expected, out);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const DecompressedTextureCache::Stats stats = mCache.getStats();
+    EXPECT_EQ(4000, stats.hits + stats.misses);
+    EXPECT_LE(stats.sizeBytes, 4 * 320);
+}
+
+}  // namespace
+}  // namespace gfxstream
@@ -12,7 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <GLcommon/etc.h>
+#include "etc.h"
 
 #include <gtest/gtest.h>
 #include <stdio.h>
@@ -14,6 +14,8 @@
 
 #include "etc.h"
 
+#include "BlockDecoding.h"
+
 #include <algorithm>
 #include <assert.h>
 #include <string.h>
@@ -293,8 +295,9 @@ static void etc2_T_H_index(const int* clrTable, etc1_uint32 low,
 //     from https://www.khronos.org/registry/gles/specs/3.0/es_spec_3.0.4.pdf
 //     page 289
 
-static void etc2_decode_block_T(etc1_uint32 high, etc1_uint32 low,
-        bool isPunchthroughAlpha, bool opaque, etc1_byte* pOut) {
+// The 4 colors of a block in the T mode, as R, G, B triplets.
+
+static void etc2_get_T_colors(etc1_uint32 high, int clrTable[12]) {
     const int LUT[] = {3, 6, 11, 16, 23, 32, 41, 64};
     int r1, r2, g1, g2, b1, b2;
     r1 = convert4To8((((high >> 27) & 3) << 2) | ((high >> 24) & 3));
@@ -306,7 +309,6 @@ static void etc2_decode_block_T(etc1_uint32 high, etc1_uint32 low,
     // 3 bits intense modifier
     int intenseIdx = (((high >> 2) & 3) << 1) | (high & 1);
     int intenseMod = LUT[intenseIdx];
-    int clrTable[12];
     clrTable[0] = r1;
     clrTable[1] = g1;
     clrTable[2] = b1;
@@ -319,11 +321,18 @@ static void etc2_decode_block_T(etc1_uint32 high, etc1_uint32 low,
     clrTable[9] = clamp(r2 - intenseMod);
     clrTable[10] = clamp(g2 - intenseMod);
     clrTable[11] = clamp(b2 - intenseMod);
-    etc2_T_H_index(clrTable, low, isPunchthroughAlpha, opaque, pOut);
 }
 
-static void etc2_decode_block_H(etc1_uint32 high, etc1_uint32 low,
+static void etc2_decode_block_T(etc1_uint32 high, etc1_uint32 low,
         bool isPunchthroughAlpha, bool opaque, etc1_byte* pOut) {
+    int clrTable[12];
+    etc2_get_T_colors(high, clrTable);
+    etc2_T_H_index(clrTable, low, isPunchthroughAlpha, opaque, pOut);
+}
+
+// The 4 colors of a block in the H mode, as R, G, B triplets.
+
+static void etc2_get_H_colors(etc1_uint32 high, int clrTable[12]) {
     const int LUT[] = {3, 6, 11, 16, 23, 32, 41, 64};
     int r1, r2, g1, g2, b1, b2;
     r1 = convert4To8(high >> 27);
@@ -337,7 +346,6 @@ static void etc2_decode_block_H(etc1_uint32 high, etc1_uint32 low,
     intenseIdx |= (high & 1) << 1;
     intenseIdx |= (((r1 << 16) | (g1 << 8) | b1) >= ((r2 << 16) | (g2 << 8) | b2));
     int intenseMod = LUT[intenseIdx];
-    int clrTable[12];
     clrTable[0] = clamp(r1 + intenseMod);
     clrTable[1] = clamp(g1 + intenseMod);
     clrTable[2] = clamp(b1 + intenseMod);
@@ -350,6 +358,12 @@ static void etc2_decode_block_H(etc1_uint32 high, etc1_uint32 low,
     clrTable[9] = clamp(r2 - intenseMod);
     clrTable[10] = clamp(g2 - intenseMod);
     clrTable[11] = clamp(b2 - intenseMod);
+}
+
+static void etc2_decode_block_H(etc1_uint32 high, etc1_uint32 low,
+        bool isPunchthroughAlpha, bool opaque, etc1_byte* pOut) {
+    int clrTable[12];
+    etc2_get_H_colors(high, clrTable);
     etc2_T_H_index(clrTable, low, isPunchthroughAlpha, opaque, pOut);
 }
 
@@ -857,107 +871,230 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
     return 0;
 }
 
-// Decode an entire image.
-// pIn - pointer to encoded data.
-// pOut - pointer to the image data. Will be written such that the Red component of
-//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset. Must be
-//        large enough to store entire image.
+// The colors of a block in the individual, differential, T or H mode, as RGBA texels indexed by
+// the output of BlockKernels::etcIndices(). Returns false for the planar mode, which doesn't use
+// a palette. Gives the same results as etc2_decode_rgb_block().
 
+static bool etc2_get_rgb_palette(const etc1_byte* pIn, bool isPunchthroughAlpha,
+                                 etc1_byte palette[8][4], bool* flipped) {
+    etc1_uint32 high = (pIn[0] << 24) | (pIn[1] << 16) | (pIn[2] << 8) | pIn[3];
+    bool opaque = (high >> 1) & 1;
+    // In punchthrough alpha blocks which aren't opaque, index 2 stands for a transparent black.
+    bool hasTransparent = isPunchthroughAlpha && !opaque;
+    int r1, r2, g1, g2, b1, b2;
+    if (isPunchthroughAlpha || high & 2) {
+        // differential
+        int rBase = high >> 27;
+        int gBase = high >> 19;
+        int bBase = high >> 11;
+        bool isT = isOverflowed(rBase, high >> 24);
+        bool isH = !isT && isOverflowed(gBase, high >> 16);
+        if (isT || isH) {
+            // There are no subblocks, so both halves of the palette are the same.
+            int clrTable[12];
+            if (isT) {
+                etc2_get_T_colors(high, clrTable);
+            } else {
+                etc2_get_H_colors(high, clrTable);
+            }
+            for (int i = 0; i < 4; i++) {
+                if (hasTransparent && i == 2) {
+                    memset(palette[i], 0, 4);
+                } else {
+                    palette[i][0] = clrTable[i * 3];
+                    palette[i][1] = clrTable[i * 3 + 1];
+                    palette[i][2] = clrTable[i * 3 + 2];
+                    palette[i][3] = 255;
+                }
+                memcpy(palette[i + 4], palette[i], 4);
+            }
+            *flipped = false;
+            return true;
+        }
+        if (isOverflowed(bBase, high >> 8)) {
+            return false;
+        }
+        r1 = convert5To8(rBase);
+        r2 = convertDiff(rBase, high >> 24);
+        g1 = convert5To8(gBase);
+        g2 = convertDiff(gBase, high >> 16);
+        b1 = convert5To8(bBase);
+        b2 = convertDiff(bBase, high >> 8);
+    } else {
+        // not differential
+        r1 = convert4To8(high >> 28);
+        r2 = convert4To8(high >> 24);
+        g1 = convert4To8(high >> 20);
+        g2 = convert4To8(high >> 16);
+        b1 = convert4To8(high >> 12);
+        b2 = convert4To8(high >> 8);
+    }
+    int tableIndexA = 7 & (high >> 5);
+    int tableIndexB = 7 & (high >> 2);
+    const int* rgbModifierTable = opaque || !isPunchthroughAlpha ?
+                                  kRGBModifierTable : kRGBOpaqueModifierTable;
+    const int* tableA = rgbModifierTable + tableIndexA * 4;
+    const int* tableB = rgbModifierTable + tableIndexB * 4;
+    for (int i = 0; i < 4; i++) {
+        etc1_byte* a = palette[i];
+        etc1_byte* b = palette[i + 4];
+        if (hasTransparent && i == 2) {
+            memset(a, 0, 4);
+            memset(b, 0, 4);
+            continue;
+        }
+        a[0] = clamp(r1 + tableA[i]);
+        a[1] = clamp(g1 + tableA[i]);
+        a[2] = clamp(b1 + tableA[i]);
+        a[3] = 255;
+        b[0] = clamp(r2 + tableB[i]);
+        b[1] = clamp(g2 + tableB[i]);
+        b[2] = clamp(b2 + tableB[i]);
+        b[3] = 255;
+    }
+    *flipped = (high & 1) != 0;
+    return true;
+}
 
-int etc2_decode_image(const etc1_byte* pIn, ETC2ImageFormat format,
-        etc1_byte* pOut,
-        etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 stride) {
-    etc1_byte block[std::max({ETC1_DECODED_BLOCK_SIZE,
-                              ETC2_DECODED_RGB8A1_BLOCK_SIZE,
-                              EAC_DECODED_R11_BLOCK_SIZE,
-                              EAC_DECODED_RG11_BLOCK_SIZE})];
-    etc1_byte alphaBlock[EAC_DECODED_ALPHA_BLOCK_SIZE];
+// Decodes the RGB part of an ETC2 block as 16 RGBA texels.
+
+static void etc2_decode_rgba_texels(const etc1_byte* pIn, bool isPunchthroughAlpha,
+                                    const gfxstream::BlockKernels& kernels,
+                                    etc1_uint32 texels[16]) {
+    etc1_uint32 palette[8];
+    bool flipped;
+    if (etc2_get_rgb_palette(pIn, isPunchthroughAlpha,
+                             reinterpret_cast<etc1_byte(*)[4]>(palette), &flipped)) {
+        etc1_byte indices[16];
+        kernels.etcIndices(pIn, flipped, indices);
+        kernels.lookup32(palette, indices, texels);
+    } else {
+        etc1_uint32 high = (pIn[0] << 24) | (pIn[1] << 16) | (pIn[2] << 8) | pIn[3];
+        etc1_uint32 low = (pIn[4] << 24) | (pIn[5] << 16) | (pIn[6] << 8) | pIn[7];
+        etc2_decode_block_P(high, low, true, reinterpret_cast<etc1_byte*>(texels));
+    }
+}
 
-    etc1_uint32 encodedWidth = (width + 3) & ~3;
-    etc1_uint32 encodedHeight = (height + 3) & ~3;
+// The values of an EAC block, as indexed by BlockKernels::eacIndices(). Gives the same results as
+// eac_decode_single_channel_block().
 
-    int pixelSize = etc_get_decoded_pixel_size(format);
-    bool isSigned = (format == EtcSignedR11 || format == EtcSignedRG11);
+static void eac_get_palette(const etc1_byte* pIn, bool isSigned, etc1_byte palette[8]) {
+    int base_codeword = isSigned ? reinterpret_cast<const char*>(pIn)[0]
+                                 : pIn[0];
+    if (base_codeword == -128) base_codeword = -127;
+    int multiplier = pIn[1] >> 4;
+    const int* table = kAlphaModifierTable + (pIn[1] & 15) * 8;
+    for (int i = 0; i < 8; i++) {
+        palette[i] = clamp(base_codeword + table[i] * multiplier);
+    }
+}
 
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
-        etc1_uint32 yEnd = height - y;
-        if (yEnd > 4) {
-            yEnd = 4;
+static void eac_get_float_palette(const etc1_byte* pIn, bool isSigned, float palette[8]) {
+    int base_codeword = isSigned ? reinterpret_cast<const char*>(pIn)[0]
+                                 : pIn[0];
+    if (base_codeword == -128) base_codeword = -127;
+    int multiplier = pIn[1] >> 4;
+    const int* table = kAlphaModifierTable + (pIn[1] & 15) * 8;
+    for (int i = 0; i < 8; i++) {
+        int modifierValue = table[i];
+        int decoded = (base_codeword + modifierValue * multiplier) * 8;
+        if (multiplier == 0) {
+            decoded += modifierValue;
         }
-        for (etc1_uint32 x = 0; x < encodedWidth; x += 4) {
-            etc1_uint32 xEnd = width - x;
-            if (xEnd > 4) {
-                xEnd = 4;
-            }
+        if (isSigned) {
+            palette[i] = (float)clampSigned1023(decoded) / 1023.0;
+        } else {
+            palette[i] = (float)clamp2047(decoded + 4) / 2047.0;
+        }
+    }
+}
+
+static void eac_decode_float_texels(const etc1_byte* pIn, bool isSigned,
+                                    const gfxstream::BlockKernels& kernels,
+                                    etc1_uint32 texels[16]) {
+    float values[8];
+    etc1_uint32 palette[8];
+    etc1_byte indices[16];
+    eac_get_float_palette(pIn, isSigned, values);
+    memcpy(palette, values, sizeof(palette));
+    kernels.eacIndices(pIn, indices);
+    kernels.lookup32(palette, indices, texels);
+}
+
+// Decodes the blocks of rows [beginRow, endRow) of an image, in the layout of etc2_decode_image().
+
+static void etc2_decode_block_rows(const etc1_byte* pIn, ETC2ImageFormat format, etc1_byte* pOut,
+                                   etc1_uint32 width, etc1_uint32 height, etc1_uint32 stride,
+                                   etc1_uint32 beginRow, etc1_uint32 endRow) {
+    const gfxstream::BlockKernels& kernels = gfxstream::getBlockKernels();
+    const etc1_uint32 blocksPerRow = (width + 3) / 4;
+    const etc1_uint32 encodedBlockSize = etc_get_encoded_data_size(format, 4, 4);
+    const int pixelSize = etc_get_decoded_pixel_size(format);
+    const bool isSigned = (format == EtcSignedR11 || format == EtcSignedRG11);
+
+    pIn += (size_t)beginRow * blocksPerRow * encodedBlockSize;
+    for (etc1_uint32 blockRow = beginRow; blockRow < endRow; blockRow++) {
+        const etc1_uint32 y = blockRow * 4;
+        const etc1_uint32 yEnd = std::min(height - y, 4u);
+        for (etc1_uint32 x = 0; x < width; x += 4, pIn += encodedBlockSize) {
+            const etc1_uint32 xEnd = std::min(width - x, 4u);
+            // Up to 8 bytes per texel, in row-major order.
+            etc1_uint32 texels[16];
+            etc1_uint32 texels2[16];
+            etc1_byte alpha[16];
             switch (format) {
-                case EtcRGBA8:
-                    eac_decode_single_channel_block(pIn, 1, false, alphaBlock);
-                    pIn += EAC_ENCODE_ALPHA_BLOCK_SIZE;
-                    // Do not break
-                    // Fall through to EtcRGB8 to decode the RGB part
                 case EtcRGB8:
-                    etc2_decode_rgb_block(pIn, false, block);
-                    pIn += ETC1_ENCODED_BLOCK_SIZE;
-                    break;
                 case EtcRGB8A1:
-                    etc2_decode_rgb_block(pIn, true, block);
-                    pIn += ETC1_ENCODED_BLOCK_SIZE;
+                    etc2_decode_rgba_texels(pIn, format == EtcRGB8A1, kernels, texels);
+                    break;
+                case EtcRGBA8: {
+                    etc1_byte alphaPalette[8];
+                    etc1_byte alphaIndices[16];
+                    eac_get_palette(pIn, false, alphaPalette);
+                    kernels.eacIndices(pIn, alphaIndices);
+                    kernels.lookup8(alphaPalette, alphaIndices, alpha);
+                    etc2_decode_rgba_texels(pIn + EAC_ENCODE_ALPHA_BLOCK_SIZE, false, kernels,
+                                            texels);
                     break;
+                }
                 case EtcR11:
                 case EtcSignedR11:
-                    eac_decode_single_channel_block(pIn, 4, isSigned, block);
-                    pIn += EAC_ENCODE_R11_BLOCK_SIZE;
+                    eac_decode_float_texels(pIn, isSigned, kernels, texels);
                     break;
                 case EtcRG11:
                 case EtcSignedRG11:
-                    // r channel
-                    eac_decode_single_channel_block(pIn, 4, isSigned, block);
-                    pIn += EAC_ENCODE_R11_BLOCK_SIZE;
-                    // g channel
-                    eac_decode_single_channel_block(pIn, 4, isSigned,
-                            block + EAC_DECODED_R11_BLOCK_SIZE);
-                    pIn += EAC_ENCODE_R11_BLOCK_SIZE;
+                    eac_decode_float_texels(pIn, isSigned, kernels, texels);
+                    eac_decode_float_texels(pIn + EAC_ENCODE_R11_BLOCK_SIZE, isSigned, kernels,
+                                            texels2);
                     break;
                 default:
                     assert(0);
             }
             for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
-                etc1_byte* p = pOut + pixelSize * x + stride * (y + cy);
+                etc1_byte* p = pOut + pixelSize * x + (size_t)stride * (y + cy);
+                const etc1_uint32* row = texels + cy * 4;
                 switch (format) {
-                    case EtcRGB8:
                     case EtcRGB8A1:
                     case EtcR11:
-                    case EtcSignedR11: {
-                            const etc1_byte* q = block + (cy * 4) * pixelSize;
-                            memcpy(p, q, xEnd * pixelSize);
+                    case EtcSignedR11:
+                        memcpy(p, row, xEnd * 4);
+                        break;
+                    case EtcRGB8:
+                        for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
+                            memcpy(p + cx * 3, row + cx, 3);
                         }
                         break;
-                    case EtcRG11:
-                    case EtcSignedRG11: {
-                            const etc1_byte* r = block + cy * EAC_DECODED_R11_BLOCK_SIZE / 4;
-                            const etc1_byte* g = block + cy * EAC_DECODED_R11_BLOCK_SIZE / 4 + EAC_DECODED_R11_BLOCK_SIZE;
-                            int channelSize = pixelSize / 2;
-                            for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
-                                memcpy(p, r, channelSize);
-                                p += channelSize;
-                                r += channelSize;
-                                memcpy(p, g, channelSize);
-                                p += channelSize;
-                                g += channelSize;
-                            }
+                    case EtcRGBA8:
+                        memcpy(p, row, xEnd * 4);
+                        for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
+                            p[cx * 4 + 3] = alpha[cy * 4 + cx];
                         }
                         break;
-                    case EtcRGBA8: {
-                            const etc1_byte* q = block + (cy * 4) * 3;
-                            const etc1_byte* qa = alphaBlock + cy * 4;
-                            for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
-                                // copy rgb data
-                                memcpy(p, q, 3);
-                                p += 3;
-                                q += 3;
-                                *p++ = *qa++;
-                            }
+                    case EtcRG11:
+                    case EtcSignedRG11:
+                        for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
+                            memcpy(p + cx * 8, row + cx, 4);
+                            memcpy(p + cx * 8 + 4, texels2 + cy * 4 + cx, 4);
                         }
                         break;
                     default:
@@ -966,6 +1103,26 @@ int etc2_decode_image(const etc1_byte* pIn, ETC2ImageFormat format,
             }
         }
     }
+}
+
+// Decode an entire image.
+// pIn - pointer to encoded data.
+// pOut - pointer to the image data. Will be written such that the Red component of
+//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset. Must be
+//        large enough to store entire image.
+// The texels of each block are looked up in a palette with the fastest BlockKernels available,
+// and large images are decoded by several threads.
+
+int etc2_decode_image(const etc1_byte* pIn, ETC2ImageFormat format,
+        etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 stride) {
+    const etc1_uint32 blocksPerRow = (width + 3) / 4;
+    gfxstream::forEachBlockRows((height + 3) / 4, blocksPerRow,
+                                [=](etc1_uint32 beginRow, etc1_uint32 endRow) {
+                                    etc2_decode_block_rows(pIn, format, pOut, width, height,
+                                                           stride, beginRow, endRow);
+                                });
     return 0;
 }
 
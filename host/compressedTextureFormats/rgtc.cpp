@@ -0,0 +1,209 @@
+// Copyright 2009 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rgtc.h"
+
+#include "BlockDecoding.h"
+
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+#include <type_traits>
+
+// From https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_texture_compression_rgtc.txt
+// according to the spec
+// RGTC1_RED = BC4_UNORM,
+// RGTC1_SIGNED_RED = BC4_SNORM,
+// RGTC2_RG = BC5_UNORM,
+// RGTC2_SIGNED_RG = BC5_SNORM.
+// the full codec spec can be found here
+// https://docs.microsoft.com/en-gb/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-block-compression#bc5
+
+static constexpr int kBlockSize = 4;
+
+inline size_t rgtc_get_block_size(RGTCImageFormat format) {
+    switch (format) {
+    case BC4_UNORM:
+    case BC4_SNORM:
+        return 8;
+    case BC5_UNORM:
+    case BC5_SNORM:
+        return 16;
+    default:
+        assert(0);
+        return 0;
+    }
+}
+
+size_t rgtc_get_decoded_pixel_size(RGTCImageFormat format) {
+    switch (format) {
+        case BC4_UNORM:
+        case BC4_SNORM:
+            return 1;
+        case BC5_UNORM:
+        case BC5_SNORM:
+            return 2;
+        default:
+            assert(0);
+            return 0;
+    }
+}
+
+template <typename genType>
+struct get_expand_type {};
+
+template <>
+struct get_expand_type<int8_t> {
+    typedef int32_t type;
+};
+
+template <>
+struct get_expand_type<uint8_t> {
+    typedef uint32_t type;
+};
+
+// The 8 values a subblock indexes, d0 and d1 being the extra ones of the 4-interpolated-values
+// mode.
+template <class T>
+void rgtc_get_palette(const uint8_t* data, T colors[8], T d0, T d1) {
+    T r0 = static_cast<T>(data[0]);
+    T r1 = static_cast<T>(data[1]);
+    colors[0] = r0;
+    colors[1] = r1;
+    typename get_expand_type<T>::type c0 = r0;
+    typename get_expand_type<T>::type c1 = r1;
+    // The interpolated values are rounded as x / n + 0.5f truncated toward zero would be, in
+    // integers: (2 * x + n) / (2 * n) truncates toward zero too.
+    if (c0 > c1) {
+        // 6 interpolated color values
+        for (int i = 2; i < 8; i++) {
+            colors[i] = static_cast<T>((2 * (c0 * (8 - i) + c1 * (i - 1)) + 7) / 14);
+        }
+    } else {
+        // 4 interpolated color values
+        for (int i = 2; i < 6; i++) {
+            colors[i] = static_cast<T>((2 * (c0 * (6 - i) + c1 * (i - 1)) + 5) / 10);
+        }
+        colors[6] = d0;
+        colors[7] = d1;
+    }
+}
+
+template <class T>
+void rgtc_decode_subblock(const uint32_t* data, T* out, int step, T d0, T d1 ) {
+    uint64_t color_indexs = ((uint64_t)data[1] << 32 | data[0]) >> 16;
+    T colors[8];
+    rgtc_get_palette<T>(reinterpret_cast<const uint8_t*>(data), colors, d0, d1);
+    uint64_t index = color_indexs;
+    for (int i = 0 ; i < 16 ; i ++) {
+        *out = colors[index & 0x7];
+        out += step;
+        index >>= 3;
+    }
+}
+
+void rgtc_decode_block(const uint8_t* in, RGTCImageFormat format, uint8_t* out) {
+    switch (format) {
+    case BC4_UNORM:
+        rgtc_decode_subblock<uint8_t>((const uint32_t*)in, out, 1, 0, 1);
+        break;
+    case BC4_SNORM:
+        rgtc_decode_subblock<int8_t>((const uint32_t*)in, (int8_t*)out, 1, -1, 1);
+        break;
+    case BC5_UNORM:
+        rgtc_decode_subblock<uint8_t>((const uint32_t*)in, out, 2, 0, 1);
+        rgtc_decode_subblock<uint8_t>((const uint32_t*)in + 2, out + 1, 2, 0, 1);
+        break;
+    case BC5_SNORM:
+        rgtc_decode_subblock<int8_t>((const uint32_t*)in, (int8_t*)out, 2, -1, 1);
+        rgtc_decode_subblock<int8_t>((const uint32_t*)in + 2, (int8_t*)(out + 1), 2, -1, 1);
+        break;
+    }
+}
+
+// Decodes a subblock into 16 values, the same as rgtc_decode_subblock() does.
+static void rgtc_decode_texels(const uint8_t* in, bool isSigned,
+                               const gfxstream::BlockKernels& kernels, uint8_t texels[16]) {
+    uint8_t palette[8];
+    if (isSigned) {
+        rgtc_get_palette<int8_t>(in, reinterpret_cast<int8_t*>(palette), -1, 1);
+    } else {
+        rgtc_get_palette<uint8_t>(in, palette, 0, 1);
+    }
+    uint8_t indices[16];
+    kernels.rgtcIndices(in, indices);
+    kernels.lookup8(palette, indices, texels);
+}
+
+// Decodes the blocks of rows [beginRow, endRow) of an image, in the layout of rgtc_decode_image().
+static void rgtc_decode_block_rows(const uint8_t* in, RGTCImageFormat format, uint8_t* out,
+                                   uint32_t width, uint32_t height, uint32_t stride,
+                                   uint32_t beginRow, uint32_t endRow) {
+    const gfxstream::BlockKernels& kernels = gfxstream::getBlockKernels();
+    const size_t data_block_size = rgtc_get_block_size(format);
+    const size_t texel_size = rgtc_get_decoded_pixel_size(format);
+    const bool isSigned = format == BC4_SNORM || format == BC5_SNORM;
+    const uint32_t blocksPerRow = (width + kBlockSize - 1) / kBlockSize;
+
+    const uint8_t* data_in = in + (size_t)beginRow * blocksPerRow * data_block_size;
+    for (uint32_t blockRow = beginRow; blockRow < endRow; blockRow++) {
+        const uint32_t y = blockRow * kBlockSize;
+        const uint32_t yEnd = std::min<uint32_t>(height - y, kBlockSize);
+        for (uint32_t x = 0; x < width; x += kBlockSize, data_in += data_block_size) {
+            const uint32_t xEnd = std::min<uint32_t>(width - x, kBlockSize);
+            // BC5 texels interleave the red and green subblocks.
+            uint8_t texels[32];
+            if (texel_size == 1) {
+                rgtc_decode_texels(data_in, isSigned, kernels, texels);
+            } else {
+                uint8_t red[16];
+                uint8_t green[16];
+                rgtc_decode_texels(data_in, isSigned, kernels, red);
+                rgtc_decode_texels(data_in + 8, isSigned, kernels, green);
+                for (int i = 0; i < 16; i++) {
+                    texels[i * 2] = red[i];
+                    texels[i * 2 + 1] = green[i];
+                }
+            }
+            const size_t rowSize = kBlockSize * texel_size;
+            for (uint32_t cy = 0; cy < yEnd; cy++) {
+                uint8_t* data_out = out + (size_t)(y + cy) * stride + x * texel_size;
+                if (xEnd == kBlockSize) {
+                    std::memcpy(data_out, texels + rowSize * cy, rowSize);
+                } else {
+                    std::memcpy(data_out, texels + rowSize * cy, xEnd * texel_size);
+                }
+            }
+        }
+    }
+}
+
+// The palette lookups use the fastest BlockKernels available, and large images are decoded by
+// several threads.
+int rgtc_decode_image(const uint8_t* in, RGTCImageFormat format, uint8_t* out, uint32_t width,
+                      uint32_t height, uint32_t stride) {
+    const uint32_t blocksPerRow = (width + kBlockSize - 1) / kBlockSize;
+    gfxstream::forEachBlockRows((height + kBlockSize - 1) / kBlockSize, blocksPerRow,
+                                [=](uint32_t beginRow, uint32_t endRow) {
+                                    rgtc_decode_block_rows(in, format, out, width, height, stride,
+                                                           beginRow, endRow);
+                                });
+    return 0;
+}
+
+size_t rgtc_get_encoded_image_size(RGTCImageFormat format, uint32_t width, uint32_t height) {
+    uint32_t w = (width + kBlockSize - 1) / kBlockSize;
+    uint32_t h = (height + kBlockSize - 1) / kBlockSize;
+    return w * h * rgtc_get_block_size(format);
+}
\ No newline at end of file
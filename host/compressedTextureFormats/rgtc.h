@@ -33,6 +33,12 @@ extern "C" {
 int rgtc_decode_image(const uint8_t* pIn, RGTCImageFormat format, uint8_t* pOut, uint32_t width,
                       uint32_t height, uint32_t stride);
 
+// Decode a block.
+// pIn - pointer to the 8 (BC4) or 16 (BC5) bytes of the block.
+// pOut - pointer to the 4 x 4 texels of the block, in row-major order, with 1 (BC4) or 2 (BC5)
+//        bytes per texel.
+void rgtc_decode_block(const uint8_t* pIn, RGTCImageFormat format, uint8_t* pOut);
+
 size_t rgtc_get_encoded_image_size(RGTCImageFormat format, uint32_t width, uint32_t height);
 
 size_t rgtc_get_decoded_pixel_size(RGTCImageFormat format);
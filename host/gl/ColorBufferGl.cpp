@@ -23,6 +23,7 @@
 #include "DebugGl.h"
 #include "OpenGLESDispatch/DispatchTables.h"
 #include "OpenGLESDispatch/EGLDispatch.h"
+#include "PixelUnpackBufferRing.h"
 #include "RenderThreadInfoGl.h"
 #include "TextureDraw.h"
 #include "TextureResize.h"
@@ -80,6 +81,9 @@ void unbindFbo() {
     s_gles2.glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+// Reads ahead taking longer than this are given up on for direct ones.
+constexpr GLuint64 kPrefetchFenceTimeoutNs = 1000000000;
+
 }
 
 static GLenum sGetUnsizedColorBufferFormat(GLenum format) {
@@ -216,6 +220,7 @@ std::unique_ptr<ColorBufferGl> ColorBufferGl::create(EGLDisplay p_display, int p
                                                      FrameworkFormat p_frameworkFormat,
                                                      HandleType hndl, ContextHelper* helper,
                                                      TextureDraw* textureDraw,
+                                                     PixelUnpackBufferRing* pixelUnpackBufferRing,
                                                      bool fastBlitSupported) {
     GLenum texFormat = 0;
     GLenum pixelType = GL_UNSIGNED_BYTE;
@@ -240,6 +245,7 @@ std::unique_ptr<ColorBufferGl> ColorBufferGl::create(EGLDisplay p_display, int p
     cb->m_format = texFormat;
     cb->m_type = pixelType;
     cb->m_frameworkFormat = p_frameworkFormat;
+    cb->m_pixelUnpackBufferRing = pixelUnpackBufferRing;
     cb->m_fastBlitSupported = fastBlitSupported;
     cb->m_numBytes = (size_t)bufsize;
 
@@ -304,8 +310,8 @@ std::unique_ptr<ColorBufferGl> ColorBufferGl::create(EGLDisplay p_display, int p
         case FRAMEWORK_FORMAT_GL_COMPATIBLE:
             break;
         default: // Any YUV format
-            cb->m_yuv_converter.reset(
-                    new YUVConverter(p_width, p_height, cb->m_frameworkFormat));
+            cb->m_yuv_converter.reset(new YUVConverter(p_width, p_height, cb->m_frameworkFormat,
+                                                       pixelUnpackBufferRing));
             break;
     }
 
@@ -360,6 +366,13 @@ ColorBufferGl::~ColorBufferGl() {
         s_gles2.glDeleteFramebuffers(1, &m_scaleRotationFbo);
     }
 
+    if (m_prefetchFence) {
+        s_gles2.glDeleteSync(m_prefetchFence);
+    }
+    if (m_prefetchBuffer) {
+        s_gles2.glDeleteBuffers(1, &m_prefetchBuffer);
+    }
+
     m_yuv_converter.reset();
 
     GLuint tex[2] = {m_tex, m_blitTex};
@@ -482,6 +495,172 @@ void ColorBufferGl::readPixelsYUVCached(int x, int y, int width, int height, voi
     return;
 }
 
+bool ColorBufferGl::prefetchPixels(bool yuv) {
+    RecursiveScopedContextBind context(m_helper);
+    if (!context.isOk()) {
+        return false;
+    }
+
+    GL_SCOPED_DEBUG_GROUP("ColorBufferGl::prefetchPixels(handle:%d yuv:%d)", mHndl, yuv);
+
+    const GLenum format = sGetUnsizedColorBufferFormat(m_format);
+    size_t size = 0;
+    if (yuv) {
+        // Without glGetTexImage(), YUV reads read nothing.
+        if (!m_yuv_converter || !s_gles2.glGetTexImage) {
+            return false;
+        }
+        size = m_yuv_converter->getDataSize();
+    } else {
+        size = PixelUnpackBufferRing::getUnpackSize(m_width, m_height, format, m_type);
+    }
+    if (!size) {
+        return false;
+    }
+
+    m_prefetched = false;
+    if (m_prefetchFence) {
+        s_gles2.glDeleteSync(m_prefetchFence);
+        m_prefetchFence = nullptr;
+    }
+
+    waitSync();
+
+    if (!m_prefetchBuffer) {
+        s_gles2.glGenBuffers(1, &m_prefetchBuffer);
+    }
+    s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, m_prefetchBuffer);
+    if (m_prefetchBufferSize != size) {
+        s_gles2.glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        m_prefetchBufferSize = size;
+    }
+
+    bool issued = false;
+    if (yuv) {
+        m_yuv_converter->readPixelsToPackBuffer();
+        issued = true;
+    } else if (bindFbo(&m_fbo, m_tex, m_needFboReattach)) {
+        m_needFboReattach = false;
+        GLint prevAlignment = 0;
+        s_gles2.glGetIntegerv(GL_PACK_ALIGNMENT, &prevAlignment);
+        s_gles2.glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        s_gles2.glReadPixels(0, 0, m_width, m_height, format, m_type, nullptr);
+        s_gles2.glPixelStorei(GL_PACK_ALIGNMENT, prevAlignment);
+        unbindFbo();
+        issued = true;
+    }
+    s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Such as for formats the driver can't read, where direct reads read nothing either.
+    if (!issued || s_gles2.glGetError() != GL_NO_ERROR) {
+        return false;
+    }
+
+    m_prefetchFence = s_gles2.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Starts the readback now rather than at the next flush.
+    s_gles2.glFlush();
+
+    m_prefetched = true;
+    m_prefetchedYuv = yuv;
+    m_prefetchedFormat = format;
+    m_prefetchedType = m_type;
+    return true;
+}
+
+const uint8_t* ColorBufferGl::mapPrefetchedPixels() {
+    if (m_prefetchFence) {
+        const GLenum result = s_gles2.glClientWaitSync(m_prefetchFence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                       kPrefetchFenceTimeoutNs);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+            return nullptr;
+        }
+        s_gles2.glDeleteSync(m_prefetchFence);
+        m_prefetchFence = nullptr;
+    }
+
+    s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, m_prefetchBuffer);
+    const void* mapped =
+        s_gles2.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_prefetchBufferSize, GL_MAP_READ_BIT);
+    if (!mapped) {
+        ERR("Failed to map prefetched pixels of ColorBuffer:%d: 0x%x", mHndl,
+            s_gles2.glGetError());
+        s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_prefetched = false;
+        return nullptr;
+    }
+    return static_cast<const uint8_t*>(mapped);
+}
+
+bool ColorBufferGl::readPrefetchedPixels(int x, int y, int width, int height, GLenum p_format,
+                                         GLenum p_type, void* pixels) {
+    if (!m_prefetched || m_prefetchedYuv) {
+        return false;
+    }
+    if (sGetUnsizedColorBufferFormat(p_format) != m_prefetchedFormat ||
+        p_type != m_prefetchedType) {
+        return false;
+    }
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > (int)m_width ||
+        y + height > (int)m_height) {
+        return false;
+    }
+
+    RecursiveScopedContextBind context(m_helper);
+    if (!context.isOk()) {
+        return false;
+    }
+
+    const uint8_t* mapped = mapPrefetchedPixels();
+    if (!mapped) {
+        return false;
+    }
+
+    const size_t pixelSize =
+        PixelUnpackBufferRing::getUnpackSize(1, 1, m_prefetchedFormat, m_prefetchedType);
+    const size_t srcStride = pixelSize * m_width;
+    const size_t dstStride = pixelSize * width;
+    const uint8_t* src = mapped + y * srcStride + x * pixelSize;
+    uint8_t* dst = static_cast<uint8_t*>(pixels);
+    for (int row = 0; row < height; row++) {
+        memcpy(dst, src, dstStride);
+        src += srcStride;
+        dst += dstStride;
+    }
+
+    const bool intact = s_gles2.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!intact) {
+        // The contents were lost, such as to a mode switch.
+        m_prefetched = false;
+    }
+    return intact;
+}
+
+bool ColorBufferGl::readPrefetchedPixelsYUV(void* pixels, uint32_t pixels_size) {
+    if (!m_prefetched || !m_prefetchedYuv || pixels_size < m_prefetchBufferSize) {
+        return false;
+    }
+
+    RecursiveScopedContextBind context(m_helper);
+    if (!context.isOk()) {
+        return false;
+    }
+
+    const uint8_t* mapped = mapPrefetchedPixels();
+    if (!mapped) {
+        return false;
+    }
+
+    m_yuv_converter->finishReadPixels(mapped, static_cast<uint8_t*>(pixels));
+
+    const bool intact = s_gles2.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    s_gles2.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!intact) {
+        m_prefetched = false;
+    }
+    return intact;
+}
+
 void ColorBufferGl::reformat(GLint internalformat, GLenum type) {
     GLenum texFormat = internalformat;
     GLenum pixelType = GL_UNSIGNED_BYTE;
@@ -596,8 +775,17 @@ bool ColorBufferGl::subUpdateFromFrameworkFormat(int x, int y, int width, int he
         s_gles2.glBindTexture(GL_TEXTURE_2D, m_tex);
         s_gles2.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        s_gles2.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, p_unsizedFormat,
-                                p_type, pixels);
+        if (m_pixelUnpackBufferRing) {
+            // Returns once |pixels| are copied, rather than once the texture is updated.
+            const size_t size =
+                PixelUnpackBufferRing::getUnpackSize(width, height, p_unsizedFormat, p_type);
+            const auto upload = m_pixelUnpackBufferRing->upload(pixels, size);
+            s_gles2.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, p_unsizedFormat,
+                                    p_type, upload.at(0));
+        } else {
+            s_gles2.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, p_unsizedFormat,
+                                    p_type, pixels);
+        }
     }
 
     if (m_fastBlitSupported) {
@@ -632,6 +820,22 @@ bool ColorBufferGl::readContents(size_t* numBytes, void* pixels) {
     }
 }
 
+bool ColorBufferGl::readContents(int x, int y, int width, int height, size_t* numBytes,
+                                 void* pixels) {
+    if (m_yuv_converter) {
+        return false;
+    }
+
+    *numBytes = m_numBytes / (m_width * m_height) * width * height;
+
+    if (!pixels) return true;
+    RecursiveScopedContextBind context(m_helper);
+
+    readPixels(x, y, width, height, m_format, m_type, pixels);
+
+    return true;
+}
+
 bool ColorBufferGl::blitFromCurrentReadBuffer() {
     RenderThreadInfoGl* const tInfo = RenderThreadInfoGl::get();
     if (!tInfo) {
@@ -933,6 +1137,7 @@ void ColorBufferGl::onSave(android::base::Stream* stream) {
 std::unique_ptr<ColorBufferGl> ColorBufferGl::onLoad(android::base::Stream* stream,
                                                      EGLDisplay p_display, ContextHelper* helper,
                                                      TextureDraw* textureDraw,
+                                                     PixelUnpackBufferRing* pixelUnpackBufferRing,
                                                      bool fastBlitSupported) {
     HandleType hndl = static_cast<HandleType>(stream->getBe32());
     GLuint width = static_cast<GLuint>(stream->getBe32());
@@ -946,7 +1151,7 @@ std::unique_ptr<ColorBufferGl> ColorBufferGl::onLoad(android::base::Stream* stre
 
     if (!eglImage) {
         return create(p_display, width, height, internalFormat, frameworkFormat,
-                      hndl, helper, textureDraw, fastBlitSupported);
+                      hndl, helper, textureDraw, pixelUnpackBufferRing, fastBlitSupported);
     }
     std::unique_ptr<ColorBufferGl> cb(
         new ColorBufferGl(p_display, hndl, width, height, helper, textureDraw));
@@ -955,6 +1160,7 @@ std::unique_ptr<ColorBufferGl> ColorBufferGl::onLoad(android::base::Stream* stre
     assert(eglImage && blitEGLImage);
     cb->m_internalFormat = internalFormat;
     cb->m_frameworkFormat = frameworkFormat;
+    cb->m_pixelUnpackBufferRing = pixelUnpackBufferRing;
     cb->m_fastBlitSupported = fastBlitSupported;
     cb->m_needFormatCheck = needFormatCheck;
     return cb;
@@ -975,8 +1181,8 @@ void ColorBufferGl::restore() {
         case FRAMEWORK_FORMAT_GL_COMPATIBLE:
             break;
         default: // any YUV format
-            m_yuv_converter.reset(
-                    new YUVConverter(m_width, m_height, m_frameworkFormat));
+            m_yuv_converter.reset(new YUVConverter(m_width, m_height, m_frameworkFormat,
+                                                   m_pixelUnpackBufferRing));
             break;
     }
 }
@@ -68,6 +68,7 @@
 namespace gfxstream {
 namespace gl {
 
+class PixelUnpackBufferRing;
 class TextureDraw;
 class TextureResize;
 class YUVConverter;
@@ -87,12 +88,14 @@ class ColorBufferGl {
     // FRAMEWORK_FORMAT_GL_COMPATIBLE).
     // It is assumed underlying EGL has EGL_KHR_gl_texture_2D_image.
     // Returns NULL on failure.
+    // |pixelUnpackBufferRing|: streams uploads if not null.
     // |fastBlitSupported|: whether or not this ColorBufferGl can be
     // blitted and posted to swapchain without context switches.
     static std::unique_ptr<ColorBufferGl> create(EGLDisplay display, int width, int height,
                                                  GLint internalFormat,
                                                  FrameworkFormat frameworkFormat, HandleType handle,
                                                  ContextHelper* helper, TextureDraw* textureDraw,
+                                                 PixelUnpackBufferRing* pixelUnpackBufferRing,
                                                  bool fastBlitSupported);
 
     // Sometimes things happen and we need to reformat the GL texture
@@ -130,6 +133,18 @@ class ColorBufferGl {
                              void* pixels,
                              uint32_t pixels_size);
 
+    // Starts reading the whole ColorBufferGl into a pixel pack buffer without
+    // waiting for the GPU, the way readPixelsYUVCached() does if |yuv|, and the
+    // way readPixels() does in the format of the ColorBufferGl otherwise.
+    // Requires GLES 3.0. Returns false if the contents can't be read ahead.
+    bool prefetchPixels(bool yuv);
+    // Complete readPixels() and readPixelsYUVCached() from the pixels last
+    // read ahead by prefetchPixels(), which must still be current. Return false
+    // if those pixels don't cover the read, which must then be done directly.
+    bool readPrefetchedPixels(int x, int y, int width, int height, GLenum p_format,
+                              GLenum p_type, void* pixels);
+    bool readPrefetchedPixelsYUV(void* pixels, uint32_t pixels_size);
+
     void swapYUVTextures(FrameworkFormat texture_type, GLuint* textures, void* metadata = nullptr);
 
     // Update the ColorBufferGl instance's pixel values from host memory.
@@ -151,6 +166,10 @@ class ColorBufferGl {
     // If the framework format is YUV, it will read back as raw YUV data.
     bool readContents(size_t* numBytes, void* pixels);
 
+    // Reads back a rectangle of the contents the same way. Fails if the
+    // framework format is YUV, as the raw YUV data can only be read whole.
+    bool readContents(int x, int y, int width, int height, size_t* numBytes, void* pixels);
+
     // Draw a ColorBufferGl instance, i.e. blit it to the current guest
     // framebuffer object / window surface. This doesn't display anything.
     bool draw();
@@ -194,7 +213,9 @@ class ColorBufferGl {
     void onSave(android::base::Stream* stream);
     static std::unique_ptr<ColorBufferGl> onLoad(android::base::Stream* stream,
                                                  EGLDisplay p_display, ContextHelper* helper,
-                                                 TextureDraw* textureDraw, bool fastBlitSupported);
+                                                 TextureDraw* textureDraw,
+                                                 PixelUnpackBufferRing* pixelUnpackBufferRing,
+                                                 bool fastBlitSupported);
 
     HandleType getHndl() const;
 
@@ -236,6 +257,9 @@ private:
  void restoreEglImage(EGLImageKHR image);
  // Helper function that does the above two operations in one go.
  void rebindEglImage(EGLImageKHR image, bool preserveContent);
+ // Helper function to map the pixels read by prefetchPixels() once the GPU
+ // has written them. Unmap with GL_PIXEL_PACK_BUFFER unbound after.
+ const uint8_t* mapPrefetchedPixels();
 
 private:
     GLuint m_tex = 0;
@@ -267,6 +291,7 @@ private:
     EGLDisplay m_display = nullptr;
     ContextHelper* m_helper = nullptr;
     TextureDraw* m_textureDraw = nullptr;
+    PixelUnpackBufferRing* m_pixelUnpackBufferRing = nullptr;
     TextureResize* m_resizer = nullptr;
     FrameworkFormat m_frameworkFormat;
     GLuint m_yuv_conversion_fbo = 0;  // FBO to offscreen-convert YUV to RGB
@@ -281,6 +306,15 @@ private:
     GLenum m_asyncReadbackType = GL_UNSIGNED_BYTE;
     size_t m_numBytes = 0;
 
+    // The pixel pack buffer prefetchPixels() reads into, and what it read.
+    GLuint m_prefetchBuffer = 0;
+    size_t m_prefetchBufferSize = 0;
+    GLsync m_prefetchFence = nullptr;
+    bool m_prefetched = false;
+    bool m_prefetchedYuv = false;
+    GLenum m_prefetchedFormat = 0;
+    GLenum m_prefetchedType = 0;
+
     bool m_importedMemory = false;
     GLuint m_memoryObject = 0;
     bool m_inUse = false;
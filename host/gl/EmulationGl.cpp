@@ -452,6 +452,10 @@ std::unique_ptr<EmulationGl> EmulationGl::create(uint32_t width, uint32_t height
         return nullptr;
     }
 
+    if (emulationGl->mGlesDispatchMaxVersion > GLES_DISPATCH_MAX_VERSION_2) {
+        emulationGl->mPixelUnpackBufferRing = std::make_unique<PixelUnpackBufferRing>();
+    }
+
     emulationGl->mCompositorGl = std::make_unique<CompositorGl>(emulationGl->mTextureDraw.get());
 
     emulationGl->mDisplayGl = std::make_unique<DisplayGl>(emulationGl->mTextureDraw.get());
@@ -498,6 +502,9 @@ EmulationGl::~EmulationGl() {
         // } else {
         //     ERR("Failed to bind context for destroying TextureDraw.");
         // }
+
+        // Likewise, its buffers and fences go with the context.
+        mPixelUnpackBufferRing.release();
     }
 
     if (mEglDisplay != EGL_NO_DISPLAY) {
@@ -508,6 +515,12 @@ EmulationGl::~EmulationGl() {
         }
         mEglDisplay = EGL_NO_DISPLAY;
     }
+
+    // The translator's shader cache is never destroyed, so write what it
+    // didn't yet before the process goes away.
+    if (s_egl.eglFlushShaderCache) {
+        s_egl.eglFlushShaderCache();
+    }
 }
 
 std::unique_ptr<gfxstream::DisplaySurface> EmulationGl::createFakeWindowSurface() {
@@ -624,12 +637,13 @@ std::unique_ptr<ColorBufferGl> EmulationGl::createColorBuffer(uint32_t width, ui
                                                               HandleType handle) {
     return ColorBufferGl::create(mEglDisplay, width, height, internalFormat, frameworkFormat,
                                  handle, getColorBufferContextHelper(), mTextureDraw.get(),
-                                 isFastBlitSupported());
+                                 mPixelUnpackBufferRing.get(), isFastBlitSupported());
 }
 
 std::unique_ptr<ColorBufferGl> EmulationGl::loadColorBuffer(android::base::Stream* stream) {
     return ColorBufferGl::onLoad(stream, mEglDisplay, getColorBufferContextHelper(),
-                                 mTextureDraw.get(), isFastBlitSupported());
+                                 mTextureDraw.get(), mPixelUnpackBufferRing.get(),
+                                 isFastBlitSupported());
 }
 
 std::unique_ptr<EmulatedEglContext> EmulationGl::createEmulatedEglContext(
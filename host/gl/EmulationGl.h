@@ -40,6 +40,7 @@
 #include "EmulatedEglWindowSurface.h"
 #include "OpenGLESDispatch/EGLDispatch.h"
 #include "OpenGLESDispatch/GLESv2Dispatch.h"
+#include "PixelUnpackBufferRing.h"
 #include "ReadbackWorkerGl.h"
 #include "TextureDraw.h"
 #include "aemu/base/files/Stream.h"
@@ -185,6 +186,9 @@ class EmulationGl {
 
    std::unique_ptr<TextureDraw> mTextureDraw;
 
+   // Streams ColorBuffer uploads, if GLES 3.0 is available.
+   std::unique_ptr<PixelUnpackBufferRing> mPixelUnpackBufferRing;
+
    uint32_t mWidth = 0;
    uint32_t mHeight = 0;
 };
@@ -0,0 +1,186 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PixelUnpackBufferRing.h"
+
+#include <GLES2/gl2ext.h>
+#include <string.h>
+
+#include "OpenGLESDispatch/DispatchTables.h"
+#include "host-common/logging.h"
+
+namespace gfxstream {
+namespace gl {
+namespace {
+
+// Only reached if the GPU is far behind, in which case mapping waits for it instead.
+constexpr GLuint64 kFenceTimeoutNs = 1000000000;
+
+}  // namespace
+
+PixelUnpackBufferRing::Upload::Upload(PixelUnpackBufferRing* ring,
+                                      std::unique_lock<std::mutex> lock, const void* pixels)
+    : mRing(ring), mLock(std::move(lock)), mPixels(pixels) {}
+
+PixelUnpackBufferRing::Upload::Upload(Upload&& other)
+    : mRing(other.mRing), mLock(std::move(other.mLock)), mPixels(other.mPixels) {
+    other.mRing = nullptr;
+}
+
+PixelUnpackBufferRing::Upload::~Upload() {
+    if (mRing) {
+        mRing->onUploadDone();
+    }
+}
+
+const void* PixelUnpackBufferRing::Upload::at(size_t offset) const {
+    if (mRing) {
+        return reinterpret_cast<const void*>(static_cast<uintptr_t>(offset));
+    }
+    if (!mPixels) {
+        return nullptr;
+    }
+    return static_cast<const char*>(mPixels) + offset;
+}
+
+PixelUnpackBufferRing::~PixelUnpackBufferRing() {
+    for (Slot& slot : mSlots) {
+        if (slot.fence) {
+            s_gles2.glDeleteSync(slot.fence);
+        }
+        if (slot.buffer) {
+            s_gles2.glDeleteBuffers(1, &slot.buffer);
+        }
+    }
+}
+
+PixelUnpackBufferRing::Upload PixelUnpackBufferRing::upload(const void* pixels, size_t size) {
+    if (!pixels || size < kMinUploadSize || size > kMaxUploadSize) {
+        return Upload(nullptr, {}, pixels);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!copyToSlotLocked(mSlots[mNextSlot], pixels, size)) {
+        return Upload(nullptr, {}, pixels);
+    }
+    return Upload(this, std::move(lock), nullptr);
+}
+
+bool PixelUnpackBufferRing::copyToSlotLocked(Slot& slot, const void* pixels, size_t size) {
+    bool idle = true;
+    if (slot.fence) {
+        const GLenum result =
+            s_gles2.glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+        idle = result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+        s_gles2.glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+
+    if (!slot.buffer) {
+        s_gles2.glGenBuffers(1, &slot.buffer);
+    }
+    s_gles2.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    if (slot.size < size) {
+        s_gles2.glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        slot.size = size;
+    }
+
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    if (idle) {
+        access |= GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+    void* mapped = s_gles2.glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+    if (!mapped) {
+        ERR("Failed to map pixel unpack buffer of %zu bytes: 0x%x", size, s_gles2.glGetError());
+        s_gles2.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    memcpy(mapped, pixels, size);
+    if (!s_gles2.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        // The contents were lost, such as to a mode switch.
+        s_gles2.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    return true;
+}
+
+void PixelUnpackBufferRing::onUploadDone() {
+    Slot& slot = mSlots[mNextSlot];
+    mNextSlot = (mNextSlot + 1) % kNumSlots;
+
+    s_gles2.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slot.fence = s_gles2.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Starts the transfer now rather than at the next flush.
+    s_gles2.glFlush();
+}
+
+/*static*/
+size_t PixelUnpackBufferRing::getUnpackSize(GLsizei width, GLsizei height, GLenum format,
+                                            GLenum type) {
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    size_t components = 0;
+    switch (format) {
+        case GL_RED:
+        case GL_RED_INTEGER:
+        case GL_ALPHA:
+        case GL_LUMINANCE:
+            components = 1;
+            break;
+        case GL_RG:
+        case GL_RG_INTEGER:
+        case GL_LUMINANCE_ALPHA:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        case GL_RGBA:
+        case GL_BGRA_EXT:
+            components = 4;
+            break;
+        default:
+            return 0;
+    }
+
+    size_t bytesPerPixel = 0;
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            bytesPerPixel = components;
+            break;
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT:
+            bytesPerPixel = 2 * components;
+            break;
+        case GL_FLOAT:
+            bytesPerPixel = 4 * components;
+            break;
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            bytesPerPixel = 2;
+            break;
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            bytesPerPixel = 4;
+            break;
+        default:
+            return 0;
+    }
+    return static_cast<size_t>(width) * height * bytesPerPixel;
+}
+
+}  // namespace gl
+}  // namespace gfxstream
@@ -0,0 +1,90 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <mutex>
+
+namespace gfxstream {
+namespace gl {
+
+// Streams texture uploads through a few pixel unpack buffers, so that uploading
+// only costs copying the pixels into one of them, and the transfer to the
+// texture happens on the GPU while the caller goes on. Each buffer is fenced
+// after its upload and only reused once the GPU is done with it.
+//
+// Requires GLES 3.0, and must be used with the same context, or contexts of the
+// same share group, current.
+class PixelUnpackBufferRing {
+   public:
+    // Uploads smaller than this aren't worth a buffer, and bigger ones would
+    // keep too much memory around.
+    static constexpr size_t kMinUploadSize = 64 * 1024;
+    static constexpr size_t kMaxUploadSize = 32 * 1024 * 1024;
+
+    // Pixels to pass to glTexSubImage2D() and the like while it is alive: an
+    // offset into the bound pixel unpack buffer the pixels were copied into, or
+    // the pixels themselves when they weren't.
+    class Upload {
+       public:
+        Upload(Upload&& other);
+        ~Upload();
+
+        const void* at(size_t offset) const;
+
+       private:
+        friend class PixelUnpackBufferRing;
+
+        Upload(PixelUnpackBufferRing* ring, std::unique_lock<std::mutex> lock, const void* pixels);
+
+        PixelUnpackBufferRing* mRing = nullptr;
+        std::unique_lock<std::mutex> mLock;
+        const void* mPixels = nullptr;
+    };
+
+    PixelUnpackBufferRing() = default;
+    ~PixelUnpackBufferRing();
+
+    // Copies |size| bytes of |pixels| into the next buffer and binds it to
+    // GL_PIXEL_UNPACK_BUFFER until the returned Upload is destroyed.
+    Upload upload(const void* pixels, size_t size);
+
+    // Bytes of |width| x |height| pixels of |format| and |type| unpacked with
+    // GL_UNPACK_ALIGNMENT of 1, or 0 if unknown.
+    static size_t getUnpackSize(GLsizei width, GLsizei height, GLenum format, GLenum type);
+
+   private:
+    struct Slot {
+        GLuint buffer = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;
+    };
+
+    static constexpr size_t kNumSlots = 3;
+
+    bool copyToSlotLocked(Slot& slot, const void* pixels, size_t size);
+    void onUploadDone();
+
+    std::mutex mMutex;
+    std::array<Slot, kNumSlots> mSlots;
+    size_t mNextSlot = 0;
+};
+
+}  // namespace gl
+}  // namespace gfxstream
@@ -18,9 +18,13 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
 #include <string>
 
 #include "OpenGLESDispatch/DispatchTables.h"
+#include "PixelUnpackBufferRing.h"
 #include "host-common/feature_control.h"
 #include "host-common/opengl/misc.h"
 
@@ -520,6 +524,14 @@ static void subUpdateYUVGLTex(GLenum texture_unit,
     s_gles2.glActiveTexture(GL_TEXTURE0);
 }
 
+// The end of the bytes subUpdateYUVGLTex() reads for a plane, or 0 if unknown.
+static size_t getPlaneUploadEnd(FrameworkFormat format, YUVPlane plane, uint32_t offsetBytes,
+                                uint32_t stridePixels, uint32_t height) {
+    const size_t size = PixelUnpackBufferRing::getUnpackSize(
+        stridePixels, height, getGlPixelFormat(format, plane), getGlPixelType(format, plane));
+    return size ? offsetBytes + size : 0;
+}
+
 bool YUVConverter::checkAndUpdateColorAspectsChanged(void* metadata) {
     bool needToUpdateConversionShader = false;
     if (metadata) {
@@ -857,11 +869,13 @@ static void doYUVConversionDraw(GLuint program,
 
 // initialize(): allocate GPU memory for YUV components,
 // and create shaders and vertex data.
-YUVConverter::YUVConverter(int width, int height, FrameworkFormat format)
+YUVConverter::YUVConverter(int width, int height, FrameworkFormat format,
+                           PixelUnpackBufferRing* pixelUnpackBufferRing)
     : mWidth(width),
       mHeight(height),
       mFormat(format),
-      mColorBufferFormat(format) {}
+      mColorBufferFormat(format),
+      mPixelUnpackBufferRing(pixelUnpackBufferRing) {}
 
 void YUVConverter::init(int width, int height, FrameworkFormat format) {
     YUV_DEBUG_LOG("w:%d h:%d format:%d", width, height, format);
@@ -933,6 +947,42 @@ uint32_t YUVConverter::getDataSize() {
 void YUVConverter::readPixels(uint8_t* pixels, uint32_t pixels_size) {
     YUV_DEBUG_LOG("w:%d h:%d format:%d pixels:%p pixels-size:%d", mWidth, mHeight, mFormat, pixels, pixels_size);
 
+    readChromaPlanes(reinterpret_cast<uintptr_t>(pixels));
+
+    if (needsNV12ToYUV420Conversion()) {
+        NV12ToYUV420PlanarInPlaceConvert(mWidth, mHeight, pixels, pixels);
+    }
+
+    // Read the Y plane last because so that we can use it as a scratch space.
+    readLumaPlane(reinterpret_cast<uintptr_t>(pixels));
+}
+
+void YUVConverter::readPixelsToPackBuffer() {
+    YUV_DEBUG_LOG("w:%d h:%d format:%d", mWidth, mHeight, mFormat);
+
+    readChromaPlanes(0);
+    readLumaPlane(0);
+}
+
+void YUVConverter::finishReadPixels(const uint8_t* packed, uint8_t* pixels) {
+    memcpy(pixels, packed, getDataSize());
+
+    if (needsNV12ToYUV420Conversion()) {
+        uint32_t yWidth, yHeight, yOffsetBytes, yStridePixels, yStrideBytes;
+        uint32_t uWidth, uHeight, uOffsetBytes, uStridePixels, uStrideBytes;
+        uint32_t vWidth, vHeight, vOffsetBytes, vStridePixels, vStrideBytes;
+        getYUVOffsets(mWidth, mHeight, mFormat,
+                      &yWidth, &yHeight, &yOffsetBytes, &yStridePixels, &yStrideBytes,
+                      &uWidth, &uHeight, &uOffsetBytes, &uStridePixels, &uStrideBytes,
+                      &vWidth, &vHeight, &vOffsetBytes, &vStridePixels, &vStrideBytes);
+
+        NV12ToYUV420PlanarInPlaceConvert(mWidth, mHeight, pixels, pixels);
+        // The conversion used the Y plane as scratch space.
+        memcpy(pixels + yOffsetBytes, packed + yOffsetBytes, yStrideBytes * yHeight);
+    }
+}
+
+void YUVConverter::readChromaPlanes(uintptr_t pixels) {
     uint32_t yWidth, yHeight, yOffsetBytes, yStridePixels, yStrideBytes;
     uint32_t uWidth, uHeight, uOffsetBytes, uStridePixels, uStrideBytes;
     uint32_t vWidth, vHeight, vOffsetBytes, vStridePixels, vStrideBytes;
@@ -942,19 +992,32 @@ void YUVConverter::readPixels(uint8_t* pixels, uint32_t pixels_size) {
                   &vWidth, &vHeight, &vOffsetBytes, &vStridePixels, &vStrideBytes);
 
     if (isInterleaved(mFormat)) {
-        readYUVTex(mTextureV, mFormat, YUVPlane::UV, pixels + std::min(uOffsetBytes, vOffsetBytes),
+        readYUVTex(mTextureV, mFormat, YUVPlane::UV,
+                   reinterpret_cast<void*>(pixels + std::min(uOffsetBytes, vOffsetBytes)),
                    uStridePixels);
     } else {
-        readYUVTex(mTextureU, mFormat, YUVPlane::U, pixels + uOffsetBytes, uStridePixels);
-        readYUVTex(mTextureV, mFormat, YUVPlane::V, pixels + vOffsetBytes, vStridePixels);
+        readYUVTex(mTextureU, mFormat, YUVPlane::U, reinterpret_cast<void*>(pixels + uOffsetBytes),
+                   uStridePixels);
+        readYUVTex(mTextureV, mFormat, YUVPlane::V, reinterpret_cast<void*>(pixels + vOffsetBytes),
+                   vStridePixels);
     }
+}
 
-    if (mFormat == FRAMEWORK_FORMAT_NV12 && mColorBufferFormat == FRAMEWORK_FORMAT_YUV_420_888) {
-        NV12ToYUV420PlanarInPlaceConvert(mWidth, mHeight, pixels, pixels);
-    }
+void YUVConverter::readLumaPlane(uintptr_t pixels) {
+    uint32_t yWidth, yHeight, yOffsetBytes, yStridePixels, yStrideBytes;
+    uint32_t uWidth, uHeight, uOffsetBytes, uStridePixels, uStrideBytes;
+    uint32_t vWidth, vHeight, vOffsetBytes, vStridePixels, vStrideBytes;
+    getYUVOffsets(mWidth, mHeight, mFormat,
+                  &yWidth, &yHeight, &yOffsetBytes, &yStridePixels, &yStrideBytes,
+                  &uWidth, &uHeight, &uOffsetBytes, &uStridePixels, &uStrideBytes,
+                  &vWidth, &vHeight, &vOffsetBytes, &vStridePixels, &vStrideBytes);
 
-    // Read the Y plane last because so that we can use it as a scratch space.
-    readYUVTex(mTextureY, mFormat, YUVPlane::Y, pixels + yOffsetBytes, yStridePixels);
+    readYUVTex(mTextureY, mFormat, YUVPlane::Y, reinterpret_cast<void*>(pixels + yOffsetBytes),
+               yStridePixels);
+}
+
+bool YUVConverter::needsNV12ToYUV420Conversion() const {
+    return mFormat == FRAMEWORK_FORMAT_NV12 && mColorBufferFormat == FRAMEWORK_FORMAT_YUV_420_888;
 }
 
 void YUVConverter::swapTextures(FrameworkFormat format, GLuint* textures, void* metadata) {
@@ -1041,7 +1104,31 @@ void YUVConverter::drawConvertFromFormat(FrameworkFormat format, int x, int y, i
                   static_cast<float>(uWidth),
                   static_cast<float>(uStridePixels));
 
-    if (pixels) {
+    if (pixels && mPixelUnpackBufferRing) {
+        // All the planes are copied at once, and the textures are updated from them on the GPU.
+        const size_t yEnd =
+            getPlaneUploadEnd(mFormat, YUVPlane::Y, yOffsetBytes, yStridePixels, yHeight);
+        const size_t uEnd = isInterleaved(mFormat)
+                                ? getPlaneUploadEnd(mFormat, YUVPlane::UV,
+                                                    std::min(uOffsetBytes, vOffsetBytes),
+                                                    uStridePixels, uHeight)
+                                : getPlaneUploadEnd(mFormat, YUVPlane::U, uOffsetBytes,
+                                                    uStridePixels, uHeight);
+        const size_t vEnd = isInterleaved(mFormat)
+                                ? uEnd
+                                : getPlaneUploadEnd(mFormat, YUVPlane::V, vOffsetBytes,
+                                                    vStridePixels, vHeight);
+        // Uploads nothing through the ring if the size of any plane is unknown.
+        const size_t size = (yEnd && uEnd && vEnd) ? std::max({yEnd, uEnd, vEnd}) : 0;
+        const auto upload = mPixelUnpackBufferRing->upload(pixels, size);
+        subUpdateYUVGLTex(GL_TEXTURE0, mTextureY, x, y, yStridePixels, yHeight, mFormat, YUVPlane::Y, upload.at(yOffsetBytes));
+        if (isInterleaved(mFormat)) {
+            subUpdateYUVGLTex(GL_TEXTURE1, mTextureU, x, y, uStridePixels, uHeight, mFormat, YUVPlane::UV, upload.at(std::min(uOffsetBytes, vOffsetBytes)));
+        } else {
+            subUpdateYUVGLTex(GL_TEXTURE1, mTextureU, x, y, uStridePixels, uHeight, mFormat, YUVPlane::U, upload.at(uOffsetBytes));
+            subUpdateYUVGLTex(GL_TEXTURE2, mTextureV, x, y, vStridePixels, vHeight, mFormat, YUVPlane::V, upload.at(vOffsetBytes));
+        }
+    } else if (pixels) {
         subUpdateYUVGLTex(GL_TEXTURE0, mTextureY, x, y, yStridePixels, yHeight, mFormat, YUVPlane::Y, pixels + yOffsetBytes);
         if (isInterleaved(mFormat)) {
             subUpdateYUVGLTex(GL_TEXTURE1, mTextureU, x, y, uStridePixels, uHeight, mFormat, YUVPlane::UV, pixels + std::min(uOffsetBytes, vOffsetBytes));
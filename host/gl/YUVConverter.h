@@ -28,6 +28,8 @@
 namespace gfxstream {
 namespace gl {
 
+class PixelUnpackBufferRing;
+
 enum class YUVPlane {
     Y = 0,
     U = 1,
@@ -58,8 +60,10 @@ enum class YUVPlane {
 class YUVConverter {
 public:
     // call ctor when creating a gralloc buffer
-    // with YUV format
-    YUVConverter(int width, int height, FrameworkFormat format);
+    // with YUV format. Uploads are streamed through
+    // |pixelUnpackBufferRing| if not null.
+    YUVConverter(int width, int height, FrameworkFormat format,
+                 PixelUnpackBufferRing* pixelUnpackBufferRing = nullptr);
     // destroy when ColorBuffer is destroyed
     ~YUVConverter();
     // call when gralloc_unlock updates
@@ -73,6 +77,11 @@ public:
     // read YUV data into pixels, exactly pixels_size bytes;
     // if size mismatches, will read nothing.
     void readPixels(uint8_t* pixels, uint32_t pixels_size);
+    // Reads the planes into the bound GL_PIXEL_PACK_BUFFER, at the offsets
+    // readPixels() reads them to, without waiting for them. finishReadPixels()
+    // then gives what readPixels() would have from the contents of the buffer.
+    void readPixelsToPackBuffer();
+    void finishReadPixels(const uint8_t* packed, uint8_t* pixels);
 
     void swapTextures(FrameworkFormat type, GLuint* textures, void* metadata = nullptr);
 
@@ -90,6 +99,12 @@ private:
     void createYUVGLShader();
     void createYUVGLFullscreenQuad();
 
+    // Read the planes to |pixels|, an address or an offset into the bound
+    // pixel pack buffer.
+    void readChromaPlanes(uintptr_t pixels);
+    void readLumaPlane(uintptr_t pixels);
+    bool needsNV12ToYUV420Conversion() const;
+
     // For dealing with n-pixel-aligned buffers
     void updateCutoffs(float yWidth, float yStridePixels,
                        float uvWidth, float uvStridePixels);
@@ -99,6 +114,7 @@ private:
     FrameworkFormat mFormat;
     // colorbuffer w/h/format, could be different
     FrameworkFormat mColorBufferFormat;
+    PixelUnpackBufferRing* mPixelUnpackBufferRing = nullptr;
     // We need the following GL objects:
     GLuint mProgram = 0;
     GLuint mQuadVertexBuffer = 0;
@@ -12,6 +12,8 @@
 
 #include "ChecksumCalculatorThreadInfo.h"
 
+#include "DecoderStats.h"
+
 #include "host-common/logging.h"
 
 #include <stdio.h>
@@ -38,6 +40,7 @@ size_t gles1_decoder_context_t::decode(void *buf, size_t len, IOStream *stream,
 		uint32_t opcode = *(uint32_t *)ptr;
 		uint32_t packetLen = *(uint32_t *)(ptr + 4);
 		if (end - ptr < packetLen) return ptr - (unsigned char*)buf;
+		const uint64_t statsStartNs = DecoderStats::start();
 		switch(opcode) {
 		case OP_glAlphaFunc: {
 			android::base::beginTrace("glAlphaFunc decode");
@@ -6181,6 +6184,7 @@ size_t gles1_decoder_context_t::decode(void *buf, size_t len, IOStream *stream,
 		GLint err = this->glGetError();
 		if (err) fprintf(stderr, "gles1 Error (post-call): 0x%X in %s\n", err, lastCall);
 		#endif
+		DecoderStats::finish(opcode, statsStartNs);
 		ptr += packetLen;
 	} // while
 	return ptr - (unsigned char*)buf;
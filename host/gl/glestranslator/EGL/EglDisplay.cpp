@@ -695,6 +695,9 @@ void EglDisplay::onLoadAllImages(android::base::Stream* stream,
         eglImg->saveableTexture =
                 m_globalNameSpace.getSaveableTextureFromLoad(globalName);
         eglImg->needRestore = true;
+        // EGL images back the color buffers, which the first frames after
+        // loading show.
+        m_globalNameSpace.prioritizeOnLoad(globalName);
         return std::make_pair(hndl, std::move(eglImg));
     });
 }
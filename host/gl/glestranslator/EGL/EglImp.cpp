@@ -43,6 +43,7 @@
 #include "EglConfig.h"
 #include "EglOsApi.h"
 #include "ClientAPIExts.h"
+#include "ShaderCache.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -148,6 +149,7 @@ EGLAPI EGLBoolean EGLAPIENTRY eglPostLoadAllImages(EGLDisplay display, EGLStream
 EGLAPI void EGLAPIENTRY eglUseOsEglApi(EGLBoolean enable, EGLBoolean nullEgl);
 EGLAPI void EGLAPIENTRY eglSetMaxGLESVersion(EGLint version);
 EGLAPI void EGLAPIENTRY eglFillUsages(void* usages);
+EGLAPI void EGLAPIENTRY eglFlushShaderCache(void);
 
 EGLAPI EGLDisplay EGLAPIENTRY eglGetNativeDisplayANDROID(EGLDisplay);
 EGLAPI EGLContext EGLAPIENTRY eglGetNativeContextANDROID(EGLDisplay, EGLContext);
@@ -1792,6 +1794,11 @@ EGLAPI void EGLAPIENTRY eglFillUsages(void* usages) {
     // }
 }
 
+EGLAPI void EGLAPIENTRY eglFlushShaderCache(void) {
+    MEM_TRACE("EMUGL");
+    FlushShaderCache();
+}
+
 EGLAPI EGLDisplay EGLAPIENTRY eglGetNativeDisplayANDROID(EGLDisplay display) {
     VALIDATE_DISPLAY_RETURN(display, (EGLDisplay)0);
     return dpy->getHostDriverDisplay();
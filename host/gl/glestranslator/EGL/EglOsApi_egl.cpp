@@ -402,6 +402,10 @@ EglOsEglDisplay::EglOsEglDisplay(bool nullEgl) {
 #endif // __linux__
 
     if (clientExts != nullptr && emugl::hasExtension(clientExts, "EGL_ANDROID_blob_cache")) {
+        // There is no context yet to get the GL renderer and version from, but the EGL version
+        // of most drivers includes theirs.
+        const char* version = mDispatcher.eglQueryString(mDisplay, EGL_VERSION);
+        InitShaderCache(mVendor + " " + (version ? version : ""));
         mDispatcher.eglSetBlobCacheFuncsANDROID(mDisplay, SetBlob, GetBlob);
     }
 
@@ -14,75 +14,54 @@
 
 #include "ShaderCache.h"
 
-#include "aemu/base/MruCache.h"
-#include <string.h>
-#include <cstdio>
+#include <atomic>
+#include <mutex>
 
-#include <map>
-#include <vector>
+#include "PersistentBlobCache.h"
+#include "aemu/base/system/System.h"
 
-namespace {
-    using BlobCacheType = std::vector<uint8_t>;
-
-    template <class K, class V>
-    class CacheObserver : android::base::MruCache<K, V>::MruCacheObserver {
-    public:
-        int count = 0;
-        CacheObserver(android::base::MruCache<K, V>* cacheReference) {
-            mCacheRef = cacheReference;
-            cacheReference->setObserver(this);
-        }
-
-        void cacheChanged() override {
-            // TODO: This will dictate when we flatten the cache.
-        }
-
-    private:
-        android::base::MruCache<K, V>* mCacheRef;
-    };
+using gfxstream::PersistentBlobCache;
 
-    template <class K, class V>
-    class CacheFlattener : public android::base::MruCache<K, V>::CacheFlattener {
-        using MruCache = std::map<typename android::base::MruCache<K, V>::template EntryWithSize<K>,
-            typename android::base::MruCache<K, V>::template EntryWithSize<V>>;
+namespace {
+    // Never destroyed, as the display isn't either.
+    std::atomic<PersistentBlobCache*> sCache{nullptr};
+}
 
-    public:
-        void handleFlatten(MruCache &mCache, void* buf, size_t bufSize) {
-            // TODO: This will handle the actual serialization.
-        }
-    };
+void InitShaderCache(const std::string& driverIdentity) {
+    static std::once_flag initOnce;
+    std::call_once(initOnce, [&] {
+        PersistentBlobCache::Options options;
+        // ~32MB of shaders, very rough estimate.
+        options.maxBytes = 32 * 1024 * 1024;
+        options.directory =
+            android::base::getEnvironmentVariable("ANDROID_EMUGL_SHADER_CACHE_DIR");
+        options.name = "gles_shader_cache";
+        options.identity = driverIdentity;
+        sCache = new PersistentBlobCache(std::move(options));
+    });
+}
 
-    CacheFlattener<BlobCacheType, BlobCacheType> testFlattener;
-    // 3200 is ~32MB of shaders, very rough estimate.
-    android::base::MruCache<BlobCacheType, BlobCacheType> mruCache(3200, &testFlattener);
-    CacheObserver<BlobCacheType, BlobCacheType> sss(&mruCache);
+void FlushShaderCache() {
+    PersistentBlobCache* cache = sCache.load();
+    if (!cache) {
+        return;
+    }
+    cache->flush();
 }
 
 void SetBlob(const void* key, EGLsizeiANDROID keySize, const void* value, EGLsizeiANDROID valueSize) {
-    std::vector<uint8_t> keyVec(keySize);
-    memcpy(keyVec.data(), key, keySize);
-
-    std::vector<uint8_t> valueVec(valueSize);
-    memcpy(valueVec.data(), value, valueSize);
-
-    mruCache.put(keyVec, keySize, std::move(valueVec), valueSize);
+    PersistentBlobCache* cache = sCache.load();
+    if (!cache) {
+        return;
+    }
+    cache->set(key, keySize, value, valueSize);
 }
 
 EGLsizeiANDROID GetBlob(const void* key, EGLsizeiANDROID keySize, void* value, EGLsizeiANDROID valueSize) {
-    std::vector<uint8_t> keyVec(keySize);
-    memcpy(keyVec.data(), key, keySize);
-
-    const std::vector<uint8_t> *result;
-    auto found = mruCache.get(keyVec, &result);
-
-    if (!found) {
+    PersistentBlobCache* cache = sCache.load();
+    if (!cache) {
         return 0;
     }
-
-    if (result->size() <= static_cast<size_t>(valueSize)) {
-        memcpy(value, result->data(), result->size());
-    }
-
     // If the size provided was too small, return the right size regardless.
-    return result->size();
+    return cache->get(key, keySize, value, valueSize);
 }
@@ -17,8 +17,17 @@
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
-#include <map>
-#include <vector>
+#include <string>
+
+// Sets up the cache of the blobs the driver gives through EGL_ANDROID_blob_cache, mostly program
+// binaries. It is kept in ANDROID_EMUGL_SHADER_CACHE_DIR if set, so that the shaders compiled
+// before are found there after a restart, in a file of its own for each |driverIdentity|. Only
+// the first call has an effect.
+void InitShaderCache(const std::string& driverIdentity);
+
+// Writes the blobs that weren't yet, since the cache is never destroyed. Called when the renderer
+// is torn down.
+void FlushShaderCache();
 
 void SetBlob(const void* key, EGLsizeiANDROID keySize, const void* value, EGLsizeiANDROID valueSize);
 
@@ -18,13 +18,41 @@
 
 #include "GLcommon/GLEScontext.h"
 #include "GLcommon/SaveableTexture.h"
+#include "TextureRestoreStats.h"
 #include "aemu/base/system/System.h"
 
 #include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 
-EGLContext s_context = EGL_NO_CONTEXT;
-EGLSurface s_surface = EGL_NO_SURFACE;
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using gfxstream::TextureRestoreStats;
+
+namespace {
+
+constexpr unsigned int kMaxUploadThreads = 3;
+// How many textures may be read ahead of the upload threads, per thread.
+constexpr size_t kReadAheadPerThread = 4;
+
+// The auxiliary context of each upload thread, kept for the next load.
+struct AuxiliaryContext {
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+};
+AuxiliaryContext s_contexts[kMaxUploadThreads];
+
+int numUploadThreads() {
+    return std::max(1u, std::min(kMaxUploadThreads,
+                                 std::thread::hardware_concurrency() / 4));
+}
+
+}  // namespace
+
+void GLBackgroundLoader::prioritize(unsigned int globalName) {
+    m_prioritized.insert(globalName);
+}
 
 intptr_t GLBackgroundLoader::main() {
 #if SNAPSHOT_PROFILE > 1
@@ -32,42 +60,66 @@ intptr_t GLBackgroundLoader::main() {
     printf("Starting GL background loading at %" PRIu64 " ms\n", start);
 #endif
 
-    if (s_context == EGL_NO_CONTEXT) {
-        if (!m_eglIface.createAndBindAuxiliaryContext(&s_context, &s_surface)) {
-            return 0;
+    std::vector<Upload> uploads;
+    uploads.reserve(m_textureMap.size());
+    for (const auto& it : m_textureMap) {
+        if (it.second && m_prioritized.count(it.first)) {
+            uploads.push_back({it.second.get(), true});
         }
-    } else {
-        // In unit tests, we might have torn down EGL. Check for stale
-        // context and surface, and recreate them if that happened.
-        if (!m_eglIface.bindAuxiliaryContext(s_context, s_surface)) {
-            printf("GLBackgroundLoader::%s auxiliary context gone, create a new one\n", __func__);
-            m_eglIface.createAndBindAuxiliaryContext(&s_context, &s_surface);
+    }
+    const size_t numPrioritized = uploads.size();
+    for (const auto& it : m_textureMap) {
+        if (it.second && !m_prioritized.count(it.first)) {
+            uploads.push_back({it.second.get(), false});
         }
     }
+    TextureRestoreStats::get().start(uploads.size(), numPrioritized);
 
-    for (const auto& it : m_textureMap) {
+    const int numThreads = numUploadThreads();
+    const size_t maxReadAhead = numThreads * kReadAheadPerThread;
+    m_numUploadThreads = numThreads;
+    std::vector<std::thread> uploadThreads;
+    for (int i = 0; i < numThreads; i++) {
+        uploadThreads.emplace_back([this, i] { uploadLoop(i); });
+    }
+
+    // Reading and decoding the textures happens here, out of the threads
+    // which upload them.
+    for (const Upload& upload : uploads) {
         if (m_interrupted.load(std::memory_order_relaxed)) break;
 
         // Acquire the texture loader for each load; bail
         // in case something else happened to interrupt loading.
-        auto ptr = m_textureLoaderWPtr.lock();
-        if (!ptr) {
-            break;
+        {
+            auto ptr = m_textureLoaderWPtr.lock();
+            if (!ptr) {
+                break;
+            }
+            upload.texture->prefetch();
         }
 
-        const SaveableTexturePtr& saveable = it.second;
-        if (saveable) {
-            m_glesIface.restoreTexture(saveable.get());
-            // allow other threads to run for a while
-            ptr.reset();
-            android::base::sleepMs(
-                m_loadDelayMs.load(std::memory_order_relaxed));
-        }
+        std::unique_lock<std::mutex> lock(m_uploadLock);
+        m_uploadCv.wait(lock, [this, maxReadAhead] {
+            return m_uploads.size() < maxReadAhead || m_numUploadThreads == 0 ||
+                   m_interrupted.load(std::memory_order_relaxed);
+        });
+        if (m_numUploadThreads == 0) break;
+        m_uploads.push_back(upload);
+        lock.unlock();
+        m_uploadCv.notify_all();
     }
 
-    m_textureMap.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_uploadLock);
+        m_readingDone = true;
+    }
+    m_uploadCv.notify_all();
+    for (auto& thread : uploadThreads) {
+        thread.join();
+    }
 
-    m_eglIface.unbindAuxiliaryContext();
+    m_textureMap.clear();
+    TextureRestoreStats::get().finish();
 
 #if SNAPSHOT_PROFILE > 1
     const auto end = get_uptime_ms();
@@ -78,11 +130,63 @@ intptr_t GLBackgroundLoader::main() {
     return 0;
 }
 
+void GLBackgroundLoader::uploadLoop(int index) {
+    AuxiliaryContext& aux = s_contexts[index];
+    bool bound = false;
+    if (aux.context == EGL_NO_CONTEXT) {
+        bound = m_eglIface.createAndBindAuxiliaryContext(&aux.context, &aux.surface);
+    } else {
+        // In unit tests, we might have torn down EGL. Check for stale
+        // context and surface, and recreate them if that happened.
+        bound = m_eglIface.bindAuxiliaryContext(aux.context, aux.surface);
+        if (!bound) {
+            printf("GLBackgroundLoader::%s auxiliary context gone, create a new one\n", __func__);
+            bound = m_eglIface.createAndBindAuxiliaryContext(&aux.context, &aux.surface);
+        }
+    }
+
+    while (bound) {
+        Upload upload;
+        {
+            std::unique_lock<std::mutex> lock(m_uploadLock);
+            m_uploadCv.wait(lock, [this] {
+                return !m_uploads.empty() || m_readingDone ||
+                       m_interrupted.load(std::memory_order_relaxed);
+            });
+            if (m_uploads.empty() || m_interrupted.load(std::memory_order_relaxed)) break;
+            upload = m_uploads.front();
+            m_uploads.pop_front();
+        }
+        m_uploadCv.notify_all();
+
+        m_glesIface.restoreTexture(upload.texture);
+        TextureRestoreStats::get().onRestored(upload.prioritized);
+        if (!upload.prioritized) {
+            // allow other threads to run for a while
+            android::base::sleepMs(
+                m_loadDelayMs.load(std::memory_order_relaxed));
+        }
+    }
+
+    if (bound) {
+        m_eglIface.unbindAuxiliaryContext();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_uploadLock);
+        m_numUploadThreads--;
+    }
+    m_uploadCv.notify_all();
+}
+
 bool GLBackgroundLoader::wait(intptr_t* exitStatus) {
     m_loadDelayMs.store(0, std::memory_order_relaxed);
     return Thread::wait();
 }
 
 void GLBackgroundLoader::interrupt() {
-    m_interrupted.store(true, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_uploadLock);
+        m_interrupted.store(true, std::memory_order_relaxed);
+    }
+    m_uploadCv.notify_all();
 }
@@ -28,6 +28,12 @@
 #include "host-common/logging.h"
 #include "snapshot/TextureLoader.h"
 #include "snapshot/TextureSaver.h"
+#include "snapshotCompression/SnapshotCompressor.h"
+
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 using android::snapshot::ITextureSaver;
 using android::snapshot::ITextureLoader;
@@ -35,6 +41,14 @@ using android::snapshot::ITextureSaverPtr;
 using android::snapshot::ITextureLoaderPtr;
 using android::snapshot::ITextureLoaderWPtr;
 
+// The number of textures read back ahead of the one being saved.
+static constexpr size_t kTexturesReadAhead = 4;
+
+// Saved ahead of the textures, as each of them is now followed by the texture
+// its contents were saved with, and its contents by whether they follow. Older
+// snapshots have the number of textures there instead, and are rejected.
+static constexpr uint32_t kTextureLayoutMagic = 0x54584c32;  // 'TXL2'
+
 NameSpace::NameSpace(NamedObjectType p_type, GlobalNameSpace *globalNameSpace,
         android::base::Stream* stream, const ObjectData::loadObject_t& loadObject) :
     m_type(p_type),
@@ -345,17 +359,46 @@ void GlobalNameSpace::onSave(android::base::Stream* stream,
     int cleanTexs = 0;
     int dirtyTexs = 0;
 #endif // SNAPSHOT_PROFILE > 1
+    // The textures are read back a few ahead of the one being saved, so that
+    // reading them back overlaps compressing the ones before, with the
+    // contents of only a few of them in memory at once.
+    gfxstream::SnapshotCompressor compressor;
+    auto readAhead = m_textureMap.begin();
+    size_t numReadAhead = 0;
+    // The first texture saved with each contents, which the others of the same
+    // contents are loaded from.
+    std::map<std::vector<uint64_t>, unsigned int> savedContents;
+    stream->putBe32(kTextureLayoutMagic);
     saveCollection(
             stream, m_textureMap,
-            [saver, &textureSaver
-#if SNAPSHOT_PROFILE > 1
-            , &cleanTexs, &dirtyTexs
-#endif // SNAPSHOT_PROFILE > 1
-                ](
-                    android::base::Stream* stream,
-                    const std::pair<const unsigned int, SaveableTexturePtr>&
-                            tex) {
+            [&](android::base::Stream* stream,
+                const std::pair<const unsigned int, SaveableTexturePtr>& tex) {
+                for (; readAhead != m_textureMap.end() &&
+                       numReadAhead < kTexturesReadAhead;
+                     ++readAhead, ++numReadAhead) {
+                    if (readAhead->second) {
+                        readAhead->second->preSaveContents(&compressor);
+                    }
+                }
+                numReadAhead--;
+
+                unsigned int contentsSource = 0;
+                if (tex.second) {
+                    std::optional<std::vector<uint64_t>> key =
+                            tex.second->getContentsKey();
+                    if (key) {
+                        auto it = savedContents.find(*key);
+                        if (it != savedContents.end()) {
+                            contentsSource = it->second;
+                            tex.second->skipSavingContents();
+                        } else {
+                            savedContents.emplace(std::move(*key),
+                                                  tex.first);
+                        }
+                    }
+                }
                 stream->putBe32(tex.first);
+                stream->putBe32(contentsSource);
 #if SNAPSHOT_PROFILE > 1
                 if (tex.second.get() && tex.second->isDirty()) {
                     dirtyTexs ++;
@@ -383,6 +426,13 @@ void GlobalNameSpace::onLoad(android::base::Stream* stream,
                              SaveableTexture::creator_t creator) {
     const ITextureLoaderPtr textureLoader = textureLoaderWPtr.lock();
     assert(m_textureMap.size() == 0);
+    if (stream->getBe32() != kTextureLayoutMagic) {
+        fprintf(stderr,
+                "Error: texture layout of an unsupported version.\n");
+        emugl::emugl_crash_reporter(
+                "Error: texture layout of an unsupported version.\n");
+        return;
+    }
     if (!textureLoader->start()) {
         fprintf(stderr,
                 "Error: texture file unsupported version or corrupted.\n");
@@ -390,10 +440,17 @@ void GlobalNameSpace::onLoad(android::base::Stream* stream,
                 "Error: texture file unsupported version or corrupted.\n");
         return;
     }
+    // The textures whose contents were saved with another texture.
+    std::vector<std::pair<unsigned int, unsigned int>> contentsSources;
     loadCollection(
             stream, &m_textureMap,
-            [this, creator, textureLoaderWPtr](android::base::Stream* stream) {
+            [this, creator, textureLoaderWPtr,
+             &contentsSources](android::base::Stream* stream) {
                 unsigned int globalName = stream->getBe32();
+                unsigned int contentsSource = stream->getBe32();
+                if (contentsSource) {
+                    contentsSources.emplace_back(globalName, contentsSource);
+                }
                 // A lot of function wrapping happens here.
                 // When touched, saveableTexture triggers
                 // textureLoader->loadTexture, which sets up the file position
@@ -414,6 +471,13 @@ void GlobalNameSpace::onLoad(android::base::Stream* stream,
                 return std::make_pair(globalName,
                                       SaveableTexturePtr(saveableTexture));
             });
+    for (const auto& texture : contentsSources) {
+        const auto source = m_textureMap.find(texture.second);
+        const SaveableTexturePtr& saveableTexture = m_textureMap[texture.first];
+        if (source != m_textureMap.end() && source->second && saveableTexture) {
+            saveableTexture->setContentsSource(source->second);
+        }
+    }
 
     m_backgroundLoader =
         std::make_shared<GLBackgroundLoader>(
@@ -435,3 +499,9 @@ const SaveableTexturePtr& GlobalNameSpace::getSaveableTextureFromLoad(
     assert(m_textureMap.count(oldGlobalName));
     return m_textureMap[oldGlobalName];
 }
+
+void GlobalNameSpace::prioritizeOnLoad(unsigned int oldGlobalName) {
+    if (m_backgroundLoader) {
+        m_backgroundLoader->prioritize(oldGlobalName);
+    }
+}
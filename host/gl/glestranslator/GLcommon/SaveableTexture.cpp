@@ -28,7 +28,10 @@
 #include "host-common/crash_reporter.h"
 #include "host-common/logging.h"
 
+#include "snapshotCompression/PayloadCodec.h"
+
 #include <algorithm>
+#include <string.h>
 
 #define SAVEABLE_TEXTURE_DEBUG 0
 
@@ -334,6 +337,28 @@ static uint32_t s_texImageSize(GLenum internalformat,
     return totalSize;
 }
 
+static GLint s_getTextureBinding(GLenum target) {
+    GLint binding = 0;
+    auto gl = GLEScontext::dispatcher();
+    switch (target) {
+        case GL_TEXTURE_2D:
+            gl.glGetIntegerv(GL_TEXTURE_BINDING_2D, &binding);
+            break;
+        case GL_TEXTURE_CUBE_MAP:
+            gl.glGetIntegerv(GL_TEXTURE_BINDING_CUBE_MAP, &binding);
+            break;
+        case GL_TEXTURE_3D:
+            gl.glGetIntegerv(GL_TEXTURE_BINDING_3D, &binding);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            gl.glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &binding);
+            break;
+        default:
+            break;
+    }
+    return binding;
+}
+
 struct TextureDataReader {
     GLESVersion glesVersion = GLES_2_0;
     GLenum fbTarget = GL_FRAMEBUFFER;
@@ -536,7 +561,10 @@ void SaveableTexture::loadFromStream(android::base::Stream* stream) {
         m_target == GL_TEXTURE_3D || m_target == GL_TEXTURE_2D_ARRAY) {
         unsigned int numLevels = m_texStorageLevels ? m_texStorageLevels :
                 m_maxMipmapLevel + 1;
-        auto loadTex = [stream, numLevels](
+        // Whether the contents of the levels follow, or are copied from the
+        // texture they were saved with.
+        const bool hasContents = stream->getByte();
+        auto loadTex = [this, stream, numLevels, hasContents](
                                std::unique_ptr<LevelImageData[]>& levelData,
                                bool isDepth) {
             levelData.reset(new LevelImageData[numLevels]);
@@ -546,7 +574,32 @@ void SaveableTexture::loadFromStream(android::base::Stream* stream) {
                 if (isDepth) {
                     levelData[level].m_depth = stream->getBe32();
                 }
-                loadBuffer(stream, &levelData[level].m_data);
+                if (!hasContents) {
+                    continue;
+                }
+                // What preSaveContents() reads back for the level.
+                const uint64_t levelSize =
+                        uint64_t(s_texImageSize(m_format, m_type, 1,
+                                                levelData[level].m_width,
+                                                levelData[level].m_height)) *
+                        (isDepth ? levelData[level].m_depth : 1);
+                const std::optional<gfxstream::CompressedPayload> contents =
+                        gfxstream::loadCompressedPayload(stream, levelSize);
+                if (!contents) {
+                    // Its bytes were skipped, so the other levels still load.
+                    GL_LOG("SaveableTexture::%s: level %u of a corrupt size\n",
+                           __func__, level);
+                    continue;
+                }
+                auto& buffer = levelData[level].m_data;
+                buffer.resize_noinit(contents->size);
+                if (!gfxstream::decompressPayload(
+                            contents->bytes.data(), contents->bytes.size(),
+                            buffer.data(), buffer.size())) {
+                    GL_LOG("SaveableTexture::%s: corrupt level %u\n",
+                           __func__, level);
+                    buffer.clear();
+                }
             }
         };
         switch (m_target) {
@@ -582,6 +635,184 @@ void SaveableTexture::loadFromStream(android::base::Stream* stream) {
     m_loadedFromStream.store(true);
 }
 
+void SaveableTexture::preSaveContents(gfxstream::SnapshotCompressor* compressor) {
+    // Only the targets onSave() saves the contents of.
+    if (m_target != GL_TEXTURE_2D && m_target != GL_TEXTURE_CUBE_MAP &&
+        m_target != GL_TEXTURE_3D && m_target != GL_TEXTURE_2D_ARRAY) {
+        return;
+    }
+
+    static constexpr GLenum pixelStoreIndexes[] = {
+            GL_PACK_ROW_LENGTH, GL_PACK_SKIP_PIXELS, GL_PACK_SKIP_ROWS,
+            GL_PACK_ALIGNMENT,
+    };
+    static constexpr GLint pixelStoreDesired[] = {0, 0, 0, 1};
+    GLint pixelStorePrev[android::base::arraySize(pixelStoreIndexes)];
+
+    GLDispatch& dispatcher = GLEScontext::dispatcher();
+    assert(dispatcher.glGetIntegerv);
+    for (int i = 0; i != android::base::arraySize(pixelStoreIndexes); ++i) {
+        if (isGles2Gles() && pixelStoreIndexes[i] != GL_PACK_ALIGNMENT &&
+            pixelStoreIndexes[i] != GL_UNPACK_ALIGNMENT) {
+            continue;
+        }
+        dispatcher.glGetIntegerv(pixelStoreIndexes[i], &pixelStorePrev[i]);
+        if (pixelStorePrev[i] != pixelStoreDesired[i]) {
+            dispatcher.glPixelStorei(pixelStoreIndexes[i],
+                                     pixelStoreDesired[i]);
+        }
+    }
+    const GLint prevTex = s_getTextureBinding(m_target);
+
+    dispatcher.glBindTexture(m_target, getGlobalName());
+    // Get the number of mipmap levels.
+    unsigned int numLevels = m_texStorageLevels ? m_texStorageLevels :
+            m_maxMipmapLevel + 1;
+
+    // bug: 112749908
+    // Texture saving causes hundreds of megabytes of memory ballooning.
+    // This could be behind nullptr dereferences in crash reports if
+    // the user ran out of commit charge on Windows, which is not measured
+    // in android::base::System::isUnderMemoryPressure.
+    //
+    // To avoid it, the contents read back are handed to the compressor
+    // rather than kept in the imgData buffers, which only keep the sizes of
+    // the levels until onSave().
+    auto readTex = [this, compressor, numLevels, &dispatcher](
+                           GLenum target, bool isDepth,
+                           std::unique_ptr<LevelImageData[]>& imgData) {
+        if (!m_isDirty && imgData) {
+            // Loaded from a snapshot and not changed since.
+            for (unsigned int level = 0; level < numLevels; level++) {
+                const auto& buffer = imgData.get()[level].m_data;
+                m_contentsToSave.push_back(compressor->compress(
+                        std::vector<uint8_t>(buffer.data(),
+                                             buffer.data() + buffer.size())));
+            }
+            return;
+        }
+
+        imgData.reset(new LevelImageData[numLevels]);
+        for (unsigned int level = 0; level < numLevels; level++) {
+            unsigned int& width = imgData.get()[level].m_width;
+            unsigned int& height = imgData.get()[level].m_height;
+            unsigned int& depth = imgData.get()[level].m_depth;
+            width = level == 0 ? m_width :
+                std::max<unsigned int>(
+                    imgData.get()[level - 1].m_width / 2, 1);
+            height = level == 0 ? m_height :
+                std::max<unsigned int>(
+                    imgData.get()[level - 1].m_height / 2, 1);
+            depth = level == 0 ? m_depth :
+                std::max<unsigned int>(
+                    imgData.get()[level - 1].m_depth / 2, 1);
+
+            if (!isGles2Gles()) {
+                GLint glWidth;
+                GLint glHeight;
+                dispatcher.glGetTexLevelParameteriv(target, level,
+                        GL_TEXTURE_WIDTH, &glWidth);
+                dispatcher.glGetTexLevelParameteriv(target, level,
+                        GL_TEXTURE_HEIGHT, &glHeight);
+                width = static_cast<unsigned int>(glWidth);
+                height = static_cast<unsigned int>(glHeight);
+            }
+            if (isDepth) {
+                if (!isGles2Gles()) {
+                    GLint glDepth;
+                    dispatcher.glGetTexLevelParameteriv(target, level,
+                            GL_TEXTURE_DEPTH, &glDepth);
+                    depth = static_cast<unsigned int>(std::max(glDepth,
+                            1));
+                }
+            } else {
+                depth = 1;
+            }
+            // Snapshot texture data
+            std::vector<uint8_t> buffer(
+                    s_texImageSize(m_format, m_type, 1, width, height) *
+                    depth);
+            if (!buffer.empty()) {
+                GLenum neededBufferFormat = m_format;
+                if (isCoreProfile()) {
+                    neededBufferFormat =
+                        getCoreProfileEmulatedFormat(m_format);
+                }
+                sTextureDataReader()->getTexImage(
+                    m_globalName, target, level, neededBufferFormat, m_type, width, height, depth, buffer.data());
+            }
+            m_contentsToSave.push_back(compressor->compress(std::move(buffer)));
+        }
+    };
+    switch (m_target) {
+        case GL_TEXTURE_2D:
+            readTex(GL_TEXTURE_2D, false, m_levelData[0]);
+            break;
+        case GL_TEXTURE_CUBE_MAP:
+            readTex(GL_TEXTURE_CUBE_MAP_POSITIVE_X, false, m_levelData[0]);
+            readTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, false, m_levelData[1]);
+            readTex(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, false, m_levelData[2]);
+            readTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, false, m_levelData[3]);
+            readTex(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, false, m_levelData[4]);
+            readTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, false, m_levelData[5]);
+            break;
+        case GL_TEXTURE_3D:
+            readTex(GL_TEXTURE_3D, true, m_levelData[0]);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            readTex(GL_TEXTURE_2D_ARRAY, true, m_levelData[0]);
+            break;
+        default:
+            break;
+    }
+
+    // Restore environment
+    for (int i = 0; i != android::base::arraySize(pixelStoreIndexes); ++i) {
+        if (isGles2Gles() && pixelStoreIndexes[i] != GL_PACK_ALIGNMENT &&
+            pixelStoreIndexes[i] != GL_UNPACK_ALIGNMENT) {
+            continue;
+        }
+        if (pixelStorePrev[i] != pixelStoreDesired[i]) {
+            dispatcher.glPixelStorei(pixelStoreIndexes[i],
+                                     pixelStorePrev[i]);
+        }
+    }
+    dispatcher.glBindTexture(m_target, prevTex);
+    m_contentsPreSaved = true;
+}
+
+void SaveableTexture::waitForContents() {
+    for (auto& contents : m_contentsToSave) {
+        m_compressedContents.push_back(contents.get());
+    }
+    m_contentsToSave.clear();
+}
+
+std::optional<std::vector<uint64_t>> SaveableTexture::getContentsKey() {
+    waitForContents();
+    if (!m_contentsPreSaved) {
+        return std::nullopt;
+    }
+    unsigned int numLevels = m_texStorageLevels ? m_texStorageLevels :
+            m_maxMipmapLevel + 1;
+    std::vector<uint64_t> key = {m_target, numLevels};
+    for (const auto& contents : m_compressedContents) {
+        key.push_back(contents.size);
+        key.push_back(contents.hash);
+        key.push_back(contents.bytes.size());
+        key.push_back(contents.bytesHash);
+    }
+    return key;
+}
+
+void SaveableTexture::skipSavingContents() {
+    m_skipSavingContents = true;
+}
+
+void SaveableTexture::setContentsSource(std::shared_ptr<SaveableTexture> source) {
+    m_contentsSource = std::move(source);
+}
+
 void SaveableTexture::onSave(
         android::base::Stream* stream) {
     stream->putBe32(m_target);
@@ -597,177 +828,62 @@ void SaveableTexture::onSave(
     // TODO: handle other texture targets
     if (m_target == GL_TEXTURE_2D || m_target == GL_TEXTURE_CUBE_MAP ||
         m_target == GL_TEXTURE_3D || m_target == GL_TEXTURE_2D_ARRAY) {
-        static constexpr GLenum pixelStoreIndexes[] = {
-                GL_PACK_ROW_LENGTH, GL_PACK_SKIP_PIXELS, GL_PACK_SKIP_ROWS,
-                GL_PACK_ALIGNMENT,
-        };
-        static constexpr GLint pixelStoreDesired[] = {0, 0, 0, 1};
-        GLint pixelStorePrev[android::base::arraySize(pixelStoreIndexes)];
+        if (!m_contentsPreSaved) {
+            gfxstream::SnapshotCompressor compressor;
+            preSaveContents(&compressor);
+        }
+        waitForContents();
 
-        GLint prevTex = 0;
         GLDispatch& dispatcher = GLEScontext::dispatcher();
         assert(dispatcher.glGetIntegerv);
-        for (int i = 0; i != android::base::arraySize(pixelStoreIndexes); ++i) {
-            if (isGles2Gles() && pixelStoreIndexes[i] != GL_PACK_ALIGNMENT &&
-                pixelStoreIndexes[i] != GL_UNPACK_ALIGNMENT) {
-                continue;
-            }
-            dispatcher.glGetIntegerv(pixelStoreIndexes[i], &pixelStorePrev[i]);
-            if (pixelStorePrev[i] != pixelStoreDesired[i]) {
-                dispatcher.glPixelStorei(pixelStoreIndexes[i],
-                                         pixelStoreDesired[i]);
-            }
-        }
-        switch (m_target) {
-            case GL_TEXTURE_2D:
-                dispatcher.glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex);
-                break;
-            case GL_TEXTURE_CUBE_MAP:
-                dispatcher.glGetIntegerv(GL_TEXTURE_BINDING_CUBE_MAP, &prevTex);
-                break;
-            case GL_TEXTURE_3D:
-                dispatcher.glGetIntegerv(GL_TEXTURE_BINDING_3D, &prevTex);
-                break;
-            case GL_TEXTURE_2D_ARRAY:
-                dispatcher.glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &prevTex);
-                break;
-            default:
-                break;
-        }
-
+        const GLint prevTex = s_getTextureBinding(m_target);
         dispatcher.glBindTexture(m_target, getGlobalName());
         // Get the number of mipmap levels.
         unsigned int numLevels = m_texStorageLevels ? m_texStorageLevels :
                 m_maxMipmapLevel + 1;
 
-        // bug: 112749908
-        // Texture saving causes hundreds of megabytes of memory ballooning.
-        // This could be behind nullptr dereferences in crash reports if
-        // the user ran out of commit charge on Windows, which is not measured
-        // in android::base::System::isUnderMemoryPressure.
-        //
-        // To debug this issue, avoid keeping the imgData buffers around,
-        // and log the memory usage.
-        //
-        // bool isLowMem = android::base::System::isUnderMemoryPressure();
-        bool isLowMem = true;
-
-        auto saveTex = [this, stream, numLevels, &dispatcher, isLowMem](
-                                GLenum target, bool isDepth,
-                                std::unique_ptr<LevelImageData[]>& imgData) {
-
-            if (m_isDirty) {
-                imgData.reset(new LevelImageData[numLevels]);
-                for (unsigned int level = 0; level < numLevels; level++) {
-                    unsigned int& width = imgData.get()[level].m_width;
-                    unsigned int& height = imgData.get()[level].m_height;
-                    unsigned int& depth = imgData.get()[level].m_depth;
-                    width = level == 0 ? m_width :
-                        std::max<unsigned int>(
-                            imgData.get()[level - 1].m_width / 2, 1);
-                    height = level == 0 ? m_height :
-                        std::max<unsigned int>(
-                            imgData.get()[level - 1].m_height / 2, 1);
-                    depth = level == 0 ? m_depth :
-                        std::max<unsigned int>(
-                            imgData.get()[level - 1].m_depth / 2, 1);
-
-                    // ScopedMemoryProfiler::Callback memoryProfilerCallback =
-                    //     [this, level, width, height, depth]
-                    //     (StringView tag, StringView stage,
-                    //      MemoryProfiler::MemoryUsageBytes currentResident,
-                    //      MemoryProfiler::MemoryUsageBytes change) {
-
-                    //     double megabyte = 1024.0 * 1024.0;
-
-                    //     GL_LOG("%s %s: %f mb current. change: %f mb. texture:"
-                    //            "format 0x%x type 0x%x level 0x%x dims (%u, %u, %u)\n",
-                    //            c_str(tag).get(),
-                    //            c_str(stage).get(),
-                    //            (double)currentResident / megabyte,
-                    //            (double)change / megabyte,
-                    //            m_format,
-                    //            m_type,
-                    //            level,
-                    //            width, height, depth);
-                    // };
-
-                    // ScopedMemoryProfiler mem("saveTexture", memoryProfilerCallback);
-
-                    android::base::SmallFixedVector<unsigned char, 16>& buffer
-                        = imgData.get()[level].m_data;
-                    if (!isGles2Gles()) {
-                        GLint glWidth;
-                        GLint glHeight;
-                        dispatcher.glGetTexLevelParameteriv(target, level,
-                                GL_TEXTURE_WIDTH, &glWidth);
-                        dispatcher.glGetTexLevelParameteriv(target, level,
-                                GL_TEXTURE_HEIGHT, &glHeight);
-                        width = static_cast<unsigned int>(glWidth);
-                        height = static_cast<unsigned int>(glHeight);
-                    }
-                    if (isDepth) {
-                        if (!isGles2Gles()) {
-                            GLint glDepth;
-                            dispatcher.glGetTexLevelParameteriv(target, level,
-                                    GL_TEXTURE_DEPTH, &glDepth);
-                            depth = static_cast<unsigned int>(std::max(glDepth,
-                                    1));
-                        }
-                    } else {
-                        depth = 1;
-                    }
-                    // Snapshot texture data
-                    buffer.clear();
-                    buffer.resize_noinit(
-                            s_texImageSize(m_format, m_type, 1, width, height) *
-                            depth);
-                    if (!buffer.empty()) {
-                        GLenum neededBufferFormat = m_format;
-                        if (isCoreProfile()) {
-                            neededBufferFormat =
-                                getCoreProfileEmulatedFormat(m_format);
-                        }
-                        sTextureDataReader()->getTexImage(
-                            m_globalName, target, level, neededBufferFormat, m_type, width, height, depth, buffer.data());
-                    }
-                }
-            }
+        // Whether the contents follow, or were saved with another texture
+        // of the same contents.
+        stream->putByte(!m_skipSavingContents);
+        auto contents = m_compressedContents.begin();
+        auto saveTex = [this, stream, numLevels, &contents](
+                               bool isDepth,
+                               std::unique_ptr<LevelImageData[]>& imgData) {
             for (unsigned int level = 0; level < numLevels; level++) {
                 stream->putBe32(imgData.get()[level].m_width);
                 stream->putBe32(imgData.get()[level].m_height);
                 if (isDepth) {
                     stream->putBe32(imgData.get()[level].m_depth);
                 }
-                saveBuffer(stream, imgData.get()[level].m_data);
+                if (!m_skipSavingContents) {
+                    gfxstream::saveCompressedPayload(stream, *contents);
+                }
+                ++contents;
             }
 
-            // If under memory pressure, delete this intermediate buffer.
-            if (isLowMem) {
-                imgData.reset();
-            }
+            // The contents were only kept until here, see preSaveContents().
+            imgData.reset();
         };
         switch (m_target) {
             case GL_TEXTURE_2D:
-                saveTex(GL_TEXTURE_2D, false, m_levelData[0]);
+                saveTex(false, m_levelData[0]);
                 break;
             case GL_TEXTURE_CUBE_MAP:
-                saveTex(GL_TEXTURE_CUBE_MAP_POSITIVE_X, false, m_levelData[0]);
-                saveTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, false, m_levelData[1]);
-                saveTex(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, false, m_levelData[2]);
-                saveTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, false, m_levelData[3]);
-                saveTex(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, false, m_levelData[4]);
-                saveTex(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, false, m_levelData[5]);
+                for (int i = 0; i < 6; i++) {
+                    saveTex(false, m_levelData[i]);
+                }
                 break;
             case GL_TEXTURE_3D:
-                saveTex(GL_TEXTURE_3D, true, m_levelData[0]);
-                break;
             case GL_TEXTURE_2D_ARRAY:
-                saveTex(GL_TEXTURE_2D_ARRAY, true, m_levelData[0]);
+                saveTex(true, m_levelData[0]);
                 break;
             default:
                 break;
         }
+        m_compressedContents.clear();
+        m_contentsPreSaved = false;
+        m_skipSavingContents = false;
+
         // Snapshot texture param
         TextureSwizzle emulatedBaseSwizzle;
         if (isCoreProfile()) {
@@ -807,27 +923,11 @@ void SaveableTexture::onSave(
                     s->putBe32(pair.second);
                 });
         // Restore environment
-        for (int i = 0; i != android::base::arraySize(pixelStoreIndexes); ++i) {
-            if (isGles2Gles() && pixelStoreIndexes[i] != GL_PACK_ALIGNMENT &&
-                pixelStoreIndexes[i] != GL_UNPACK_ALIGNMENT) {
-                continue;
-            }
-            if (pixelStorePrev[i] != pixelStoreDesired[i]) {
-                dispatcher.glPixelStorei(pixelStoreIndexes[i],
-                                         pixelStorePrev[i]);
-            }
-        }
         dispatcher.glBindTexture(m_target, prevTex);
 
-        // If we were under memory pressure, we deleted the intermediate
-        // buffer, so we need to maintain the invariant that m_isDirty = false
-        // textures requires that the intermediate buffer is still around.
-        // Therefore, mark as dirty if we were under memory pressure.
-        //
-        // TODO: Don't keep those around in memory regardless of memory
-        // pressure
-
-        m_isDirty = false || isLowMem;
+        // The intermediate buffers were deleted, so the contents have to be
+        // read back again on the next save.
+        m_isDirty = true;
     } else if (m_target != 0) {
         // SaveableTexture is uninitialized iff a texture hasn't been bound,
         // which will give m_target==0
@@ -836,9 +936,57 @@ void SaveableTexture::onSave(
     }
 }
 
-void SaveableTexture::restore() {
+void SaveableTexture::prefetch() {
+    std::lock_guard<std::mutex> lock(m_prefetchLock);
+    if (m_prefetched) {
+        return;
+    }
     assert(m_loader);
     m_loader(this);
+    if (m_contentsSource) {
+        copyContentsFrom(m_contentsSource.get());
+        m_contentsSource.reset();
+    }
+    m_prefetched = true;
+}
+
+void SaveableTexture::copyContentsFrom(SaveableTexture* source) {
+    source->prefetch();
+
+    unsigned int numLevels = m_texStorageLevels ? m_texStorageLevels :
+            m_maxMipmapLevel + 1;
+    unsigned int sourceNumLevels = source->m_texStorageLevels ?
+            source->m_texStorageLevels : source->m_maxMipmapLevel + 1;
+    bool sameLayout = m_target == source->m_target &&
+            numLevels == sourceNumLevels;
+    for (int face = 0; face < 6 && sameLayout; face++) {
+        sameLayout = !m_levelData[face] == !source->m_levelData[face];
+    }
+    if (!sameLayout) {
+        // Only textures of the same layout are saved together, so the
+        // snapshot is corrupt.
+        GL_LOG("SaveableTexture::%s: contents source of another layout\n",
+               __func__);
+        return;
+    }
+    for (int face = 0; face < 6; face++) {
+        if (!m_levelData[face]) {
+            continue;
+        }
+        for (unsigned int level = 0; level < numLevels; level++) {
+            const auto& from = source->m_levelData[face][level].m_data;
+            auto& to = m_levelData[face][level].m_data;
+            to.clear();
+            to.resize_noinit(from.size());
+            if (!from.empty()) {
+                memcpy(to.data(), from.data(), from.size());
+            }
+        }
+    }
+}
+
+void SaveableTexture::restore() {
+    prefetch();
 
     if (!m_loadedFromStream.load()) {
         return;
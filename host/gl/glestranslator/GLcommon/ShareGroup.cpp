@@ -24,12 +24,69 @@
 #include "host-common/logging.h"
 
 #include <array>
+#include <memory>
+#include <thread>
 #include <utility>
 
 static constexpr int toIndex(NamedObjectType type) {
     return static_cast<int>(type);
 }
 
+namespace {
+
+// Shared by all the share groups, so that a share group allocated where a
+// deleted one was doesn't hit the cache entries of the latter.
+std::atomic<uint64_t> sNextNameGeneration{1};
+
+// Lookups cached per thread and kind of lookup. Must be a power of two.
+constexpr size_t kNameCacheSize = 256;
+
+// Spins before yielding while waiting for the object data lock.
+constexpr int kObjectDataLockSpins = 1000;
+
+struct NameCacheEntry {
+    uint64_t generation = 0;
+    const ShareGroup* shareGroup = nullptr;
+    NamedObjectType type = NamedObjectType::NULLTYPE;
+    uint64_t key = 0;
+    uint64_t value = 0;
+};
+
+struct NamedObjectCacheEntry {
+    uint64_t generation = 0;
+    const ShareGroup* shareGroup = nullptr;
+    NamedObjectType type = NamedObjectType::NULLTYPE;
+    ObjectLocalName localName = 0;
+    // Weak, so that the cache doesn't delay deleting the object.
+    std::weak_ptr<NamedObject> object;
+};
+
+// Only accessed by its thread.
+struct NameCache {
+    NameCacheEntry globalNames[kNameCacheSize];
+    NameCacheEntry localNames[kNameCacheSize];
+    NamedObjectCacheEntry namedObjects[kNameCacheSize];
+};
+
+NameCache& nameCache() {
+    // On the heap, to keep it out of the static TLS block.
+    static thread_local std::unique_ptr<NameCache> tCache(new NameCache);
+    return *tCache;
+}
+
+size_t nameCacheIndex(NamedObjectType type, uint64_t key) {
+    return ((key * 0x9E3779B97F4A7C15ull) >> 32 ^ toIndex(type)) & (kNameCacheSize - 1);
+}
+
+template <class Entry>
+bool isHit(const Entry& entry, const ShareGroup* shareGroup, uint64_t generation,
+           NamedObjectType type) {
+    return entry.generation == generation && entry.shareGroup == shareGroup &&
+           entry.type == type;
+}
+
+}  // namespace
+
 struct ShareGroup::ObjectDataAutoLock {
     ObjectDataAutoLock(ShareGroup* self) : self(self) {
         self->lockObjectData();
@@ -45,6 +102,7 @@ ShareGroup::ShareGroup(GlobalNameSpace *globalNameSpace,
                        uint64_t sharedGroupID,
                        android::base::Stream* stream,
                        const ObjectData::loadObject_t& loadObject) :
+                       m_nameGeneration(sNextNameGeneration.fetch_add(1)),
                        m_sharedGroupID(sharedGroupID) {
     ObjectDataAutoLock lock(this);
     for (int i = 0; i < toIndex(NamedObjectType::NUM_OBJECT_TYPES);
@@ -118,6 +176,9 @@ void ShareGroup::postLoadRestore() {
             ++i;
         }
         m_needLoadRestore = false;
+        // Restoring created the global names, without |m_namespaceLock|.
+        android::base::AutoLock namespaceLock(m_namespaceLock);
+        bumpNameGeneration();
     }
 }
 
@@ -126,13 +187,25 @@ bool ShareGroup::needRestore() {
 }
 
 void ShareGroup::lockObjectData() {
-    while (m_objectsDataLock.test_and_set(std::memory_order_acquire)) {
-        ;
+    int spins = 0;
+    while (m_objectsDataLocked.exchange(true, std::memory_order_acquire)) {
+        // Wait for the lock to look free before trying again, rather than
+        // taking its cache line away from the owner on every iteration.
+        while (m_objectsDataLocked.load(std::memory_order_relaxed)) {
+            if (++spins > kObjectDataLockSpins) {
+                std::this_thread::yield();
+            }
+        }
     }
 }
 
 void ShareGroup::unlockObjectData() {
-    m_objectsDataLock.clear(std::memory_order_release);
+    m_objectsDataLocked.store(false, std::memory_order_release);
+}
+
+void ShareGroup::bumpNameGeneration() {
+    m_nameGeneration.store(sNextNameGeneration.fetch_add(1, std::memory_order_relaxed),
+                           std::memory_order_release);
 }
 
 ShareGroup::~ShareGroup()
@@ -162,6 +235,7 @@ ShareGroup::genName(GenNameInfo genNameInfo,
             m_nameSpace[toIndex(genNameInfo.m_type)]->genName(
                                                     genNameInfo,
                                                     p_localName, genLocal);
+    bumpNameGeneration();
     return localName;
 }
 
@@ -186,8 +260,18 @@ ShareGroup::getGlobalName(NamedObjectType p_type,
     if (toIndex(p_type) >= toIndex(NamedObjectType::NUM_OBJECT_TYPES)) {
         return 0;
     }
+
+    NameCacheEntry& entry = nameCache().globalNames[nameCacheIndex(p_type, p_localName)];
+    if (isHit(entry, this, m_nameGeneration.load(std::memory_order_acquire), p_type) &&
+        entry.key == p_localName) {
+        return static_cast<unsigned int>(entry.value);
+    }
+
     android::base::AutoLock lock(m_namespaceLock);
-    return m_nameSpace[toIndex(p_type)]->getGlobalName(p_localName);
+    const unsigned int globalName = m_nameSpace[toIndex(p_type)]->getGlobalName(p_localName);
+    entry = {m_nameGeneration.load(std::memory_order_relaxed), this, p_type, p_localName,
+             globalName};
+    return globalName;
 }
 
 ObjectLocalName
@@ -199,8 +283,17 @@ ShareGroup::getLocalName(NamedObjectType p_type,
         return 0;
     }
 
+    NameCacheEntry& entry = nameCache().localNames[nameCacheIndex(p_type, p_globalName)];
+    if (isHit(entry, this, m_nameGeneration.load(std::memory_order_acquire), p_type) &&
+        entry.key == p_globalName) {
+        return entry.value;
+    }
+
     android::base::AutoLock lock(m_namespaceLock);
-    return m_nameSpace[toIndex(p_type)]->getLocalName(p_globalName);
+    const ObjectLocalName localName = m_nameSpace[toIndex(p_type)]->getLocalName(p_globalName);
+    entry = {m_nameGeneration.load(std::memory_order_relaxed), this, p_type, p_globalName,
+             localName};
+    return localName;
 }
 
 NamedObjectPtr ShareGroup::getNamedObject(NamedObjectType p_type,
@@ -210,8 +303,23 @@ NamedObjectPtr ShareGroup::getNamedObject(NamedObjectType p_type,
         return 0;
     }
 
+    NamedObjectCacheEntry& entry =
+            nameCache().namedObjects[nameCacheIndex(p_type, p_localName)];
+    if (isHit(entry, this, m_nameGeneration.load(std::memory_order_acquire), p_type) &&
+        entry.localName == p_localName) {
+        // The names didn't change, so the object can only be gone if there
+        // was none.
+        return entry.object.lock();
+    }
+
     android::base::AutoLock lock(m_namespaceLock);
-    return m_nameSpace[toIndex(p_type)]->getNamedObject(p_localName);
+    NamedObjectPtr namedObject = m_nameSpace[toIndex(p_type)]->getNamedObject(p_localName);
+    entry.generation = m_nameGeneration.load(std::memory_order_relaxed);
+    entry.shareGroup = this;
+    entry.type = p_type;
+    entry.localName = p_localName;
+    entry.object = namedObject;
+    return namedObject;
 }
 
 void
@@ -225,6 +333,7 @@ ShareGroup::deleteName(NamedObjectType p_type, ObjectLocalName p_localName)
     android::base::AutoLock lock(m_namespaceLock);
     ObjectDataAutoLock objDataLock(this);
     m_nameSpace[toIndex(p_type)]->deleteName(p_localName);
+    bumpNameGeneration();
 }
 
 bool
@@ -252,6 +361,7 @@ ShareGroup::replaceGlobalObject(NamedObjectType p_type,
     android::base::AutoLock lock(m_namespaceLock);
     m_nameSpace[toIndex(p_type)]->replaceGlobalObject(p_localName,
                                                                p_globalObject);
+    bumpNameGeneration();
 }
 
 void
@@ -267,6 +377,7 @@ ShareGroup::setGlobalObject(NamedObjectType p_type,
     android::base::AutoLock lock(m_namespaceLock);
     m_nameSpace[toIndex(p_type)]->setGlobalObject(p_localName,
                                                   p_globalObject);
+    bumpNameGeneration();
 }
 
 void
@@ -357,6 +468,7 @@ unsigned int ShareGroup::ensureObjectOnBind(NamedObjectType p_type, ObjectLocalN
     bool genLocal = false;
     auto gi = GenNameInfo(p_type);
     ns->genName( gi, p_localName, genLocal);
+    bumpNameGeneration();
 
     switch (p_type) {
         case NamedObjectType::VERTEXBUFFER: {
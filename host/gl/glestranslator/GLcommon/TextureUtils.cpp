@@ -23,8 +23,10 @@
 
 #include "aemu/base/AlignedBuf.h"
 #include "compressedTextureFormats/AstcCpuDecompressor.h"
+#include "compressedTextureFormats/DecompressedTextureCache.h"
 
 using android::AlignedBuf;
+using gfxstream::DecompressedTextureCache;
 using gfxstream::vk::AstcCpuDecompressor;
 
 #define GL_R16 0x822A
@@ -482,11 +484,13 @@ void doCompressedTexImage2D(GLEScontext* ctx, GLenum target, GLint level,
         const size_t size = bpr * height;
         std::unique_ptr<etc1_byte[]> pOut(new etc1_byte[size]);
 
-        int res =
-            etc2_decode_image(
-                    (const etc1_byte*)data, etcFormat, pOut.get(),
-                    width, height, bpr);
-        SET_ERROR_IF(res!=0, GL_INVALID_VALUE);
+        const bool decoded = DecompressedTextureCache::get().getOrDecompress(
+            internalformat, width, height, (const uint8_t*)data, compressedSize, pOut.get(), size,
+            [&] {
+                return etc2_decode_image((const etc1_byte*)data, etcFormat, pOut.get(), width,
+                                         height, bpr) == 0;
+            });
+        SET_ERROR_IF(!decoded, GL_INVALID_VALUE);
 
         glTexImage2DPtr(target, level, convertedInternalFormat,
                         width, height, border, format, type, pOut.get());
@@ -515,9 +519,14 @@ void doCompressedTexImage2D(GLEScontext* ctx, GLenum target, GLint level,
 
         AlignedBuf<uint8_t, 64> alignedUncompressedData(size);
 
-        const bool result = astcDecompress(
-                reinterpret_cast<const uint8_t*>(data), imageSize, width,
-                height, blockWidth, blockHeight, alignedUncompressedData.data(), size);
+        const bool result = DecompressedTextureCache::get().getOrDecompress(
+            DecompressedTextureCache::astcFormat(blockWidth, blockHeight), width, height,
+            reinterpret_cast<const uint8_t*>(data), imageSize, alignedUncompressedData.data(),
+            size, [&] {
+                return astcDecompress(reinterpret_cast<const uint8_t*>(data), imageSize, width,
+                                      height, blockWidth, blockHeight,
+                                      alignedUncompressedData.data(), size);
+            });
         SET_ERROR_IF(!result, GL_INVALID_VALUE);
 
         glTexImage2DPtr(target, level, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, width,
@@ -598,9 +607,13 @@ void doCompressedTexImage2D(GLEScontext* ctx, GLenum target, GLint level,
         const size_t size = bpr * height;
         std::unique_ptr<uint8_t[]> pOut(new uint8_t[size]);
 
-        int res =
-            rgtc_decode_image((const uint8_t*)data, rgtcFormat, pOut.get(), width, height, bpr);
-        SET_ERROR_IF(res != 0, GL_INVALID_VALUE);
+        const bool decoded = DecompressedTextureCache::get().getOrDecompress(
+            internalformat, width, height, (const uint8_t*)data, compressedSize, pOut.get(), size,
+            [&] {
+                return rgtc_decode_image((const uint8_t*)data, rgtcFormat, pOut.get(), width,
+                                         height, bpr) == 0;
+            });
+        SET_ERROR_IF(!decoded, GL_INVALID_VALUE);
         glTexImage2DPtr(target, level, convertedInternalFormat, width, height, border, format, type,
                         pOut.get());
     } else {
@@ -22,8 +22,18 @@
 #include <EGL/egl.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
+// Restores the textures of a snapshot in the background, after it is loaded.
+//
+// The loader thread reads and decodes the textures from the snapshot, and a
+// pool of threads, each with its own auxiliary context, uploads them. The
+// prioritized textures go first, and the others are uploaded with a delay
+// between them to leave the GPU to the guest.
 class GLBackgroundLoader : public android::base::InterruptibleThread {
 public:
     GLBackgroundLoader(const android::snapshot::ITextureLoaderWPtr& textureLoaderWeak,
@@ -39,11 +49,22 @@ public:
         m_textureMap.clear();
     }
 
+    // Restores the texture of |globalName| before the others. Must be called
+    // before the thread starts.
+    void prioritize(unsigned int globalName);
+
     intptr_t main() override;
     bool wait(intptr_t* exitStatus) override;
     void interrupt() override;
 
 private:
+    struct Upload {
+        SaveableTexture* texture;
+        bool prioritized;
+    };
+
+    void uploadLoop(int index);
+
     std::atomic<int> m_loadDelayMs { 10 };
     std::atomic<bool> m_interrupted { false };
 
@@ -52,4 +73,12 @@ private:
     const GLESiface& m_glesIface;
 
     SaveableTextureMap& m_textureMap;
+    std::unordered_set<unsigned int> m_prioritized;
+
+    // The textures read, waiting to be uploaded.
+    std::mutex m_uploadLock;
+    std::condition_variable m_uploadCv;
+    std::deque<Upload> m_uploads;
+    bool m_readingDone = false;
+    int m_numUploadThreads = 0;
 };
@@ -150,6 +150,8 @@ public:
                 SaveableTexture::creator_t creator);
     void postLoad(android::base::Stream* stream);
     const SaveableTexturePtr& getSaveableTextureFromLoad(unsigned int oldGlobalName);
+    // Restores the texture of |oldGlobalName| before the others, after loading.
+    void prioritizeOnLoad(unsigned int oldGlobalName);
     SaveableTextureMap* getSaveableTextureMap() { return &m_textureMap; }
 
     void clearTextureMap();
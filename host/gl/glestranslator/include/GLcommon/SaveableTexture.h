@@ -19,6 +19,7 @@
 #include "aemu/base/containers/SmallVector.h"
 #include "aemu/base/files/Stream.h"
 #include "snapshot/LazySnapshotObj.h"
+#include "snapshotCompression/SnapshotCompressor.h"
 #include "GLcommon/NamedObject.h"
 #include "GLcommon/TextureData.h"
 #include "GLcommon/TranslatorIfaces.h"
@@ -27,7 +28,11 @@
 
 #include <atomic>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 class GLDispatch;
 class GlobalNameSpace;
@@ -69,6 +74,24 @@ public:
     // The bound context cannot be changed from preSave to onSave to postSave
     static void preSave();
     static void postSave();
+    // Reads the contents back and starts compressing them on |compressor| for
+    // onSave(), so that reading the next textures back overlaps it. Otherwise
+    // onSave() does it all.
+    // precondition: a context must be properly bound
+    void preSaveContents(gfxstream::SnapshotCompressor* compressor);
+    // Waits for the contents read back by preSaveContents() to be compressed,
+    // and returns a key which is the same for textures of the same contents,
+    // or nothing if there are none. It holds the target, the number of levels,
+    // and the sizes and hashes of the contents of each level both before and
+    // after compression, so that a collision of one hash alone doesn't make
+    // two textures the same.
+    std::optional<std::vector<uint64_t>> getContentsKey();
+    // Makes onSave() leave out the contents, as they are saved with another
+    // texture.
+    void skipSavingContents();
+    // Makes the contents those of |source| once loaded, as they were saved with
+    // it.
+    void setContentsSource(std::shared_ptr<SaveableTexture> source);
     // precondition: a context must be properly bound
     void onSave(android::base::Stream* stream);
     // getGlobalObject() will touch and load data onto GPU if it is not yet
@@ -77,6 +100,9 @@ public:
     // precondition: a context must be properly bound
     void fillEglImage(EglImage* eglImage);
     void loadFromStream(android::base::Stream* stream);
+    // Reads the texture from the snapshot, if it wasn't yet, so that restore()
+    // only has to upload it. Needs no context.
+    void prefetch();
     void makeDirty();
     bool isDirty() const;
     void setTarget(GLenum target);
@@ -89,6 +115,9 @@ public:
     void restore();
 
 private:
+    void waitForContents();
+    void copyContentsFrom(SaveableTexture* source);
+
     unsigned int m_target = GL_TEXTURE_2D;
     unsigned int m_width = 0;
     unsigned int m_height = 0;
@@ -115,6 +144,15 @@ private:
     GlobalNameSpace* m_globalNamespace = nullptr;
     bool m_isDirty = true;
     std::atomic<bool> m_loadedFromStream { false };
+    std::mutex m_prefetchLock;
+    bool m_prefetched = false;
+    // The contents of each level of each face read back for onSave(), being
+    // compressed, and once they are.
+    std::vector<std::future<gfxstream::CompressedPayload>> m_contentsToSave;
+    std::vector<gfxstream::CompressedPayload> m_compressedContents;
+    bool m_contentsPreSaved = false;
+    bool m_skipSavingContents = false;
+    std::shared_ptr<SaveableTexture> m_contentsSource;
 };
 
 typedef std::shared_ptr<SaveableTexture> SaveableTexturePtr;
@@ -42,6 +42,10 @@ class NameSpace;
 //   unless the user context share with another user context. In that case they
 //   both will share the same ShareGroup instance.
 //   calls into that class gets serialized through a lock so it is thread safe.
+//   Name lookups are cached per thread, so that the contexts of a share
+//   group don't serialize on that lock to translate names: the caches are
+//   valid as long as the generation of the ShareGroup, bumped whenever
+//   names are added, removed or remapped, doesn't change.
 //
 class ShareGroup
 {
@@ -136,6 +140,10 @@ private:
     // A RAII autolock class for the objectData spinlock.
     struct ObjectDataAutoLock;
 
+    // Invalidates the name lookups cached by the threads. Must be called
+    // with |m_namespaceLock| held, after changing the names.
+    void bumpNameGeneration();
+
 private:
     const ObjectDataPtr& getObjectDataPtrNoLock(NamedObjectType p_type,
                                                 ObjectLocalName p_localName);
@@ -144,11 +152,14 @@ private:
     android::base::Lock m_restoreLock;
     NameSpace* m_nameSpace[static_cast<int>(NamedObjectType::NUM_OBJECT_TYPES)];
 
+    // Changes whenever names are added, removed or remapped. Generations are
+    // unique across share groups.
+    std::atomic<uint64_t> m_nameGeneration;
     // |m_objectsData| has no measured data races, so replace heavyweight mutex
     // with a simple spinlock - just in case if there's some missed
     // multi-threaded access path.
     // TODO(zyy@): Create a common spinlock class.
-    std::atomic_flag m_objectsDataLock = ATOMIC_FLAG_INIT;
+    std::atomic<bool> m_objectsDataLocked{false};
     // The ID of this shared group
     // It is unique within its ObjectNameManager
     uint64_t m_sharedGroupID;
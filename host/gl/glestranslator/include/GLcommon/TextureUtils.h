@@ -18,8 +18,8 @@
 
 #include "GLEScontext.h"
 #include "PaletteTexture.h"
-#include "etc.h"
-#include "rgtc.h"
+#include "compressedTextureFormats/etc.h"
+#include "compressedTextureFormats/rgtc.h"
 
 #include <functional>
 #include <GLES/gl.h>
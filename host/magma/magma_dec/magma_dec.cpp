@@ -12,6 +12,8 @@
 
 #include "ChecksumCalculatorThreadInfo.h"
 
+#include "DecoderStats.h"
+
 #include "host-common/logging.h"
 
 #include <stdio.h>
@@ -38,6 +40,7 @@ size_t magma_decoder_context_t::decode(void *buf, size_t len, IOStream *stream,
 		uint32_t opcode = *(uint32_t *)ptr;
 		uint32_t packetLen = *(uint32_t *)(ptr + 4);
 		if (end - ptr < packetLen) return ptr - (unsigned char*)buf;
+		const uint64_t statsStartNs = DecoderStats::start();
 		switch(opcode) {
 		case OP_magma_device_import: {
 			android::base::beginTrace("magma_device_import decode");
@@ -1213,6 +1216,7 @@ size_t magma_decoder_context_t::decode(void *buf, size_t len, IOStream *stream,
 		default:
 			return ptr - (unsigned char*)buf;
 		} //switch
+		DecoderStats::finish(opcode, statsStartNs);
 		ptr += packetLen;
 	} // while
 	return ptr - (unsigned char*)buf;
@@ -12,6 +12,8 @@
 
 #include "ChecksumCalculatorThreadInfo.h"
 
+#include "DecoderStats.h"
+
 #include "host-common/logging.h"
 
 #include <stdio.h>
@@ -40,6 +42,7 @@ size_t renderControl_decoder_context_t::decode(void *buf, size_t len, IOStream *
         // calculation parameters.
         const size_t checksumSize = checksumCalc->checksumByteSize();
         const bool useChecksum = checksumSize > 0;
+		const uint64_t statsStartNs = DecoderStats::start();
 		switch(opcode) {
 		case OP_rcGetRendererVersion: {
 			android::base::beginTrace("rcGetRendererVersion decode");
@@ -1465,6 +1468,7 @@ size_t renderControl_decoder_context_t::decode(void *buf, size_t len, IOStream *
 		default:
 			return ptr - (unsigned char*)buf;
 		} //switch
+		DecoderStats::finish(opcode, statsStartNs);
 		ptr += packetLen;
 	} // while
 	return ptr - (unsigned char*)buf;
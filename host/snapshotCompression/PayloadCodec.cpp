@@ -0,0 +1,133 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PayloadCodec.h"
+
+#include <lz4.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace gfxstream {
+namespace {
+
+// Payloads are cut into blocks of this many bytes, the last one possibly smaller, which stay under
+// LZ4_MAX_INPUT_SIZE. Each block is stored as its compressed size, in 32 bits little endian,
+// followed by its LZ4 block.
+constexpr size_t kBlockSize = size_t(1) << 30;
+constexpr size_t kBlockHeaderSize = 4;
+
+void putBlockSize(uint32_t size, uint8_t* out) {
+    for (size_t i = 0; i < kBlockHeaderSize; i++) {
+        out[i] = static_cast<uint8_t>(size >> (8 * i));
+    }
+}
+
+uint32_t getBlockSize(const uint8_t* in) {
+    uint32_t size = 0;
+    for (size_t i = 0; i < kBlockHeaderSize; i++) {
+        size |= uint32_t(in[i]) << (8 * i);
+    }
+    return size;
+}
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+constexpr uint64_t kHashMultiplier = 0x9e3779b97f4a7c15ull;
+
+// Spreads every bit of |value| over all the others.
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+}  // namespace
+
+void compressPayload(const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+    out->resize(maxCompressedPayloadSize(size));
+    size_t op = 0;
+    for (size_t ip = 0; ip < size; ip += kBlockSize) {
+        const size_t blockSize = std::min(kBlockSize, size - ip);
+        const int compressedSize = LZ4_compress_default(
+            reinterpret_cast<const char*>(data + ip),
+            reinterpret_cast<char*>(out->data() + op + kBlockHeaderSize),
+            static_cast<int>(blockSize), LZ4_COMPRESSBOUND(static_cast<int>(blockSize)));
+        // Only fails if the output is smaller than the bound.
+        putBlockSize(static_cast<uint32_t>(compressedSize), out->data() + op);
+        op += kBlockHeaderSize + compressedSize;
+    }
+    out->resize(op);
+}
+
+size_t maxCompressedPayloadSize(size_t size) {
+    const size_t fullBlocks = size / kBlockSize;
+    const size_t lastBlockSize = size % kBlockSize;
+    size_t maxSize = fullBlocks * (kBlockHeaderSize + LZ4_COMPRESSBOUND(kBlockSize));
+    if (lastBlockSize) {
+        maxSize += kBlockHeaderSize + LZ4_COMPRESSBOUND(lastBlockSize);
+    }
+    return maxSize;
+}
+
+bool decompressPayload(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+    size_t ip = 0;
+    for (size_t op = 0; op < outSize; op += kBlockSize) {
+        const size_t blockSize = std::min(kBlockSize, outSize - op);
+        if (inSize - ip < kBlockHeaderSize) {
+            return false;
+        }
+        const uint32_t compressedSize = getBlockSize(in + ip);
+        ip += kBlockHeaderSize;
+        if (compressedSize > inSize - ip || compressedSize > LZ4_MAX_INPUT_SIZE) {
+            return false;
+        }
+        const int decompressedSize = LZ4_decompress_safe(
+            reinterpret_cast<const char*>(in + ip), reinterpret_cast<char*>(out + op),
+            static_cast<int>(compressedSize), static_cast<int>(blockSize));
+        if (decompressedSize < 0 || static_cast<size_t>(decompressedSize) != blockSize) {
+            return false;
+        }
+        ip += compressedSize;
+    }
+    return ip == inSize;
+}
+
+uint64_t hashPayload(const uint8_t* data, size_t size) {
+    // Four lanes of 8 bytes each keep the multiplications independent of one another.
+    uint64_t lanes[4] = {size, size ^ kHashMultiplier, ~size, size * kHashMultiplier};
+    size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        for (int i = 0; i < 4; i++) {
+            lanes[i] = (lanes[i] ^ mix(read64(data + pos + 8 * i))) * kHashMultiplier;
+        }
+    }
+    uint64_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        result = (result ^ mix(lanes[i])) * kHashMultiplier;
+    }
+    for (; pos < size; pos++) {
+        result = (result ^ data[pos]) * kHashMultiplier;
+    }
+    return mix(result);
+}
+
+}  // namespace gfxstream
@@ -0,0 +1,41 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace gfxstream {
+
+// Compresses snapshot payloads with LZ4, which trades ratio for speed to keep up with reading
+// images back from the GPU, and does well on the long runs of identical pixels typical of them.
+
+// Replaces the contents of |out| with the compressed |size| bytes of |data|.
+void compressPayload(const uint8_t* data, size_t size, std::vector<uint8_t>* out);
+
+// The largest size compressPayload() can turn |size| bytes into.
+size_t maxCompressedPayloadSize(size_t size);
+
+// Decompresses into exactly |outSize| bytes of |out|. Returns false if |compressed| is corrupt or
+// doesn't decompress into that many bytes.
+bool decompressPayload(const uint8_t* compressed, size_t compressedSize, uint8_t* out,
+                       size_t outSize);
+
+// A fast, non-cryptographic 64-bit hash of the |size| bytes of |data|, to find identical payloads.
+uint64_t hashPayload(const uint8_t* data, size_t size);
+
+}  // namespace gfxstream
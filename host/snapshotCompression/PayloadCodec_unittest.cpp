@@ -0,0 +1,131 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "PayloadCodec.h"
+
+namespace gfxstream {
+namespace {
+
+std::vector<uint8_t> roundTrip(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> compressed;
+    compressPayload(data.data(), data.size(), &compressed);
+    std::vector<uint8_t> decompressed(data.size());
+    EXPECT_TRUE(decompressPayload(compressed.data(), compressed.size(), decompressed.data(),
+                                  decompressed.size()));
+    return decompressed;
+}
+
+std::vector<uint8_t> randomBytes(size_t size) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(size);
+    for (uint8_t& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+TEST(PayloadCodecTest, RoundTripsSmallPayloads) {
+    for (size_t size = 0; size < 64; size++) {
+        const std::vector<uint8_t> data = randomBytes(size);
+        EXPECT_EQ(data, roundTrip(data));
+    }
+}
+
+TEST(PayloadCodecTest, RoundTripsRandomPayload) {
+    const std::vector<uint8_t> data = randomBytes(1 << 20);
+    EXPECT_EQ(data, roundTrip(data));
+}
+
+TEST(PayloadCodecTest, StaysWithinMaxCompressedSize) {
+    for (size_t size : {size_t(0), size_t(1), size_t(300), size_t(1) << 20}) {
+        const std::vector<uint8_t> data = randomBytes(size);
+        std::vector<uint8_t> compressed;
+        compressPayload(data.data(), data.size(), &compressed);
+        EXPECT_LE(compressed.size(), maxCompressedPayloadSize(size)) << size;
+    }
+}
+
+TEST(PayloadCodecTest, CompressesRepeatedPixels) {
+    // A solid image with a stripe, as 32-bit pixels.
+    std::vector<uint8_t> data(256 * 256 * 4);
+    for (size_t i = 0; i < data.size(); i += 4) {
+        const bool stripe = (i / 4) % 256 < 16;
+        data[i] = stripe ? 0xff : 0x20;
+        data[i + 1] = 0x40;
+        data[i + 2] = stripe ? 0x00 : 0x60;
+        data[i + 3] = 0xff;
+    }
+
+    std::vector<uint8_t> compressed;
+    compressPayload(data.data(), data.size(), &compressed);
+    EXPECT_LT(compressed.size(), data.size() / 32);
+    EXPECT_EQ(data, roundTrip(data));
+}
+
+TEST(PayloadCodecTest, RejectsCorruptPayloads) {
+    std::vector<uint8_t> data(4096, 0x55);
+    std::vector<uint8_t> compressed;
+    compressPayload(data.data(), data.size(), &compressed);
+
+    std::vector<uint8_t> decompressed(data.size());
+    // Truncated.
+    EXPECT_FALSE(decompressPayload(compressed.data(), compressed.size() - 1, decompressed.data(),
+                                   decompressed.size()));
+    // Decompresses into fewer or more bytes than expected.
+    EXPECT_FALSE(decompressPayload(compressed.data(), compressed.size(), decompressed.data(),
+                                   decompressed.size() - 1));
+    decompressed.resize(data.size() + 1);
+    EXPECT_FALSE(decompressPayload(compressed.data(), compressed.size(), decompressed.data(),
+                                   decompressed.size()));
+
+    decompressed.resize(data.size());
+
+    // A block size past the end of the payload.
+    std::vector<uint8_t> badBlockSize = compressed;
+    badBlockSize[0] += 1;
+    EXPECT_FALSE(decompressPayload(badBlockSize.data(), badBlockSize.size(), decompressed.data(),
+                                   decompressed.size()));
+
+    // Bytes that aren't an LZ4 block.
+    std::vector<uint8_t> garbage = compressed;
+    std::fill(garbage.begin() + 4, garbage.end(), 0xff);
+    EXPECT_FALSE(decompressPayload(garbage.data(), garbage.size(), decompressed.data(),
+                                   decompressed.size()));
+}
+
+TEST(PayloadCodecTest, HashesDifferingPayloadsApart) {
+    std::vector<uint8_t> data = randomBytes(4096 + 7);
+    const uint64_t hash = hashPayload(data.data(), data.size());
+    EXPECT_EQ(hash, hashPayload(data.data(), data.size()));
+
+    // Any single bit, in the bulk or the tail, or the size.
+    for (size_t pos : {size_t(0), size_t(1000), data.size() - 1}) {
+        data[pos] ^= 1;
+        EXPECT_NE(hash, hashPayload(data.data(), data.size()));
+        data[pos] ^= 1;
+    }
+    EXPECT_NE(hash, hashPayload(data.data(), data.size() - 1));
+
+    const std::vector<uint8_t> zeros(64, 0);
+    EXPECT_NE(hashPayload(zeros.data(), 32), hashPayload(zeros.data(), 64));
+}
+
+}  // namespace
+}  // namespace gfxstream
@@ -0,0 +1,136 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "SnapshotCompressor.h"
+
+#include <algorithm>
+
+#include "PayloadCodec.h"
+
+namespace gfxstream {
+namespace {
+
+constexpr unsigned int kMaxWorkers = 4;
+
+unsigned int numWorkers() {
+    // Leaves the other cores to the threads reading and writing the payloads.
+    return std::max(1u, std::min(kMaxWorkers, std::thread::hardware_concurrency() / 2));
+}
+
+}  // namespace
+
+void saveCompressedPayload(android::base::Stream* stream, const CompressedPayload& payload) {
+    stream->putBe64(payload.size);
+    stream->putBe64(payload.bytes.size());
+    stream->write(payload.bytes.data(), payload.bytes.size());
+}
+
+std::optional<CompressedPayload> loadCompressedPayload(android::base::Stream* stream,
+                                                       uint64_t maxSize) {
+    CompressedPayload payload;
+    payload.size = stream->getBe64();
+    const uint64_t compressedSize = stream->getBe64();
+    if (payload.size > maxSize ||
+        compressedSize > maxCompressedPayloadSize(static_cast<size_t>(payload.size))) {
+        // Stops early if the stream ends first.
+        uint8_t skipped[4096];
+        for (uint64_t left = compressedSize; left > 0;) {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(left, sizeof(skipped)));
+            if (stream->read(skipped, chunk) != static_cast<ssize_t>(chunk)) {
+                break;
+            }
+            left -= chunk;
+        }
+        return std::nullopt;
+    }
+    payload.bytes.resize(compressedSize);
+    stream->read(payload.bytes.data(), payload.bytes.size());
+    return payload;
+}
+
+SnapshotCompressor::SnapshotCompressor() {
+    const unsigned int count = numWorkers();
+    for (unsigned int i = 0; i < count; i++) {
+        mWorkers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+SnapshotCompressor::~SnapshotCompressor() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone = true;
+    }
+    mCv.notify_all();
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+std::future<CompressedPayload> SnapshotCompressor::compress(std::vector<uint8_t> payload) {
+    auto task = std::make_shared<std::packaged_task<CompressedPayload()>>(
+        [payload = std::move(payload)] {
+            CompressedPayload compressed;
+            compressed.size = payload.size();
+            compressed.hash = hashPayload(payload.data(), payload.size());
+            compressPayload(payload.data(), payload.size(), &compressed.bytes);
+            compressed.bytesHash = hashPayload(compressed.bytes.data(), compressed.bytes.size());
+            return compressed;
+        });
+    std::future<CompressedPayload> result = task->get_future();
+    enqueue([task] { (*task)(); });
+    return result;
+}
+
+std::future<std::optional<std::vector<uint8_t>>> SnapshotCompressor::decompress(
+    CompressedPayload payload) {
+    auto task = std::make_shared<std::packaged_task<std::optional<std::vector<uint8_t>>()>>(
+        [payload = std::move(payload)]() -> std::optional<std::vector<uint8_t>> {
+            std::vector<uint8_t> decompressed(payload.size);
+            if (!decompressPayload(payload.bytes.data(), payload.bytes.size(),
+                                   decompressed.data(), decompressed.size())) {
+                return std::nullopt;
+            }
+            return decompressed;
+        });
+    std::future<std::optional<std::vector<uint8_t>>> result = task->get_future();
+    enqueue([task] { (*task)(); });
+    return result;
+}
+
+void SnapshotCompressor::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mCv.notify_one();
+}
+
+void SnapshotCompressor::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCv.wait(lock, [this] { return mDone || !mJobs.empty(); });
+            // Queued jobs still run when done, as their futures are waited for.
+            if (mJobs.empty()) {
+                return;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+        job();
+    }
+}
+
+}  // namespace gfxstream
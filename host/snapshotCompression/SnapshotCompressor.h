@@ -0,0 +1,75 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "aemu/base/files/Stream.h"
+
+namespace gfxstream {
+
+struct CompressedPayload {
+    // The size of the payload before compression.
+    uint64_t size = 0;
+    std::vector<uint8_t> bytes;
+    // The hashPayload() of the payload before compression, to find identical ones. Not saved.
+    uint64_t hash = 0;
+    // The hashPayload() of |bytes|, which also has to match for two payloads to be taken as
+    // identical, so that a collision of |hash| alone doesn't. Not saved.
+    uint64_t bytesHash = 0;
+};
+
+void saveCompressedPayload(android::base::Stream* stream, const CompressedPayload& payload);
+// Returns nothing if the payload is larger than |maxSize| bytes before or after compression, which
+// means the stream is corrupt. The bytes the payload claims to have are skipped then, so that the
+// rest of the stream can still be read if only its size was wrong.
+std::optional<CompressedPayload> loadCompressedPayload(android::base::Stream* stream,
+                                                       uint64_t maxSize);
+
+// Compresses and decompresses snapshot payloads on a pool of worker threads, so that it overlaps
+// with reading the payloads back from the GPU on save, and with reading the rest of the snapshot
+// on load.
+class SnapshotCompressor {
+   public:
+    SnapshotCompressor();
+    // Waits for the payloads still queued.
+    ~SnapshotCompressor();
+
+    std::future<CompressedPayload> compress(std::vector<uint8_t> payload);
+    // The future holds nothing if the payload is corrupt.
+    std::future<std::optional<std::vector<uint8_t>>> decompress(CompressedPayload payload);
+
+   private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    std::deque<std::function<void()>> mJobs;
+    bool mDone = false;
+    std::vector<std::thread> mWorkers;
+};
+
+}  // namespace gfxstream
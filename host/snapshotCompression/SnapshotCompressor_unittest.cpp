@@ -0,0 +1,124 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "PayloadCodec.h"
+#include "SnapshotCompressor.h"
+#include "aemu/base/files/MemStream.h"
+
+namespace gfxstream {
+namespace {
+
+std::vector<uint8_t> makePayload(size_t size, uint8_t seed) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = static_cast<uint8_t>((i / 64) * seed);
+    }
+    return payload;
+}
+
+TEST(SnapshotCompressorTest, RoundTripsThroughStream) {
+    std::vector<std::vector<uint8_t>> payloads;
+    for (uint8_t i = 0; i < 16; i++) {
+        payloads.push_back(makePayload(1000 * i + 7, i));
+    }
+
+    android::base::MemStream stream;
+    {
+        SnapshotCompressor compressor;
+        std::vector<std::future<CompressedPayload>> compressed;
+        for (const std::vector<uint8_t>& payload : payloads) {
+            compressed.push_back(compressor.compress(payload));
+        }
+        for (std::future<CompressedPayload>& payload : compressed) {
+            saveCompressedPayload(&stream, payload.get());
+        }
+    }
+
+    SnapshotCompressor compressor;
+    std::vector<std::future<std::optional<std::vector<uint8_t>>>> decompressed;
+    for (size_t i = 0; i < payloads.size(); i++) {
+        std::optional<CompressedPayload> payload =
+            loadCompressedPayload(&stream, payloads[i].size());
+        ASSERT_TRUE(payload);
+        decompressed.push_back(compressor.decompress(std::move(*payload)));
+    }
+    for (size_t i = 0; i < payloads.size(); i++) {
+        std::optional<std::vector<uint8_t>> payload = decompressed[i].get();
+        ASSERT_TRUE(payload);
+        EXPECT_EQ(payloads[i], *payload);
+    }
+}
+
+TEST(SnapshotCompressorTest, HashesPayloads) {
+    SnapshotCompressor compressor;
+    std::future<CompressedPayload> a = compressor.compress(makePayload(4096, 3));
+    std::future<CompressedPayload> b = compressor.compress(makePayload(4096, 3));
+    std::future<CompressedPayload> c = compressor.compress(makePayload(4096, 5));
+    const CompressedPayload payloadA = a.get();
+    const CompressedPayload payloadB = b.get();
+    const CompressedPayload payloadC = c.get();
+    EXPECT_EQ(payloadA.hash, payloadB.hash);
+    EXPECT_NE(payloadA.hash, payloadC.hash);
+    EXPECT_EQ(payloadA.bytesHash, payloadB.bytesHash);
+    EXPECT_NE(payloadA.bytesHash, payloadC.bytesHash);
+    EXPECT_EQ(payloadA.bytesHash, hashPayload(payloadA.bytes.data(), payloadA.bytes.size()));
+}
+
+TEST(SnapshotCompressorTest, FailsToDecompressCorruptPayload) {
+    SnapshotCompressor compressor;
+    CompressedPayload payload = compressor.compress(makePayload(4096, 3)).get();
+    payload.size++;
+    EXPECT_FALSE(compressor.decompress(std::move(payload)).get());
+}
+
+TEST(SnapshotCompressorTest, RejectsOversizedPayloads) {
+    SnapshotCompressor compressor;
+    const CompressedPayload payload = compressor.compress(makePayload(4096, 3)).get();
+    {
+        android::base::MemStream stream;
+        saveCompressedPayload(&stream, payload);
+        saveCompressedPayload(&stream, payload);
+        EXPECT_FALSE(loadCompressedPayload(&stream, 4095));
+        // The rejected payload was skipped.
+        std::optional<CompressedPayload> next = loadCompressedPayload(&stream, 4096);
+        ASSERT_TRUE(next);
+        EXPECT_EQ(payload.bytes, next->bytes);
+    }
+
+    // A compressed size that no payload of the size could have.
+    android::base::MemStream stream;
+    stream.putBe64(4096);
+    stream.putBe64(uint64_t(1) << 62);
+    EXPECT_FALSE(loadCompressedPayload(&stream, 4096));
+}
+
+TEST(SnapshotCompressorTest, RunsQueuedJobsOnDestruction) {
+    std::vector<std::future<CompressedPayload>> compressed;
+    {
+        SnapshotCompressor compressor;
+        for (int i = 0; i < 32; i++) {
+            compressed.push_back(compressor.compress(makePayload(64 * 1024, i)));
+        }
+    }
+    for (std::future<CompressedPayload>& payload : compressed) {
+        EXPECT_EQ(64 * 1024, payload.get().size);
+    }
+}
+
+}  // namespace
+}  // namespace gfxstream
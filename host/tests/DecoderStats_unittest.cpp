@@ -0,0 +1,149 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "DecoderStats.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+const DecoderStats::OpcodeStats* find(const std::vector<DecoderStats::OpcodeStats>& stats,
+                                      uint32_t opcode) {
+    for (const auto& opcodeStats : stats) {
+        if (opcodeStats.opcode == opcode) {
+            return &opcodeStats;
+        }
+    }
+    return nullptr;
+}
+
+TEST(DecoderStatsTest, Buckets) {
+    EXPECT_EQ(0, DecoderStats::bucketOf(0));
+    EXPECT_EQ(0, DecoderStats::bucketOf(1));
+    EXPECT_EQ(1, DecoderStats::bucketOf(2));
+    EXPECT_EQ(1, DecoderStats::bucketOf(3));
+    EXPECT_EQ(10, DecoderStats::bucketOf(1024));
+    EXPECT_EQ(10, DecoderStats::bucketOf(2047));
+    EXPECT_EQ(DecoderStats::kNumBuckets - 1, DecoderStats::bucketOf(1ull << 31));
+    EXPECT_EQ(DecoderStats::kNumBuckets - 1, DecoderStats::bucketOf(~0ull));
+}
+
+TEST(DecoderStatsTest, DisabledByDefault) {
+    DecoderStats::reset();
+    ASSERT_FALSE(DecoderStats::isEnabled());
+    DecoderStats::finish(2048, DecoderStats::start());
+    EXPECT_TRUE(DecoderStats::collect().empty());
+
+    DecoderStats::setEnabled(true);
+    DecoderStats::finish(2048, DecoderStats::start());
+    DecoderStats::setEnabled(false);
+    const auto stats = DecoderStats::collect();
+    ASSERT_EQ(1, stats.size());
+    EXPECT_EQ(2048, stats[0].opcode);
+    EXPECT_EQ(1, stats[0].count);
+}
+
+TEST(DecoderStatsTest, AddsUpThreads) {
+    DecoderStats::reset();
+
+    // Vulkan opcodes are sparse and large.
+    constexpr uint32_t kVkOpcode = 299567883;
+    constexpr uint32_t kGlOpcode = 2048;
+    DecoderStats::record(kVkOpcode, 1000);
+    DecoderStats::record(kVkOpcode, 3000);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([] {
+            for (int j = 0; j < 1000; ++j) {
+                DecoderStats::record(kGlOpcode, 10);
+            }
+            DecoderStats::record(kVkOpcode, 2000);
+        });
+    }
+    // Threads that exited keep counting.
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto stats = DecoderStats::collect();
+    ASSERT_EQ(2, stats.size());
+    EXPECT_EQ(kGlOpcode, stats[0].opcode);
+    EXPECT_EQ(4000, stats[0].count);
+    EXPECT_EQ(40000, stats[0].totalNs);
+    EXPECT_EQ(4000, stats[0].buckets[3]);
+
+    EXPECT_EQ(kVkOpcode, stats[1].opcode);
+    EXPECT_EQ(6, stats[1].count);
+    EXPECT_EQ(12000, stats[1].totalNs);
+    EXPECT_EQ(1, stats[1].buckets[9]);
+    EXPECT_EQ(4, stats[1].buckets[10]);
+    EXPECT_EQ(1, stats[1].buckets[11]);
+
+    DecoderStats::reset();
+    EXPECT_TRUE(DecoderStats::collect().empty());
+    DecoderStats::record(kGlOpcode, 5);
+    const auto afterReset = DecoderStats::collect();
+    ASSERT_EQ(1, afterReset.size());
+    EXPECT_EQ(1, afterReset[0].count);
+}
+
+TEST(DecoderStatsTest, TooManyOpcodes) {
+    DecoderStats::reset();
+    std::thread([] {
+        for (uint32_t opcode = 200000000; opcode < 200002000; ++opcode) {
+            DecoderStats::record(opcode, 1);
+        }
+    }).join();
+
+    const auto stats = DecoderStats::collect();
+    const DecoderStats::OpcodeStats* other = find(stats, DecoderStats::kOtherOpcodes);
+    ASSERT_NE(nullptr, other);
+    EXPECT_EQ(2000, other->count + stats.size() - 1);
+    EXPECT_NE(nullptr, find(stats, 200000000));
+}
+
+// Recording while another thread collects.
+TEST(DecoderStatsTest, CollectWhileRecording) {
+    DecoderStats::reset();
+    constexpr uint64_t kNumRecords = 200000;
+    std::thread recorder([] {
+        for (uint64_t i = 0; i < kNumRecords; ++i) {
+            DecoderStats::record(1024 + i % 8, 100);
+        }
+    });
+
+    uint64_t lastCount = 0;
+    for (int i = 0; i < 100; ++i) {
+        uint64_t count = 0;
+        for (const auto& opcodeStats : DecoderStats::collect()) {
+            count += opcodeStats.count;
+        }
+        EXPECT_GE(count, lastCount);
+        lastCount = count;
+    }
+    recorder.join();
+
+    uint64_t count = 0;
+    for (const auto& opcodeStats : DecoderStats::collect()) {
+        count += opcodeStats.count;
+    }
+    EXPECT_EQ(kNumRecords, count);
+}
+
+}  // namespace
+}  // namespace gfxstream
@@ -0,0 +1,101 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "DirtyRegion.h"
+
+#include <gtest/gtest.h>
+
+namespace gfxstream {
+namespace {
+
+bool contains(const DirtyRegion& region, uint32_t x, uint32_t y) {
+    for (const DirtyRegion::Rect& rect : region.rects()) {
+        if (x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(DirtyRegionTest, StartsAsAll) {
+    DirtyRegion region(64, 32);
+    EXPECT_TRUE(region.isAll());
+    EXPECT_EQ(64 * 32, region.area());
+
+    region.clear();
+    EXPECT_TRUE(region.empty());
+    EXPECT_FALSE(region.isAll());
+    EXPECT_EQ(0, region.area());
+}
+
+TEST(DirtyRegionTest, ClipsToTheImage) {
+    DirtyRegion region(64, 32);
+    region.clear();
+
+    region.add(-8, -8, 16, 16);
+    ASSERT_EQ(1, region.rects().size());
+    EXPECT_EQ(0, region.rects()[0].x);
+    EXPECT_EQ(0, region.rects()[0].y);
+    EXPECT_EQ(8, region.rects()[0].width);
+    EXPECT_EQ(8, region.rects()[0].height);
+
+    region.add(64, 0, 8, 8);
+    region.add(0, 16, 8, 0);
+    EXPECT_EQ(1, region.rects().size());
+
+    region.add(0, 0, 1000, 1000);
+    EXPECT_TRUE(region.isAll());
+}
+
+TEST(DirtyRegionTest, MergesOverlappingAndTouching) {
+    DirtyRegion region(64, 64);
+    region.clear();
+
+    region.add(0, 0, 8, 8);
+    region.add(32, 32, 8, 8);
+    EXPECT_EQ(2, region.rects().size());
+
+    // Touches the first, whose bounds then overlap nothing else.
+    region.add(8, 0, 8, 8);
+    EXPECT_EQ(2, region.rects().size());
+    EXPECT_EQ(16 * 8 + 8 * 8, region.area());
+
+    // Overlaps both.
+    region.add(4, 4, 30, 30);
+    ASSERT_EQ(1, region.rects().size());
+    EXPECT_EQ(40 * 40, region.area());
+}
+
+TEST(DirtyRegionTest, MergesClosestPastMaxRects) {
+    DirtyRegion region(1024, 1024);
+    region.clear();
+
+    for (uint32_t i = 0; i < DirtyRegion::kMaxRects; i++) {
+        region.add(i * 256, 0, 16, 16);
+    }
+    EXPECT_EQ(DirtyRegion::kMaxRects, region.rects().size());
+
+    // Closest to the first one.
+    region.add(0, 32, 16, 16);
+    ASSERT_EQ(DirtyRegion::kMaxRects, region.rects().size());
+    EXPECT_EQ(16 * 48 + (DirtyRegion::kMaxRects - 1) * 16 * 16, region.area());
+
+    for (uint32_t i = 0; i < DirtyRegion::kMaxRects; i++) {
+        EXPECT_TRUE(contains(region, i * 256, 0));
+    }
+    EXPECT_TRUE(contains(region, 0, 40));
+    EXPECT_FALSE(contains(region, 100, 100));
+}
+
+}  // namespace
+}  // namespace gfxstream
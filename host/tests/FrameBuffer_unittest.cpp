@@ -220,6 +220,75 @@ TEST_F(FrameBufferTest, CreateOpenUpdateCloseColorBuffer) {
     mFb->closeColorBuffer(handle);
 }
 
+// Tests that updates keep their contents when the pixels are reused right
+// away, and with more updates in flight than there are buffers to stream them.
+TEST_F(FrameBufferTest, CreateOpenUpdateCloseColorBuffer_ReusePixels) {
+    HandleType handle =
+        mFb->createColorBuffer(mWidth, mHeight, GL_RGBA, FRAMEWORK_FORMAT_GL_COMPATIBLE);
+    EXPECT_NE(0, handle);
+    EXPECT_EQ(0, mFb->openColorBuffer(handle));
+
+    constexpr int kNumUpdates = 8;
+    for (int i = 1; i <= kNumUpdates; i++) {
+        TestTexture forUpdate = createTestTextureRGBA8888SingleColor(
+            mWidth, mHeight, float(i) / kNumUpdates, 0.0f, 0.0f, 1.0f);
+        mFb->updateColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                               forUpdate.data());
+        memset(forUpdate.data(), 0, forUpdate.size());
+    }
+
+    TestTexture expected =
+        createTestTextureRGBA8888SingleColor(mWidth, mHeight, 1.0f, 0.0f, 0.0f, 1.0f);
+    TestTexture forRead = createTestTextureRGBA8888SingleColor(mWidth, mHeight, 0.0f, 0.0f, 0.0f, 0.0f);
+    mFb->readColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, forRead.data());
+
+    EXPECT_TRUE(ImageMatches(mWidth, mHeight, 4, mWidth, expected.data(), forRead.data()));
+
+    mFb->closeColorBuffer(handle);
+}
+
+// Posting a buffer read before reads it ahead, and later reads complete from that.
+TEST_F(FrameBufferTest, CreateOpenUpdateCloseColorBuffer_ReadAfterPost) {
+    HandleType handle =
+        mFb->createColorBuffer(mWidth, mHeight, GL_RGBA, FRAMEWORK_FORMAT_GL_COMPATIBLE);
+    EXPECT_NE(0, handle);
+    EXPECT_EQ(0, mFb->openColorBuffer(handle));
+
+    TestTexture forRead = createTestTextureRGBA8888SingleColor(mWidth, mHeight, 0.0f, 0.0f, 0.0f, 0.0f);
+    mFb->readColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, forRead.data());
+
+    TestTexture forUpdate = createTestPatternRGBA8888(mWidth, mHeight);
+    mFb->updateColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                           forUpdate.data());
+    mFb->post(handle);
+
+    mFb->readColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, forRead.data());
+    EXPECT_TRUE(ImageMatches(mWidth, mHeight, 4, mWidth, forUpdate.data(), forRead.data()));
+
+    // Rows of a part.
+    const int x = mWidth / 4;
+    const int y = mHeight / 4;
+    const int width = mWidth / 2;
+    const int height = mHeight / 2;
+    std::vector<uint8_t> partExpected;
+    for (int row = y; row < y + height; row++) {
+        const uint8_t* rowStart = forUpdate.data() + (row * mWidth + x) * 4;
+        partExpected.insert(partExpected.end(), rowStart, rowStart + width * 4);
+    }
+    std::vector<uint8_t> partRead(width * height * 4);
+    mFb->readColorBuffer(handle, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, partRead.data());
+    EXPECT_TRUE(ImageMatches(width, height, 4, width, partExpected.data(), partRead.data()));
+
+    // Updates after the post aren't missed.
+    forUpdate = createTestTextureRGBA8888SingleColor(mWidth, mHeight, 0.0f, 1.0f, 0.0f, 1.0f);
+    mFb->updateColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                           forUpdate.data());
+    mFb->readColorBuffer(handle, 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, forRead.data());
+    EXPECT_TRUE(ImageMatches(mWidth, mHeight, 4, mWidth, forUpdate.data(), forRead.data()));
+
+    mFb->closeColorBuffer(handle);
+}
+
 TEST_F(FrameBufferTest, CreateOpenUpdateCloseColorBuffer_ReadYUV420) {
     HandleType handle = mFb->createColorBuffer(mWidth, mHeight, GL_RGBA,
                                                FRAMEWORK_FORMAT_YUV_420_888);
@@ -480,6 +480,61 @@ TEST_F(SnapshotGlTextureObjectTest, CreateCubeMap) {
     doCheckedSnapshot();
 }
 
+// Textures with the same contents are saved once and restored from each other,
+// so this also creates a second texture with the same images.
+class SnapshotGlDuplicateTextureObjectTest : public SnapshotGlTextureObjectTest {
+public:
+    void changedStateCheck() override {
+        SnapshotGlTextureObjectTest::changedStateCheck();
+
+        SCOPED_TRACE("Duplicate texture object " +
+                     std::to_string(m_duplicate_name));
+        EXPECT_EQ(GL_TRUE, gl->glIsTexture(m_duplicate_name));
+        for (int i = 0; i < m_state.images2D.size(); i++) {
+            const GlTextureImageState& level = m_state.images2D[i];
+            EXPECT_TRUE(compareVector<GLubyte>(
+                    level.bytes,
+                    getTextureImageData(gl, m_duplicate_name, GL_TEXTURE_2D, i,
+                                        level.width, level.height,
+                                        level.format, level.type),
+                    "mipmap level " + std::to_string(i)));
+            EXPECT_EQ(GL_NO_ERROR, gl->glGetError());
+        }
+    }
+
+    void stateChange() override {
+        gl->glGenTextures(1, &m_duplicate_name);
+        gl->glBindTexture(GL_TEXTURE_2D, m_duplicate_name);
+        for (int i = 0; i < m_state.images2D.size(); i++) {
+            GlTextureImageState& level = m_state.images2D[i];
+            level.bytes.resize(level.width * level.height *
+                               glUtilsPixelBitSize(level.format,
+                                                   GL_UNSIGNED_BYTE) / 8);
+            for (size_t j = 0; j < level.bytes.size(); j++) {
+                level.bytes[j] = static_cast<GLubyte>(j * 7 + i);
+            }
+            gl->glTexImage2D(GL_TEXTURE_2D, i, level.format, level.width,
+                             level.height, 0, level.format, GL_UNSIGNED_BYTE,
+                             level.bytes.data());
+        }
+
+        SnapshotGlTextureObjectTest::stateChange();
+    }
+
+protected:
+    GLuint m_duplicate_name;
+};
+
+TEST_F(SnapshotGlDuplicateTextureObjectTest, Create2DMipmaps) {
+    m_state = {.minFilter = GL_LINEAR,
+               .magFilter = GL_NEAREST,
+               .wrapS = GL_MIRRORED_REPEAT,
+               .wrapT = GL_CLAMP_TO_EDGE,
+               .target = GL_TEXTURE_2D,
+               .images2D = kGLES2TestTexture2D};
+    doCheckedSnapshot();
+}
+
 }  // namespace
 }  // namespace gl
 }  // namespace gfxstream
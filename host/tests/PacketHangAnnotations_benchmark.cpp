@@ -0,0 +1,171 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-packet cost of the hang annotations and watchdogs set up by the
+// decoders, with the annotation map built for every packet as the decoders
+// used to do ("Eager") and with PacketHangAnnotations ("Lazy").
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "PacketHangAnnotations.h"
+#include "aemu/base/HealthMonitor.h"
+
+namespace gfxstream {
+namespace {
+
+using android::base::EventHangMetadata;
+
+// Accepts watchdogs like the real HealthMonitor but drops them right away, so
+// that only the cost on the decoding thread is measured.
+class NullHealthMonitor {
+   public:
+    using Id = uint64_t;
+
+    template <class Metadata, class Callback, class... Rest>
+    Id startMonitoringTask(Metadata metadata, Callback onHangCallback, Rest&&...) {
+        benchmark::DoNotOptimize(metadata.get());
+        benchmark::DoNotOptimize(&onHangCallback);
+        return mNextId++;
+    }
+    void touchMonitoredTask(Id) {}
+    void stopMonitoringTask(Id id) { benchmark::DoNotOptimize(id); }
+
+   private:
+    Id mNextId = 0;
+};
+
+constexpr uint32_t kOpcode = 20004;
+constexpr uint32_t kPacketLen = 256;
+constexpr const char* kProcessName = "com.example.app";
+
+template <class HealthMonitorT>
+void decodePacketEager(HealthMonitorT* healthMonitor, uint32_t opcode, uint32_t packetLen,
+                       uint32_t seqno, std::optional<uint32_t>& prevSeqno) {
+    std::unique_ptr<EventHangMetadata::HangAnnotations> executionData =
+        std::make_unique<EventHangMetadata::HangAnnotations>();
+    if (healthMonitor) {
+        executionData->insert(
+            {{"packet_length", std::to_string(packetLen)}, {"opcode", std::to_string(opcode)}});
+        executionData->insert({{"renderthread_guest_process", std::string(kProcessName)}});
+        if (prevSeqno) {
+            executionData->insert({{"previous_seqno", std::to_string(prevSeqno.value())}});
+        }
+        executionData->insert({{"seqno", std::to_string(seqno)}});
+    }
+    {
+        auto seqnoWatchdog =
+            WATCHDOG_BUILDER(healthMonitor, "RenderThread seqno loop")
+                .setHangType(EventHangMetadata::HangType::kRenderThread)
+                .setAnnotations(
+                    std::make_unique<EventHangMetadata::HangAnnotations>(*executionData))
+                .setOnHangCallback([]() {
+                    return std::make_unique<EventHangMetadata::HangAnnotations>();
+                })
+                .build();
+        prevSeqno = seqno;
+    }
+    auto executionWatchdog =
+        WATCHDOG_BUILDER(healthMonitor, "RenderThread VkDecoder command execution")
+            .setHangType(EventHangMetadata::HangType::kRenderThread)
+            .setAnnotations(std::move(executionData))
+            .build();
+    benchmark::ClobberMemory();
+}
+
+template <class HealthMonitorT>
+void decodePacketLazy(HealthMonitorT* healthMonitor, PacketHangAnnotations& hangAnnotations,
+                      uint32_t opcode, uint32_t packetLen, uint32_t seqno) {
+    if (healthMonitor) {
+        hangAnnotations.setPacket(opcode, packetLen);
+        hangAnnotations.setSeqno(seqno);
+    }
+    {
+        auto seqnoWatchdog =
+            healthMonitor
+                ? WATCHDOG_BUILDER(healthMonitor, "RenderThread seqno loop")
+                      .setHangType(EventHangMetadata::HangType::kRenderThread)
+                      .setOnHangCallback([&hangAnnotations]() { return hangAnnotations.build(); })
+                      .build()
+                : nullptr;
+    }
+    auto executionWatchdog =
+        healthMonitor ? WATCHDOG_BUILDER(healthMonitor, "RenderThread VkDecoder command execution")
+                            .setHangType(EventHangMetadata::HangType::kRenderThread)
+                            .setOnHangCallback(hangAnnotations.getOnHangCallback())
+                            .build()
+                      : nullptr;
+    benchmark::ClobberMemory();
+}
+
+void BM_PacketEager_NoMonitor(benchmark::State& state) {
+    NullHealthMonitor* healthMonitor = nullptr;
+    std::optional<uint32_t> prevSeqno;
+    uint32_t seqno = 0;
+    for (auto _ : state) {
+        decodePacketEager(healthMonitor, kOpcode, kPacketLen, ++seqno, prevSeqno);
+    }
+}
+BENCHMARK(BM_PacketEager_NoMonitor);
+
+void BM_PacketLazy_NoMonitor(benchmark::State& state) {
+    NullHealthMonitor* healthMonitor = nullptr;
+    PacketHangAnnotations hangAnnotations("opcode", "packet_length");
+    uint32_t seqno = 0;
+    for (auto _ : state) {
+        decodePacketLazy(healthMonitor, hangAnnotations, kOpcode, kPacketLen, ++seqno);
+    }
+}
+BENCHMARK(BM_PacketLazy_NoMonitor);
+
+void BM_PacketEager_WithMonitor(benchmark::State& state) {
+    NullHealthMonitor healthMonitor;
+    std::optional<uint32_t> prevSeqno;
+    uint32_t seqno = 0;
+    for (auto _ : state) {
+        decodePacketEager(&healthMonitor, kOpcode, kPacketLen, ++seqno, prevSeqno);
+    }
+}
+BENCHMARK(BM_PacketEager_WithMonitor);
+
+void BM_PacketLazy_WithMonitor(benchmark::State& state) {
+    NullHealthMonitor healthMonitor;
+    PacketHangAnnotations hangAnnotations("opcode", "packet_length");
+    hangAnnotations.setProcessName(kProcessName);
+    uint32_t seqno = 0;
+    for (auto _ : state) {
+        decodePacketLazy(&healthMonitor, hangAnnotations, kOpcode, kPacketLen, ++seqno);
+    }
+}
+BENCHMARK(BM_PacketLazy_WithMonitor);
+
+// What the health monitor thread pays once a hang has been detected.
+void BM_PacketLazy_BuildOnHang(benchmark::State& state) {
+    PacketHangAnnotations hangAnnotations("opcode", "packet_length");
+    hangAnnotations.setProcessName(kProcessName);
+    hangAnnotations.setPacket(kOpcode, kPacketLen);
+    hangAnnotations.setSeqno(1);
+    hangAnnotations.setPacket(kOpcode, kPacketLen);
+    hangAnnotations.setSeqno(2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hangAnnotations.build());
+    }
+}
+BENCHMARK(BM_PacketLazy_BuildOnHang);
+
+}  // namespace
+}  // namespace gfxstream
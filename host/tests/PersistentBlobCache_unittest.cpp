@@ -0,0 +1,302 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "PersistentBlobCache.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+using std::chrono::milliseconds;
+
+std::vector<uint8_t> makeValue(size_t size, uint8_t seed) {
+    std::vector<uint8_t> value(size);
+    for (size_t i = 0; i < size; i++) {
+        value[i] = seed + i * 13;
+    }
+    return value;
+}
+
+class PersistentBlobCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::random_device random;
+        mDir = std::filesystem::temp_directory_path() /
+               ("PersistentBlobCacheTest-" + std::to_string(random()));
+        std::filesystem::create_directories(mDir);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(mDir); }
+
+    PersistentBlobCache::Options options(const std::string& identity = "driver 1.0") {
+        PersistentBlobCache::Options options;
+        options.directory = mDir.string();
+        options.name = "blobs";
+        options.identity = identity;
+        options.writebackDelay = milliseconds(10);
+        return options;
+    }
+
+    static void set(PersistentBlobCache& cache, const std::string& key,
+                    const std::vector<uint8_t>& value) {
+        cache.set(key.data(), key.size(), value.data(), value.size());
+    }
+
+    // The value of |key|, or an empty one if there is none.
+    static std::vector<uint8_t> get(PersistentBlobCache& cache, const std::string& key) {
+        std::vector<uint8_t> value(cache.get(key.data(), key.size(), nullptr, 0));
+        if (!value.empty()) {
+            EXPECT_EQ(value.size(), cache.get(key.data(), key.size(), value.data(), value.size()));
+        }
+        return value;
+    }
+
+    static void corrupt(const std::string& path, size_t offsetFromEnd) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-static_cast<std::streamoff>(offsetFromEnd), std::ios::end);
+        char byte = file.peek();
+        file.seekp(-static_cast<std::streamoff>(offsetFromEnd), std::ios::end);
+        file.put(byte ^ 0x5a);
+    }
+
+    std::filesystem::path mDir;
+};
+
+TEST_F(PersistentBlobCacheTest, MemoryOnly) {
+    PersistentBlobCache cache(PersistentBlobCache::Options{});
+    EXPECT_TRUE(cache.path().empty());
+    const std::vector<uint8_t> value = makeValue(100, 1);
+    set(cache, "key", value);
+    EXPECT_EQ(value, get(cache, "key"));
+    EXPECT_TRUE(get(cache, "other").empty());
+
+    // Values that don't fit aren't copied, but their size is returned.
+    std::vector<uint8_t> small(10, 0);
+    EXPECT_EQ(100, cache.get("key", 3, small.data(), small.size()));
+    EXPECT_EQ(std::vector<uint8_t>(10, 0), small);
+
+    const std::vector<uint8_t> newValue = makeValue(50, 2);
+    set(cache, "key", newValue);
+    EXPECT_EQ(newValue, get(cache, "key"));
+    EXPECT_EQ(1, cache.numEntries());
+    EXPECT_EQ(53, cache.sizeBytes());
+    EXPECT_FALSE(cache.flush());
+}
+
+TEST_F(PersistentBlobCacheTest, Persists) {
+    std::string path;
+    {
+        PersistentBlobCache cache(options());
+        path = cache.path();
+        for (int i = 0; i < 100; i++) {
+            set(cache, "key" + std::to_string(i), makeValue(i * 10, i));
+        }
+    }
+    EXPECT_TRUE(std::filesystem::exists(path));
+
+    PersistentBlobCache cache(options());
+    EXPECT_EQ(path, cache.path());
+    EXPECT_EQ(100, cache.numEntries());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(makeValue(i * 10, i), get(cache, "key" + std::to_string(i)));
+    }
+
+    // Changes made after loading are persisted too, and values read from the file survive it
+    // being replaced.
+    set(cache, "key1", makeValue(20, 7));
+    set(cache, "new", makeValue(30, 8));
+    EXPECT_TRUE(cache.flush());
+    EXPECT_EQ(makeValue(20, 2), get(cache, "key2"));
+
+    PersistentBlobCache reloaded(options());
+    EXPECT_EQ(101, reloaded.numEntries());
+    EXPECT_EQ(makeValue(20, 7), get(reloaded, "key1"));
+    EXPECT_EQ(makeValue(30, 8), get(reloaded, "new"));
+    EXPECT_EQ(makeValue(20, 2), get(reloaded, "key2"));
+}
+
+TEST_F(PersistentBlobCacheTest, WritesInBackground) {
+    PersistentBlobCache cache(options());
+    set(cache, "key", makeValue(100, 1));
+
+    // The file is written without flushing or destroying the cache.
+    for (int i = 0; i < 500 && !std::filesystem::exists(cache.path()); i++) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    PersistentBlobCache other(options());
+    EXPECT_EQ(makeValue(100, 1), get(other, "key"));
+}
+
+TEST_F(PersistentBlobCacheTest, RetriesFailedWrites) {
+    PersistentBlobCache::Options opts = options();
+    // Only write when asked to.
+    opts.writebackDelay = std::chrono::hours(1);
+    PersistentBlobCache cache(opts);
+    set(cache, "key", makeValue(100, 1));
+
+    std::filesystem::remove_all(mDir);
+    EXPECT_FALSE(cache.flush());
+
+    // The changes that failed to be written still are, without changing anything else.
+    std::filesystem::create_directories(mDir);
+    EXPECT_TRUE(cache.flush());
+    PersistentBlobCache other(options());
+    EXPECT_EQ(makeValue(100, 1), get(other, "key"));
+}
+
+TEST_F(PersistentBlobCacheTest, EvictsLeastRecentlyUsed) {
+    PersistentBlobCache::Options opts = options();
+    opts.maxBytes = 3 * 104;
+    {
+        PersistentBlobCache cache(opts);
+        set(cache, "key1", makeValue(100, 1));
+        set(cache, "key2", makeValue(100, 2));
+        set(cache, "key3", makeValue(100, 3));
+        get(cache, "key1");
+        set(cache, "key4", makeValue(100, 4));
+        EXPECT_EQ(3, cache.numEntries());
+        EXPECT_TRUE(get(cache, "key2").empty());
+
+        // Too large to be cached at all.
+        set(cache, "big", makeValue(1000, 5));
+        EXPECT_TRUE(get(cache, "big").empty());
+    }
+
+    PersistentBlobCache cache(opts);
+    EXPECT_EQ(3, cache.numEntries());
+    EXPECT_EQ(makeValue(100, 1), get(cache, "key1"));
+    EXPECT_TRUE(get(cache, "key2").empty());
+
+    // Loading a larger file than allowed keeps the most recently used entries.
+    opts.maxBytes = 104;
+    PersistentBlobCache smaller(opts);
+    EXPECT_EQ(1, smaller.numEntries());
+    EXPECT_EQ(makeValue(100, 4), get(smaller, "key4"));
+}
+
+TEST_F(PersistentBlobCacheTest, IdentitiesHaveTheirOwnFiles) {
+    std::string path;
+    {
+        PersistentBlobCache cache(options("driver 1.0"));
+        path = cache.path();
+        set(cache, "key", makeValue(100, 1));
+    }
+    {
+        PersistentBlobCache cache(options("driver 2.0"));
+        EXPECT_NE(path, cache.path());
+        EXPECT_EQ(0, cache.numEntries());
+        set(cache, "key", makeValue(100, 2));
+    }
+
+    PersistentBlobCache cache(options("driver 1.0"));
+    EXPECT_EQ(makeValue(100, 1), get(cache, "key"));
+}
+
+TEST_F(PersistentBlobCacheTest, DropsCorruptedValues) {
+    std::string path;
+    {
+        PersistentBlobCache cache(options());
+        path = cache.path();
+        set(cache, "key1", makeValue(100, 1));
+        set(cache, "key2", makeValue(100, 2));
+    }
+    // Entries are written most recently used first: key1's value ends the file.
+    corrupt(path, 10);
+
+    PersistentBlobCache cache(options());
+    EXPECT_EQ(2, cache.numEntries());
+    EXPECT_TRUE(get(cache, "key1").empty());
+    EXPECT_EQ(makeValue(100, 2), get(cache, "key2"));
+    EXPECT_EQ(1, cache.numEntries());
+}
+
+TEST_F(PersistentBlobCacheTest, IgnoresCorruptedFiles) {
+    std::string path;
+    {
+        PersistentBlobCache cache(options());
+        path = cache.path();
+        set(cache, "key1", makeValue(100, 1));
+    }
+    // Corrupts key1.
+    corrupt(path, 102);
+    EXPECT_EQ(0, PersistentBlobCache(options()).numEntries());
+
+    {
+        PersistentBlobCache cache(options());
+        set(cache, "key1", makeValue(100, 1));
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT_EQ(0, PersistentBlobCache(options()).numEntries());
+
+    // Other format versions are ignored too.
+    {
+        PersistentBlobCache cache(options());
+        set(cache, "key1", makeValue(100, 1));
+    }
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(8);
+        const uint32_t version = PersistentBlobCache::kFormatVersion + 1;
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    PersistentBlobCache cache(options());
+    EXPECT_EQ(0, cache.numEntries());
+
+    // And replaced.
+    set(cache, "key2", makeValue(100, 2));
+    EXPECT_TRUE(cache.flush());
+    EXPECT_EQ(1, PersistentBlobCache(options()).numEntries());
+}
+
+TEST_F(PersistentBlobCacheTest, Concurrent) {
+    PersistentBlobCache::Options opts = options();
+    opts.maxBytes = 50 * 1024;
+    opts.writebackDelay = milliseconds(1);
+    PersistentBlobCache cache(opts);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2000; i++) {
+                const int k = (i * (t + 1)) % 300;
+                const std::string key = "key" + std::to_string(k);
+                const std::vector<uint8_t> value = makeValue(200 + k, k);
+                if (i % 3 == 0) {
+                    set(cache, key, value);
+                } else {
+                    const std::vector<uint8_t> got = get(cache, key);
+                    if (!got.empty()) {
+                        ASSERT_EQ(value, got);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_LE(cache.sizeBytes(), 50 * 1024);
+    EXPECT_TRUE(cache.flush());
+    EXPECT_EQ(cache.numEntries(), PersistentBlobCache(opts).numEntries());
+}
+
+}  // namespace
+}  // namespace gfxstream
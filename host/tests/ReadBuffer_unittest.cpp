@@ -0,0 +1,114 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "ReadBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+void appendPacket(std::vector<unsigned char>* view, uint32_t opcode, uint32_t size) {
+    const size_t begin = view->size();
+    view->resize(begin + size, static_cast<unsigned char>(opcode));
+    memcpy(view->data() + begin, &opcode, sizeof(opcode));
+    memcpy(view->data() + begin + sizeof(opcode), &size, sizeof(size));
+}
+
+TEST(ReadBufferTest, StagesPacketsOutOfTheExternalView) {
+    std::vector<unsigned char> view;
+    appendPacket(&view, 1, 16);
+    appendPacket(&view, 2, 32);
+
+    ReadBuffer readBuf(1024);
+    readBuf.beginExternalView(view.data(), view.size());
+    EXPECT_EQ(48u, readBuf.stageExternalView());
+    EXPECT_EQ(0u, readBuf.externalViewLeft());
+    ASSERT_EQ(48u, readBuf.validData());
+    EXPECT_NE(view.data(), readBuf.buf());
+    EXPECT_EQ(0, memcmp(view.data(), readBuf.buf(), view.size()));
+
+    // Changing the view afterwards doesn't change what is decoded.
+    view[24] = 0xff;
+    EXPECT_EQ(2, readBuf.buf()[24]);
+    readBuf.consume(48);
+    readBuf.endExternalView();
+    EXPECT_EQ(0u, readBuf.validData());
+}
+
+TEST(ReadBufferTest, StagesOnlyAsManyPacketsAsFit) {
+    std::vector<unsigned char> view;
+    appendPacket(&view, 1, 48);
+    appendPacket(&view, 2, 48);
+
+    ReadBuffer readBuf(64);
+    readBuf.beginExternalView(view.data(), view.size());
+    EXPECT_EQ(48u, readBuf.stageExternalView());
+    EXPECT_EQ(48u, readBuf.externalViewLeft());
+    readBuf.consume(48);
+    EXPECT_EQ(48u, readBuf.stageExternalView());
+    EXPECT_EQ(0, memcmp(view.data() + 48, readBuf.buf(), 48));
+    readBuf.consume(48);
+    readBuf.endExternalView();
+}
+
+TEST(ReadBufferTest, StagesAPacketLargerThanTheBuffer) {
+    std::vector<unsigned char> view;
+    appendPacket(&view, 1, 256);
+
+    ReadBuffer readBuf(64);
+    readBuf.beginExternalView(view.data(), view.size());
+    EXPECT_EQ(256u, readBuf.stageExternalView());
+    ASSERT_EQ(256u, readBuf.validData());
+    EXPECT_EQ(0, memcmp(view.data(), readBuf.buf(), view.size()));
+    readBuf.consume(256);
+    readBuf.endExternalView();
+}
+
+TEST(ReadBufferTest, LeavesPacketsPastTheViewForTheRegularPath) {
+    std::vector<unsigned char> view;
+    appendPacket(&view, 1, 16);
+    appendPacket(&view, 2, 64);
+    // The second packet claims more than the view has.
+    view.resize(40);
+
+    ReadBuffer readBuf(1024);
+    readBuf.beginExternalView(view.data(), view.size());
+    EXPECT_EQ(16u, readBuf.stageExternalView());
+    EXPECT_EQ(24u, readBuf.externalViewLeft());
+    readBuf.consume(16);
+    EXPECT_EQ(0u, readBuf.stageExternalView());
+
+    EXPECT_EQ(24, readBuf.endExternalView());
+    ASSERT_EQ(24u, readBuf.validData());
+    EXPECT_EQ(0, memcmp(view.data() + 16, readBuf.buf(), 24));
+}
+
+TEST(ReadBufferTest, LeavesPacketsOfACorruptSizeForTheRegularPath) {
+    std::vector<unsigned char> view;
+    appendPacket(&view, 1, 16);
+    view[4] = 4;
+
+    ReadBuffer readBuf(1024);
+    readBuf.beginExternalView(view.data(), view.size());
+    EXPECT_EQ(0u, readBuf.stageExternalView());
+    EXPECT_EQ(16, readBuf.endExternalView());
+    EXPECT_EQ(0, memcmp(view.data(), readBuf.buf(), view.size()));
+}
+
+}  // namespace
+}  // namespace gfxstream
@@ -0,0 +1,323 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "RingStream.h"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+constexpr uint32_t kBufferSize = 16384;
+constexpr uint32_t kFlushInterval = 1024;
+
+// A byte pattern that depends on the position in the stream, so that dropped,
+// duplicated or reordered xfers show up as mismatches.
+uint8_t patternByte(uint64_t index) {
+    return static_cast<uint8_t>((index * 2654435761ULL) >> 13);
+}
+
+class RingStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mRingStorage.assign(sizeof(struct asg_ring_storage), 0);
+        mBuffer.assign(kBufferSize, 0);
+
+        mContext = asg_context_create(mRingStorage.data(), mBuffer.data(), kBufferSize);
+        mContext.ring_config->buffer_size = kBufferSize;
+        mContext.ring_config->flush_interval = kFlushInterval;
+        mContext.ring_config->host_consumed_pos = 0;
+        mContext.ring_config->guest_write_pos = 0;
+        mContext.ring_config->transfer_mode = 1;
+        mContext.ring_config->transfer_size = 0;
+        mContext.ring_config->in_error = 0;
+
+        android::emulation::asg::ConsumerCallbacks callbacks = {
+            .onUnavailableRead =
+                [this] {
+                    if (mOnUnavailableRead) {
+                        return mOnUnavailableRead();
+                    }
+                    std::this_thread::yield();
+                    return 0;
+                },
+            .getPtr = [](uint64_t) -> char* { return nullptr; },
+        };
+        mStream = std::make_unique<RingStream>(mContext, callbacks, kFlushInterval);
+    }
+
+    void TearDown() override { mStream.reset(); }
+
+    // Mirrors what the guest AddressSpaceStream does for type 1 xfers: fill the
+    // current flush_interval slot, wait until the host has few enough xfers
+    // outstanding, publish the xfer and move on to the next slot.
+    void guestWrite(uint32_t size) {
+        for (uint32_t i = 0; i < size; ++i) {
+            mBuffer[mGuestSlotOffset + i] = patternByte(mGuestBytesWritten + i);
+        }
+
+        const uint32_t maxOutstanding = kBufferSize / kFlushInterval - 1;
+        while (ring_buffer_available_read(mContext.to_host, 0) >=
+               maxOutstanding * sizeof(struct asg_type1_xfer)) {
+            if (mGuestAbort.load(std::memory_order_relaxed)) return;
+            std::this_thread::yield();
+        }
+
+        struct asg_type1_xfer xfer = {mGuestSlotOffset, size};
+        while (ring_buffer_write(mContext.to_host, &xfer, sizeof(xfer), 1) != 1) {
+            if (mGuestAbort.load(std::memory_order_relaxed)) return;
+            std::this_thread::yield();
+        }
+
+        mGuestBytesWritten += size;
+        mGuestSlotOffset = (mGuestSlotOffset + kFlushInterval) % kBufferSize;
+    }
+
+    // Returns the number of bytes returned by a single read() call and checks
+    // them against the pattern.
+    size_t hostRead(size_t wanted) {
+        std::vector<uint8_t> data(wanted);
+        const size_t got = mStream->read(data.data(), wanted);
+        for (size_t i = 0; i < got; ++i) {
+            if (data[i] != patternByte(mHostBytesRead + i)) {
+                ADD_FAILURE() << "Mismatch at stream offset " << mHostBytesRead + i;
+                break;
+            }
+        }
+        mHostBytesRead += got;
+        return got;
+    }
+
+    uint32_t pendingXfers() const {
+        return ring_buffer_available_read(mContext.to_host, 0) / sizeof(struct asg_type1_xfer);
+    }
+
+    uint32_t hostConsumedPos() const {
+        return __atomic_load_n(&mContext.ring_config->host_consumed_pos, __ATOMIC_ACQUIRE);
+    }
+
+    std::vector<char> mRingStorage;
+    std::vector<char> mBuffer;
+    struct asg_context mContext;
+    std::unique_ptr<RingStream> mStream;
+
+    uint32_t mGuestSlotOffset = 0;
+    uint64_t mGuestBytesWritten = 0;
+    uint64_t mHostBytesRead = 0;
+    std::atomic<bool> mGuestAbort{false};
+    std::function<int()> mOnUnavailableRead;
+};
+
+TEST_F(RingStreamTest, Type1ReadConsumesAllReadyXfersInOnePass) {
+    for (int i = 0; i < 8; ++i) {
+        guestWrite(100);
+    }
+
+    EXPECT_EQ(800, hostRead(4096));
+    EXPECT_EQ(0, pendingXfers());
+    EXPECT_EQ(800, hostConsumedPos());
+}
+
+TEST_F(RingStreamTest, Type1ReadStopsAtCallerBuffer) {
+    for (int i = 0; i < 4; ++i) {
+        guestWrite(100);
+    }
+
+    EXPECT_EQ(200, hostRead(250));
+    EXPECT_EQ(2, pendingXfers());
+    EXPECT_EQ(200, hostConsumedPos());
+
+    EXPECT_EQ(200, hostRead(250));
+    EXPECT_EQ(0, pendingXfers());
+    EXPECT_EQ(400, hostConsumedPos());
+}
+
+TEST_F(RingStreamTest, Type1ReadStagesXferLargerThanCallerBuffer) {
+    guestWrite(600);
+    guestWrite(50);
+
+    EXPECT_EQ(256, hostRead(256));
+    EXPECT_EQ(1, pendingXfers());
+    EXPECT_EQ(600, hostConsumedPos());
+
+    // The staged remainder is returned before the next xfer is looked at.
+    EXPECT_EQ(344, hostRead(4096));
+    EXPECT_EQ(50, hostRead(4096));
+    EXPECT_EQ(650, hostConsumedPos());
+}
+
+TEST_F(RingStreamTest, Type1ReadConsumesXfersWrappingAroundRing) {
+    const uint32_t kXfersPerRing = RING_BUFFER_SIZE / sizeof(struct asg_type1_xfer);
+
+    // Move the read position to just before the end of |to_host|.
+    for (uint32_t i = 0; i < kXfersPerRing - 3; ++i) {
+        guestWrite(16);
+        EXPECT_EQ(16, hostRead(16));
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        guestWrite(32 + i);
+    }
+    EXPECT_EQ(10 * 32 + 45, hostRead(4096));
+    EXPECT_EQ(0, pendingXfers());
+}
+
+TEST_F(RingStreamTest, ZeroCopyReadHoldsXfersUntilEnded) {
+    guestWrite(100);
+    guestWrite(200);
+
+    size_t size = 0;
+    const unsigned char* view = mStream->beginZeroCopyRead(&size);
+    ASSERT_NE(nullptr, view);
+    EXPECT_EQ(reinterpret_cast<const unsigned char*>(mBuffer.data()), view);
+    // Slots are flush_interval apart, so the second xfer isn't contiguous.
+    EXPECT_EQ(100, size);
+    EXPECT_EQ(2, pendingXfers());
+    EXPECT_EQ(0, hostConsumedPos());
+
+    mStream->endZeroCopyRead();
+    EXPECT_EQ(1, pendingXfers());
+    EXPECT_EQ(100, hostConsumedPos());
+    mHostBytesRead += 100;
+
+    EXPECT_EQ(200, hostRead(4096));
+    EXPECT_EQ(300, hostConsumedPos());
+}
+
+TEST_F(RingStreamTest, ZeroCopyReadMergesContiguousXfers) {
+    guestWrite(kFlushInterval);
+    guestWrite(kFlushInterval);
+    guestWrite(10);
+
+    size_t size = 0;
+    const unsigned char* view = mStream->beginZeroCopyRead(&size);
+    ASSERT_NE(nullptr, view);
+    EXPECT_EQ(2 * kFlushInterval + 10, size);
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(patternByte(i), view[i]);
+    }
+
+    mStream->endZeroCopyRead();
+    EXPECT_EQ(0, pendingXfers());
+    EXPECT_EQ(2 * kFlushInterval + 10, hostConsumedPos());
+}
+
+TEST_F(RingStreamTest, ZeroCopyReadDefersRepliesUntilEnded) {
+    guestWrite(100);
+
+    size_t size = 0;
+    const unsigned char* view = mStream->beginZeroCopyRead(&size);
+    ASSERT_NE(nullptr, view);
+    ASSERT_EQ(100, size);
+
+    // Replies are written to the buffer the view is in, so they wait for it.
+    const std::vector<char> reply(64, 'r');
+    mStream->writeFully(reply.data(), reply.size());
+    EXPECT_EQ(1, pendingXfers());
+    EXPECT_EQ(0, ring_buffer_available_read(mContext.from_host_large_xfer.ring,
+                                            &mContext.from_host_large_xfer.view));
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(patternByte(i), view[i]);
+    }
+
+    mStream->endZeroCopyRead();
+    EXPECT_EQ(0, pendingXfers());
+    EXPECT_EQ(100, hostConsumedPos());
+
+    std::vector<char> received(reply.size());
+    ASSERT_EQ(reply.size(), ring_buffer_available_read(mContext.from_host_large_xfer.ring,
+                                                       &mContext.from_host_large_xfer.view));
+    ring_buffer_view_read(mContext.from_host_large_xfer.ring, &mContext.from_host_large_xfer.view,
+                          received.data(), received.size(), 1);
+    EXPECT_EQ(reply, received);
+}
+
+TEST_F(RingStreamTest, ZeroCopyReadReturnsStagedDataFirst) {
+    guestWrite(600);
+    guestWrite(50);
+
+    EXPECT_EQ(256, hostRead(256));
+
+    size_t size = 0;
+    EXPECT_EQ(nullptr, mStream->beginZeroCopyRead(&size));
+    EXPECT_EQ(344, hostRead(4096));
+    EXPECT_NE(nullptr, mStream->beginZeroCopyRead(&size));
+    EXPECT_EQ(50, size);
+    mStream->endZeroCopyRead();
+}
+
+TEST_F(RingStreamTest, ParksWhenGuestIsIdle) {
+    const RingStream::WaitStats before = RingStream::getWaitStats();
+
+    // Stands in for the guest pinging the host after the render thread parked.
+    int parks = 0;
+    mOnUnavailableRead = [&] {
+        if (++parks == 3) {
+            guestWrite(64);
+        }
+        return 0;
+    };
+
+    EXPECT_EQ(64, hostRead(4096));
+    EXPECT_EQ(3, parks);
+
+    const RingStream::WaitStats after = RingStream::getWaitStats();
+    EXPECT_EQ(before.parks + 3, after.parks);
+    EXPECT_EQ(before.parkedWaits + 1, after.parkedWaits);
+    EXPECT_EQ(before.spinWaits, after.spinWaits);
+}
+
+TEST_F(RingStreamTest, Type1ReadStressConcurrentProducer) {
+    constexpr uint32_t kNumXfers = 20000;
+
+    std::atomic<uint64_t> totalBytes{0};
+    std::thread guest([&] {
+        for (uint32_t i = 0; i < kNumXfers; ++i) {
+            guestWrite(1 + (i * 7919) % kFlushInterval);
+        }
+        totalBytes.store(mGuestBytesWritten, std::memory_order_release);
+    });
+
+    uint64_t expectedTotal = 0;
+    for (uint32_t i = 0; i < kNumXfers; ++i) {
+        expectedTotal += 1 + (i * 7919) % kFlushInterval;
+    }
+
+    // Vary the caller buffer so that reads end both on and off xfer
+    // boundaries, and so that large xfers sometimes have to be staged.
+    uint32_t iteration = 0;
+    while (mHostBytesRead < expectedTotal && !HasFailure()) {
+        const size_t wanted = std::min<uint64_t>(expectedTotal - mHostBytesRead,
+                                                 1 + (iteration++ * 4099) % (4 * kFlushInterval));
+        hostRead(wanted);
+    }
+
+    // Don't leave the guest thread waiting on the host if the data was bad.
+    mGuestAbort.store(true, std::memory_order_relaxed);
+    guest.join();
+
+    EXPECT_EQ(expectedTotal, totalBytes.load(std::memory_order_acquire));
+    EXPECT_EQ(expectedTotal, mHostBytesRead);
+    EXPECT_EQ(0, pendingXfers());
+    EXPECT_EQ(static_cast<uint32_t>(expectedTotal), hostConsumedPos());
+}
+
+}  // namespace
+}  // namespace gfxstream
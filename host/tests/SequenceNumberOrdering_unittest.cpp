@@ -0,0 +1,84 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "SequenceNumberOrdering.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+TEST(SequenceNumberOrderingTest, NextSequenceNumberDoesNotWait) {
+    SequenceNumberOrdering ordering;
+    for (uint32_t seqno = 1; seqno <= 100; ++seqno) {
+        ordering.waitForTurn(seqno);
+        ordering.complete();
+    }
+    EXPECT_EQ(100, ordering.current());
+    EXPECT_EQ(0, ordering.getStats().waits);
+}
+
+TEST(SequenceNumberOrderingTest, ParkedWaiterIsWokenUp) {
+    SequenceNumberOrdering ordering;
+
+    std::thread waiter([&] { ordering.waitForTurn(2); });
+
+    // Give the waiter plenty of time to give up spinning.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ordering.complete();
+    waiter.join();
+
+    const SequenceNumberOrdering::Stats stats = ordering.getStats();
+    EXPECT_EQ(1, stats.waits);
+    EXPECT_EQ(1, stats.parkedWaits);
+    EXPECT_GE(stats.maxWaitUs, 10000);
+}
+
+TEST(SequenceNumberOrderingTest, ExecutesInOrderAcrossThreads) {
+    constexpr uint32_t kNumThreads = 8;
+    constexpr uint32_t kNumCommands = 20000;
+
+    SequenceNumberOrdering ordering;
+    std::vector<uint32_t> executed;
+    executed.reserve(kNumCommands);
+
+    // Like render threads of one process, each thread gets an interleaved
+    // share of the sequence numbers.
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint32_t seqno = t + 1; seqno <= kNumCommands; seqno += kNumThreads) {
+                ordering.waitForTurn(seqno);
+                executed.push_back(seqno);
+                ordering.complete();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(kNumCommands, executed.size());
+    for (uint32_t i = 0; i < kNumCommands; ++i) {
+        ASSERT_EQ(i + 1, executed[i]);
+    }
+    EXPECT_EQ(kNumCommands, ordering.current());
+}
+
+}  // namespace
+}  // namespace gfxstream
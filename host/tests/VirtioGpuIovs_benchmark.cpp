@@ -0,0 +1,146 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// ColorBuffer transfers between guest memory split in 4KiB pages and the
+// linear copy of a resource, walking every iovec and copying the whole range
+// spanned by the box as sync_iov used to ("Walk"), and with VirtioGpuIovs
+// ("Indexed").
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "VirtioGpuIovs.h"
+
+namespace gfxstream {
+namespace {
+
+constexpr size_t kPageSize = 4096;
+constexpr size_t kBpp = 4;
+
+struct Box {
+    uint32_t x, y, w, h;
+};
+
+// A RGBA ColorBuffer resource backed by pages scattered over guest memory.
+class Resource {
+   public:
+    Resource(uint32_t width, uint32_t height)
+        : mWidth(width), mLinear(static_cast<size_t>(width) * height * kBpp) {
+        const size_t numPages = (mLinear.size() + kPageSize - 1) / kPageSize;
+        mGuestMemory.resize(numPages * kPageSize);
+
+        std::vector<size_t> pages(numPages);
+        std::iota(pages.begin(), pages.end(), 0);
+        std::shuffle(pages.begin(), pages.end(), std::mt19937(0));
+
+        size_t remaining = mLinear.size();
+        for (size_t page : pages) {
+            const size_t size = std::min(remaining, kPageSize);
+            mIovs.push_back(iovec{.iov_base = mGuestMemory.data() + page * kPageSize,
+                                  .iov_len = size});
+            remaining -= size;
+        }
+        mIndex = VirtioGpuIovs(mIovs.data(), mIovs.size());
+    }
+
+    void transferWalk(const Box& box) {
+        const size_t stride = mWidth * kBpp;
+        const size_t start = box.y * stride + box.x * kBpp;
+        const size_t end = start + (box.h - 1) * stride + box.w * kBpp;
+
+        size_t iovOffset = 0;
+        size_t written = 0;
+        for (const iovec& iov : mIovs) {
+            if (written >= end - start) {
+                break;
+            }
+            const size_t iovEnd = iovOffset + iov.iov_len;
+            const size_t lower = std::max(iovOffset, start);
+            const size_t upper = std::min(iovEnd, end);
+            if (lower < upper) {
+                memcpy(mLinear.data() + lower,
+                       static_cast<const char*>(iov.iov_base) + lower - iovOffset, upper - lower);
+                written += upper - lower;
+            }
+            iovOffset = iovEnd;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    void transferIndexed(const Box& box) {
+        const size_t stride = mWidth * kBpp;
+        mIndex.copyRows(VirtioGpuIovs::Direction::kIovsToLinear, box.y * stride + box.x * kBpp,
+                        box.w * kBpp, stride, box.h, mLinear.data());
+        benchmark::ClobberMemory();
+    }
+
+   private:
+    uint32_t mWidth;
+    std::vector<char> mLinear;
+    std::vector<char> mGuestMemory;
+    std::vector<iovec> mIovs;
+    VirtioGpuIovs mIndex;
+};
+
+void setBytesProcessed(benchmark::State& state, const Box& box) {
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(box.w) * box.h * kBpp);
+}
+
+Box getBox(const benchmark::State& state) {
+    return Box{static_cast<uint32_t>(state.range(2)), static_cast<uint32_t>(state.range(3)),
+               static_cast<uint32_t>(state.range(4)), static_cast<uint32_t>(state.range(5))};
+}
+
+void BM_TransferWalk(benchmark::State& state) {
+    Resource resource(state.range(0), state.range(1));
+    const Box box = getBox(state);
+    for (auto _ : state) {
+        resource.transferWalk(box);
+    }
+    setBytesProcessed(state, box);
+}
+
+void BM_TransferIndexed(benchmark::State& state) {
+    Resource resource(state.range(0), state.range(1));
+    const Box box = getBox(state);
+    for (auto _ : state) {
+        resource.transferIndexed(box);
+    }
+    setBytesProcessed(state, box);
+}
+
+// Arguments: the resource width and height, and the box as x, y, w, h.
+void transferArgs(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"w", "h", "box_x", "box_y", "box_w", "box_h"});
+    // Full frames.
+    benchmark->Args({1920, 1080, 0, 0, 1920, 1080});
+    benchmark->Args({3840, 2160, 0, 0, 3840, 2160});
+    // A narrow strip, like a status bar clock or a cursor update.
+    benchmark->Args({1920, 1080, 1700, 0, 128, 64});
+    benchmark->Args({3840, 2160, 3400, 0, 256, 128});
+    // A dirty rectangle near the bottom of the frame.
+    benchmark->Args({1920, 1080, 640, 900, 640, 160});
+    benchmark->Args({3840, 2160, 1280, 1800, 1280, 320});
+}
+
+BENCHMARK(BM_TransferWalk)->Apply(transferArgs);
+BENCHMARK(BM_TransferIndexed)->Apply(transferArgs);
+
+}  // namespace
+}  // namespace gfxstream
@@ -0,0 +1,176 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "VirtioGpuIovs.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+// Guest memory split in iovecs of the given sizes, filled with a pattern.
+class FragmentedMemory {
+   public:
+    explicit FragmentedMemory(const std::vector<size_t>& iovSizes) {
+        size_t total = 0;
+        for (size_t size : iovSizes) {
+            total += size;
+        }
+        mBytes.resize(total);
+        for (size_t i = 0; i < total; ++i) {
+            mBytes[i] = static_cast<uint8_t>(i * 7 + 1);
+        }
+        // Lay the iovecs out in reverse order so that a copy that ignores
+        // their boundaries gets the wrong bytes.
+        size_t end = total;
+        for (size_t size : iovSizes) {
+            end -= size;
+            mIovs.push_back(iovec{.iov_base = mBytes.data() + end, .iov_len = size});
+        }
+    }
+
+    const std::vector<iovec>& iovs() const { return mIovs; }
+
+    // Byte at |offset| in the resource.
+    uint8_t& at(size_t offset) {
+        for (const iovec& iov : mIovs) {
+            if (offset < iov.iov_len) {
+                return static_cast<uint8_t*>(iov.iov_base)[offset];
+            }
+            offset -= iov.iov_len;
+        }
+        return mBytes.at(mBytes.size());
+    }
+
+   private:
+    std::vector<uint8_t> mBytes;
+    std::vector<iovec> mIovs;
+};
+
+TEST(VirtioGpuIovsTest, CopyWholeRange) {
+    FragmentedMemory memory({3, 0, 5, 1, 7, 16});
+    VirtioGpuIovs iovs(memory.iovs().data(), memory.iovs().size());
+    ASSERT_EQ(32, iovs.size());
+
+    std::vector<uint8_t> linear(32);
+    ASSERT_TRUE(iovs.copy(VirtioGpuIovs::Direction::kIovsToLinear, 0, 32, linear.data()));
+    for (size_t i = 0; i < 32; ++i) {
+        EXPECT_EQ(memory.at(i), linear[i]) << "at " << i;
+    }
+
+    for (size_t i = 0; i < 32; ++i) {
+        linear[i] = static_cast<uint8_t>(0xF0 ^ i);
+    }
+    ASSERT_TRUE(iovs.copy(VirtioGpuIovs::Direction::kLinearToIovs, 0, 32, linear.data()));
+    for (size_t i = 0; i < 32; ++i) {
+        EXPECT_EQ(linear[i], memory.at(i)) << "at " << i;
+    }
+}
+
+TEST(VirtioGpuIovsTest, CopyRowsOnlyTouchesTheBox) {
+    // 8 rows of 16 bytes, in iovecs that don't line up with the rows.
+    FragmentedMemory memory({5, 11, 3, 29, 16, 7, 57});
+    VirtioGpuIovs iovs(memory.iovs().data(), memory.iovs().size());
+    ASSERT_EQ(128, iovs.size());
+
+    // A box of 3 rows of 6 bytes starting at row 2, column 4.
+    constexpr size_t kStride = 16;
+    constexpr size_t kOffset = 2 * kStride + 4;
+    constexpr size_t kRowSize = 6;
+    constexpr size_t kNumRows = 3;
+
+    std::vector<uint8_t> linear(128, 0);
+    ASSERT_TRUE(iovs.copyRows(VirtioGpuIovs::Direction::kIovsToLinear, kOffset, kRowSize, kStride,
+                              kNumRows, linear.data()));
+    for (size_t i = 0; i < 128; ++i) {
+        const size_t row = i / kStride;
+        const size_t column = i % kStride;
+        const bool inBox = row >= 2 && row < 2 + kNumRows && column >= 4 && column < 4 + kRowSize;
+        EXPECT_EQ(inBox ? memory.at(i) : 0, linear[i]) << "at " << i;
+    }
+
+    std::vector<uint8_t> before(128);
+    for (size_t i = 0; i < 128; ++i) {
+        before[i] = memory.at(i);
+        linear[i] = 0xAA;
+    }
+    ASSERT_TRUE(iovs.copyRows(VirtioGpuIovs::Direction::kLinearToIovs, kOffset, kRowSize, kStride,
+                              kNumRows, linear.data()));
+    for (size_t i = 0; i < 128; ++i) {
+        const size_t row = i / kStride;
+        const size_t column = i % kStride;
+        const bool inBox = row >= 2 && row < 2 + kNumRows && column >= 4 && column < 4 + kRowSize;
+        EXPECT_EQ(inBox ? 0xAA : before[i], memory.at(i)) << "at " << i;
+    }
+}
+
+TEST(VirtioGpuIovsTest, CopyRowsFarApart) {
+    // Rows many iovecs apart, to go through the binary search.
+    std::vector<size_t> iovSizes(256, 4);
+    FragmentedMemory memory(iovSizes);
+    VirtioGpuIovs iovs(memory.iovs().data(), memory.iovs().size());
+
+    constexpr size_t kStride = 100;
+    std::vector<uint8_t> linear(1024, 0);
+    ASSERT_TRUE(iovs.copyRows(VirtioGpuIovs::Direction::kIovsToLinear, 3, 6, kStride, 10,
+                              linear.data()));
+    for (size_t row = 0; row < 10; ++row) {
+        for (size_t i = 0; i < 6; ++i) {
+            const size_t offset = 3 + row * kStride + i;
+            EXPECT_EQ(memory.at(offset), linear[offset]) << "at " << offset;
+        }
+    }
+}
+
+TEST(VirtioGpuIovsTest, CopyRange) {
+    FragmentedMemory memory({3, 5, 1, 7});
+    VirtioGpuIovs iovs(memory.iovs().data(), memory.iovs().size());
+
+    // Only holds the 9 bytes from offset 2 on.
+    std::vector<uint8_t> range(9);
+    ASSERT_TRUE(iovs.copyRange(VirtioGpuIovs::Direction::kIovsToLinear, 2, 9, range.data()));
+    for (size_t i = 0; i < 9; ++i) {
+        EXPECT_EQ(memory.at(2 + i), range[i]) << "at " << i;
+    }
+
+    for (size_t i = 0; i < 9; ++i) {
+        range[i] = static_cast<uint8_t>(0x80 | i);
+    }
+    ASSERT_TRUE(iovs.copyRange(VirtioGpuIovs::Direction::kLinearToIovs, 2, 9, range.data()));
+    for (size_t i = 0; i < 9; ++i) {
+        EXPECT_EQ(range[i], memory.at(2 + i)) << "at " << i;
+    }
+
+    EXPECT_FALSE(iovs.copyRange(VirtioGpuIovs::Direction::kIovsToLinear, 8, 9, range.data()));
+}
+
+TEST(VirtioGpuIovsTest, RejectsOutOfRange) {
+    FragmentedMemory memory({8, 8});
+    VirtioGpuIovs iovs(memory.iovs().data(), memory.iovs().size());
+
+    std::vector<uint8_t> linear(64, 0);
+    EXPECT_FALSE(iovs.copy(VirtioGpuIovs::Direction::kIovsToLinear, 10, 7, linear.data()));
+    EXPECT_FALSE(iovs.copy(VirtioGpuIovs::Direction::kIovsToLinear, 17, 1, linear.data()));
+    EXPECT_FALSE(
+        iovs.copyRows(VirtioGpuIovs::Direction::kIovsToLinear, 0, 4, 8, 3, linear.data()));
+    EXPECT_TRUE(iovs.copyRows(VirtioGpuIovs::Direction::kIovsToLinear, 4, 4, 8, 2, linear.data()));
+
+    VirtioGpuIovs empty;
+    EXPECT_EQ(0, empty.size());
+    EXPECT_FALSE(empty.copy(VirtioGpuIovs::Direction::kIovsToLinear, 0, 1, linear.data()));
+}
+
+}  // namespace
+}  // namespace gfxstream
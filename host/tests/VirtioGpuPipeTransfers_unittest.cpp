@@ -0,0 +1,301 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "VirtioGpuPipeTransfers.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace {
+
+using namespace std::chrono_literals;
+
+// A pipe service that only moves the bytes the test makes available, and
+// wakes up |transfers| when it gets some once asked to.
+struct FakePipe {
+    explicit FakePipe(VirtioGpuPipeTransfers* transfers) : transfers(transfers) {}
+
+    VirtioGpuPipeTransfers* transfers;
+    std::mutex lock;
+    // Bytes the service has for the guest to read.
+    std::string readable;
+    // How many more bytes the service accepts from the guest, and what it got.
+    size_t writable = 0;
+    std::string written;
+    bool failed = false;
+    int wakeFlags = 0;
+
+    static FakePipe* from(GoldfishHostPipe* hostPipe) {
+        return reinterpret_cast<FakePipe*>(hostPipe);
+    }
+    GoldfishHostPipe* hostPipe() { return reinterpret_cast<GoldfishHostPipe*>(this); }
+
+    void makeReadable(const std::string& bytes, bool signalWake = true) {
+        std::unique_lock<std::mutex> guard(lock);
+        readable += bytes;
+        const bool wake = signalWake && (wakeFlags & GOLDFISH_PIPE_WAKE_READ);
+        guard.unlock();
+        if (wake) transfers->wake();
+    }
+    void makeWritable(size_t size) {
+        std::unique_lock<std::mutex> guard(lock);
+        writable += size;
+        const bool wake = wakeFlags & GOLDFISH_PIPE_WAKE_WRITE;
+        guard.unlock();
+        if (wake) transfers->wake();
+    }
+};
+
+GoldfishPipeServiceOps makeFakeOps() {
+    GoldfishPipeServiceOps ops = {};
+    ops.guest_recv = [](GoldfishHostPipe* hostPipe, GoldfishPipeBuffer* buffers,
+                        int numBuffers) -> int {
+        FakePipe* pipe = FakePipe::from(hostPipe);
+        std::lock_guard<std::mutex> guard(pipe->lock);
+        if (pipe->failed) return -1;
+        if (pipe->readable.empty()) return kPipeTryAgain;
+        const size_t size = std::min(buffers[0].size, pipe->readable.size());
+        memcpy(buffers[0].data, pipe->readable.data(), size);
+        pipe->readable.erase(0, size);
+        return static_cast<int>(size);
+    };
+    ops.guest_send = [](GoldfishHostPipe** hostPipe, const GoldfishPipeBuffer* buffers,
+                        int numBuffers) -> int {
+        FakePipe* pipe = FakePipe::from(*hostPipe);
+        std::lock_guard<std::mutex> guard(pipe->lock);
+        if (pipe->failed) return -1;
+        if (pipe->writable == 0) return kPipeTryAgain;
+        const size_t size = std::min(buffers[0].size, pipe->writable);
+        pipe->written.append(static_cast<const char*>(buffers[0].data), size);
+        pipe->writable -= size;
+        return static_cast<int>(size);
+    };
+    ops.guest_wake_on = [](GoldfishHostPipe* hostPipe, GoldfishPipeWakeFlags flags) {
+        FakePipe* pipe = FakePipe::from(hostPipe);
+        std::lock_guard<std::mutex> guard(pipe->lock);
+        pipe->wakeFlags |= flags;
+    };
+    return ops;
+}
+
+std::vector<char> bytes(const std::string& string) {
+    return std::vector<char>(string.begin(), string.end());
+}
+
+TEST(VirtioGpuPipeTransfersTest, RecvCompletesWhenThePipeHasTheBytes) {
+    const GoldfishPipeServiceOps ops = makeFakeOps();
+    VirtioGpuPipeTransfers transfers(&ops);
+    FakePipe pipe(&transfers);
+
+    // The first 3 bytes were read before the transfer got queued.
+    std::vector<char> data = bytes("abc");
+    data.resize(10);
+    std::promise<std::string> received;
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, pipe.hostPipe(), 0,
+                      std::move(data), 3, [&received](bool ok, std::vector<char>& data) {
+                          EXPECT_TRUE(ok);
+                          received.set_value(std::string(data.begin(), data.end()));
+                      });
+    EXPECT_TRUE(transfers.hasPending(pipe.hostPipe()));
+
+    auto future = received.get_future();
+    EXPECT_EQ(std::future_status::timeout, future.wait_for(20ms));
+
+    pipe.makeReadable("defg");
+    std::this_thread::sleep_for(5ms);
+    pipe.makeReadable("hij");
+    ASSERT_EQ(std::future_status::ready, future.wait_for(5s));
+    EXPECT_EQ("abcdefghij", future.get());
+    EXPECT_FALSE(transfers.hasPending(pipe.hostPipe()));
+
+    std::lock_guard<std::mutex> guard(pipe.lock);
+    EXPECT_TRUE(pipe.wakeFlags & GOLDFISH_PIPE_WAKE_READ);
+}
+
+TEST(VirtioGpuPipeTransfersTest, WaitsForThePipeToSignalAWake) {
+    const GoldfishPipeServiceOps ops = makeFakeOps();
+    VirtioGpuPipeTransfers transfers(&ops);
+    FakePipe pipe(&transfers);
+
+    std::promise<void> received;
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, pipe.hostPipe(), 0,
+                      std::vector<char>(2), 0,
+                      [&received](bool ok, std::vector<char>&) { received.set_value(); });
+    auto future = received.get_future();
+
+    // Once the worker found the pipe empty, it doesn't poll it.
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> guard(pipe.lock);
+            if (pipe.wakeFlags & GOLDFISH_PIPE_WAKE_READ) break;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    pipe.makeReadable("ab", /*signalWake=*/false);
+    EXPECT_EQ(std::future_status::timeout, future.wait_for(50ms));
+
+    transfers.wake();
+    EXPECT_EQ(std::future_status::ready, future.wait_for(5s));
+}
+
+TEST(VirtioGpuPipeTransfersTest, TransfersOnAPipeCompleteInOrder) {
+    const GoldfishPipeServiceOps ops = makeFakeOps();
+    VirtioGpuPipeTransfers transfers(&ops);
+    FakePipe pipe(&transfers);
+    FakePipe otherPipe(&transfers);
+
+    std::mutex completedLock;
+    std::vector<std::string> completed;
+    auto onComplete = [&](const std::string& name) {
+        return [&, name](bool ok, std::vector<char>&) {
+            EXPECT_TRUE(ok);
+            std::lock_guard<std::mutex> guard(completedLock);
+            completed.push_back(name);
+        };
+    };
+
+    std::promise<void> lastCompleted;
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kSend, pipe.hostPipe(), 0,
+                      bytes("xxfirst"), 2, onComplete("first"));
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kSend, pipe.hostPipe(), 0,
+                      bytes("second"), 0, onComplete("second"));
+    // A pipe that is ready doesn't wait for the others.
+    otherPipe.makeWritable(5);
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kSend, otherPipe.hostPipe(), 0,
+                      bytes("other"), 0, onComplete("other"));
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, pipe.hostPipe(), 0,
+                      std::vector<char>(2), 0, [&](bool ok, std::vector<char>& data) {
+                          EXPECT_TRUE(ok);
+                          EXPECT_EQ("ok", std::string(data.begin(), data.end()));
+                          lastCompleted.set_value();
+                      });
+
+    // Enough room for the first transfer and part of the second one, and a
+    // reply that must not be read before both were sent.
+    pipe.makeReadable("ok");
+    pipe.makeWritable(8);
+    std::this_thread::sleep_for(20ms);
+    pipe.makeWritable(3);
+
+    ASSERT_EQ(std::future_status::ready, lastCompleted.get_future().wait_for(5s));
+    {
+        std::lock_guard<std::mutex> guard(pipe.lock);
+        EXPECT_EQ("firstsecond", pipe.written);
+    }
+    {
+        std::lock_guard<std::mutex> guard(otherPipe.lock);
+        EXPECT_EQ("other", otherPipe.written);
+    }
+    std::lock_guard<std::mutex> guard(completedLock);
+    ASSERT_EQ(3, completed.size());
+    completed.erase(std::find(completed.begin(), completed.end(), "other"));
+    EXPECT_EQ((std::vector<std::string>{"first", "second"}), completed);
+}
+
+TEST(VirtioGpuPipeTransfersTest, FailedAndCancelledTransfers) {
+    const GoldfishPipeServiceOps ops = makeFakeOps();
+    VirtioGpuPipeTransfers transfers(&ops);
+
+    FakePipe failingPipe(&transfers);
+    failingPipe.failed = true;
+    std::promise<bool> failed;
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kSend, failingPipe.hostPipe(), 0,
+                      bytes("data"), 0,
+                      [&failed](bool ok, std::vector<char>&) { failed.set_value(ok); });
+    auto failedFuture = failed.get_future();
+    ASSERT_EQ(std::future_status::ready, failedFuture.wait_for(5s));
+    EXPECT_FALSE(failedFuture.get());
+
+    FakePipe closingPipe(&transfers);
+    int numCancelled = 0;
+    for (int i = 0; i < 3; ++i) {
+        transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, closingPipe.hostPipe(), 0,
+                          std::vector<char>(4), 0, [&numCancelled](bool ok, std::vector<char>&) {
+                              EXPECT_FALSE(ok);
+                              ++numCancelled;
+                          });
+    }
+    transfers.cancel(closingPipe.hostPipe());
+    EXPECT_EQ(3, numCancelled);
+    EXPECT_FALSE(transfers.hasPending(closingPipe.hostPipe()));
+}
+
+TEST(VirtioGpuPipeTransfersTest, CancellingAResourceWaitsForItsCallbacks) {
+    constexpr uint32_t kResourceId = 1;
+    constexpr uint32_t kOtherResourceId = 2;
+    const GoldfishPipeServiceOps ops = makeFakeOps();
+    VirtioGpuPipeTransfers transfers(&ops);
+    FakePipe pipe(&transfers);
+    FakePipe otherPipe(&transfers);
+
+    // A callback that is still copying into the resource when it gets
+    // cancelled.
+    std::promise<void> copying;
+    std::promise<void> copied;
+    std::atomic<bool> copyFinished{false};
+    auto copiedFuture = copied.get_future().share();
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, pipe.hostPipe(), kResourceId,
+                      std::vector<char>(2), 0, [&](bool ok, std::vector<char>&) {
+                          EXPECT_TRUE(ok);
+                          copying.set_value();
+                          copiedFuture.wait();
+                          copyFinished = true;
+                      });
+    int numCancelled = 0;
+    for (GoldfishHostPipe* hostPipe : {pipe.hostPipe(), otherPipe.hostPipe()}) {
+        transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, hostPipe, kResourceId,
+                          std::vector<char>(2), 0, [&numCancelled](bool ok, std::vector<char>&) {
+                              EXPECT_FALSE(ok);
+                              ++numCancelled;
+                          });
+    }
+    std::promise<bool> otherCompleted;
+    transfers.enqueue(VirtioGpuPipeTransfers::Direction::kRecv, otherPipe.hostPipe(),
+                      kOtherResourceId, std::vector<char>(2), 0,
+                      [&otherCompleted](bool ok, std::vector<char>&) {
+                          otherCompleted.set_value(ok);
+                      });
+
+    pipe.makeReadable("ab");
+    ASSERT_EQ(std::future_status::ready, copying.get_future().wait_for(5s));
+
+    std::thread finisher([&copied] {
+        std::this_thread::sleep_for(20ms);
+        copied.set_value();
+    });
+    transfers.cancelResource(kResourceId);
+    EXPECT_TRUE(copyFinished);
+    EXPECT_EQ(2, numCancelled);
+    EXPECT_FALSE(transfers.hasPending(pipe.hostPipe()));
+    finisher.join();
+
+    // The transfers into other resources are kept.
+    EXPECT_TRUE(transfers.hasPending(otherPipe.hostPipe()));
+    otherPipe.makeReadable("cd");
+    auto otherFuture = otherCompleted.get_future();
+    ASSERT_EQ(std::future_status::ready, otherFuture.wait_for(5s));
+    EXPECT_TRUE(otherFuture.get());
+}
+
+}  // namespace
+}  // namespace gfxstream
@@ -13,15 +13,24 @@
 // limitations under the License.
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <deque>
+#include <future>
+#include <iterator>
 #include <type_traits>
 #include <unordered_map>
 
 #include "BlobManager.h"
+#include "ColorBuffer.h"
+#include "DecoderStats.h"
 #include "FrameBuffer.h"
 #include "GfxStreamAgents.h"
+#include "RingStream.h"
+#include "TextureRestoreStats.h"
+#include "VirtioGpuIovs.h"
+#include "VirtioGpuPipeTransfers.h"
 #include "VirtioGpuTimelines.h"
 #include "VkCommonOperations.h"
 #include "aemu/base/AlignedBuf.h"
@@ -30,6 +39,7 @@
 #include "aemu/base/Tracing.h"
 #include "aemu/base/memory/SharedMemory.h"
 #include "aemu/base/synchronization/Lock.h"
+#include "compressedTextureFormats/DecompressedTextureCache.h"
 #include "host-common/AddressSpaceService.h"
 #include "host-common/GfxstreamFatalError.h"
 #include "host-common/address_space_device.h"
@@ -53,14 +63,9 @@ extern "C" {
 #include "virgl_hw.h"
 }  // extern "C"
 
-#if defined(_WIN32)
-struct iovec {
-    void* iov_base; /* Starting address */
-    size_t iov_len; /* Length in bytes */
-};
-#else
+#if !defined(_WIN32)
 #include <unistd.h>
-#endif  // _WIN32
+#endif  // !_WIN32
 
 #define MAX_DEBUG_BUFFER_SIZE 512
 
@@ -193,12 +198,18 @@ using android::base::SharedMemory;
 
 using emugl::FatalError;
 using gfxstream::BlobManager;
+using gfxstream::ColorBuffer;
+using gfxstream::DecoderStats;
+using gfxstream::DecompressedTextureCache;
 using gfxstream::ManagedDescriptorInfo;
+using gfxstream::RingStream;
+using gfxstream::TextureRestoreStats;
+using gfxstream::kPipeTryAgain;
+using gfxstream::VirtioGpuIovs;
+using gfxstream::VirtioGpuPipeTransfers;
 
 using VirtioGpuResId = uint32_t;
 
-static constexpr int kPipeTryAgain = -2;
-
 struct VirtioGpuCmd {
     uint32_t op;
     uint32_t cmdSize;
@@ -230,6 +241,8 @@ struct PipeResEntry {
     stream_renderer_resource_create_args args;
     iovec* iov;
     uint32_t numIovs;
+    // Index of |iov| for transfers, rebuilt whenever the iovecs change.
+    VirtioGpuIovs iovIndex;
     void* linear;
     size_t linearSize;
     GoldfishHostPipe* hostPipe;
@@ -365,35 +378,38 @@ static inline uint32_t gl_format_to_natural_type(uint32_t format) {
     }
 }
 
+// Bytes per pixel of non-YUV formats, or 0 if unknown.
+static inline uint32_t virgl_format_to_bpp(uint32_t format) {
+    switch (format) {
+        case VIRGL_FORMAT_R16G16B16A16_FLOAT:
+            return 8;
+        case VIRGL_FORMAT_B8G8R8X8_UNORM:
+        case VIRGL_FORMAT_B8G8R8A8_UNORM:
+        case VIRGL_FORMAT_R8G8B8X8_UNORM:
+        case VIRGL_FORMAT_R8G8B8A8_UNORM:
+        case VIRGL_FORMAT_R10G10B10A2_UNORM:
+            return 4;
+        case VIRGL_FORMAT_B5G6R5_UNORM:
+        case VIRGL_FORMAT_R8G8_UNORM:
+        case VIRGL_FORMAT_R16_UNORM:
+            return 2;
+        case VIRGL_FORMAT_R8_UNORM:
+            return 1;
+        default:
+            stream_renderer_error("Unknown virgl format: 0x%x", format);
+            return 0;
+    }
+}
+
 static inline size_t virgl_format_to_linear_base(uint32_t format, uint32_t totalWidth,
                                                  uint32_t totalHeight, uint32_t x, uint32_t y,
                                                  uint32_t w, uint32_t h) {
     if (virgl_format_is_yuv(format)) {
         return 0;
     } else {
-        uint32_t bpp = 4;
-        switch (format) {
-            case VIRGL_FORMAT_R16G16B16A16_FLOAT:
-                bpp = 8;
-                break;
-            case VIRGL_FORMAT_B8G8R8X8_UNORM:
-            case VIRGL_FORMAT_B8G8R8A8_UNORM:
-            case VIRGL_FORMAT_R8G8B8X8_UNORM:
-            case VIRGL_FORMAT_R8G8B8A8_UNORM:
-            case VIRGL_FORMAT_R10G10B10A2_UNORM:
-                bpp = 4;
-                break;
-            case VIRGL_FORMAT_B5G6R5_UNORM:
-            case VIRGL_FORMAT_R8G8_UNORM:
-            case VIRGL_FORMAT_R16_UNORM:
-                bpp = 2;
-                break;
-            case VIRGL_FORMAT_R8_UNORM:
-                bpp = 1;
-                break;
-            default:
-                stream_renderer_error("Unknown virgl format: 0x%x", format);
-                return 0;
+        uint32_t bpp = virgl_format_to_bpp(format);
+        if (bpp == 0) {
+            return 0;
         }
 
         uint32_t stride = totalWidth * bpp;
@@ -446,29 +462,9 @@ static inline size_t virgl_format_to_total_xfer_len(uint32_t format, uint32_t to
         uint32_t dataSize = ySize + uvSize;
         return dataSize;
     } else {
-        uint32_t bpp = 4;
-        switch (format) {
-            case VIRGL_FORMAT_R16G16B16A16_FLOAT:
-                bpp = 8;
-                break;
-            case VIRGL_FORMAT_B8G8R8X8_UNORM:
-            case VIRGL_FORMAT_B8G8R8A8_UNORM:
-            case VIRGL_FORMAT_R8G8B8X8_UNORM:
-            case VIRGL_FORMAT_R8G8B8A8_UNORM:
-            case VIRGL_FORMAT_R10G10B10A2_UNORM:
-                bpp = 4;
-                break;
-            case VIRGL_FORMAT_B5G6R5_UNORM:
-            case VIRGL_FORMAT_R16_UNORM:
-            case VIRGL_FORMAT_R8G8_UNORM:
-                bpp = 2;
-                break;
-            case VIRGL_FORMAT_R8_UNORM:
-                bpp = 1;
-                break;
-            default:
-                stream_renderer_error("Unknown virgl format: 0x%x", format);
-                return 0;
+        uint32_t bpp = virgl_format_to_bpp(format);
+        if (bpp == 0) {
+            return 0;
         }
 
         uint32_t stride = totalWidth * bpp;
@@ -482,11 +478,12 @@ enum IovSyncDir {
     LINEAR_TO_IOV = 1,
 };
 
-static int sync_iov(PipeResEntry* res, uint64_t offset, const stream_renderer_box* box,
-                    IovSyncDir dir) {
-    stream_renderer_info("offset: 0x%llx box: %u %u %u %u size %u x %u iovs %u linearSize %zu",
-                         (unsigned long long)offset, box->x, box->y, box->w, box->h,
-                         res->args.width, res->args.height, res->numIovs, res->linearSize);
+static int sync_iov(PipeResEntry* res, const VirtioGpuIovs& iovs, uint64_t offset,
+                    const stream_renderer_box* box, IovSyncDir dir) {
+    stream_renderer_info(
+        "offset: 0x%llx box: %u %u %u %u size %u x %u iovs size %zu linearSize %zu",
+        (unsigned long long)offset, box->x, box->y, box->w, box->h, res->args.width,
+        res->args.height, iovs.size(), res->linearSize);
 
     if (box->x > res->args.width || box->y > res->args.height) {
         stream_renderer_error("Box out of range of resource");
@@ -520,43 +517,22 @@ static int sync_iov(PipeResEntry* res, uint64_t offset, const stream_renderer_bo
         return -EINVAL;
     }
 
-    uint32_t iovIndex = 0;
-    size_t iovOffset = 0;
-    size_t written = 0;
-    char* linear = static_cast<char*>(res->linear);
+    const auto direction = dir == IOV_TO_LINEAR ? VirtioGpuIovs::Direction::kIovsToLinear
+                                                : VirtioGpuIovs::Direction::kLinearToIovs;
 
-    while (written < length) {
-        if (iovIndex >= res->numIovs) {
-            stream_renderer_error("write request overflowed numIovs");
-            return -EINVAL;
-        }
-
-        const char* iovBase_const = static_cast<const char*>(res->iov[iovIndex].iov_base);
-        char* iovBase = static_cast<char*>(res->iov[iovIndex].iov_base);
-        size_t iovLen = res->iov[iovIndex].iov_len;
-        size_t iovOffsetEnd = iovOffset + iovLen;
-
-        auto lower_intersect = std::max(iovOffset, start);
-        auto upper_intersect = std::min(iovOffsetEnd, end);
-        if (lower_intersect < upper_intersect) {
-            size_t toWrite = upper_intersect - lower_intersect;
-            switch (dir) {
-                case IOV_TO_LINEAR:
-                    memcpy(linear + lower_intersect, iovBase_const + lower_intersect - iovOffset,
-                           toWrite);
-                    break;
-                case LINEAR_TO_IOV:
-                    memcpy(iovBase + lower_intersect - iovOffset, linear + lower_intersect,
-                           toWrite);
-                    break;
-                default:
-                    stream_renderer_error("Invalid synchronization dir");
-                    return -EINVAL;
-            }
-            written += toWrite;
-        }
-        ++iovIndex;
-        iovOffset += iovLen;
+    // YUV transfers always cover all the planes. Otherwise, only copy the rows
+    // of the box rather than the whole range they span.
+    bool copied;
+    if (virgl_format_is_yuv(res->args.format)) {
+        copied = iovs.copy(direction, start, length, res->linear);
+    } else {
+        const size_t bpp = virgl_format_to_bpp(res->args.format);
+        copied = iovs.copyRows(direction, start, box->w * bpp, res->args.width * bpp, box->h,
+                               res->linear);
+    }
+    if (!copied) {
+        stream_renderer_error("write request overflowed iovs");
+        return -EINVAL;
     }
 
     return 0;
@@ -586,6 +562,7 @@ class PipeVirglRenderer {
         }
         mVirtioGpuTimelines = VirtioGpuTimelines::create(true);
         mVirtioGpuTimelines = VirtioGpuTimelines::create(true);
+        mPipeTransfers = std::make_unique<VirtioGpuPipeTransfers>(ensureAndGetServiceOps());
         return 0;
     }
 
@@ -680,6 +657,7 @@ class PipeVirglRenderer {
             return -EINVAL;
         }
 
+        mPipeTransfers->cancel(hostPipe);
         ops->guest_close(hostPipe, GOLDFISH_PIPE_CLOSE_GRACEFUL);
 
         mContexts.erase(it);
@@ -1043,6 +1021,10 @@ class PipeVirglRenderer {
         auto it = mResources.find(toUnrefId);
         if (it == mResources.end()) return;
 
+        // Pipe reads still waiting for bytes copy them into the memory freed
+        // below.
+        mPipeTransfers->cancelResource(toUnrefId);
+
         auto contextsIt = mResourceContexts.find(toUnrefId);
         if (contextsIt != mResourceContexts.end()) {
             mResourceContexts.erase(contextsIt->first);
@@ -1104,6 +1086,8 @@ class PipeVirglRenderer {
         auto it = mResources.find(resId);
         if (it == mResources.end()) return;
 
+        mPipeTransfers->cancelResource(resId);
+
         auto& entry = it->second;
 
         if (num_iovs) {
@@ -1126,7 +1110,12 @@ class PipeVirglRenderer {
         stream_renderer_info("done");
     }
 
-    int handleTransferReadPipe(PipeResEntry* res, uint64_t offset, stream_renderer_box* box) {
+    // Unlike the other transfers, also syncs |iovs|, since that has to wait
+    // for the pipe when it doesn't have all the bytes yet. Only transfers
+    // into the attached backing, which outlives the call, complete after it
+    // returned: |explicitIovs| belong to the caller.
+    int handleTransferReadPipe(PipeResEntry* res, uint64_t offset, stream_renderer_box* box,
+                               const VirtioGpuIovs& iovs, bool explicitIovs) {
         if (res->type != ResType::PIPE) {
             stream_renderer_error("resid: %d not a PIPE resource", res->args.handle);
             return -EINVAL;
@@ -1141,7 +1130,9 @@ class PipeVirglRenderer {
         size_t readBytes = 0;
         size_t wantedBytes = readBytes + (size_t)box->w;
 
-        while (readBytes < wantedBytes) {
+        // Earlier transfers still waiting on the pipe go first.
+        bool pending = mPipeTransfers->hasPending(hostPipe);
+        while (!pending && readBytes < wantedBytes) {
             GoldfishPipeBuffer buf = {
                 ((char*)res->linear) + box->x + readBytes,
                 wantedBytes - readBytes,
@@ -1150,11 +1141,56 @@ class PipeVirglRenderer {
 
             if (status > 0) {
                 readBytes += status;
-            } else if (status != kPipeTryAgain) {
+            } else if (status == kPipeTryAgain) {
+                pending = true;
+            } else {
                 return EIO;
             }
         }
 
+        if (!pending) {
+            return sync_iov(res, iovs, offset, box, LINEAR_TO_IOV);
+        }
+
+        // The rest of the bytes are copied straight to the guest: |linear| is
+        // only a staging buffer, which the command thread keeps using.
+        std::vector<char> data(wantedBytes);
+        memcpy(data.data(), ((char*)res->linear) + box->x, readBytes);
+
+        if (explicitIovs) {
+            // Still queued behind the earlier transfers on the pipe.
+            std::promise<bool> received;
+            mPipeTransfers->enqueue(VirtioGpuPipeTransfers::Direction::kRecv, hostPipe, 0,
+                                    std::move(data), readBytes,
+                                    [&iovs, &received, x = box->x](bool ok,
+                                                                   std::vector<char>& data) {
+                                        received.set_value(
+                                            ok && iovs.copyRange(
+                                                      VirtioGpuIovs::Direction::kLinearToIovs, x,
+                                                      data.size(), data.data()));
+                                    });
+            return received.get_future().get() ? 0 : EIO;
+        }
+
+        // Let the command thread move on, and only signal the fences behind
+        // this transfer once the pipe produced the rest of the bytes and they
+        // got copied to the guest. The attached iovs stay valid until the
+        // resource is unreferenced or its iovs are detached, which cancel the
+        // transfer and wait for the callback to finish.
+        auto taskId = mVirtioGpuTimelines->enqueueTask(VirtioGpuRingGlobal{});
+        mPipeTransfers->enqueue(
+            VirtioGpuPipeTransfers::Direction::kRecv, hostPipe, res->args.handle,
+            std::move(data), readBytes,
+            [this, taskId, iovs, x = box->x, resId = res->args.handle](bool ok,
+                                                                        std::vector<char>& data) {
+                if (!ok) {
+                    stream_renderer_error("resid: %u pipe read failed", resId);
+                } else if (!iovs.copyRange(VirtioGpuIovs::Direction::kLinearToIovs, x,
+                                           data.size(), data.data())) {
+                    stream_renderer_error("resid: %u pipe read overflowed iovs", resId);
+                }
+                mVirtioGpuTimelines->notifyTaskCompletion(taskId);
+            });
         return 0;
     }
 
@@ -1179,7 +1215,9 @@ class PipeVirglRenderer {
         size_t writtenBytes = 0;
         size_t wantedBytes = (size_t)box->w;
 
-        while (writtenBytes < wantedBytes) {
+        // Earlier transfers still waiting on the pipe go first.
+        bool pending = mPipeTransfers->hasPending(hostPipe);
+        while (!pending && writtenBytes < wantedBytes) {
             GoldfishPipeBuffer buf = {
                 ((char*)res->linear) + box->x + writtenBytes,
                 wantedBytes - writtenBytes,
@@ -1199,11 +1237,32 @@ class PipeVirglRenderer {
 
             if (status > 0) {
                 writtenBytes += status;
-            } else if (status != kPipeTryAgain) {
+            } else if (status == kPipeTryAgain) {
+                pending = true;
+            } else {
                 return EIO;
             }
         }
 
+        if (!pending) {
+            return 0;
+        }
+
+        // The bytes were already copied out of the guest, so the guest is
+        // free to reuse its buffer once the fences behind this transfer
+        // signal, after the pipe consumed the rest of them.
+        std::vector<char> data(((char*)res->linear) + box->x,
+                               ((char*)res->linear) + box->x + wantedBytes);
+
+        auto taskId = mVirtioGpuTimelines->enqueueTask(VirtioGpuRingGlobal{});
+        mPipeTransfers->enqueue(
+            VirtioGpuPipeTransfers::Direction::kSend, hostPipe, 0, std::move(data), writtenBytes,
+            [this, taskId, resId = res->args.handle](bool ok, std::vector<char>&) {
+                if (!ok) {
+                    stream_renderer_error("resid: %u pipe write failed", resId);
+                }
+                mVirtioGpuTimelines->notifyTaskCompletion(taskId);
+            });
         return 0;
     }
 
@@ -1277,10 +1336,15 @@ class PipeVirglRenderer {
         int ret = 0;
 
         auto& entry = it->second;
+        VirtioGpuIovs explicitIovs;
+        if (iovec_cnt) {
+            explicitIovs = VirtioGpuIovs(iov, iovec_cnt);
+        }
+        const VirtioGpuIovs& iovs = iovec_cnt ? explicitIovs : entry.iovIndex;
+
         switch (entry.type) {
             case ResType::PIPE:
-                ret = handleTransferReadPipe(&entry, offset, box);
-                break;
+                return handleTransferReadPipe(&entry, offset, box, iovs, iovec_cnt != 0);
             case ResType::BUFFER:
                 ret = handleTransferReadBuffer(&entry, offset, box);
                 break;
@@ -1293,16 +1357,7 @@ class PipeVirglRenderer {
             return ret;
         }
 
-        if (iovec_cnt) {
-            PipeResEntry e = {
-                entry.args, iov, (uint32_t)iovec_cnt, entry.linear, entry.linearSize,
-            };
-            ret = sync_iov(&e, offset, box, LINEAR_TO_IOV);
-        } else {
-            ret = sync_iov(&entry, offset, box, LINEAR_TO_IOV);
-        }
-
-        return ret;
+        return sync_iov(&entry, iovs, offset, box, LINEAR_TO_IOV);
     }
 
     int transferWriteIov(int resId, uint64_t offset, stream_renderer_box* box, struct iovec* iov,
@@ -1314,12 +1369,9 @@ class PipeVirglRenderer {
 
         int ret = 0;
         if (iovec_cnt) {
-            PipeResEntry e = {
-                entry.args, iov, (uint32_t)iovec_cnt, entry.linear, entry.linearSize,
-            };
-            ret = sync_iov(&e, offset, box, IOV_TO_LINEAR);
+            ret = sync_iov(&entry, VirtioGpuIovs(iov, iovec_cnt), offset, box, IOV_TO_LINEAR);
         } else {
-            ret = sync_iov(&entry, offset, box, IOV_TO_LINEAR);
+            ret = sync_iov(&entry, entry.iovIndex, offset, box, IOV_TO_LINEAR);
         }
 
         if (ret != 0) {
@@ -1693,6 +1745,11 @@ class PipeVirglRenderer {
         return -EINVAL;
     }
 
+    // Called when a pipe signals it can make progress.
+    void onPipeWake() {
+        if (mPipeTransfers) mPipeTransfers->wake();
+    }
+
 #ifdef CONFIG_AEMU
     void setServiceOps(const GoldfishPipeServiceOps* ops) { mServiceOps = ops; }
 #endif  // CONFIG_AEMU
@@ -1717,6 +1774,7 @@ class PipeVirglRenderer {
         entry.iov = (iovec*)malloc(sizeof(*iov) * num_iovs);
         entry.numIovs = num_iovs;
         memcpy(entry.iov, iov, num_iovs * sizeof(*iov));
+        entry.iovIndex = VirtioGpuIovs(iov, num_iovs);
         entry.linear = linear;
         entry.linearSize = linearSize;
     }
@@ -1774,6 +1832,9 @@ class PipeVirglRenderer {
     // fences created for that context should not be signaled immediately.
     // Rather, they should get in line.
     std::unique_ptr<VirtioGpuTimelines> mVirtioGpuTimelines = nullptr;
+
+    // Pipe transfers waiting for the pipe service to produce or consume bytes.
+    std::unique_ptr<VirtioGpuPipeTransfers> mPipeTransfers;
 };
 
 static PipeVirglRenderer* sRenderer() {
@@ -1781,6 +1842,30 @@ static PipeVirglRenderer* sRenderer() {
     return p;
 }
 
+// The pipe transfers ask the pipes to wake up with guest_wake_on(), which
+// reaches the pipe device through signalWake(). Pass the signal on to the
+// device, and retry the transfers.
+static const AndroidPipeHwFuncs* sPipeDeviceHwFuncs = nullptr;
+static AndroidPipeHwFuncs sPipeHwFuncs = {};
+
+// Installed before any pipe gets opened, so nothing calls the functions while
+// they are filled in.
+static void installPipeWakeHook() {
+    if (sPipeDeviceHwFuncs) return;
+    sPipeDeviceHwFuncs = android_pipe_set_hw_funcs(&sPipeHwFuncs);
+    if (!sPipeDeviceHwFuncs) {
+        android_pipe_set_hw_funcs(nullptr);
+        return;
+    }
+    sPipeHwFuncs = *sPipeDeviceHwFuncs;
+    sPipeHwFuncs.signalWake = [](void* hwPipe, unsigned flags) {
+        if (sPipeDeviceHwFuncs->signalWake) {
+            sPipeDeviceHwFuncs->signalWake(hwPipe, flags);
+        }
+        sRenderer()->onPipeWake();
+    };
+}
+
 extern "C" {
 
 VG_EXPORT int stream_renderer_resource_create(struct stream_renderer_resource_create_args* args,
@@ -1916,6 +2001,130 @@ VG_EXPORT int stream_renderer_vulkan_info(uint32_t res_handle,
     return sRenderer()->vulkanInfo(res_handle, vulkan_info);
 }
 
+VG_EXPORT void stream_renderer_set_decode_stats_enabled(int enabled) {
+    DecoderStats::setEnabled(enabled != 0);
+}
+
+VG_EXPORT void stream_renderer_reset_decode_stats(void) { DecoderStats::reset(); }
+
+VG_EXPORT int stream_renderer_get_decode_stats(struct stream_renderer_decode_stats_entry* entries,
+                                               uint32_t* num_entries) {
+    static_assert(STREAM_RENDERER_DECODE_STATS_NUM_BUCKETS == DecoderStats::kNumBuckets,
+                  "Mismatched number of decode stats buckets");
+    if (!num_entries) {
+        return -EINVAL;
+    }
+
+    const auto stats = DecoderStats::collect();
+    if (entries) {
+        const size_t numCopied = std::min<size_t>(*num_entries, stats.size());
+        for (size_t i = 0; i < numCopied; ++i) {
+            stream_renderer_decode_stats_entry& entry = entries[i];
+            entry = {};
+            entry.opcode = stats[i].opcode;
+            entry.count = stats[i].count;
+            entry.total_ns = stats[i].totalNs;
+            std::copy(std::begin(stats[i].buckets), std::end(stats[i].buckets),
+                      entry.latency_buckets);
+        }
+    }
+    *num_entries = static_cast<uint32_t>(stats.size());
+    return 0;
+}
+
+VG_EXPORT void stream_renderer_set_decompressed_texture_cache_size(uint64_t max_bytes) {
+    DecompressedTextureCache::get().setMaxBytes(max_bytes);
+}
+
+VG_EXPORT int stream_renderer_get_decompressed_texture_cache_stats(
+    struct stream_renderer_decompressed_texture_cache_stats* stats) {
+    if (!stats) {
+        return -EINVAL;
+    }
+
+    const auto cacheStats = DecompressedTextureCache::get().getStats();
+    stats->hits = cacheStats.hits;
+    stats->misses = cacheStats.misses;
+    stats->evictions = cacheStats.evictions;
+    stats->num_entries = cacheStats.numEntries;
+    stats->size_bytes = cacheStats.sizeBytes;
+    stats->max_bytes = cacheStats.maxBytes;
+    return 0;
+}
+
+VG_EXPORT int stream_renderer_get_texture_restore_stats(
+    struct stream_renderer_texture_restore_stats* stats) {
+    if (!stats) {
+        return -EINVAL;
+    }
+
+    const auto restoreStats = TextureRestoreStats::get().getStats();
+    stats->num_textures = restoreStats.numTextures;
+    stats->num_restored = restoreStats.numRestored;
+    stats->num_prioritized = restoreStats.numPrioritized;
+    stats->num_prioritized_restored = restoreStats.numPrioritizedRestored;
+    stats->prioritized_restore_ms = restoreStats.prioritizedRestoreMs;
+    stats->restore_ms = restoreStats.restoreMs;
+    stats->in_progress = restoreStats.inProgress ? 1 : 0;
+    return 0;
+}
+
+VG_EXPORT int stream_renderer_get_color_buffer_sync_stats(
+    struct stream_renderer_color_buffer_sync_stats* stats) {
+    if (!stats) {
+        return -EINVAL;
+    }
+
+    const auto syncStats = ColorBuffer::getSyncStats();
+    stats->num_syncs = syncStats.numSyncs;
+    stats->bytes_copied = syncStats.bytesCopied;
+    stats->bytes_avoided = syncStats.bytesAvoided;
+    return 0;
+}
+
+VG_EXPORT int stream_renderer_get_ring_wait_stats(struct stream_renderer_ring_wait_stats* stats) {
+    if (!stats) {
+        return -EINVAL;
+    }
+
+    const auto waitStats = RingStream::getWaitStats();
+    stats->spin_waits = waitStats.spinWaits;
+    stats->parked_waits = waitStats.parkedWaits;
+    stats->parks = waitStats.parks;
+    stats->spin_time_us = waitStats.spinTimeUs;
+    stats->commit_backoffs = waitStats.commitBackoffs;
+    return 0;
+}
+
+VG_EXPORT int stream_renderer_get_sequence_number_stats(
+    struct stream_renderer_sequence_number_stats_entry* entries, uint32_t* num_entries) {
+    if (!num_entries) {
+        return -EINVAL;
+    }
+
+    auto fb = gfxstream::FrameBuffer::getFB();
+    if (!fb) {
+        *num_entries = 0;
+        return 0;
+    }
+
+    const auto stats = fb->getSequenceNumberStats();
+    if (entries) {
+        const size_t numCopied = std::min<size_t>(*num_entries, stats.size());
+        for (size_t i = 0; i < numCopied; ++i) {
+            stream_renderer_sequence_number_stats_entry& entry = entries[i];
+            entry = {};
+            entry.process_id = stats[i].puid;
+            entry.waits = stats[i].stats.waits;
+            entry.parked_waits = stats[i].stats.parkedWaits;
+            entry.total_wait_us = stats[i].stats.totalWaitUs;
+            entry.max_wait_us = stats[i].stats.maxWaitUs;
+        }
+    }
+    *num_entries = static_cast<uint32_t>(stats.size());
+    return 0;
+}
+
 static const GoldfishPipeServiceOps goldfish_pipe_service_ops = {
     // guest_open()
     [](GoldfishHwPipe* hwPipe) -> GoldfishHostPipe* {
@@ -2366,6 +2575,7 @@ VG_EXPORT int stream_renderer_init(struct stream_renderer_param* stream_renderer
     }
 
     sRenderer()->init(renderer_cookie, renderer_flags, fence_callback);
+    installPipeWakeHook();
     gfxstream::FrameBuffer::waitUntilInitialized();
 
     stream_renderer_info("Started renderer");
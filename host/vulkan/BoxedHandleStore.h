@@ -0,0 +1,501 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "aemu/base/synchronization/Lock.h"
+#include "host-common/GfxstreamFatalError.h"
+
+namespace gfxstream {
+namespace vk {
+
+// Storage for the boxed handles handed out to the guest.
+//
+// Handles use the same layout as android::base::EntityManager<32, 16, 16>:
+// the low 32 bits are an index into the store, followed by 16 bits of
+// generation and 16 bits of type tag, so handles saved in snapshots by older
+// versions can still be restored with addFixed().
+//
+// Slots live in chunks that are allocated on demand and never freed nor moved
+// until the store is destroyed, so get() is wait-free and add() and remove()
+// are lock-free, however many handles are alive. Like with EntityManager, the
+// pointer returned by get() stays valid until the handle is removed.
+template <class T>
+class BoxedHandleStore {
+   public:
+    static constexpr uint32_t kChunkBits = 12;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr uint32_t kMaxChunks = 4096;
+    static constexpr uint64_t kMaxIndex = uint64_t(kChunkSize) * kMaxChunks;
+
+    BoxedHandleStore() = default;
+    BoxedHandleStore(const BoxedHandleStore&) = delete;
+    BoxedHandleStore& operator=(const BoxedHandleStore&) = delete;
+
+    ~BoxedHandleStore() {
+        for (auto& chunk : mChunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t add(const T& item, size_t type) {
+        const uint32_t index = allocateIndex();
+        Slot& slot = getOrCreateSlot(index);
+        // Skip generation 0 so that a handle is never VK_NULL_HANDLE.
+        if (++slot.generation == 0) slot.generation = 1;
+        const uint64_t handle = makeHandle(index, slot.generation, type);
+        slot.item = item;
+        slot.handle.store(handle, std::memory_order_release);
+        return handle;
+    }
+
+    // Adds |item| under a handle returned by a previous add(), which must not
+    // be alive. Used when loading snapshots, and by vkResetFences to recreate
+    // a fence under the handle it just removed.
+    uint64_t addFixed(uint64_t handle, const T& item, size_t type) {
+        const uint64_t index = getIndex(handle);
+        if (index >= kMaxIndex) {
+            GFXSTREAM_ABORT(emugl::FatalError(emugl::ABORT_REASON_OTHER))
+                << "Boxed handle index " << index << " out of range";
+        }
+        // Make sure add() never hands out this index.
+        reserveIndex(static_cast<uint32_t>(index));
+        uint32_t nextIndex = mNextIndex.load(std::memory_order_relaxed);
+        while (nextIndex <= index &&
+               !mNextIndex.compare_exchange_weak(nextIndex, static_cast<uint32_t>(index + 1),
+                                                 std::memory_order_relaxed)) {
+        }
+
+        Slot& slot = getOrCreateSlot(static_cast<uint32_t>(index));
+        const uint16_t generation = static_cast<uint16_t>(handle >> kIndexBits);
+        slot.generation = generation;
+        const uint64_t fixedHandle = makeHandle(static_cast<uint32_t>(index), generation, type);
+        slot.item = item;
+        slot.handle.store(fixedHandle, std::memory_order_release);
+        return fixedHandle;
+    }
+
+    void remove(uint64_t handle) {
+        Slot* slot = findSlot(handle);
+        if (!slot) return;
+        uint64_t expected = handle;
+        if (slot->handle.compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+            freeIndex(static_cast<uint32_t>(getIndex(handle)));
+        }
+    }
+
+    T* get(uint64_t handle) {
+        Slot* slot = findSlot(handle);
+        if (!slot || slot->handle.load(std::memory_order_acquire) != handle) return nullptr;
+        return &slot->item;
+    }
+
+    const T* get_const(uint64_t handle) const {
+        return const_cast<BoxedHandleStore*>(this)->get(handle);
+    }
+
+    // Not thread safe. Keeps the chunks for reuse.
+    void clear() {
+        for (auto& chunk : mChunks) {
+            Slot* slots = chunk.load(std::memory_order_relaxed);
+            if (!slots) continue;
+            for (uint32_t i = 0; i < kChunkSize; ++i) {
+                slots[i].handle.store(0, std::memory_order_relaxed);
+                slots[i].item = T();
+            }
+        }
+        mFreeListHead.store(0, std::memory_order_relaxed);
+        mNextIndex.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    static constexpr uint32_t kIndexBits = 32;
+    static constexpr uint32_t kGenerationBits = 16;
+
+    struct Slot {
+        std::atomic<uint64_t> handle{0};
+        // Next index + 1 in the free list, 0 at its end.
+        std::atomic<uint32_t> nextFree{0};
+        // Only accessed by whoever allocated the index.
+        uint16_t generation = 0;
+        T item = T();
+    };
+
+    static uint64_t getIndex(uint64_t handle) { return handle & ((1ull << kIndexBits) - 1); }
+
+    static uint64_t makeHandle(uint32_t index, uint16_t generation, size_t type) {
+        return uint64_t(index) | (uint64_t(generation) << kIndexBits) |
+               (uint64_t(type) << (kIndexBits + kGenerationBits));
+    }
+
+    Slot* findSlot(uint64_t handle) {
+        const uint64_t index = getIndex(handle);
+        if (index >= kMaxIndex) return nullptr;
+        Slot* slots = mChunks[index >> kChunkBits].load(std::memory_order_acquire);
+        if (!slots) return nullptr;
+        return &slots[index & (kChunkSize - 1)];
+    }
+
+    Slot& getOrCreateSlot(uint32_t index) {
+        std::atomic<Slot*>& chunk = mChunks[index >> kChunkBits];
+        Slot* slots = chunk.load(std::memory_order_acquire);
+        if (!slots) {
+            Slot* newSlots = new Slot[kChunkSize];
+            if (chunk.compare_exchange_strong(slots, newSlots, std::memory_order_acq_rel)) {
+                slots = newSlots;
+            } else {
+                // Another thread installed the chunk first.
+                delete[] newSlots;
+            }
+        }
+        return slots[index & (kChunkSize - 1)];
+    }
+
+    // The free list head packs the first index + 1 in the low 32 bits and a
+    // counter in the high 32 bits, which keeps a pop racing with a pop and a
+    // push of the same index from succeeding (the ABA problem).
+    bool popFreeIndex(uint32_t* index) {
+        uint64_t head = mFreeListHead.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(head) != 0) {
+            *index = static_cast<uint32_t>(head) - 1;
+            // Chunks are never freed, so this read is safe even if another
+            // thread pops the index first; the CAS then fails.
+            const uint32_t next = findSlotByIndex(*index).nextFree.load(std::memory_order_relaxed);
+            const uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+            if (mFreeListHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t allocateIndex() {
+        uint32_t index;
+        if (popFreeIndex(&index)) return index;
+
+        index = mNextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= kMaxIndex) {
+            GFXSTREAM_ABORT(emugl::FatalError(emugl::ABORT_REASON_OTHER))
+                << "Too many live boxed handles: " << index;
+        }
+        return index;
+    }
+
+    void freeIndex(uint32_t index) {
+        Slot& slot = findSlotByIndex(index);
+        uint64_t head = mFreeListHead.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do {
+            slot.nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            newHead = ((head >> 32) + 1) << 32 | (uint64_t(index) + 1);
+        } while (!mFreeListHead.compare_exchange_weak(head, newHead, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    }
+
+    // Takes |index| out of the free list if it was removed, so that add()
+    // doesn't hand it out again while a handle restored at it is alive. The
+    // indices popped before it are pushed back. A removed index was usually
+    // freed last, e.g. when vkResetFences recreates a fence under the same
+    // handle, so this rarely pops more than one.
+    void reserveIndex(uint32_t index) {
+        android::base::AutoLock lock(mReserveLock);
+        if (index >= mNextIndex.load(std::memory_order_relaxed)) return;
+        // Indices skipped by addFixed() may have no chunk, and are never free.
+        Slot* slots = mChunks[index >> kChunkBits].load(std::memory_order_acquire);
+        if (!slots || slots[index & (kChunkSize - 1)].handle.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        std::vector<uint32_t> popped;
+        uint32_t freeIndexToCheck;
+        while (popFreeIndex(&freeIndexToCheck) && freeIndexToCheck != index) {
+            popped.push_back(freeIndexToCheck);
+        }
+        for (auto it = popped.rbegin(); it != popped.rend(); ++it) {
+            freeIndex(*it);
+        }
+    }
+
+    Slot& findSlotByIndex(uint32_t index) {
+        return mChunks[index >> kChunkBits].load(std::memory_order_acquire)[index &
+                                                                            (kChunkSize - 1)];
+    }
+
+    std::array<std::atomic<Slot*>, kMaxChunks> mChunks = {};
+    std::atomic<uint64_t> mFreeListHead{0};
+    std::atomic<uint32_t> mNextIndex{0};
+    android::base::Lock mReserveLock;
+};
+
+// Maps the underlying driver handles back to their boxed handles.
+//
+// Open addressing with linear probing, where the keys and values are atomics:
+// lookups, inserts and erases don't take any lock. Once half of the slots of a
+// table were used, including the ones left behind by erases, the live entries
+// are moved into a new table sized after how many there are, so memory and
+// probe lengths follow the number of live handles rather than how many were
+// ever created. Inserts and erases wait for the move, while lookups keep
+// reading the old table, which is only freed once no lookup can still be in
+// it.
+//
+// The same underlying handle must not be inserted by two threads at once,
+// which the driver guarantees since it only hands out a handle again after
+// it was destroyed.
+class BoxedHandleReverseMap {
+   public:
+    BoxedHandleReverseMap() : mTable(new Table(kInitialCapacity)) {}
+    BoxedHandleReverseMap(const BoxedHandleReverseMap&) = delete;
+    BoxedHandleReverseMap& operator=(const BoxedHandleReverseMap&) = delete;
+
+    ~BoxedHandleReverseMap() { delete mTable.load(std::memory_order_relaxed); }
+
+    void set(uint64_t unboxed, uint64_t boxed) {
+        if (!unboxed || !boxed) return;
+        write([unboxed, boxed](Table& table) {
+            for (size_t i = hash(unboxed) & table.mask, probes = 0; probes <= table.mask;
+                 i = (i + 1) & table.mask, ++probes) {
+                Entry& entry = table.entries[i];
+                const uint64_t key = entry.key.load(std::memory_order_acquire);
+                if (key == kEmptyKey) break;
+                if (key != unboxed) continue;
+                // Only replace a value that isn't being erased.
+                uint64_t value = entry.value.load(std::memory_order_acquire);
+                if (value &&
+                    entry.value.compare_exchange_strong(value, boxed, std::memory_order_acq_rel)) {
+                    return true;
+                }
+            }
+
+            for (size_t i = hash(unboxed) & table.mask, probes = 0; probes <= table.mask;
+                 i = (i + 1) & table.mask, ++probes) {
+                Entry& entry = table.entries[i];
+                uint64_t key = entry.key.load(std::memory_order_acquire);
+                if (key != kEmptyKey && key != kErasedKey) continue;
+                const bool wasEmpty = key == kEmptyKey;
+                if (!entry.key.compare_exchange_strong(key, unboxed, std::memory_order_acq_rel)) {
+                    continue;
+                }
+                entry.value.store(boxed, std::memory_order_release);
+                if (wasEmpty) {
+                    table.used.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+            // The table filled up before its entries could be moved.
+            return false;
+        });
+    }
+
+    // Returns the boxed handle of |unboxed|, or 0 if there is none.
+    uint64_t get(uint64_t unboxed) const {
+        if (!unboxed) return 0;
+        const ReadGuard guard(*this);
+        const Table& table = *mTable.load(std::memory_order_seq_cst);
+        for (size_t i = hash(unboxed) & table.mask, probes = 0; probes <= table.mask;
+             i = (i + 1) & table.mask, ++probes) {
+            const Entry& entry = table.entries[i];
+            const uint64_t key = entry.key.load(std::memory_order_acquire);
+            if (key == kEmptyKey) break;
+            if (key != unboxed) continue;
+            const uint64_t value = entry.value.load(std::memory_order_acquire);
+            if (value) return value;
+        }
+        return 0;
+    }
+
+    // Erases the mapping of |unboxed| if it still maps to |boxed|, so that a
+    // late removal of a boxed handle doesn't erase the mapping of a newer
+    // object that got the same underlying handle.
+    void erase(uint64_t unboxed, uint64_t boxed) {
+        if (!unboxed) return;
+        write([unboxed, boxed](Table& table) {
+            for (size_t i = hash(unboxed) & table.mask, probes = 0; probes <= table.mask;
+                 i = (i + 1) & table.mask, ++probes) {
+                Entry& entry = table.entries[i];
+                const uint64_t key = entry.key.load(std::memory_order_acquire);
+                if (key == kEmptyKey) break;
+                if (key != unboxed) continue;
+                uint64_t value = boxed;
+                // The value is cleared first, so that lookups racing with the
+                // slot being reused never see the previous value.
+                if (entry.value.compare_exchange_strong(value, 0, std::memory_order_acq_rel)) {
+                    entry.key.store(kErasedKey, std::memory_order_release);
+                    break;
+                }
+            }
+            return true;
+        });
+    }
+
+    // Not thread safe.
+    void clear() {
+        delete mTable.load(std::memory_order_relaxed);
+        mTable.store(new Table(kInitialCapacity), std::memory_order_relaxed);
+    }
+
+    size_t getCapacityForTesting() const {
+        return mTable.load(std::memory_order_relaxed)->capacity();
+    }
+
+   private:
+    static constexpr size_t kInitialCapacity = 4096;
+    static constexpr uint64_t kEmptyKey = 0;
+    static constexpr uint64_t kErasedKey = ~0ull;
+
+    struct Entry {
+        std::atomic<uint64_t> key{kEmptyKey};
+        std::atomic<uint64_t> value{0};
+    };
+
+    struct Table {
+        explicit Table(size_t capacity) : mask(capacity - 1), entries(new Entry[capacity]) {}
+        size_t capacity() const { return mask + 1; }
+
+        const size_t mask;
+        const std::unique_ptr<Entry[]> entries;
+        // Entries that are or have been used, which is what slows down probing.
+        std::atomic<size_t> used{0};
+    };
+
+    // Keeps the table a lookup loads from being freed until it is destroyed.
+    //
+    // Lookups count themselves in the reader count of the current epoch. To
+    // free a table, it is replaced first, then the epoch is advanced and the
+    // thread waits for the reader count of the previous epoch to drop to 0.
+    class ReadGuard {
+       public:
+        explicit ReadGuard(const BoxedHandleReverseMap& map) : mReaders(map.enterRead()) {}
+        ~ReadGuard() { mReaders.fetch_sub(1, std::memory_order_release); }
+
+       private:
+        std::atomic<uint32_t>& mReaders;
+    };
+
+    static size_t hash(uint64_t key) {
+        // Driver handles are mostly aligned pointers.
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 20);
+    }
+
+    std::atomic<uint32_t>& enterRead() const {
+        for (;;) {
+            const uint32_t epoch = mEpoch.load(std::memory_order_seq_cst);
+            std::atomic<uint32_t>& readers = mReaders[epoch & 1];
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            // Otherwise the thread moving the entries may have missed this
+            // reader and may be freeing the table.
+            if (mEpoch.load(std::memory_order_seq_cst) == epoch) return readers;
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // Runs |op| on the current table until it returns true, which it returns
+    // unless the table is full, and moves the entries once it is half used.
+    //
+    // Writers count themselves in |mWriters| rather than as readers: moving
+    // the entries waits for all of them before replacing the table, and keeps
+    // new ones out until then.
+    template <class Op>
+    void write(Op&& op) {
+        for (;;) {
+            Table* table = nullptr;
+            bool done = false;
+            bool halfUsed = false;
+            mWriters.fetch_add(1, std::memory_order_seq_cst);
+            const bool moving = mMoving.load(std::memory_order_seq_cst);
+            if (!moving) {
+                table = mTable.load(std::memory_order_acquire);
+                done = op(*table);
+                halfUsed = table->used.load(std::memory_order_relaxed) > table->capacity() / 2;
+            }
+            mWriters.fetch_sub(1, std::memory_order_release);
+
+            if (moving) {
+                // Waits for the move to complete.
+                android::base::AutoLock lock(mMoveLock);
+                continue;
+            }
+            if (!done || halfUsed) {
+                moveEntries(table);
+            }
+            if (done) return;
+        }
+    }
+
+    void moveEntries(Table* table) {
+        android::base::AutoLock lock(mMoveLock);
+        // Only this function frees tables, so |table| is only used if it is
+        // still the current one.
+        if (mTable.load(std::memory_order_relaxed) != table) return;
+
+        mMoving.store(true, std::memory_order_seq_cst);
+        while (mWriters.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+
+        auto isLive = [](const Entry& entry) {
+            const uint64_t key = entry.key.load(std::memory_order_relaxed);
+            return key != kEmptyKey && key != kErasedKey &&
+                   entry.value.load(std::memory_order_relaxed) != 0;
+        };
+        size_t live = 0;
+        for (size_t i = 0; i < table->capacity(); ++i) {
+            if (isLive(table->entries[i])) ++live;
+        }
+        // Leaves room for as many inserts as there are live entries before
+        // the next move.
+        size_t capacity = kInitialCapacity;
+        while (capacity < live * 4) capacity *= 2;
+
+        Table* moved = new Table(capacity);
+        for (size_t i = 0; i < table->capacity(); ++i) {
+            const Entry& entry = table->entries[i];
+            if (!isLive(entry)) continue;
+            const uint64_t key = entry.key.load(std::memory_order_relaxed);
+            size_t j = hash(key) & moved->mask;
+            while (moved->entries[j].key.load(std::memory_order_relaxed) != kEmptyKey) {
+                j = (j + 1) & moved->mask;
+            }
+            moved->entries[j].key.store(key, std::memory_order_relaxed);
+            moved->entries[j].value.store(entry.value.load(std::memory_order_relaxed),
+                                          std::memory_order_relaxed);
+        }
+        moved->used.store(live, std::memory_order_relaxed);
+        mTable.store(moved, std::memory_order_seq_cst);
+        mMoving.store(false, std::memory_order_release);
+
+        const uint32_t epoch = mEpoch.fetch_add(1, std::memory_order_seq_cst);
+        while (mReaders[epoch & 1].load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+        delete table;
+    }
+
+    std::atomic<Table*> mTable{nullptr};
+    mutable std::atomic<uint32_t> mEpoch{0};
+    mutable std::array<std::atomic<uint32_t>, 2> mReaders = {};
+    std::atomic<uint32_t> mWriters{0};
+    std::atomic<bool> mMoving{false};
+    android::base::Lock mMoveLock;
+};
+
+}  // namespace vk
+}  // namespace gfxstream
@@ -0,0 +1,83 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Boxed handle creation and destruction from several render threads, with the
+// entity manager and the reverse map behind one lock as they used to be
+// ("Locked"), and with BoxedHandleStore and BoxedHandleReverseMap.
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+#include <unordered_map>
+
+#include "BoxedHandleStore.h"
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+struct TestItem {
+    uint64_t underlying = 0;
+};
+
+constexpr size_t kTestType = 3;
+
+// Like a driver, each thread reuses a small set of underlying handles.
+uint64_t underlyingHandle(int thread, uint64_t i) {
+    return ((uint64_t(thread) << 20) | ((i % 1024) + 1)) * 0x40;
+}
+
+void BM_ChurnLocked(benchmark::State& state) {
+    static std::mutex lock;
+    static std::unordered_map<uint64_t, TestItem> store;
+    static std::unordered_map<uint64_t, uint64_t> reverseMap;
+    static uint64_t nextHandle = 1;
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        const uint64_t unboxed = underlyingHandle(state.thread_index(), i++);
+        uint64_t handle;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            handle = nextHandle++;
+            store[handle] = TestItem{unboxed};
+            reverseMap[unboxed] = handle;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        reverseMap.erase(store[handle].underlying);
+        store.erase(handle);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChurnLocked)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_ChurnLockFree(benchmark::State& state) {
+    static BoxedHandleStore<TestItem> store;
+    static BoxedHandleReverseMap reverseMap;
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        const uint64_t unboxed = underlyingHandle(state.thread_index(), i++);
+        const uint64_t handle = store.add(TestItem{unboxed}, kTestType);
+        reverseMap.set(unboxed, handle);
+        reverseMap.erase(store.get(handle)->underlying, handle);
+        store.remove(handle);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChurnLockFree)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
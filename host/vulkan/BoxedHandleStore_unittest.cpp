@@ -0,0 +1,246 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "BoxedHandleStore.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+struct TestItem {
+    uint64_t underlying = 0;
+};
+
+constexpr size_t kTestType = 3;
+
+TEST(BoxedHandleStoreTest, addGetRemove) {
+    BoxedHandleStore<TestItem> store;
+    uint64_t handle = store.add(TestItem{0x1000}, kTestType);
+    EXPECT_NE(0, handle);
+    EXPECT_EQ(kTestType, handle >> 48);
+    ASSERT_NE(nullptr, store.get(handle));
+    EXPECT_EQ(0x1000, store.get(handle)->underlying);
+
+    store.remove(handle);
+    EXPECT_EQ(nullptr, store.get(handle));
+
+    // The index gets reused, but not the handle.
+    uint64_t newHandle = store.add(TestItem{0x2000}, kTestType);
+    EXPECT_NE(handle, newHandle);
+    EXPECT_EQ(handle & 0xffffffff, newHandle & 0xffffffff);
+    EXPECT_EQ(nullptr, store.get(handle));
+    EXPECT_EQ(0x2000, store.get(newHandle)->underlying);
+}
+
+TEST(BoxedHandleStoreTest, manyLiveHandles) {
+    // Well past the 16000 handles the previous store could track without
+    // falling back to a std::map.
+    constexpr uint64_t kNumHandles = 100000;
+    BoxedHandleStore<TestItem> store;
+    std::vector<uint64_t> handles;
+    for (uint64_t i = 1; i <= kNumHandles; ++i) {
+        handles.push_back(store.add(TestItem{i}, kTestType));
+    }
+    std::unordered_set<uint64_t> uniqueHandles(handles.begin(), handles.end());
+    EXPECT_EQ(kNumHandles, uniqueHandles.size());
+    for (uint64_t i = 0; i < kNumHandles; ++i) {
+        ASSERT_NE(nullptr, store.get(handles[i]));
+        EXPECT_EQ(i + 1, store.get(handles[i])->underlying);
+    }
+}
+
+TEST(BoxedHandleStoreTest, addFixed) {
+    BoxedHandleStore<TestItem> store;
+    uint64_t handle = store.add(TestItem{0x1000}, kTestType);
+    store.clear();
+    EXPECT_EQ(nullptr, store.get(handle));
+
+    // Like a handle restored from a snapshot.
+    uint64_t fixedHandle = (uint64_t(kTestType) << 48) | (uint64_t(7) << 32) | 20000;
+    EXPECT_EQ(fixedHandle, store.addFixed(fixedHandle, TestItem{0x2000}, kTestType));
+    ASSERT_NE(nullptr, store.get(fixedHandle));
+    EXPECT_EQ(0x2000, store.get(fixedHandle)->underlying);
+
+    // New handles don't collide with restored ones.
+    uint64_t newHandle = store.add(TestItem{0x3000}, kTestType);
+    EXPECT_NE(fixedHandle & 0xffffffff, newHandle & 0xffffffff);
+    EXPECT_EQ(0x2000, store.get(fixedHandle)->underlying);
+}
+
+// Like vkResetFences, which destroys a fence and recreates it under the same
+// boxed handle.
+TEST(BoxedHandleStoreTest, addFixedAfterRemove) {
+    BoxedHandleStore<TestItem> store;
+    uint64_t otherHandle = store.add(TestItem{0x1000}, kTestType);
+    uint64_t handle = store.add(TestItem{0x2000}, kTestType);
+    store.remove(otherHandle);
+    store.remove(handle);
+
+    EXPECT_EQ(handle, store.addFixed(handle, TestItem{0x3000}, kTestType));
+
+    // add() reuses the other free index, and then a new one, but never the
+    // restored one.
+    uint64_t newHandle = store.add(TestItem{0x4000}, kTestType);
+    EXPECT_EQ(otherHandle & 0xffffffff, newHandle & 0xffffffff);
+    uint64_t anotherHandle = store.add(TestItem{0x5000}, kTestType);
+    EXPECT_NE(handle & 0xffffffff, anotherHandle & 0xffffffff);
+    ASSERT_NE(nullptr, store.get(handle));
+    EXPECT_EQ(0x3000, store.get(handle)->underlying);
+    EXPECT_EQ(0x4000, store.get(newHandle)->underlying);
+    EXPECT_EQ(0x5000, store.get(anotherHandle)->underlying);
+}
+
+TEST(BoxedHandleStoreTest, concurrentAddRemove) {
+    constexpr uint32_t kNumThreads = 8;
+    constexpr uint32_t kNumIterations = 20000;
+    BoxedHandleStore<TestItem> store;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&store, t] {
+            std::vector<uint64_t> live;
+            for (uint32_t i = 0; i < kNumIterations; ++i) {
+                const uint64_t underlying = (uint64_t(t) << 32) | i;
+                const uint64_t handle = store.add(TestItem{underlying}, kTestType);
+                live.push_back(handle);
+                if (i % 3 == 2) {
+                    // Nobody else can have taken over the handles we own.
+                    for (uint64_t liveHandle : live) {
+                        ASSERT_NE(nullptr, store.get(liveHandle));
+                        ASSERT_EQ(t, store.get(liveHandle)->underlying >> 32);
+                        store.remove(liveHandle);
+                    }
+                    live.clear();
+                }
+            }
+            for (uint64_t liveHandle : live) {
+                store.remove(liveHandle);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(BoxedHandleReverseMapTest, setGetErase) {
+    BoxedHandleReverseMap reverseMap;
+    EXPECT_EQ(0, reverseMap.get(0x1000));
+
+    reverseMap.set(0x1000, 0xaaaa);
+    EXPECT_EQ(0xaaaa, reverseMap.get(0x1000));
+
+    reverseMap.set(0x1000, 0xbbbb);
+    EXPECT_EQ(0xbbbb, reverseMap.get(0x1000));
+
+    // A stale boxed handle doesn't erase the current mapping.
+    reverseMap.erase(0x1000, 0xaaaa);
+    EXPECT_EQ(0xbbbb, reverseMap.get(0x1000));
+
+    reverseMap.erase(0x1000, 0xbbbb);
+    EXPECT_EQ(0, reverseMap.get(0x1000));
+
+    reverseMap.set(0x1000, 0xcccc);
+    EXPECT_EQ(0xcccc, reverseMap.get(0x1000));
+}
+
+TEST(BoxedHandleReverseMapTest, growsPastInitialCapacity) {
+    constexpr uint64_t kNumHandles = 100000;
+    BoxedHandleReverseMap reverseMap;
+    for (uint64_t i = 1; i <= kNumHandles; ++i) {
+        reverseMap.set(i * 0x40, i);
+    }
+    for (uint64_t i = 1; i <= kNumHandles; ++i) {
+        ASSERT_EQ(i, reverseMap.get(i * 0x40));
+    }
+    for (uint64_t i = 1; i <= kNumHandles; i += 2) {
+        reverseMap.erase(i * 0x40, i);
+    }
+    for (uint64_t i = 1; i <= kNumHandles; ++i) {
+        ASSERT_EQ(i % 2 ? 0 : i, reverseMap.get(i * 0x40));
+    }
+
+    reverseMap.clear();
+    EXPECT_EQ(0, reverseMap.get(0x80));
+}
+
+TEST(BoxedHandleReverseMapTest, concurrentChurn) {
+    constexpr uint32_t kNumThreads = 8;
+    constexpr uint32_t kNumIterations = 50000;
+    BoxedHandleReverseMap reverseMap;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&reverseMap, t] {
+            for (uint32_t i = 0; i < kNumIterations; ++i) {
+                // Like a driver, reuse a small set of underlying handles.
+                const uint64_t unboxed = ((uint64_t(t) << 16) | ((i % 512) + 1)) * 0x40;
+                const uint64_t boxed = (uint64_t(t) << 32) | (i + 1);
+                reverseMap.set(unboxed, boxed);
+                ASSERT_EQ(boxed, reverseMap.get(unboxed));
+                reverseMap.erase(unboxed, boxed);
+                ASSERT_EQ(0, reverseMap.get(unboxed));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Handles that are created and destroyed over and over, with only a few alive
+// at once, leave erased slots behind; they must not make the map keep growing.
+TEST(BoxedHandleReverseMapTest, churnKeepsCapacityBounded) {
+    constexpr uint32_t kNumThreads = 4;
+    constexpr uint64_t kNumLivePerThread = 250;
+    constexpr uint64_t kNumIterations = 500000;
+    BoxedHandleReverseMap reverseMap;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&reverseMap, t] {
+            // Never reuses an underlying handle, so that no erased slot is
+            // reused either.
+            auto unboxedOf = [t](uint64_t i) { return ((i << 4) | t) * 0x40 + 0x40; };
+            for (uint64_t i = 0; i < kNumIterations; ++i) {
+                reverseMap.set(unboxedOf(i), i + 1);
+                if (i >= kNumLivePerThread) {
+                    const uint64_t erased = i - kNumLivePerThread;
+                    reverseMap.erase(unboxedOf(erased), erased + 1);
+                    ASSERT_EQ(0, reverseMap.get(unboxedOf(erased)));
+                }
+            }
+            for (uint64_t i = kNumIterations - kNumLivePerThread; i < kNumIterations; ++i) {
+                ASSERT_EQ(i + 1, reverseMap.get(unboxedOf(i)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // At most 4 slots per live handle, or the initial capacity.
+    EXPECT_LE(reverseMap.getCapacityForTesting(),
+              std::max<size_t>(4096, 8 * kNumThreads * kNumLivePerThread));
+}
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
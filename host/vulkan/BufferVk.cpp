@@ -37,8 +37,8 @@ BufferVk::~BufferVk() {
     }
 }
 
-void BufferVk::readToBytes(uint64_t offset, uint64_t size, void* outBytes) {
-    readBufferToBytes(mHandle, offset, size, outBytes);
+bool BufferVk::readToBytes(uint64_t offset, uint64_t size, void* outBytes) {
+    return readBufferToBytes(mHandle, offset, size, outBytes);
 }
 
 bool BufferVk::updateFromBytes(uint64_t offset, uint64_t size, const void* bytes) {
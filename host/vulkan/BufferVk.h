@@ -24,7 +24,7 @@ class BufferVk {
 
     ~BufferVk();
 
-    void readToBytes(uint64_t offset, uint64_t size, void* outBytes);
+    bool readToBytes(uint64_t offset, uint64_t size, void* outBytes);
 
     bool updateFromBytes(uint64_t offset, uint64_t size, const void* bytes);
 
@@ -41,6 +41,15 @@ ColorBufferVk::~ColorBufferVk() {
     }
 }
 
+bool ColorBufferVk::getContentsSize(std::size_t* outNumBytes) {
+    VkDeviceSize size = 0;
+    if (!getColorBufferTransferSize(mHandle, &size)) {
+        return false;
+    }
+    *outNumBytes = static_cast<std::size_t>(size);
+    return true;
+}
+
 bool ColorBufferVk::readToBytes(std::vector<uint8_t>* outBytes) {
     return readColorBufferToBytes(mHandle, outBytes);
 }
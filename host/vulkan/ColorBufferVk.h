@@ -30,6 +30,9 @@ class ColorBufferVk {
 
     ~ColorBufferVk();
 
+    // The size of the whole contents, which the bytes read and updated from are a part of.
+    bool getContentsSize(std::size_t* outNumBytes);
+
     bool readToBytes(std::vector<uint8_t>* outBytes);
     bool readToBytes(uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* outBytes);
 
@@ -0,0 +1,217 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "PersistentPipelineCache.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "host-common/logging.h"
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+// How often to save the cache while pipelines are being created. Getting the contents of the cache
+// copies all of it, so this shouldn't be much more often.
+constexpr std::chrono::seconds kSaveInterval(5);
+
+// Identifies the physical device and driver whose pipelines the cache holds.
+std::string makeKey(const VkPhysicalDeviceProperties& properties) {
+    std::string key = "vk_pipeline_cache";
+    key.append(reinterpret_cast<const char*>(&properties.vendorID), sizeof(properties.vendorID));
+    key.append(reinterpret_cast<const char*>(&properties.deviceID), sizeof(properties.deviceID));
+    key.append(reinterpret_cast<const char*>(&properties.driverVersion),
+               sizeof(properties.driverVersion));
+    key.append(reinterpret_cast<const char*>(properties.pipelineCacheUUID), VK_UUID_SIZE);
+    return key;
+}
+
+// Drivers are supposed to reject the data of another device, but not all of them check.
+bool isCompatible(const std::vector<uint8_t>& data, const VkPhysicalDeviceProperties& properties) {
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<uint8_t> getCacheData(VkDevice device, const VulkanDispatch* vk,
+                                  VkPipelineCache cache) {
+    std::vector<uint8_t> data;
+    size_t size = 0;
+    if (vk->vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS) {
+        return data;
+    }
+    data.resize(size);
+    // VK_INCOMPLETE if the cache grew meanwhile, in which case what fits is still valid.
+    if (vk->vkGetPipelineCacheData(device, cache, &size, data.data()) < 0) {
+        size = 0;
+    }
+    data.resize(size);
+    return data;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<PersistentPipelineCache> PersistentPipelineCache::create(
+    VkDevice device, const VulkanDispatch* vk, const VkPhysicalDeviceProperties& properties,
+    PersistentBlobCache* store) {
+    std::string key = makeKey(properties);
+
+    std::vector<uint8_t> data(store->get(key.data(), key.size(), nullptr, 0));
+    if (!data.empty() && store->get(key.data(), key.size(), data.data(), data.size()) !=
+                             data.size()) {
+        // Replaced by a different size meanwhile.
+        data.clear();
+    }
+    if (!data.empty() && !isCompatible(data, properties)) {
+        WARN("Ignoring an incompatible pipeline cache of %zu bytes.", data.size());
+        data.clear();
+    }
+
+    VkPipelineCacheCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.data(),
+    };
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    VkResult result = vk->vkCreatePipelineCache(device, &createInfo, nullptr, &cache);
+    if (result != VK_SUCCESS && !data.empty()) {
+        WARN("Failed to load a pipeline cache of %zu bytes: %d.", data.size(), result);
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        result = vk->vkCreatePipelineCache(device, &createInfo, nullptr, &cache);
+    }
+    if (result != VK_SUCCESS) {
+        WARN("Failed to create a pipeline cache: %d.", result);
+        return nullptr;
+    }
+    return std::unique_ptr<PersistentPipelineCache>(
+        new PersistentPipelineCache(device, vk, std::move(key), store, cache));
+}
+
+PersistentPipelineCache::PersistentPipelineCache(VkDevice device, const VulkanDispatch* vk,
+                                                 std::string key, PersistentBlobCache* store,
+                                                 VkPipelineCache cache)
+    : mDevice(device),
+      mVk(vk),
+      mKey(std::move(key)),
+      mStore(store),
+      mCache(cache),
+      mLastSave(std::chrono::steady_clock::now()) {}
+
+PersistentPipelineCache::~PersistentPipelineCache() {
+    save();
+    mVk->vkDestroyPipelineCache(mDevice, mCache, nullptr);
+}
+
+VkResult PersistentPipelineCache::createGuestCache(const VkPipelineCacheCreateInfo* pCreateInfo,
+                                                   const VkAllocationCallbacks* pAllocator,
+                                                   VkPipelineCache* pPipelineCache) {
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    if (pCreateInfo->initialDataSize == 0) {
+        const std::vector<uint8_t> data = getCacheData(mDevice, mVk, mCache);
+        if (!data.empty()) {
+            VkPipelineCacheCreateInfo seededCreateInfo = *pCreateInfo;
+            seededCreateInfo.initialDataSize = data.size();
+            seededCreateInfo.pInitialData = data.data();
+            result =
+                mVk->vkCreatePipelineCache(mDevice, &seededCreateInfo, pAllocator, pPipelineCache);
+        }
+    }
+    const bool seeded = result == VK_SUCCESS;
+    if (!seeded) {
+        result = mVk->vkCreatePipelineCache(mDevice, pCreateInfo, pAllocator, pPipelineCache);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!seeded && pCreateInfo->initialDataSize != 0) {
+        mVk->vkMergePipelineCaches(mDevice, *pPipelineCache, 1, &mCache);
+    }
+    // Caches the guest synchronizes itself can't be merged from while the guest may use them.
+    if (!(pCreateInfo->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT_EXT)) {
+        mPendingMerges.insert(*pPipelineCache);
+        // The guest's own data may hold pipelines this cache doesn't.
+        mDirty |= pCreateInfo->initialDataSize != 0;
+    }
+    return result;
+}
+
+void PersistentPipelineCache::onGuestCacheDestroyed(VkPipelineCache guestCache) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPendingMerges.count(guestCache)) {
+        mergeIntoCacheLocked(1, &guestCache);
+        mPendingMerges.erase(guestCache);
+    }
+}
+
+PersistentPipelineCache::ScopedUse PersistentPipelineCache::onCreatePipelines(
+    VkPipelineCache guestCache) {
+    bool saveDue = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDirty = true;
+        saveDue = std::chrono::steady_clock::now() - mLastSave >= kSaveInterval;
+    }
+    if (saveDue) {
+        save();
+    }
+    if (guestCache != VK_NULL_HANDLE) {
+        return ScopedUse(guestCache, {});
+    }
+    return ScopedUse(mCache, std::shared_lock<std::shared_mutex>(mCacheMutex));
+}
+
+void PersistentPipelineCache::save() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLastSave = std::chrono::steady_clock::now();
+    if (!mDirty) {
+        return;
+    }
+    mDirty = false;
+    mergeLocked();
+    const std::vector<uint8_t> data = getCacheData(mDevice, mVk, mCache);
+    if (!data.empty()) {
+        mStore->set(mKey.data(), mKey.size(), data.data(), data.size());
+    }
+}
+
+void PersistentPipelineCache::mergeLocked() {
+    if (mPendingMerges.empty()) {
+        return;
+    }
+    const std::vector<VkPipelineCache> srcCaches(mPendingMerges.begin(), mPendingMerges.end());
+    mergeIntoCacheLocked(srcCaches.size(), srcCaches.data());
+}
+
+void PersistentPipelineCache::mergeIntoCacheLocked(uint32_t srcCacheCount,
+                                                   const VkPipelineCache* srcCaches) {
+    std::unique_lock<std::shared_mutex> cacheLock(mCacheMutex);
+    VkResult result = mVk->vkMergePipelineCaches(mDevice, mCache, srcCacheCount, srcCaches);
+    if (result != VK_SUCCESS) {
+        WARN("Failed to merge %u pipeline caches: %d.", srcCacheCount, result);
+    }
+}
+
+}  // namespace vk
+}  // namespace gfxstream
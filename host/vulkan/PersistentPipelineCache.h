@@ -0,0 +1,105 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+
+#include "PersistentBlobCache.h"
+#include "vulkan/cereal/common/goldfish_vk_dispatch.h"
+
+namespace gfxstream {
+namespace vk {
+
+// A VkPipelineCache which the host keeps for a device, so that the pipelines of every guest
+// process, and of every run when the store is persisted, are compiled once per driver.
+//
+// The cache is loaded from the store, keyed by the physical device and its pipeline cache UUID,
+// when the device is created. It seeds the guest's pipeline caches and is used for the pipelines
+// the guest creates without one. What gets added to the guest's caches is merged back into it,
+// and it is saved to the store every few seconds while pipelines are being created, and when the
+// device is destroyed. The store then writes the file in the background.
+//
+// It is safe to use from any thread. Vulkan requires the destination of a merge to be externally
+// synchronized, so merging into the cache waits for the pipelines being created with it.
+class PersistentPipelineCache {
+   public:
+    // The cache to create pipelines with. Nothing is merged into the host cache while it is alive.
+    class ScopedUse {
+       public:
+        VkPipelineCache handle() const { return mHandle; }
+
+       private:
+        friend class PersistentPipelineCache;
+
+        ScopedUse(VkPipelineCache handle, std::shared_lock<std::shared_mutex> lock)
+            : mHandle(handle), mLock(std::move(lock)) {}
+
+        VkPipelineCache mHandle;
+        std::shared_lock<std::shared_mutex> mLock;
+    };
+
+    static std::unique_ptr<PersistentPipelineCache> create(
+        VkDevice device, const VulkanDispatch* vk, const VkPhysicalDeviceProperties& properties,
+        PersistentBlobCache* store);
+
+    // Saves the cache and destroys it. Must happen before the device is.
+    ~PersistentPipelineCache();
+
+    VkPipelineCache handle() const { return mCache; }
+
+    // Creates a guest pipeline cache, seeded with the contents of this one.
+    VkResult createGuestCache(const VkPipelineCacheCreateInfo* pCreateInfo,
+                              const VkAllocationCallbacks* pAllocator,
+                              VkPipelineCache* pPipelineCache);
+    // Merges what |guestCache| holds before it gets destroyed.
+    void onGuestCacheDestroyed(VkPipelineCache guestCache);
+
+    // Picks the cache to create pipelines with, and saves the cache if it is due.
+    ScopedUse onCreatePipelines(VkPipelineCache guestCache);
+
+    // Merges the guest caches and saves the contents to the store.
+    void save();
+
+   private:
+    PersistentPipelineCache(VkDevice device, const VulkanDispatch* vk, std::string key,
+                            PersistentBlobCache* store, VkPipelineCache cache);
+
+    void mergeLocked();
+    void mergeIntoCacheLocked(uint32_t srcCacheCount, const VkPipelineCache* srcCaches);
+
+    const VkDevice mDevice;
+    const VulkanDispatch* const mVk;
+    const std::string mKey;
+    PersistentBlobCache* const mStore;
+    const VkPipelineCache mCache;
+
+    // Held shared while pipelines are created with |mCache|, and exclusively to merge into it.
+    std::shared_mutex mCacheMutex;
+    // Taken before |mCacheMutex|.
+    std::mutex mMutex;
+    // Guest caches which may hold pipelines this one doesn't.
+    std::unordered_set<VkPipelineCache> mPendingMerges;
+    bool mDirty = false;
+    std::chrono::steady_clock::time_point mLastSave;
+};
+
+}  // namespace vk
+}  // namespace gfxstream
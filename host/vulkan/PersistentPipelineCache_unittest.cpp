@@ -0,0 +1,292 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "PersistentPipelineCache.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+constexpr uint32_t kVendorId = 0x1234;
+constexpr uint32_t kDeviceId = 0x5678;
+
+// A pipeline cache of a fake driver, holding the ids of the pipelines created with it.
+struct FakeCache {
+    std::mutex mutex;
+    std::set<uint32_t> pipelines;
+    // Pipelines being created with the cache, which it must not be merged into meanwhile.
+    std::atomic<int> creating{0};
+};
+
+std::atomic<bool> sMergedWhileCreating{false};
+
+VkPhysicalDeviceProperties makeProperties(uint32_t deviceId = kDeviceId) {
+    VkPhysicalDeviceProperties properties = {};
+    properties.vendorID = kVendorId;
+    properties.deviceID = deviceId;
+    properties.driverVersion = 1;
+    memset(properties.pipelineCacheUUID, 0xab, VK_UUID_SIZE);
+    return properties;
+}
+
+FakeCache* fromHandle(VkPipelineCache cache) { return reinterpret_cast<FakeCache*>(cache); }
+
+VKAPI_ATTR VkResult VKAPI_CALL fakeCreatePipelineCache(VkDevice,
+                                                       const VkPipelineCacheCreateInfo* pCreateInfo,
+                                                       const VkAllocationCallbacks*,
+                                                       VkPipelineCache* pPipelineCache) {
+    auto* cache = new FakeCache;
+    VkPipelineCacheHeaderVersionOne header;
+    if (pCreateInfo->initialDataSize >= sizeof(header)) {
+        memcpy(&header, pCreateInfo->pInitialData, sizeof(header));
+        const auto* ids = reinterpret_cast<const uint8_t*>(pCreateInfo->pInitialData) +
+                          sizeof(header);
+        for (size_t i = 0; i < (pCreateInfo->initialDataSize - sizeof(header)) / sizeof(uint32_t);
+             i++) {
+            uint32_t id;
+            memcpy(&id, ids + i * sizeof(uint32_t), sizeof(id));
+            cache->pipelines.insert(id);
+        }
+    }
+    *pPipelineCache = reinterpret_cast<VkPipelineCache>(cache);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL fakeDestroyPipelineCache(VkDevice, VkPipelineCache pipelineCache,
+                                                    const VkAllocationCallbacks*) {
+    delete fromHandle(pipelineCache);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL fakeGetPipelineCacheData(VkDevice, VkPipelineCache pipelineCache,
+                                                        size_t* pDataSize, void* pData) {
+    FakeCache* cache = fromHandle(pipelineCache);
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    const VkPhysicalDeviceProperties properties = makeProperties();
+    VkPipelineCacheHeaderVersionOne header = {
+        .headerSize = sizeof(VkPipelineCacheHeaderVersionOne),
+        .headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE,
+        .vendorID = properties.vendorID,
+        .deviceID = properties.deviceID,
+    };
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    std::vector<uint8_t> data(sizeof(header));
+    memcpy(data.data(), &header, sizeof(header));
+    for (uint32_t id : cache->pipelines) {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&id);
+        data.insert(data.end(), bytes, bytes + sizeof(id));
+    }
+
+    if (!pData) {
+        *pDataSize = data.size();
+        return VK_SUCCESS;
+    }
+    const size_t size = std::min(*pDataSize, data.size());
+    memcpy(pData, data.data(), size);
+    *pDataSize = size;
+    return size < data.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL fakeMergePipelineCaches(VkDevice, VkPipelineCache dstCache,
+                                                       uint32_t srcCacheCount,
+                                                       const VkPipelineCache* pSrcCaches) {
+    FakeCache* dst = fromHandle(dstCache);
+    if (dst->creating.load() != 0) {
+        sMergedWhileCreating = true;
+    }
+    for (uint32_t i = 0; i < srcCacheCount; i++) {
+        FakeCache* src = fromHandle(pSrcCaches[i]);
+        std::set<uint32_t> pipelines;
+        {
+            std::lock_guard<std::mutex> lock(src->mutex);
+            pipelines = src->pipelines;
+        }
+        std::lock_guard<std::mutex> lock(dst->mutex);
+        dst->pipelines.insert(pipelines.begin(), pipelines.end());
+    }
+    if (dst->creating.load() != 0) {
+        sMergedWhileCreating = true;
+    }
+    return VK_SUCCESS;
+}
+
+// Creates a pipeline with the cache |onCreatePipelines()| picks.
+void createPipeline(PersistentPipelineCache& hostCache, VkPipelineCache guestCache, uint32_t id,
+                    std::chrono::microseconds duration = std::chrono::microseconds(0)) {
+    const PersistentPipelineCache::ScopedUse use = hostCache.onCreatePipelines(guestCache);
+    FakeCache* cache = fromHandle(use.handle());
+    cache->creating++;
+    std::this_thread::sleep_for(duration);
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->pipelines.insert(id);
+    }
+    cache->creating--;
+}
+
+bool holdsPipeline(VkPipelineCache cache, uint32_t id) {
+    std::lock_guard<std::mutex> lock(fromHandle(cache)->mutex);
+    return fromHandle(cache)->pipelines.count(id) != 0;
+}
+
+class PersistentPipelineCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        std::random_device random;
+        mDir = std::filesystem::temp_directory_path() /
+               ("PersistentPipelineCacheTest-" + std::to_string(random()));
+        std::filesystem::create_directories(mDir);
+
+        mVk.vkCreatePipelineCache = fakeCreatePipelineCache;
+        mVk.vkDestroyPipelineCache = fakeDestroyPipelineCache;
+        mVk.vkGetPipelineCacheData = fakeGetPipelineCacheData;
+        mVk.vkMergePipelineCaches = fakeMergePipelineCaches;
+        sMergedWhileCreating = false;
+    }
+
+    void TearDown() override { std::filesystem::remove_all(mDir); }
+
+    std::unique_ptr<PersistentBlobCache> createStore() {
+        PersistentBlobCache::Options options;
+        options.directory = mDir.string();
+        options.name = "pipelines";
+        options.identity = "driver 1.0";
+        options.writebackDelay = std::chrono::milliseconds(10);
+        return std::make_unique<PersistentBlobCache>(options);
+    }
+
+    std::unique_ptr<PersistentPipelineCache> create(
+        PersistentBlobCache* store, const VkPhysicalDeviceProperties& properties = makeProperties()) {
+        return PersistentPipelineCache::create(mDevice, &mVk, properties, store);
+    }
+
+    VkPipelineCache createGuestCache(PersistentPipelineCache& hostCache) {
+        const VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        };
+        VkPipelineCache guestCache = VK_NULL_HANDLE;
+        EXPECT_EQ(VK_SUCCESS, hostCache.createGuestCache(&createInfo, nullptr, &guestCache));
+        return guestCache;
+    }
+
+    void destroyGuestCache(PersistentPipelineCache& hostCache, VkPipelineCache guestCache) {
+        hostCache.onGuestCacheDestroyed(guestCache);
+        fakeDestroyPipelineCache(mDevice, guestCache, nullptr);
+    }
+
+    std::filesystem::path mDir;
+    VulkanDispatch mVk = {};
+    const VkDevice mDevice = reinterpret_cast<VkDevice>(uintptr_t(0x1000));
+};
+
+TEST_F(PersistentPipelineCacheTest, MergesGuestCaches) {
+    auto store = createStore();
+    auto hostCache = create(store.get());
+    ASSERT_NE(nullptr, hostCache);
+
+    VkPipelineCache guestCache = createGuestCache(*hostCache);
+    createPipeline(*hostCache, guestCache, 1);
+    EXPECT_FALSE(holdsPipeline(hostCache->handle(), 1));
+
+    hostCache->save();
+    EXPECT_TRUE(holdsPipeline(hostCache->handle(), 1));
+
+    createPipeline(*hostCache, guestCache, 2);
+    destroyGuestCache(*hostCache, guestCache);
+    EXPECT_TRUE(holdsPipeline(hostCache->handle(), 2));
+
+    // New guest caches are seeded with what the others created.
+    VkPipelineCache otherGuestCache = createGuestCache(*hostCache);
+    EXPECT_TRUE(holdsPipeline(otherGuestCache, 1));
+    EXPECT_TRUE(holdsPipeline(otherGuestCache, 2));
+    destroyGuestCache(*hostCache, otherGuestCache);
+}
+
+TEST_F(PersistentPipelineCacheTest, PersistsAndReloads) {
+    {
+        auto store = createStore();
+        auto hostCache = create(store.get());
+        ASSERT_NE(nullptr, hostCache);
+        createPipeline(*hostCache, VK_NULL_HANDLE, 1);
+        VkPipelineCache guestCache = createGuestCache(*hostCache);
+        createPipeline(*hostCache, guestCache, 2);
+        destroyGuestCache(*hostCache, guestCache);
+        // Saves when destroyed, and the store writes the file when it is.
+        hostCache.reset();
+    }
+
+    auto store = createStore();
+    auto hostCache = create(store.get());
+    ASSERT_NE(nullptr, hostCache);
+    EXPECT_TRUE(holdsPipeline(hostCache->handle(), 1));
+    EXPECT_TRUE(holdsPipeline(hostCache->handle(), 2));
+}
+
+TEST_F(PersistentPipelineCacheTest, KeepsDevicesApart) {
+    {
+        auto store = createStore();
+        auto hostCache = create(store.get());
+        ASSERT_NE(nullptr, hostCache);
+        createPipeline(*hostCache, VK_NULL_HANDLE, 1);
+    }
+
+    auto store = createStore();
+    auto hostCache = create(store.get(), makeProperties(kDeviceId + 1));
+    ASSERT_NE(nullptr, hostCache);
+    EXPECT_FALSE(holdsPipeline(hostCache->handle(), 1));
+}
+
+// Merging into the host cache while pipelines are created with it is a data race in the driver.
+TEST_F(PersistentPipelineCacheTest, MergesWaitForPipelineCreation) {
+    constexpr uint32_t kNumPipelines = 200;
+    auto store = createStore();
+    auto hostCache = create(store.get());
+    ASSERT_NE(nullptr, hostCache);
+
+    std::thread creator([&] {
+        for (uint32_t i = 0; i < kNumPipelines; i++) {
+            createPipeline(*hostCache, VK_NULL_HANDLE, i, std::chrono::microseconds(100));
+        }
+    });
+    std::thread merger([&] {
+        for (uint32_t i = 0; i < kNumPipelines; i++) {
+            VkPipelineCache guestCache = createGuestCache(*hostCache);
+            createPipeline(*hostCache, guestCache, kNumPipelines + i);
+            if (i % 2) {
+                hostCache->save();
+            }
+            destroyGuestCache(*hostCache, guestCache);
+        }
+    });
+    creator.join();
+    merger.join();
+
+    EXPECT_FALSE(sMergedWhileCreating);
+    for (uint32_t i = 0; i < 2 * kNumPipelines; i++) {
+        EXPECT_TRUE(holdsPipeline(hostCache->handle(), i)) << i;
+    }
+}
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
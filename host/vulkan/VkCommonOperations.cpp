@@ -20,6 +20,9 @@
 #include <string.h>
 #include <vulkan/vk_enum_string_helper.h>
 
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <iomanip>
 #include <ostream>
 #include <sstream>
@@ -31,6 +34,7 @@
 #include "aemu/base/Tracing.h"
 #include "aemu/base/containers/Lookup.h"
 #include "aemu/base/containers/StaticMap.h"
+#include "aemu/base/synchronization/ConditionVariable.h"
 #include "aemu/base/synchronization/Lock.h"
 #include "aemu/base/system/System.h"
 #include "common/goldfish_vk_dispatch.h"
@@ -1098,38 +1102,6 @@ VkEmulation* createGlobalVkEmulation(VulkanDispatch* vk) {
                                              string_VkResult(poolCreateRes));
     }
 
-    VkCommandBufferAllocateInfo cbAi = {
-        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        0,
-        sVkEmulation->commandPool,
-        VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        1,
-    };
-
-    VkResult cbAllocRes =
-        dvk->vkAllocateCommandBuffers(sVkEmulation->device, &cbAi, &sVkEmulation->commandBuffer);
-
-    if (cbAllocRes != VK_SUCCESS) {
-        VK_EMU_INIT_RETURN_OR_ABORT_ON_ERROR(cbAllocRes,
-                                             "Failed to allocate command buffer. Error: %s.",
-                                             string_VkResult(cbAllocRes));
-    }
-
-    VkFenceCreateInfo fenceCi = {
-        VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        0,
-        0,
-    };
-
-    VkResult fenceCreateRes = dvk->vkCreateFence(sVkEmulation->device, &fenceCi, nullptr,
-                                                 &sVkEmulation->commandBufferFence);
-
-    if (fenceCreateRes != VK_SUCCESS) {
-        VK_EMU_INIT_RETURN_OR_ABORT_ON_ERROR(
-            fenceCreateRes, "Failed to create fence for command buffer. Error: %s.",
-            string_VkResult(fenceCreateRes));
-    }
-
     // At this point, the global emulation state's logical device can alloc
     // memory and send commands. However, it can't really do much yet to
     // communicate the results without the staging buffer. Set that up here.
@@ -1192,6 +1164,51 @@ VkEmulation* createGlobalVkEmulation(VulkanDispatch* vk) {
                                              string_VkResult(stagingBufferBindRes));
     }
 
+    // Slice offsets stay aligned as getFormatTransferChunks() expects, which
+    // also covers any nonCoherentAtomSize.
+    const VkDeviceSize stagingSliceSize = sVkEmulation->staging.size /
+                                          VkEmulation::kNumStagingSlices /
+                                          kFormatTransferChunkAlignment *
+                                          kFormatTransferChunkAlignment;
+    sVkEmulation->stagingSlices.resize(VkEmulation::kNumStagingSlices);
+    for (uint32_t i = 0; i < VkEmulation::kNumStagingSlices; ++i) {
+        VkEmulation::StagingSlice& slice = sVkEmulation->stagingSlices[i];
+        slice.offset = i * stagingSliceSize;
+        slice.size = stagingSliceSize;
+
+        VkCommandBufferAllocateInfo cbAi = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            0,
+            sVkEmulation->commandPool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1,
+        };
+
+        VkResult cbAllocRes =
+            dvk->vkAllocateCommandBuffers(sVkEmulation->device, &cbAi, &slice.commandBuffer);
+
+        if (cbAllocRes != VK_SUCCESS) {
+            VK_EMU_INIT_RETURN_OR_ABORT_ON_ERROR(cbAllocRes,
+                                                 "Failed to allocate command buffer. Error: %s.",
+                                                 string_VkResult(cbAllocRes));
+        }
+
+        VkFenceCreateInfo fenceCi = {
+            VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            0,
+            0,
+        };
+
+        VkResult fenceCreateRes =
+            dvk->vkCreateFence(sVkEmulation->device, &fenceCi, nullptr, &slice.fence);
+
+        if (fenceCreateRes != VK_SUCCESS) {
+            VK_EMU_INIT_RETURN_OR_ABORT_ON_ERROR(
+                fenceCreateRes, "Failed to create fence for command buffer. Error: %s.",
+                string_VkResult(fenceCreateRes));
+        }
+    }
+
     sVkEmulation->debugUtilsAvailableAndRequested = debugUtilsAvailableAndRequested;
     if (sVkEmulation->debugUtilsAvailableAndRequested) {
         sVkEmulation->debugUtilsHelper =
@@ -1286,11 +1303,11 @@ void teardownGlobalVkEmulation() {
 
     sVkEmulation->dvk->vkDestroyBuffer(sVkEmulation->device, sVkEmulation->staging.buffer, nullptr);
 
-    sVkEmulation->dvk->vkDestroyFence(sVkEmulation->device, sVkEmulation->commandBufferFence,
-                                      nullptr);
-
-    sVkEmulation->dvk->vkFreeCommandBuffers(sVkEmulation->device, sVkEmulation->commandPool, 1,
-                                            &sVkEmulation->commandBuffer);
+    for (auto& slice : sVkEmulation->stagingSlices) {
+        sVkEmulation->dvk->vkDestroyFence(sVkEmulation->device, slice.fence, nullptr);
+        sVkEmulation->dvk->vkFreeCommandBuffers(sVkEmulation->device, sVkEmulation->commandPool,
+                                                1, &slice.commandBuffer);
+    }
 
     sVkEmulation->dvk->vkDestroyCommandPool(sVkEmulation->device, sVkEmulation->commandPool,
                                             nullptr);
@@ -2127,6 +2144,146 @@ bool colorBufferNeedsUpdateBetweenGlAndVk(uint32_t colorBufferHandle) {
     return colorBufferNeedsUpdateBetweenGlAndVk(*colorBufferInfo);
 }
 
+namespace {
+
+constexpr uint64_t kStagingTransferMaxWaitNs = 5ULL * 1000ULL * 1000ULL * 1000ULL;
+
+// Signaled when a staging slice is released.
+android::base::ConditionVariable sStagingSliceAvailable;
+
+// The range of |slice| holding |size| bytes, for flushing and invalidating.
+VkMappedMemoryRange getStagingSliceMappedRange(const VkEmulation::StagingSlice& slice,
+                                               VkDeviceSize size) {
+    // nonCoherentAtomSize is at most 256 and divides the slice offsets and sizes.
+    constexpr VkDeviceSize kMaxNonCoherentAtomSize = 256;
+    return VkMappedMemoryRange{
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .pNext = nullptr,
+        .memory = sVkEmulation->staging.memory.memory,
+        .offset = slice.offset,
+        .size = std::min(slice.size, (size + kMaxNonCoherentAtomSize - 1) /
+                                         kMaxNonCoherentAtomSize * kMaxNonCoherentAtomSize),
+    };
+}
+
+uint8_t* getStagingSlicePtr(const VkEmulation::StagingSlice& slice) {
+    return static_cast<uint8_t*>(sVkEmulation->staging.memory.mappedPtr) + slice.offset;
+}
+
+// A transfer through the staging slices, split in chunks that each fit in a
+// slice. Chunks are submitted as soon as they are recorded and completed in
+// order, so that the CPU copies of a chunk overlap with the GPU copies of the
+// previous ones. sVkEmulationLock must be held; it is released while waiting
+// for fences so that transfers for other ColorBuffers and Buffers can proceed.
+class StagingTransfer {
+   public:
+    // Called without sVkEmulationLock once the GPU is done with a chunk.
+    using OnChunkComplete =
+        std::function<void(const VkEmulation::StagingSlice& slice, size_t chunkIndex)>;
+
+    explicit StagingTransfer(OnChunkComplete onChunkComplete = nullptr)
+        : mOnChunkComplete(std::move(onChunkComplete)) {}
+
+    ~StagingTransfer() { completeAll(); }
+
+    // Returns a slice to record the next chunk into. When all slices are
+    // taken, waits for the oldest chunk of this transfer or, if it has none in
+    // flight, for another transfer to release a slice. Transfers never wait on
+    // each other while holding slices, so this can't deadlock.
+    VkEmulation::StagingSlice* acquire() {
+        while (true) {
+            for (auto& slice : sVkEmulation->stagingSlices) {
+                if (!slice.inUse) {
+                    slice.inUse = true;
+                    return &slice;
+                }
+            }
+            if (!mInFlight.empty()) {
+                completeOldest();
+            } else {
+                sStagingSliceAvailable.wait(&sVkEmulationLock);
+            }
+        }
+    }
+
+    // Gives back a slice that was acquired but not submitted.
+    void release(VkEmulation::StagingSlice* slice) {
+        slice->inUse = false;
+        sStagingSliceAvailable.broadcast();
+    }
+
+    // Submits the commands recorded in the slice's command buffer.
+    void submit(VkEmulation::StagingSlice* slice, size_t chunkIndex) {
+        const VkSubmitInfo submitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreCount = 0,
+            .pWaitSemaphores = nullptr,
+            .pWaitDstStageMask = nullptr,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &slice->commandBuffer,
+            .signalSemaphoreCount = 0,
+            .pSignalSemaphores = nullptr,
+        };
+        {
+            android::base::AutoLock lock(*sVkEmulation->queueLock);
+            VK_CHECK(sVkEmulation->dvk->vkQueueSubmit(sVkEmulation->queue, 1, &submitInfo,
+                                                      slice->fence));
+        }
+        mInFlight.push_back({slice, chunkIndex});
+    }
+
+    void completeAll() {
+        while (!mInFlight.empty()) {
+            completeOldest();
+        }
+    }
+
+   private:
+    void completeOldest() {
+        auto [slice, chunkIndex] = mInFlight.front();
+        mInFlight.pop_front();
+
+        auto vk = sVkEmulation->dvk;
+        VkDevice device = sVkEmulation->device;
+        sVkEmulationLock.unlock();
+        VK_CHECK(vk->vkWaitForFences(device, 1, &slice->fence, VK_TRUE, kStagingTransferMaxWaitNs));
+        VK_CHECK(vk->vkResetFences(device, 1, &slice->fence));
+        if (mOnChunkComplete) {
+            mOnChunkComplete(*slice, chunkIndex);
+        }
+        sVkEmulationLock.lock();
+
+        release(slice);
+    }
+
+    OnChunkComplete mOnChunkComplete;
+    std::deque<std::pair<VkEmulation::StagingSlice*, size_t>> mInFlight;
+};
+
+}  // namespace
+
+bool getColorBufferTransferSize(uint32_t colorBufferHandle, VkDeviceSize* outSize) {
+    if (!sVkEmulation || !sVkEmulation->live) {
+        VK_COMMON_VERBOSE("VkEmulation not available.");
+        return false;
+    }
+
+    AutoLock lock(sVkEmulationLock);
+
+    auto colorBufferInfo = android::base::find(sVkEmulation->colorBuffers, colorBufferHandle);
+    if (!colorBufferInfo) {
+        VK_COMMON_VERBOSE("Failed to get ColorBuffer:%d transfer size, not found.",
+                          colorBufferHandle);
+        return false;
+    }
+
+    return getFormatTransferInfo(colorBufferInfo->imageCreateInfoShallow.format,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.width,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.height, outSize,
+                                 nullptr);
+}
+
 bool readColorBufferToBytes(uint32_t colorBufferHandle, std::vector<uint8_t>* bytes) {
     if (!sVkEmulation || !sVkEmulation->live) {
         VK_COMMON_VERBOSE("VkEmulation not available.");
@@ -2198,19 +2355,15 @@ bool readColorBufferToBytesLocked(uint32_t colorBufferHandle, uint32_t x, uint32
         return false;
     }
 
-    if (x != 0 || y != 0 || w != colorBufferInfo->imageCreateInfoShallow.extent.width ||
-        h != colorBufferInfo->imageCreateInfoShallow.extent.height) {
-        VK_COMMON_ERROR("Failed to read from ColorBuffer:%d, unhandled subrect.",
-                        colorBufferHandle);
-        return false;
-    }
-
-    VkDeviceSize bufferCopySize = 0;
-    std::vector<VkBufferImageCopy> bufferImageCopies;
-    if (!getFormatTransferInfo(colorBufferInfo->imageCreateInfoShallow.format,
-                               colorBufferInfo->imageCreateInfoShallow.extent.width,
-                               colorBufferInfo->imageCreateInfoShallow.extent.height,
-                               &bufferCopySize, &bufferImageCopies)) {
+    const VkRect2D rect = {
+        .offset = {.x = static_cast<int32_t>(x), .y = static_cast<int32_t>(y)},
+        .extent = {.width = w, .height = h},
+    };
+    std::vector<FormatTransferChunk> chunks;
+    if (!getFormatTransferChunks(colorBufferInfo->imageCreateInfoShallow.format,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.width,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.height, rect,
+                                 sVkEmulation->stagingSlices[0].size, &chunks)) {
         VK_COMMON_ERROR("Failed to read ColorBuffer:%d, unable to get transfer info.",
                         colorBufferHandle);
         return false;
@@ -2227,86 +2380,86 @@ bool readColorBufferToBytesLocked(uint32_t colorBufferHandle, uint32_t x, uint32
         colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
     }
 
-    // Record our synchronization commands.
-    const VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = nullptr,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
-
-    VkCommandBuffer commandBuffer = sVkEmulation->commandBuffer;
-
-    VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
+    StagingTransfer transfer([&chunks, outPixels, vk](const VkEmulation::StagingSlice& slice,
+                                                      size_t chunkIndex) {
+        const FormatTransferChunk& chunk = chunks[chunkIndex];
+        const VkMappedMemoryRange toInvalidate =
+            getStagingSliceMappedRange(slice, chunk.stagingSize);
+        VK_CHECK(vk->vkInvalidateMappedMemoryRanges(sVkEmulation->device, 1, &toInvalidate));
 
-    const VkImageMemoryBarrier toTransferSrcImageBarrier = {
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
-        .oldLayout = colorBufferInfo->currentLayout,
-        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = colorBufferInfo->image,
-        .subresourceRange =
-            {
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
-            },
-    };
+        const uint8_t* stagingPtr = getStagingSlicePtr(slice);
+        for (const FormatTransferPiece& piece : chunk.pieces) {
+            std::memcpy(static_cast<uint8_t*>(outPixels) + piece.contentsOffset,
+                        stagingPtr + piece.bufferImageCopy.bufferOffset, piece.size);
+        }
+    });
 
-    vk->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &toTransferSrcImageBarrier);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        VkEmulation::StagingSlice* slice = transfer.acquire();
 
-    colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        // The lock may have been released to wait for a slice.
+        colorBufferInfo = android::base::find(sVkEmulation->colorBuffers, colorBufferHandle);
+        if (!colorBufferInfo) {
+            VK_COMMON_ERROR("Failed to read from ColorBuffer:%d, destroyed during the read.",
+                            colorBufferHandle);
+            transfer.release(slice);
+            return false;
+        }
 
-    vk->vkCmdCopyImageToBuffer(commandBuffer, colorBufferInfo->image,
-                               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sVkEmulation->staging.buffer,
-                               bufferImageCopies.size(), bufferImageCopies.data());
+        // Record our synchronization commands.
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
 
-    VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
+        VkCommandBuffer commandBuffer = slice->commandBuffer;
 
-    const VkSubmitInfo submitInfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer,
-        .signalSemaphoreCount = 0,
-        .pSignalSemaphores = nullptr,
-    };
+        VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
-    {
-        android::base::AutoLock lock(*sVkEmulation->queueLock);
-        VK_CHECK(vk->vkQueueSubmit(sVkEmulation->queue, 1, &submitInfo,
-                                   sVkEmulation->commandBufferFence));
-    }
+        // Transfers for this ColorBuffer from other threads may still be in flight.
+        const VkImageMemoryBarrier toTransferSrcImageBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .oldLayout = colorBufferInfo->currentLayout,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = colorBufferInfo->image,
+            .subresourceRange =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+        };
 
-    static constexpr uint64_t ANB_MAX_WAIT_NS = 5ULL * 1000ULL * 1000ULL * 1000ULL;
+        vk->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                                 &toTransferSrcImageBarrier);
 
-    VK_CHECK(vk->vkWaitForFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence,
-                                 VK_TRUE, ANB_MAX_WAIT_NS));
+        colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
-    VK_CHECK(vk->vkResetFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence));
+        std::vector<VkBufferImageCopy> bufferImageCopies;
+        for (const FormatTransferPiece& piece : chunks[i].pieces) {
+            bufferImageCopies.push_back(piece.bufferImageCopy);
+            bufferImageCopies.back().bufferOffset += slice->offset;
+        }
+        vk->vkCmdCopyImageToBuffer(commandBuffer, colorBufferInfo->image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   sVkEmulation->staging.buffer, bufferImageCopies.size(),
+                                   bufferImageCopies.data());
 
-    const VkMappedMemoryRange toInvalidate = {
-        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        .pNext = nullptr,
-        .memory = sVkEmulation->staging.memory.memory,
-        .offset = 0,
-        .size = VK_WHOLE_SIZE,
-    };
+        VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
 
-    VK_CHECK(vk->vkInvalidateMappedMemoryRanges(sVkEmulation->device, 1, &toInvalidate));
+        transfer.submit(slice, i);
+    }
 
-    const auto* stagingBufferPtr = sVkEmulation->staging.memory.mappedPtr;
-    std::memcpy(outPixels, stagingBufferPtr, bufferCopySize);
+    transfer.completeAll();
 
     return true;
 }
@@ -2382,34 +2535,20 @@ bool updateColorBufferFromBytesLocked(uint32_t colorBufferHandle, uint32_t x, ui
         return false;
     }
 
-    if (x != 0 || y != 0 || w != colorBufferInfo->imageCreateInfoShallow.extent.width ||
-        h != colorBufferInfo->imageCreateInfoShallow.extent.height) {
-        VK_COMMON_ERROR("Failed to update ColorBuffer:%d, unhandled subrect.", colorBufferHandle);
-        return false;
-    }
-
-    VkDeviceSize bufferCopySize = 0;
-    std::vector<VkBufferImageCopy> bufferImageCopies;
-    if (!getFormatTransferInfo(colorBufferInfo->imageCreateInfoShallow.format,
-                               colorBufferInfo->imageCreateInfoShallow.extent.width,
-                               colorBufferInfo->imageCreateInfoShallow.extent.height,
-                               &bufferCopySize, &bufferImageCopies)) {
+    const VkRect2D rect = {
+        .offset = {.x = static_cast<int32_t>(x), .y = static_cast<int32_t>(y)},
+        .extent = {.width = w, .height = h},
+    };
+    std::vector<FormatTransferChunk> chunks;
+    if (!getFormatTransferChunks(colorBufferInfo->imageCreateInfoShallow.format,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.width,
+                                 colorBufferInfo->imageCreateInfoShallow.extent.height, rect,
+                                 sVkEmulation->stagingSlices[0].size, &chunks)) {
         VK_COMMON_ERROR("Failed to update ColorBuffer:%d, unable to get transfer info.",
                         colorBufferHandle);
         return false;
     }
 
-    const VkDeviceSize stagingBufferSize = sVkEmulation->staging.size;
-    if (bufferCopySize > stagingBufferSize) {
-        VK_COMMON_ERROR("Failed to update ColorBuffer:%d, transfer size %" PRIu64
-                        " too large for staging buffer size:%" PRIu64 ".",
-                        colorBufferHandle, bufferCopySize, stagingBufferSize);
-        return false;
-    }
-
-    auto* stagingBufferPtr = sVkEmulation->staging.memory.mappedPtr;
-    std::memcpy(stagingBufferPtr, pixels, bufferCopySize);
-
     // Avoid transitioning from VK_IMAGE_LAYOUT_UNDEFINED. Unfortunetly, Android does not
     // yet have a mechanism for sharing the expected VkImageLayout. However, the Vulkan
     // spec's image layout transition sections says "If the old layout is
@@ -2421,83 +2560,87 @@ bool updateColorBufferFromBytesLocked(uint32_t colorBufferHandle, uint32_t x, ui
         colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     }
 
-    // Record our synchronization commands.
-    const VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = nullptr,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
+    // The guest may access the ColorBuffer memory from its own device as soon
+    // as this returns, so all the chunks are waited for before returning.
+    StagingTransfer transfer;
 
-    VkCommandBuffer commandBuffer = sVkEmulation->commandBuffer;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        VkEmulation::StagingSlice* slice = transfer.acquire();
 
-    VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
-
-    const VkImageMemoryBarrier toTransferDstImageBarrier = {
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
-        .oldLayout = colorBufferInfo->currentLayout,
-        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = colorBufferInfo->image,
-        .subresourceRange =
-            {
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
-            },
-    };
+        // Copy to the staging buffer without blocking other transfers.
+        sVkEmulationLock.unlock();
+        uint8_t* stagingPtr = getStagingSlicePtr(*slice);
+        for (const FormatTransferPiece& piece : chunks[i].pieces) {
+            std::memcpy(stagingPtr + piece.bufferImageCopy.bufferOffset,
+                        static_cast<const uint8_t*>(pixels) + piece.contentsOffset, piece.size);
+        }
+        const VkMappedMemoryRange toFlush =
+            getStagingSliceMappedRange(*slice, chunks[i].stagingSize);
+        VK_CHECK(vk->vkFlushMappedMemoryRanges(sVkEmulation->device, 1, &toFlush));
+        sVkEmulationLock.lock();
+
+        colorBufferInfo = android::base::find(sVkEmulation->colorBuffers, colorBufferHandle);
+        if (!colorBufferInfo) {
+            VK_COMMON_ERROR("Failed to update ColorBuffer:%d, destroyed during the update.",
+                            colorBufferHandle);
+            transfer.release(slice);
+            return false;
+        }
 
-    vk->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &toTransferDstImageBarrier);
+        // Record our synchronization commands.
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
 
-    colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        VkCommandBuffer commandBuffer = slice->commandBuffer;
 
-    // Copy to staging buffer
-    vk->vkCmdCopyBufferToImage(commandBuffer, sVkEmulation->staging.buffer, colorBufferInfo->image,
-                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, bufferImageCopies.size(),
-                               bufferImageCopies.data());
+        VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
-    VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
+        // Transfers for this ColorBuffer from other threads may still be in flight.
+        const VkImageMemoryBarrier toTransferDstImageBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            .oldLayout = colorBufferInfo->currentLayout,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = colorBufferInfo->image,
+            .subresourceRange =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+        };
 
-    const VkSubmitInfo submitInfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer,
-        .signalSemaphoreCount = 0,
-        .pSignalSemaphores = nullptr,
-    };
+        vk->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                                 &toTransferDstImageBarrier);
 
-    {
-        android::base::AutoLock lock(*sVkEmulation->queueLock);
-        VK_CHECK(vk->vkQueueSubmit(sVkEmulation->queue, 1, &submitInfo,
-                                   sVkEmulation->commandBufferFence));
-    }
+        colorBufferInfo->currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 
-    static constexpr uint64_t ANB_MAX_WAIT_NS = 5ULL * 1000ULL * 1000ULL * 1000ULL;
+        // Copy from the staging buffer
+        std::vector<VkBufferImageCopy> bufferImageCopies;
+        for (const FormatTransferPiece& piece : chunks[i].pieces) {
+            bufferImageCopies.push_back(piece.bufferImageCopy);
+            bufferImageCopies.back().bufferOffset += slice->offset;
+        }
+        vk->vkCmdCopyBufferToImage(commandBuffer, sVkEmulation->staging.buffer,
+                                   colorBufferInfo->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   bufferImageCopies.size(), bufferImageCopies.data());
 
-    VK_CHECK(vk->vkWaitForFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence,
-                                 VK_TRUE, ANB_MAX_WAIT_NS));
+        VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
 
-    VK_CHECK(vk->vkResetFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence));
+        transfer.submit(slice, i);
+    }
 
-    const VkMappedMemoryRange toInvalidate = {
-        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        .pNext = nullptr,
-        .memory = sVkEmulation->staging.memory.memory,
-        .offset = 0,
-        .size = VK_WHOLE_SIZE,
-    };
-    VK_CHECK(vk->vkInvalidateMappedMemoryRanges(sVkEmulation->device, 1, &toInvalidate));
+    transfer.completeAll();
 
     return true;
 }
@@ -2823,72 +2966,57 @@ bool readBufferToBytes(uint32_t bufferHandle, uint64_t offset, uint64_t size, vo
         return false;
     }
 
-    const auto& stagingBufferInfo = sVkEmulation->staging;
-    if (size > stagingBufferInfo.size) {
-        VK_COMMON_ERROR("Failed to read from Buffer:%d, staging buffer too small.", bufferHandle);
-        return false;
-    }
-
-    const VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = nullptr,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
+    const VkDeviceSize sliceSize = sVkEmulation->stagingSlices[0].size;
+    StagingTransfer transfer([=](const VkEmulation::StagingSlice& slice, size_t chunkIndex) {
+        const VkDeviceSize chunkOffset = chunkIndex * sliceSize;
+        const VkDeviceSize chunkSize = std::min(sliceSize, size - chunkOffset);
 
-    VkCommandBuffer commandBuffer = sVkEmulation->commandBuffer;
+        const VkMappedMemoryRange toInvalidate = getStagingSliceMappedRange(slice, chunkSize);
+        VK_CHECK(vk->vkInvalidateMappedMemoryRanges(sVkEmulation->device, 1, &toInvalidate));
 
-    VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
-
-    const VkBufferCopy bufferCopy = {
-        .srcOffset = offset,
-        .dstOffset = 0,
-        .size = size,
-    };
-    vk->vkCmdCopyBuffer(commandBuffer, bufferInfo->buffer, stagingBufferInfo.buffer, 1,
-                        &bufferCopy);
+        const void* srcPtr = getStagingSlicePtr(slice);
+        void* dstPtr = outBytes;
+        void* dstPtrOffset =
+            reinterpret_cast<void*>(reinterpret_cast<char*>(dstPtr) + offset + chunkOffset);
+        std::memcpy(dstPtrOffset, srcPtr, chunkSize);
+    });
 
-    VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
+    for (VkDeviceSize chunkOffset = 0; chunkOffset < size; chunkOffset += sliceSize) {
+        VkEmulation::StagingSlice* slice = transfer.acquire();
 
-    const VkSubmitInfo submitInfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer,
-        .signalSemaphoreCount = 0,
-        .pSignalSemaphores = nullptr,
-    };
+        // The lock may have been released to wait for a slice.
+        bufferInfo = android::base::find(sVkEmulation->buffers, bufferHandle);
+        if (!bufferInfo) {
+            VK_COMMON_ERROR("Failed to read from Buffer:%d, destroyed during the read.",
+                            bufferHandle);
+            transfer.release(slice);
+            return false;
+        }
 
-    {
-        android::base::AutoLock lock(*sVkEmulation->queueLock);
-        VK_CHECK(vk->vkQueueSubmit(sVkEmulation->queue, 1, &submitInfo,
-                                   sVkEmulation->commandBufferFence));
-    }
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
 
-    static constexpr uint64_t ANB_MAX_WAIT_NS = 5ULL * 1000ULL * 1000ULL * 1000ULL;
+        VkCommandBuffer commandBuffer = slice->commandBuffer;
 
-    VK_CHECK(vk->vkWaitForFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence,
-                                 VK_TRUE, ANB_MAX_WAIT_NS));
+        VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
-    VK_CHECK(vk->vkResetFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence));
+        const VkBufferCopy bufferCopy = {
+            .srcOffset = offset + chunkOffset,
+            .dstOffset = slice->offset,
+            .size = std::min(sliceSize, size - chunkOffset),
+        };
+        vk->vkCmdCopyBuffer(commandBuffer, bufferInfo->buffer, sVkEmulation->staging.buffer, 1,
+                            &bufferCopy);
 
-    const VkMappedMemoryRange toInvalidate = {
-        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        .pNext = nullptr,
-        .memory = stagingBufferInfo.memory.memory,
-        .offset = 0,
-        .size = size,
-    };
+        VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
 
-    VK_CHECK(vk->vkInvalidateMappedMemoryRanges(sVkEmulation->device, 1, &toInvalidate));
+        transfer.submit(slice, chunkOffset / sliceSize);
+    }
 
-    const void* srcPtr = reinterpret_cast<const void*>(
-        reinterpret_cast<const char*>(stagingBufferInfo.memory.mappedPtr));
-    void* dstPtr = outBytes;
-    void* dstPtrOffset = reinterpret_cast<void*>(reinterpret_cast<char*>(dstPtr) + offset);
-    std::memcpy(dstPtrOffset, srcPtr, size);
+    transfer.completeAll();
 
     return true;
 }
@@ -2910,71 +3038,55 @@ bool updateBufferFromBytes(uint32_t bufferHandle, uint64_t offset, uint64_t size
         return false;
     }
 
-    const auto& stagingBufferInfo = sVkEmulation->staging;
-    if (size > stagingBufferInfo.size) {
-        VK_COMMON_ERROR("Failed to update Buffer:%d, staging buffer too small.", bufferHandle);
-        return false;
-    }
-
-    const void* srcPtr = bytes;
-    const void* srcPtrOffset =
-        reinterpret_cast<const void*>(reinterpret_cast<const char*>(srcPtr) + offset);
-    void* dstPtr = stagingBufferInfo.memory.mappedPtr;
-    std::memcpy(dstPtr, srcPtrOffset, size);
-
-    const VkMappedMemoryRange toFlush = {
-        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        .pNext = nullptr,
-        .memory = stagingBufferInfo.memory.memory,
-        .offset = 0,
-        .size = size,
-    };
-    VK_CHECK(vk->vkFlushMappedMemoryRanges(sVkEmulation->device, 1, &toFlush));
-
-    const VkCommandBufferBeginInfo beginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = nullptr,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
+    const VkDeviceSize sliceSize = sVkEmulation->stagingSlices[0].size;
+    StagingTransfer transfer;
+
+    for (VkDeviceSize chunkOffset = 0; chunkOffset < size; chunkOffset += sliceSize) {
+        const VkDeviceSize chunkSize = std::min(sliceSize, size - chunkOffset);
+        VkEmulation::StagingSlice* slice = transfer.acquire();
+
+        // Copy to the staging buffer without blocking other transfers.
+        sVkEmulationLock.unlock();
+        const void* srcPtr = bytes;
+        const void* srcPtrOffset = reinterpret_cast<const void*>(
+            reinterpret_cast<const char*>(srcPtr) + offset + chunkOffset);
+        std::memcpy(getStagingSlicePtr(*slice), srcPtrOffset, chunkSize);
+        const VkMappedMemoryRange toFlush = getStagingSliceMappedRange(*slice, chunkSize);
+        VK_CHECK(vk->vkFlushMappedMemoryRanges(sVkEmulation->device, 1, &toFlush));
+        sVkEmulationLock.lock();
+
+        bufferInfo = android::base::find(sVkEmulation->buffers, bufferHandle);
+        if (!bufferInfo) {
+            VK_COMMON_ERROR("Failed to update Buffer:%d, destroyed during the update.",
+                            bufferHandle);
+            transfer.release(slice);
+            return false;
+        }
 
-    VkCommandBuffer commandBuffer = sVkEmulation->commandBuffer;
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
 
-    VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
+        VkCommandBuffer commandBuffer = slice->commandBuffer;
 
-    const VkBufferCopy bufferCopy = {
-        .srcOffset = 0,
-        .dstOffset = offset,
-        .size = size,
-    };
-    vk->vkCmdCopyBuffer(commandBuffer, stagingBufferInfo.buffer, bufferInfo->buffer, 1,
-                        &bufferCopy);
+        VK_CHECK(vk->vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
-    VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
+        const VkBufferCopy bufferCopy = {
+            .srcOffset = slice->offset,
+            .dstOffset = offset + chunkOffset,
+            .size = chunkSize,
+        };
+        vk->vkCmdCopyBuffer(commandBuffer, sVkEmulation->staging.buffer, bufferInfo->buffer, 1,
+                            &bufferCopy);
 
-    const VkSubmitInfo submitInfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer,
-        .signalSemaphoreCount = 0,
-        .pSignalSemaphores = nullptr,
-    };
+        VK_CHECK(vk->vkEndCommandBuffer(commandBuffer));
 
-    {
-        android::base::AutoLock lock(*sVkEmulation->queueLock);
-        VK_CHECK(vk->vkQueueSubmit(sVkEmulation->queue, 1, &submitInfo,
-                                   sVkEmulation->commandBufferFence));
+        transfer.submit(slice, chunkOffset / sliceSize);
     }
 
-    static constexpr uint64_t ANB_MAX_WAIT_NS = 5ULL * 1000ULL * 1000ULL * 1000ULL;
-
-    VK_CHECK(vk->vkWaitForFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence,
-                                 VK_TRUE, ANB_MAX_WAIT_NS));
-
-    VK_CHECK(vk->vkResetFences(sVkEmulation->device, 1, &sVkEmulation->commandBufferFence));
+    transfer.completeAll();
 
     return true;
 }
@@ -135,15 +135,12 @@ struct VkEmulation {
     bool debugUtilsAvailableAndRequested = false;
     DebugUtilsHelper debugUtilsHelper = DebugUtilsHelper::withUtilsDisabled();
 
-    // Queue, command pool, and command buffer
-    // for running commands to sync stuff system-wide.
+    // Queue and command pool for running commands to sync stuff system-wide.
     // TODO(b/197362803): Encapsulate host side VkQueue and the lock.
     VkQueue queue = VK_NULL_HANDLE;
     std::shared_ptr<android::base::Lock> queueLock = nullptr;
     uint32_t queueFamilyIndex = 0;
     VkCommandPool commandPool = VK_NULL_HANDLE;
-    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
-    VkFence commandBufferFence = VK_NULL_HANDLE;
 
     struct ImageSupportInfo {
         // Input parameters
@@ -242,6 +239,20 @@ struct VkEmulation {
         VkDeviceSize size = kDefaultStagingBufferSize;
     };
 
+    // The staging buffer is split into slices, each with its own command buffer
+    // and fence, so that transfers to and from different ColorBuffers and
+    // Buffers can be in flight at the same time. A transfer owns its slices
+    // until it has waited for their fences.
+    static constexpr uint32_t kNumStagingSlices = 4;
+
+    struct StagingSlice {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        bool inUse = false;
+    };
+
     enum class VulkanMode {
         // Default: ColorBuffers can still be used with the existing GL-based
         // API.  Synchronization with (if it exists) Vulkan images happens on
@@ -332,6 +343,7 @@ struct VkEmulation {
     // buffer is not; other users need to create buffers that
     // bind to imported versions of the memory.
     StagingBufferInfo staging;
+    std::vector<StagingSlice> stagingSlices;
 
     // ColorBuffers are intended to back the guest's shareable images.
     // For example:
@@ -456,15 +468,20 @@ int32_t mapGpaToBufferHandle(uint32_t bufferHandle, uint64_t gpa, uint64_t size
 
 bool colorBufferNeedsUpdateBetweenGlAndVk(uint32_t colorBufferHandle);
 
+// The size of the whole contents read and updated from bytes.
+bool getColorBufferTransferSize(uint32_t colorBufferHandle, VkDeviceSize* outSize);
+
 bool readColorBufferToBytes(uint32_t colorBufferHandle, std::vector<uint8_t>* bytes);
 bool readColorBufferToBytes(uint32_t colorBufferHandle, uint32_t x, uint32_t y, uint32_t w,
                             uint32_t h, void* outPixels);
+// The emulation lock is released while waiting for the transfer to complete.
 bool readColorBufferToBytesLocked(uint32_t colorBufferHandle, uint32_t x, uint32_t y, uint32_t w,
                                   uint32_t h, void* outPixels);
 
 bool updateColorBufferFromBytes(uint32_t colorBufferHandle, const std::vector<uint8_t>& bytes);
 bool updateColorBufferFromBytes(uint32_t colorBufferHandle, uint32_t x, uint32_t y, uint32_t w,
                                 uint32_t h, const void* pixels);
+// The emulation lock is released while waiting for the transfer to complete.
 bool updateColorBufferFromBytesLocked(uint32_t colorBufferHandle, uint32_t x, uint32_t y,
                                       uint32_t w, uint32_t h, const void* pixels);
 
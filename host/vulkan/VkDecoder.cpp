@@ -35,6 +35,7 @@
 #include <optional>
 #include <unordered_map>
 
+#include "DecoderStats.h"
 #include "VkDecoderGlobalState.h"
 #include "VkDecoderSnapshot.h"
 #include "VulkanDispatch.h"
@@ -51,6 +52,7 @@
 #include "host-common/feature_control.h"
 #include "host-common/logging.h"
 #include "host/FrameBuffer.h"
+#include "host/PacketHangAnnotations.h"
 #include "render-utils/IOStream.h"
 #define MAX_PACKET_LENGTH (400 * 1024 * 1024)  // 400MB
 
@@ -94,6 +96,7 @@ class VkDecoder::Impl {
     android::base::BumpPool m_pool;
     BoxedHandleUnwrapAndDeletePreserveBoxedMapping m_boxedHandleUnwrapAndDeletePreserveBoxedMapping;
     std::optional<uint32_t> m_prevSeqno;
+    PacketHangAnnotations m_hangAnnotations{"opcode", "packet_length"};
 };
 
 VkDecoder::VkDecoder() : mImpl(new VkDecoder::Impl()) {}
@@ -127,6 +130,10 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
     if (m_forSnapshotLoad) {
         ptr += m_state->setCreatedHandlesForSnapshotLoad(ptr);
     }
+    if (healthMonitor) {
+        m_hangAnnotations.setProcessName(processName);
+        m_hangAnnotations.setGfxApiLogger(&gfx_logger);
+    }
     while (end - ptr >= 8) {
         uint32_t opcode = *(uint32_t*)ptr;
         uint32_t packetLen = *(uint32_t*)(ptr + 4);
@@ -149,21 +156,11 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
         uint8_t* snapshotTraceBegin = vkReadStream->beginTrace();
         vkReadStream->setHandleMapping(&m_boxedHandleUnwrapMapping);
 
-        std::unique_ptr<EventHangMetadata::HangAnnotations> executionData =
-            std::make_unique<EventHangMetadata::HangAnnotations>();
-        if (healthMonitor) {
-            executionData->insert(
-                {{"packet_length", std::to_string(packetLen)}, {"opcode", std::to_string(opcode)}});
-            if (processName) {
-                executionData->insert({{"renderthread_guest_process", std::string(processName)}});
-            }
-            if (m_prevSeqno) {
-                executionData->insert({{"previous_seqno", std::to_string(m_prevSeqno.value())}});
-            }
-        }
+        // Hang annotations are only turned into strings if a watchdog fires.
+        if (healthMonitor) m_hangAnnotations.setPacket(opcode, packetLen);
 
-        std::atomic<uint32_t>* seqnoPtr =
-            processResources ? processResources->getSequenceNumberPtr() : nullptr;
+        SequenceNumberOrdering* seqnoPtr =
+            processResources ? processResources->getSequenceNumberOrdering() : nullptr;
 
         if (queueSubmitWithCommandsEnabled &&
             ((opcode >= OP_vkFirst && opcode < OP_vkLast) ||
@@ -171,7 +168,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
             uint32_t seqno;
             memcpy(&seqno, *readStreamPtrPtr, sizeof(uint32_t));
             *readStreamPtrPtr += sizeof(uint32_t);
-            if (healthMonitor) executionData->insert({{"seqno", std::to_string(seqno)}});
+            if (healthMonitor) m_hangAnnotations.setSeqno(seqno);
             if (m_prevSeqno && seqno == m_prevSeqno.value()) {
                 WARN(
                     "Seqno %d is the same as previously processed on thread %d. It might be a "
@@ -182,27 +179,19 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
             if (seqnoPtr && !m_forSnapshotLoad) {
                 {
                     auto seqnoWatchdog =
-                        WATCHDOG_BUILDER(healthMonitor, "RenderThread seqno loop")
-                            .setHangType(EventHangMetadata::HangType::kRenderThread)
-                            .setAnnotations(std::make_unique<EventHangMetadata::HangAnnotations>(
-                                *executionData))
-                            /* Data gathered if this hangs*/
-                            .setOnHangCallback([=]() {
-                                auto annotations =
-                                    std::make_unique<EventHangMetadata::HangAnnotations>();
-                                annotations->insert(
-                                    {{"seqnoPtr",
-                                      std::to_string(seqnoPtr->load(std::memory_order_seq_cst))}});
-                                return annotations;
-                            })
-                            .build();
-                    while ((seqno - seqnoPtr->load(std::memory_order_seq_cst) != 1)) {
-#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)))
-                        _mm_pause();
-#elif (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
-                        __asm__ __volatile__("pause;");
-#endif
-                    }
+                        healthMonitor
+                            ? WATCHDOG_BUILDER(healthMonitor, "RenderThread seqno loop")
+                                  .setHangType(EventHangMetadata::HangType::kRenderThread)
+                                  /* Data gathered if this hangs*/
+                                  .setOnHangCallback([this, seqnoPtr]() {
+                                      auto annotations = m_hangAnnotations.build();
+                                      annotations->insert(
+                                          {{"seqnoPtr", std::to_string(seqnoPtr->current())}});
+                                      return annotations;
+                                  })
+                                  .build()
+                            : nullptr;
+                    seqnoPtr->waitForTurn(seqno);
                     m_prevSeqno = seqno;
                 }
             }
@@ -211,12 +200,15 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
         gfx_logger.recordCommandExecution();
 
         auto executionWatchdog =
-            WATCHDOG_BUILDER(healthMonitor, "RenderThread VkDecoder command execution")
-                .setHangType(EventHangMetadata::HangType::kRenderThread)
-                .setAnnotations(std::move(executionData))
-                .build();
+            healthMonitor
+                ? WATCHDOG_BUILDER(healthMonitor, "RenderThread VkDecoder command execution")
+                      .setHangType(EventHangMetadata::HangType::kRenderThread)
+                      .setOnHangCallback(m_hangAnnotations.getOnHangCallback())
+                      .build()
+                : nullptr;
 
         auto vk = m_vk;
+        const uint64_t statsStartNs = DecoderStats::start();
         switch (opcode) {
 #ifdef VK_VERSION_1_0
             case OP_vkCreateInstance: {
@@ -281,8 +273,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           pCreateInfo, pAllocator, pInstance);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -323,8 +314,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, instance, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -420,8 +410,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPhysicalDevices);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -467,8 +456,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, physicalDevice, pFeatures);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -521,8 +509,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -601,8 +588,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         format, type, tiling, usage, flags, pImageFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -650,8 +636,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                        physicalDevice, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -753,8 +738,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pQueueFamilyPropertyCount, pQueueFamilyProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -805,8 +789,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -844,8 +827,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetInstanceProcAddr_PFN_vkVoidFunction_return, instance, pName);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -883,8 +865,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetDeviceProcAddr_PFN_vkVoidFunction_return, device, pName);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -959,8 +940,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                         pDevice);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1001,8 +981,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          &m_pool, device, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1115,8 +1094,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1236,8 +1214,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pLayerName, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1331,8 +1308,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1438,8 +1414,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1488,8 +1463,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           queueIndex, pQueue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1544,8 +1518,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        queue, submitCount, pSubmits, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1561,8 +1534,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                     fprintf(stderr, "stream %p: call vkQueueWaitIdle 0x%llx \n", ioStream,
                             (unsigned long long)queue);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 VkResult vkQueueWaitIdle_VkResult_return = (VkResult)0;
                 vkQueueWaitIdle_VkResult_return = m_state->on_vkQueueWaitIdle(&m_pool, queue);
                 if ((vkQueueWaitIdle_VkResult_return) == VK_ERROR_DEVICE_LOST)
@@ -1598,8 +1570,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                     fprintf(stderr, "stream %p: call vkDeviceWaitIdle 0x%llx \n", ioStream,
                             (unsigned long long)device);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 VkResult vkDeviceWaitIdle_VkResult_return = (VkResult)0;
                 vkDeviceWaitIdle_VkResult_return = vk->vkDeviceWaitIdle(unboxed_device);
                 if ((vkDeviceWaitIdle_VkResult_return) == VK_ERROR_DEVICE_LOST)
@@ -1697,8 +1668,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           pMemory);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1752,8 +1722,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDeviceMemory(boxed_memory_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1823,8 +1792,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                      memory, offset, size, flags, ppData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1856,8 +1824,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        &m_pool, device, memory);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -1934,8 +1901,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRanges);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2014,8 +1980,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRanges);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2062,8 +2027,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCommittedMemoryInBytes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2113,8 +2077,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindBufferMemory_VkResult_return, device, buffer, memory, memoryOffset);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2164,8 +2127,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindImageMemory_VkResult_return, device, image, memory, memoryOffset);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2218,8 +2180,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2272,8 +2233,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2386,8 +2346,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSparseMemoryRequirementCount, pSparseMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2506,8 +2465,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         type, samples, usage, tiling, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2565,8 +2523,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkQueueBindSparse_VkResult_return, queue, bindInfoCount, pBindInfo, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2641,8 +2598,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        device, pCreateInfo, pAllocator, pFence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2695,8 +2651,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkFence(boxed_fence_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2745,8 +2700,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        device, fenceCount, pFences);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2787,8 +2741,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           device, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2830,8 +2783,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             (unsigned long long)pFences, (unsigned long long)waitAll,
                             (unsigned long long)timeout);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 VkResult vkWaitForFences_VkResult_return = (VkResult)0;
                 vkWaitForFences_VkResult_return =
                     vk->vkWaitForFences(unboxed_device, fenceCount, pFences, waitAll, timeout);
@@ -2928,8 +2880,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSemaphore);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -2982,8 +2933,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSemaphore(boxed_semaphore_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3062,8 +3012,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        device, pCreateInfo, pAllocator, pEvent);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3119,8 +3068,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkEvent(boxed_event_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3161,8 +3109,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           device, event);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3201,8 +3148,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                     vkSetEvent_VkResult_return, device, event);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3243,8 +3189,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                       event);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3326,8 +3271,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pQueryPool);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3383,8 +3327,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkQueryPool(boxed_queryPool_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3458,8 +3401,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         queryCount, dataSize, pData, stride, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3535,8 +3477,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                         device, pCreateInfo, pAllocator, pBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3589,8 +3530,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkBuffer(boxed_buffer_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3671,8 +3611,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkCreateBufferView_VkResult_return, device, pCreateInfo, pAllocator, pView);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3729,8 +3668,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkBufferView(boxed_bufferView_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3806,8 +3744,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        device, pCreateInfo, pAllocator, pImage);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3860,8 +3797,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkImage(boxed_image_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -3925,8 +3861,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSubresource, pLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4003,8 +3938,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkCreateImageView_VkResult_return, device, pCreateInfo, pAllocator, pView);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4057,8 +3991,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkImageView(boxed_imageView_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4138,8 +4071,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pShaderModule);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4193,8 +4125,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkShaderModule(boxed_shaderModule_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4275,8 +4206,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPipelineCache);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4331,8 +4261,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkPipelineCache(boxed_pipelineCache_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4417,8 +4346,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4481,8 +4409,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSrcCaches);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4589,8 +4516,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         createInfoCount, pCreateInfos, pAllocator, pPipelines);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4602,14 +4528,11 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 const VkComputePipelineCreateInfo* pCreateInfos;
                 const VkAllocationCallbacks* pAllocator;
                 VkPipeline* pPipelines;
-                // Begin non wrapped dispatchable handle unboxing for device;
+                // Begin global wrapped dispatchable handle unboxing for device;
                 uint64_t cgen_var_0;
                 memcpy((uint64_t*)&cgen_var_0, *readStreamPtrPtr, 1 * 8);
                 *readStreamPtrPtr += 1 * 8;
                 *(VkDevice*)&device = (VkDevice)(VkDevice)((VkDevice)(*&cgen_var_0));
-                auto unboxed_device = unbox_VkDevice(device);
-                auto vk = dispatch_VkDevice(device);
-                // End manual dispatchable handle unboxing for device;
                 uint64_t cgen_var_1;
                 memcpy((uint64_t*)&cgen_var_1, *readStreamPtrPtr, 1 * 8);
                 *readStreamPtrPtr += 1 * 8;
@@ -4667,17 +4590,16 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             (unsigned long long)pAllocator, (unsigned long long)pPipelines);
                 }
                 VkResult vkCreateComputePipelines_VkResult_return = (VkResult)0;
-                vkCreateComputePipelines_VkResult_return =
-                    vk->vkCreateComputePipelines(unboxed_device, pipelineCache, createInfoCount,
-                                                 pCreateInfos, pAllocator, pPipelines);
+                vkCreateComputePipelines_VkResult_return = m_state->on_vkCreateComputePipelines(
+                    &m_pool, device, pipelineCache, createInfoCount, pCreateInfos, pAllocator,
+                    pPipelines);
                 if ((vkCreateComputePipelines_VkResult_return) == VK_ERROR_DEVICE_LOST)
                     m_state->on_DeviceLost();
                 m_state->on_CheckOutOfMemory(vkCreateComputePipelines_VkResult_return, opcode,
                                              context);
                 vkStream->unsetHandleMapping();
-                // Begin auto non dispatchable handle create for pPipelines;
-                if (vkCreateComputePipelines_VkResult_return == VK_SUCCESS)
-                    vkStream->setHandleMapping(&m_boxedHandleCreateMapping);
+                // Begin manual non dispatchable handle create for pPipelines;
+                vkStream->unsetHandleMapping();
                 if (((createInfoCount))) {
                     uint64_t* cgen_var_4;
                     vkStream->alloc((void**)&cgen_var_4, ((createInfoCount)) * 8);
@@ -4687,7 +4609,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                      ((createInfoCount)));
                     vkStream->write((VkPipeline*)pPipelines, 8 * ((createInfoCount)));
                 }
-                // Begin auto non dispatchable handle create for pPipelines;
+                // Begin manual non dispatchable handle create for pPipelines;
                 vkStream->setHandleMapping(&m_boxedHandleUnwrapMapping);
                 vkStream->write(&vkCreateComputePipelines_VkResult_return, sizeof(VkResult));
                 vkStream->commitWrite();
@@ -4701,8 +4623,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         createInfoCount, pCreateInfos, pAllocator, pPipelines);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4755,8 +4676,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkPipeline(boxed_pipeline_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4843,8 +4763,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPipelineLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4908,8 +4827,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 delayed_delete_VkPipelineLayout(boxed_pipelineLayout_preserve, unboxed_device,
                                                 delayed_remove_callback);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -4986,8 +4904,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          device, pCreateInfo, pAllocator, pSampler);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5040,8 +4957,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSampler(boxed_sampler_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5127,8 +5043,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSetLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5186,8 +5101,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDescriptorSetLayout(boxed_descriptorSetLayout_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5268,8 +5182,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDescriptorPool);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5324,8 +5237,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDescriptorPool(boxed_descriptorPool_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5371,8 +5283,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkResetDescriptorPool_VkResult_return, device, descriptorPool, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5450,8 +5361,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDescriptorSets);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5528,8 +5438,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 // Skipping handle cleanup for vkFreeDescriptorSets
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5599,8 +5508,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDescriptorCopies);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5680,8 +5588,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFramebuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5735,8 +5642,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkFramebuffer(boxed_framebuffer_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5815,8 +5721,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPass);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5870,8 +5775,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkRenderPass(boxed_renderPass_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -5924,8 +5828,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pGranularity);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6005,8 +5908,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCommandPool);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6060,8 +5962,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkCommandPool(boxed_commandPool_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6106,8 +6007,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkResetCommandPool_VkResult_return, device, commandPool, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6181,8 +6081,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCommandBuffers);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6255,8 +6154,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                     }
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6301,8 +6199,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBeginCommandBuffer_VkResult_return, commandBuffer, pBeginInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6337,8 +6234,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkEndCommandBuffer_VkResult_return, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6377,8 +6273,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkResetCommandBuffer_VkResult_return, commandBuffer, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6416,8 +6311,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            pipelineBindPoint, pipeline);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6470,8 +6364,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           viewportCount, pViewports);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6522,8 +6415,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          scissorCount, pScissors);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6556,8 +6448,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, commandBuffer, lineWidth);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6602,8 +6493,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6638,8 +6528,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 commandBuffer, blendConstants);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6677,8 +6566,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              maxDepthBounds);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6718,8 +6606,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         compareMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6759,8 +6646,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         writeMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6800,8 +6686,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         reference);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6877,8 +6762,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         dynamicOffsetCount, pDynamicOffsets);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6922,8 +6806,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, indexType);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -6982,8 +6865,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstBinding, bindingCount, pBuffers, pOffsets);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7030,8 +6912,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                    firstVertex, firstInstance);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7083,8 +6964,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         instanceCount, firstIndex, vertexOffset, firstInstance);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7133,8 +7013,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            drawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7184,8 +7063,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, drawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7227,8 +7105,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        groupCountY, groupCountZ);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7268,8 +7145,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                commandBuffer, buffer, offset);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7329,8 +7205,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          dstBuffer, regionCount, pRegions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7394,8 +7269,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7466,8 +7340,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions, filter);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7531,8 +7404,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         dstImage, dstImageLayout, regionCount, pRegions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7596,8 +7468,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         srcImageLayout, dstBuffer, regionCount, pRegions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7647,8 +7518,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            dstOffset, dataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7696,8 +7566,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          dstOffset, size, data);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7765,8 +7634,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageLayout, pColor, rangeCount, pRanges);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7836,8 +7704,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageLayout, pDepthStencil, rangeCount, pRanges);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7904,8 +7771,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         attachmentCount, pAttachments, rectCount, pRects);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -7974,8 +7840,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8015,8 +7880,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        &m_pool, commandBuffer, event, stageMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8056,8 +7920,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          &m_pool, commandBuffer, event, stageMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8178,8 +8041,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImageMemoryBarriers);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8287,8 +8149,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageMemoryBarrierCount, pImageMemoryBarriers);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8334,8 +8195,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8375,8 +8235,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                        &m_pool, commandBuffer, queryPool, query);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8422,8 +8281,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              firstQuery, queryCount);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8470,8 +8328,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              queryPool, query);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8535,8 +8392,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstQuery, queryCount, dstBuffer, dstOffset, stride, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8592,8 +8448,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             stageFlags, offset, size, pValues);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8637,8 +8492,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPassBegin, contents);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8671,8 +8525,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           &m_pool, commandBuffer, contents);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8702,8 +8555,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8750,8 +8602,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         commandBufferCount, pCommandBuffers);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8789,8 +8640,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkEnumerateInstanceVersion_VkResult_return, pApiVersion);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8842,8 +8692,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindBufferMemory2_VkResult_return, device, bindInfoCount, pBindInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8895,8 +8744,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindImageMemory2_VkResult_return, device, bindInfoCount, pBindInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8951,8 +8799,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         localDeviceIndex, remoteDeviceIndex, pPeerMemoryFeatures);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -8985,8 +8832,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, commandBuffer, deviceMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9041,8 +8887,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9157,8 +9002,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPhysicalDeviceGroupCount, pPhysicalDeviceGroupProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9215,8 +9059,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9274,8 +9117,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9393,8 +9235,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSparseMemoryRequirementCount, pSparseMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9440,8 +9281,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, physicalDevice, pFeatures);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9489,8 +9329,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9543,8 +9382,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9617,8 +9455,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImageFormatInfo, pImageFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9720,8 +9557,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pQueueFamilyPropertyCount, pQueueFamilyProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9772,8 +9608,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9883,8 +9718,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFormatInfo, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9924,8 +9758,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, device, commandPool, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -9974,8 +9807,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, device, pQueueInfo, pQueue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10061,8 +9893,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pYcbcrConversion);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10120,8 +9951,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSamplerYcbcrConversion(boxed_ycbcrConversion_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10210,8 +10040,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pDescriptorUpdateTemplate);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10272,8 +10101,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDescriptorUpdateTemplate(boxed_descriptorUpdateTemplate_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10331,8 +10159,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         descriptorUpdateTemplate, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10404,8 +10231,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalBufferInfo, pExternalBufferProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10471,8 +10297,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalFenceInfo, pExternalFenceProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10537,8 +10362,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalSemaphoreInfo, pExternalSemaphoreProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10599,8 +10423,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSupport);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10661,8 +10484,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10722,8 +10544,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10802,8 +10623,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPass);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10855,8 +10675,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPassBegin, pSubpassBeginInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10907,8 +10726,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            pSubpassBeginInfo, pSubpassEndInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10949,8 +10767,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              pSubpassEndInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -10994,8 +10811,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           queryCount);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11048,8 +10864,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetSemaphoreCounterValue_VkResult_return, device, semaphore, pValue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11081,8 +10896,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             ioStream, (unsigned long long)device, (unsigned long long)pWaitInfo,
                             (unsigned long long)timeout);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 VkResult vkWaitSemaphores_VkResult_return = (VkResult)0;
                 vkWaitSemaphores_VkResult_return =
                     vk->vkWaitSemaphores(unboxed_device, pWaitInfo, timeout);
@@ -11146,8 +10960,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkSignalSemaphore_VkResult_return, device, pSignalInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11192,8 +11005,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetBufferDeviceAddress_VkDeviceAddress_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11237,8 +11049,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetBufferOpaqueCaptureAddress_uint64_t_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11285,8 +11096,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetDeviceMemoryOpaqueCaptureAddress_uint64_t_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11345,8 +11155,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSurfaceKHR(boxed_surface_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11408,8 +11217,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         queueFamilyIndex, surface, pSupported);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11479,8 +11287,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         surface, pSurfaceCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11593,8 +11400,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         surface, pSurfaceFormatCount, pSurfaceFormats);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11686,8 +11492,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         surface, pPresentModeCount, pPresentModes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11773,8 +11578,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSwapchain);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11831,8 +11635,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSwapchainKHR(boxed_swapchain_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -11934,8 +11737,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSwapchainImageCount, pSwapchainImages);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12005,8 +11807,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         semaphore, fence, pImageIndex);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12051,8 +11852,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkQueuePresentKHR_VkResult_return, queue, pPresentInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12119,8 +11919,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDeviceGroupPresentCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12190,8 +11989,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pModes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12301,8 +12099,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         surface, pRectCount, pRects);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12358,8 +12155,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireNextImage2KHR_VkResult_return, device, pAcquireInfo, pImageIndex);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12469,8 +12265,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12578,8 +12373,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12681,8 +12475,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         planeIndex, pDisplayCount, pDisplays);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12794,8 +12587,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12888,8 +12680,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCreateInfo, pAllocator, pMode);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -12961,8 +12752,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         planeIndex, pCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13041,8 +12831,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13141,8 +12930,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCreateInfos, pAllocator, pSwapchains);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13221,8 +13009,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13278,8 +13065,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, queueFamilyIndex, dpy, visualID);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13384,8 +13170,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13438,8 +13223,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, queueFamilyIndex, display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13520,8 +13304,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13602,8 +13385,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13648,8 +13430,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, queueFamilyIndex);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13725,8 +13506,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pVideoProfile, pCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13851,8 +13631,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pVideoFormatInfo, pVideoFormatPropertyCount, pVideoFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13928,8 +13707,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pVideoSession);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -13980,8 +13758,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                   device, videoSession, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14111,8 +13888,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pVideoSessionMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14179,8 +13955,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         videoSessionBindMemoryCount, pVideoSessionBindMemories);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14261,8 +14036,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pVideoSessionParameters);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14322,8 +14096,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         videoSessionParameters, pUpdateInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14378,8 +14151,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         videoSessionParameters, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14419,8 +14191,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pBeginInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14461,8 +14232,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 commandBuffer, pEndCodingInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14504,8 +14274,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCodingControlInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14547,8 +14316,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              &m_pool, commandBuffer, pFrameInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14591,8 +14359,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 commandBuffer, pRenderingInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14622,8 +14389,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14674,8 +14440,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, physicalDevice, pFeatures);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14723,8 +14488,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14777,8 +14541,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14851,8 +14614,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, pImageFormatInfo, pImageFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -14954,8 +14716,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pQueueFamilyPropertyCount, pQueueFamilyProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15007,8 +14768,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15119,8 +14879,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFormatInfo, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15178,8 +14937,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         localDeviceIndex, remoteDeviceIndex, pPeerMemoryFeatures);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15213,8 +14971,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, deviceMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15269,8 +15026,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         baseGroupY, baseGroupZ, groupCountX, groupCountY, groupCountZ);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15315,8 +15071,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                               commandPool, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15435,8 +15190,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPhysicalDeviceGroupCount, pPhysicalDeviceGroupProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15510,8 +15264,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalBufferInfo, pExternalBufferProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15573,8 +15326,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15646,8 +15398,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         handle, pMemoryWin32HandleProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15703,8 +15454,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                           device, pGetFdInfo, pFd);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15770,8 +15520,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryFdProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15841,8 +15590,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalSemaphoreInfo, pExternalSemaphoreProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15900,8 +15648,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImportSemaphoreWin32HandleInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -15959,8 +15706,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16008,8 +15754,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkImportSemaphoreFdKHR_VkResult_return, device, pImportSemaphoreFdInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16060,8 +15805,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetSemaphoreFdKHR_VkResult_return, device, pGetFdInfo, pFd);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16130,8 +15874,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipelineBindPoint, layout, set, descriptorWriteCount, pDescriptorWrites);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16194,8 +15937,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         descriptorUpdateTemplate, layout, set, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16292,8 +16034,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pDescriptorUpdateTemplate);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16354,8 +16095,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDescriptorUpdateTemplate(boxed_descriptorUpdateTemplate_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16413,8 +16153,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         descriptorUpdateTemplate, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16498,8 +16237,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPass);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16552,8 +16290,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRenderPassBegin, pSubpassBeginInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16604,8 +16341,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSubpassBeginInfo, pSubpassEndInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16646,8 +16382,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 commandBuffer, pSubpassEndInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16693,8 +16428,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetSwapchainStatusKHR_VkResult_return, device, swapchain);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16762,8 +16496,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalFenceInfo, pExternalFenceProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16818,8 +16551,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImportFenceWin32HandleInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16877,8 +16609,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16927,8 +16658,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkImportFenceFdKHR_VkResult_return, device, pImportFenceFdInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -16982,8 +16712,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          device, pGetFdInfo, pFd);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17156,8 +16885,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             pCounterDescriptions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17215,8 +16943,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPerformanceQueryCreateInfo, pNumPasses);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17263,8 +16990,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireProfilingLockKHR_VkResult_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17293,8 +17019,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, device);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17374,8 +17099,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurfaceInfo, pSurfaceCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17494,8 +17218,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurfaceInfo, pSurfaceFormatCount, pSurfaceFormats);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17607,8 +17330,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17717,8 +17439,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17830,8 +17551,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17904,8 +17624,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplayPlaneInfo, pCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -17971,8 +17690,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18030,8 +17748,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18149,8 +17866,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSparseMemoryRequirementCount, pSparseMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18241,8 +17957,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pYcbcrConversion);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18300,8 +18015,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkSamplerYcbcrConversion(boxed_ycbcrConversion_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18357,8 +18071,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindBufferMemory2KHR_VkResult_return, device, bindInfoCount, pBindInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18411,8 +18124,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkBindImageMemory2KHR_VkResult_return, device, bindInfoCount, pBindInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18477,8 +18189,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSupport);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18539,8 +18250,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18600,8 +18310,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18672,8 +18381,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetSemaphoreCounterValueKHR_VkResult_return, device, semaphore, pValue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18705,8 +18413,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             ioStream, (unsigned long long)device, (unsigned long long)pWaitInfo,
                             (unsigned long long)timeout);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 VkResult vkWaitSemaphoresKHR_VkResult_return = (VkResult)0;
                 vkWaitSemaphoresKHR_VkResult_return =
                     vk->vkWaitSemaphoresKHR(unboxed_device, pWaitInfo, timeout);
@@ -18770,8 +18477,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkSignalSemaphoreKHR_VkResult_return, device, pSignalInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18895,8 +18601,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFragmentShadingRateCount, pFragmentShadingRates);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -18942,8 +18647,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFragmentSize, combinerOps);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19002,8 +18706,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkWaitForPresentKHR_VkResult_return, device, swapchain, presentId, timeout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19052,8 +18755,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetBufferDeviceAddressKHR_VkDeviceAddress_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19098,8 +18800,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetBufferOpaqueCaptureAddressKHR_uint64_t_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19146,8 +18847,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetDeviceMemoryOpaqueCaptureAddressKHR_uint64_t_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19214,8 +18914,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDeferredOperation);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19266,8 +18965,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19308,8 +19006,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetDeferredOperationMaxConcurrencyKHR_uint32_t_return, device, operation);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19352,8 +19049,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetDeferredOperationResultKHR_VkResult_return, device, operation);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19395,8 +19091,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkDeferredOperationJoinKHR_VkResult_return, device, operation);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19515,8 +19210,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExecutableCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19634,8 +19328,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExecutableInfo, pStatisticCount, pStatistics);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19768,8 +19461,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExecutableInfo, pInternalRepresentationCount, pInternalRepresentations);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19819,8 +19511,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              &m_pool, commandBuffer, pEncodeInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19868,8 +19559,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            pDependencyInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19910,8 +19600,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              stageMask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -19974,8 +19663,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              pEvents, pDependencyInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20016,8 +19704,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                   commandBuffer, pDependencyInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20064,8 +19751,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         queryPool, query);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20126,8 +19812,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkQueueSubmit2KHR_VkResult_return, queue, submitCount, pSubmits, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20178,8 +19863,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         dstBuffer, dstOffset, marker);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20276,8 +19960,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCheckpointDataCount, pCheckpointData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20326,8 +20009,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              pCopyBufferInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20366,8 +20048,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, commandBuffer, pCopyImageInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20409,8 +20090,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCopyBufferToImageInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20452,8 +20132,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCopyImageToBufferInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20492,8 +20171,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, commandBuffer, pBlitImageInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20535,8 +20213,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                commandBuffer, pResolveImageInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20602,8 +20279,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20665,8 +20341,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20784,8 +20459,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSparseMemoryRequirementCount, pSparseMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20842,8 +20516,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageUsage, grallocUsage);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20902,8 +20575,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         semaphore, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -20980,8 +20652,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pWaitSemaphores, image, pNativeFenceFd);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21072,8 +20743,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pCallback);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21133,8 +20803,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDebugReportCallbackEXT(boxed_callback_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21193,8 +20862,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         objectType, object, location, messageCode, pLayerPrefix, pMessage);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21255,8 +20923,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkDebugMarkerSetObjectTagEXT_VkResult_return, device, pTagInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21305,8 +20972,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkDebugMarkerSetObjectNameEXT_VkResult_return, device, pNameInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21347,8 +21013,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                   commandBuffer, pMarkerInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21378,8 +21043,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21420,8 +21084,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                    commandBuffer, pMarkerInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21499,8 +21162,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstBinding, bindingCount, pBuffers, pOffsets, pSizes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21577,8 +21239,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCounterBufferOffsets);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21655,8 +21316,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCounterBufferOffsets);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21708,8 +21368,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         query, flags, index);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21755,8 +21414,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         query, index);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21817,8 +21475,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         counterOffset, vertexStride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21893,8 +21550,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pModule);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -21968,8 +21624,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pFunction);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22019,8 +21674,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                               module, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22071,8 +21725,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 function, pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22112,8 +21765,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                 commandBuffer, pLaunchInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22158,8 +21810,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetImageViewHandleNVX_uint32_t_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22223,8 +21874,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetImageViewAddressNVX_VkResult_return, device, imageView, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22285,8 +21935,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22346,8 +21995,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22456,8 +22104,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pInfoSize, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22542,8 +22189,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22644,8 +22290,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pExternalImageFormatProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22708,8 +22353,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22791,8 +22435,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22847,8 +22490,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pConditionalRenderingBegin);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22878,8 +22520,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22937,8 +22578,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstViewport, viewportCount, pViewportWScalings);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -22985,8 +22625,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkReleaseDisplayEXT_VkResult_return, physicalDevice, display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23042,8 +22681,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireXlibDisplayEXT_VkResult_return, physicalDevice, dpy, display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23108,8 +22746,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplay);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23182,8 +22819,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         surface, pSurfaceCapabilities);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23242,8 +22878,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplayPowerInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23320,8 +22955,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pFence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23406,8 +23040,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplayEventInfo, pAllocator, pFence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23466,8 +23099,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCounterValue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23537,8 +23169,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplayTimingProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23657,8 +23288,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPresentationTimingCount, pPresentationTimings);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23726,8 +23356,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstDiscardRectangle, discardRectangleCount, pDiscardRectangles);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23798,8 +23427,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              pSwapchains, pMetadata);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23878,8 +23506,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -23960,8 +23587,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24001,8 +23627,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, physicalDevice, pMTLDevice);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24041,8 +23666,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkSetMTLTextureMVK_VkResult_return, image, mtlTexture);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24075,8 +23699,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, image, pMTLTexture);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24109,8 +23732,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, buffer, pMTLBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24149,8 +23771,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkUseIOSurfaceMVK_VkResult_return, image, ioSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24183,8 +23804,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                            &m_pool, image, pIOSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24238,8 +23858,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkSetDebugUtilsObjectNameEXT_VkResult_return, device, pNameInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24286,8 +23905,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkSetDebugUtilsObjectTagEXT_VkResult_return, device, pTagInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24326,8 +23944,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, queue, pLabelInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24356,8 +23973,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, queue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24396,8 +24012,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, queue, pLabelInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24437,8 +24052,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pLabelInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24468,8 +24082,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24510,8 +24123,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pLabelInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24600,8 +24212,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pMessenger);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24661,8 +24272,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDebugUtilsMessengerEXT(boxed_messenger_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24715,8 +24325,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         messageTypes, pCallbackData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24786,8 +24395,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24848,8 +24456,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24905,8 +24512,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSampleLocationsInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -24966,8 +24572,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMultisampleProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25050,8 +24655,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25142,8 +24746,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pValidationCache);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25202,8 +24805,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkValidationCacheEXT(boxed_validationCache_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25269,8 +24871,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSrcCaches);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25358,8 +24959,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25407,8 +25007,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25464,8 +25063,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstViewport, viewportCount, pShadingRatePalettes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25524,8 +25122,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         sampleOrderType, customSampleOrderCount, pCustomSampleOrders);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25619,8 +25216,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pAccelerationStructure);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25681,8 +25277,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkAccelerationStructureNV(boxed_accelerationStructure_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25744,8 +25339,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25808,8 +25402,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pBindInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25890,8 +25483,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         instanceData, instanceOffset, update, dst, src, scratch, scratchOffset);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -25943,8 +25535,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         mode);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26062,8 +25653,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         callableShaderBindingStride, width, height, depth);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26167,8 +25757,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         createInfoCount, pCreateInfos, pAllocator, pPipelines);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26235,8 +25824,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstGroup, groupCount, dataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26303,8 +25891,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstGroup, groupCount, dataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26367,8 +25954,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         accelerationStructure, dataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26438,8 +26024,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstQuery);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26485,8 +26070,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkCompileDeferredNV_VkResult_return, device, pipeline, shader);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26575,8 +26159,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pHostPointer, pMemoryHostPointerProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26629,8 +26212,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipelineStage, dstBuffer, dstOffset, marker);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26721,8 +26303,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, pTimeDomainCount, pTimeDomains);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26798,8 +26379,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pTimestampInfos, pTimestamps, pMaxDeviation);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26855,8 +26435,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                               commandBuffer, taskCount, firstTask);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26906,8 +26485,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, drawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -26967,8 +26545,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         offset, countBuffer, countBufferOffset, maxDrawCount, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27030,8 +26607,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstExclusiveScissor, exclusiveScissorCount, pExclusiveScissors);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27075,8 +26651,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                               commandBuffer, pCheckpointMarker);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27172,8 +26747,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCheckpointDataCount, pCheckpointData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27226,8 +26800,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkInitializePerformanceApiINTEL_VkResult_return, device, pInitializeInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27256,8 +26829,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, device);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27308,8 +26880,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkCmdSetPerformanceMarkerINTEL_VkResult_return, commandBuffer, pMarkerInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27362,8 +26933,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMarkerInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27416,8 +26986,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pOverrideInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27483,8 +27052,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAcquireInfo, pConfiguration);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27531,8 +27099,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         configuration);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27579,8 +27146,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         configuration);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27642,8 +27208,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetPerformanceParameterINTEL_VkResult_return, device, parameter, pValue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27687,8 +27252,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                               swapChain, localDimmingEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27770,8 +27334,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27852,8 +27415,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkGetBufferDeviceAddressEXT_VkDeviceAddress_return, device, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -27965,8 +27527,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pToolCount, pToolProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28084,8 +27645,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, pPropertyCount, pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28208,8 +27768,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                             physicalDevice, pCombinationCount, pCombinations);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28313,8 +27872,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurfaceInfo, pPresentModeCount, pPresentModes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28360,8 +27918,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireFullScreenExclusiveModeEXT_VkResult_return, device, swapchain);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28407,8 +27964,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkReleaseFullScreenExclusiveModeEXT_VkResult_return, device, swapchain);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28483,8 +28039,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurfaceInfo, pModes);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28565,8 +28120,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28609,8 +28163,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         lineStippleFactor, lineStipplePattern);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28658,8 +28211,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              queryCount);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28697,8 +28249,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              &m_pool, commandBuffer, cullMode);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28732,8 +28283,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, frontFace);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28769,8 +28319,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         primitiveTopology);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28818,8 +28367,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         viewportCount, pViewports);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28866,8 +28414,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         scissorCount, pScissors);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28959,8 +28506,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstBinding, bindingCount, pBuffers, pOffsets, pSizes, pStrides);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -28995,8 +28541,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                     commandBuffer, depthTestEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29031,8 +28576,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         depthWriteEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29067,8 +28611,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                    commandBuffer, depthCompareOp);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29104,8 +28647,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         depthBoundsTestEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29140,8 +28682,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         stencilTestEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29194,8 +28735,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         failOp, passOp, depthFailOp, compareOp);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29263,8 +28803,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29308,8 +28847,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pGeneratedCommandsInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29358,8 +28896,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         isPreprocessed, pGeneratedCommandsInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29407,8 +28944,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipelineBindPoint, pipeline, groupIndex);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29501,8 +29037,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pIndirectCommandsLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29563,8 +29098,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkIndirectCommandsLayoutNV(boxed_indirectCommandsLayout_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29624,8 +29158,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireDrmDisplayEXT_VkResult_return, physicalDevice, drmFd, display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29684,8 +29217,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29769,8 +29301,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPrivateDataSlot);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29821,8 +29352,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29877,8 +29407,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         privateDataSlot, data);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29931,8 +29460,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                              objectHandle, privateDataSlot, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -29983,8 +29511,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         combinerOps);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30046,8 +29573,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vkAcquireWinrtDisplayNV_VkResult_return, physicalDevice, display);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30102,8 +29628,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pDisplay);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30184,8 +29709,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30238,8 +29762,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, queueFamilyIndex, dfb);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30327,8 +29850,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         vertexAttributeDescriptionCount, pVertexAttributeDescriptions);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30394,8 +29916,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pGetZirconHandleInfo, pZirconHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30470,8 +29991,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         handleType, zirconHandle, pMemoryZirconHandleProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30528,8 +30048,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImportSemaphoreZirconHandleInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30592,8 +30111,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pGetZirconHandleInfo, pZirconHandle);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30672,8 +30190,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pCollection);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30732,8 +30249,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         collection, pImageConstraintsInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30793,8 +30309,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         collection, pBufferConstraintsInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30846,8 +30361,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30915,8 +30429,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pProperties);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -30985,8 +30498,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         renderpass, pMaxWorkgroupSize);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31016,8 +30528,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31061,8 +30572,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         imageLayout);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31124,8 +30634,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pMemoryGetRemoteAddressInfo, pAddress);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31163,8 +30672,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         patchControlPoints);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31201,8 +30709,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         rasterizerDiscardEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31237,8 +30744,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                     commandBuffer, depthBiasEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31271,8 +30777,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                             &m_pool, commandBuffer, logicOp);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31309,8 +30814,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         primitiveRestartEnable);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31391,8 +30895,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSurface);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31444,8 +30947,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         physicalDevice, queueFamilyIndex, window);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31491,8 +30993,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         attachmentCount, pColorWriteEnables);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31559,8 +31060,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAddress);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31721,8 +31221,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pImageInfos, pBufferInfos, pBufferViews);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31761,8 +31260,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pBeginInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31789,8 +31287,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31822,8 +31319,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, flags);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31860,8 +31356,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         needHostSync, sequenceNumber);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -31961,8 +31456,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pImage, pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32062,8 +31556,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pBuffer, pMemoryRequirements);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32165,8 +31658,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSize, pHostmemId);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32230,8 +31722,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkDeviceMemory(boxed_memory_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32265,8 +31756,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                                needHostSync, sequenceNumber);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32316,8 +31806,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pSubmits, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32343,8 +31832,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, queue);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32397,8 +31885,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pBindInfo, fence);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32447,8 +31934,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pRowPitchAlignment);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32503,8 +31989,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pOffset, pRowPitchAlignment);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32537,8 +32022,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         ioStream, (unsigned long long)queue, (unsigned long long)commandBuffer,
                         (unsigned long long)dataSize, (unsigned long long)pData);
                 }
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 m_state->on_vkQueueFlushCommandsGOOGLE(&m_pool, queue, commandBuffer, dataSize,
                                                        pData, context);
                 vkStream->unsetHandleMapping();
@@ -32671,8 +32155,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPendingDescriptorWrites);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32737,8 +32220,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pPoolIdCount, pPoolIds);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32797,8 +32279,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pWaitSemaphores, image);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32849,8 +32330,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         deviceMemory, dataOffset, dataSize);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32890,8 +32370,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                                                          device, memory);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -32964,8 +32443,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pVertexInfo, instanceCount, firstInstance, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33044,8 +32522,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pIndexInfo, instanceCount, firstInstance, stride, pVertexOffset);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33091,8 +32568,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, device, memory, priority);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33187,8 +32663,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pAllocator, pAccelerationStructure);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33249,8 +32724,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 }
                 delete_VkAccelerationStructureKHR(boxed_accelerationStructure_preserve);
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33307,8 +32781,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pInfos, ppBuildRangeInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33380,8 +32853,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pInfos, pIndirectDeviceAddresses, pIndirectStrides, ppMaxPrimitiveCounts);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33451,8 +32923,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         infoCount, pInfos, ppBuildRangeInfos);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33508,8 +32979,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33568,8 +33038,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         deferredOperation, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33628,8 +33097,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         deferredOperation, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33715,8 +33183,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pData, stride);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33757,8 +33224,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33800,8 +33266,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33843,8 +33308,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         snapshotTraceBegin, snapshotTraceBytes, &m_pool, commandBuffer, pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33893,8 +33357,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -33964,8 +33427,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         firstQuery);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34021,8 +33483,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCompatibility);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34103,8 +33564,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pBuildInfo, pMaxPrimitiveCounts, pSizeInfo);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34199,8 +33659,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCallableShaderBindingTable, width, height, depth);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34310,8 +33769,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34382,8 +33840,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipeline, firstGroup, groupCount, dataSize, pData);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34470,8 +33927,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pCallableShaderBindingTable, indirectDeviceAddress);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34524,8 +33980,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipeline, group, groupShader);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34563,8 +34018,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                         pipelineStackSize);
                 }
                 vkReadStream->clearPool();
-                if (queueSubmitWithCommandsEnabled)
-                    seqnoPtr->fetch_add(1, std::memory_order_seq_cst);
+                if (queueSubmitWithCommandsEnabled) seqnoPtr->complete();
                 android::base::endTrace();
                 break;
             }
@@ -34576,6 +34030,7 @@ size_t VkDecoder::Impl::decode(void* buf, size_t len, IOStream* ioStream,
                 return ptr - (unsigned char*)buf;
             }
         }
+        DecoderStats::finish(opcode, statsStartNs);
         ptr += packetLen;
     }
     if (m_forSnapshotLoad) {
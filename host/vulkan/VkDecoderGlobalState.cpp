@@ -14,15 +14,20 @@
 #include "VkDecoderGlobalState.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
 #include "BlobManager.h"
+#include "BoxedHandleStore.h"
 #include "FrameBuffer.h"
+#include "PersistentBlobCache.h"
+#include "PersistentPipelineCache.h"
 #include "RenderThreadInfoVk.h"
 #include "VkAndroidNativeBuffer.h"
 #include "VkCommonOperations.h"
@@ -34,7 +39,6 @@
 #include "aemu/base/Optional.h"
 #include "aemu/base/Tracing.h"
 #include "aemu/base/containers/EntityManager.h"
-#include "aemu/base/containers/HybridEntityManager.h"
 #include "aemu/base/containers/Lookup.h"
 #include "aemu/base/files/Stream.h"
 #include "aemu/base/memory/SharedMemory.h"
@@ -170,24 +174,22 @@ enum BoxedHandleTypeTag {
 template <class T>
 class BoxedHandleManager {
    public:
-    // The hybrid entity manager uses a sequence lock to protect access to
-    // a working set of 16000 handles, allowing us to avoid using a regular
-    // lock for those. Performance is degraded when going over this number,
-    // as it will then fall back to a std::map.
-    //
-    // We use 16000 as the max number of live handles to track; we don't
-    // expect the system to go over 16000 total live handles, outside some
-    // dEQP object management tests.
-    using Store = android::base::HybridEntityManager<16000, uint64_t, T>;
+    // Neither the store nor the reverse map take a lock, so creating and
+    // destroying objects from several render threads doesn't serialize here,
+    // and there is no limit past which they get slower.
+    using Store = BoxedHandleStore<T>;
 
+    // Only protects |delayedRemoves|.
     Lock lock;
     mutable Store store;
-    std::unordered_map<uint64_t, uint64_t> reverseMap;
+    BoxedHandleReverseMap reverseMap;
     struct DelayedRemove {
         uint64_t handle;
         std::function<void()> callback;
     };
     std::unordered_map<VkDevice, std::vector<DelayedRemove>> delayedRemoves;
+    // Number of entries in |delayedRemoves|, readable without |lock|.
+    std::atomic<size_t> delayedRemovesCount{0};
 
     void clear() {
         reverseMap.clear();
@@ -196,23 +198,20 @@ class BoxedHandleManager {
 
     uint64_t add(const T& item, BoxedHandleTypeTag tag) {
         auto res = (uint64_t)store.add(item, (size_t)tag);
-        AutoLock l(lock);
-        reverseMap[(uint64_t)(item.underlying)] = res;
+        reverseMap.set((uint64_t)(item.underlying), res);
         return res;
     }
 
     uint64_t addFixed(uint64_t handle, const T& item, BoxedHandleTypeTag tag) {
         auto res = (uint64_t)store.addFixed(handle, item, (size_t)tag);
-        AutoLock l(lock);
-        reverseMap[(uint64_t)(item.underlying)] = res;
+        reverseMap.set((uint64_t)(item.underlying), res);
         return res;
     }
 
     void remove(uint64_t h) {
         auto item = get(h);
         if (item) {
-            AutoLock l(lock);
-            reverseMap.erase((uint64_t)(item->underlying));
+            reverseMap.erase((uint64_t)(item->underlying), h);
         }
         store.remove(h);
     }
@@ -220,6 +219,14 @@ class BoxedHandleManager {
     void removeDelayed(uint64_t h, VkDevice device, std::function<void()> callback) {
         AutoLock l(lock);
         delayedRemoves[device].push_back({h, callback});
+        delayedRemovesCount.fetch_add(1, std::memory_order_release);
+    }
+
+    // Lets hot paths skip taking the global state lock to process delayed
+    // removes when there are none. May be stale, which only delays processing
+    // until the next check.
+    bool hasDelayedRemoves() const {
+        return delayedRemovesCount.load(std::memory_order_acquire) > 0;
     }
 
     void processDelayedRemovesGlobalStateLocked(VkDevice device) {
@@ -232,19 +239,16 @@ class BoxedHandleManager {
             // VkDecoderGlobalState is already locked when callback is called.
             auto funcGlobalStateLocked = r.callback;
             funcGlobalStateLocked();
-            store.remove(h);
+            remove(h);
         }
+        delayedRemovesCount.fetch_sub(delayedRemovesList.size(), std::memory_order_relaxed);
         delayedRemovesList.clear();
         delayedRemoves.erase(it);
     }
 
     T* get(uint64_t h) { return (T*)store.get_const(h); }
 
-    uint64_t getBoxedFromUnboxedLocked(uint64_t unboxed) {
-        auto* res = android::base::find(reverseMap, unboxed);
-        if (!res) return 0;
-        return *res;
-    }
+    uint64_t getBoxedFromUnboxed(uint64_t unboxed) { return reverseMap.get(unboxed); }
 };
 
 struct OrderMaintenanceInfo {
@@ -325,6 +329,16 @@ class VkDecoderGlobalState::Impl {
                                                 ->getPhysAddrStartLocked();
         }
         mGuestUsesAngle = feature_is_enabled(kFeature_GuestUsesAngle);
+        if (android::base::getEnvironmentVariable("ANDROID_EMU_VK_NO_PIPELINE_CACHE") != "1") {
+            PersistentBlobCache::Options options;
+            // Pipeline caches of a few drivers, very rough estimate.
+            options.maxBytes = 64 * 1024 * 1024;
+            options.directory =
+                android::base::getEnvironmentVariable("ANDROID_EMUGL_SHADER_CACHE_DIR");
+            options.name = "vk_pipeline_cache";
+            options.identity = "vk_pipeline_cache";
+            mPipelineCacheStore = std::make_unique<PersistentBlobCache>(std::move(options));
+        }
     }
 
     ~Impl() = default;
@@ -353,6 +367,8 @@ class VkDecoderGlobalState::Impl {
         mFramebufferInfo.clear();
         mSemaphoreInfo.clear();
         mFenceInfo.clear();
+        mAnyImageViewNeedsEmulatedAlpha = false;
+        mAnySamplerNeedsEmulatedAlpha = false;
 #ifdef _WIN32
         mSemaphoreId = 1;
         mExternalSemaphoresById.clear();
@@ -1291,6 +1307,12 @@ class VkDecoderGlobalState::Impl {
         deviceInfo.externalFencePool =
             std::make_unique<ExternalFencePool<VulkanDispatch>>(dispatch, *pDevice);
 
+        auto* physdevInfo = android::base::find(mPhysdevInfo, physicalDevice);
+        if (mPipelineCacheStore && physdevInfo) {
+            deviceInfo.pipelineCache = PersistentPipelineCache::create(
+                *pDevice, dispatch, physdevInfo->props, mPipelineCacheStore.get());
+        }
+
         if (mLogging) {
             fprintf(stderr, "%s: init vulkan dispatch from device (end)\n", __func__);
         }
@@ -1326,13 +1348,15 @@ class VkDecoderGlobalState::Impl {
                     fprintf(stderr, "%s: get device queue (end)\n", __func__);
                 }
                 queues.push_back(queueOut);
-                mQueueInfo[queueOut].device = *pDevice;
-                mQueueInfo[queueOut].queueFamilyIndex = index;
 
                 auto boxed = new_boxed_VkQueue(queueOut, dispatch_VkDevice(deviceInfo.boxed),
                                                false /* does not own dispatch */);
-                mQueueInfo[queueOut].boxed = boxed;
-                mQueueInfo[queueOut].lock = new Lock;
+                mQueueInfo.accessOrCreate(queueOut, [&](QueueInfo& queueInfo) {
+                    queueInfo.device = *pDevice;
+                    queueInfo.queueFamilyIndex = index;
+                    queueInfo.boxed = boxed;
+                    queueInfo.lock = new Lock;
+                });
             }
         }
 
@@ -1365,10 +1389,9 @@ class VkDecoderGlobalState::Impl {
 
         VkQueue unboxedQueue = (*queueList)[queueIndex];
 
-        auto* queueInfo = android::base::find(mQueueInfo, unboxedQueue);
-        if (!queueInfo) return;
-
-        *pQueue = (VkQueue)queueInfo->boxed;
+        mQueueInfo.access(unboxedQueue, [pQueue](QueueInfo* queueInfo) {
+            if (queueInfo) *pQueue = queueInfo->boxed;
+        });
     }
 
     void on_vkGetDeviceQueue2(android::base::BumpPool* pool, VkDevice boxed_device,
@@ -1392,15 +1415,15 @@ class VkDecoderGlobalState::Impl {
 
         deviceInfo->decompPipelines->clear();
 
-        auto eraseIt = mQueueInfo.begin();
-        for (; eraseIt != mQueueInfo.end();) {
-            if (eraseIt->second.device == device) {
-                delete eraseIt->second.lock;
-                delete_VkQueue(eraseIt->second.boxed);
-                eraseIt = mQueueInfo.erase(eraseIt);
-            } else {
-                ++eraseIt;
-            }
+        std::vector<QueueInfo> queueInfos;
+        mQueueInfo.eraseIf([device, &queueInfos](VkQueue, const QueueInfo& queueInfo) {
+            if (queueInfo.device != device) return false;
+            queueInfos.push_back(queueInfo);
+            return true;
+        });
+        for (const QueueInfo& queueInfo : queueInfos) {
+            delete queueInfo.lock;
+            delete_VkQueue(queueInfo.boxed);
         }
 
         VulkanDispatch* deviceDispatch = dispatch_VkDevice(deviceInfo->boxed);
@@ -1417,6 +1440,9 @@ class VkDecoderGlobalState::Impl {
             mFenceInfo.erase(fence);
         }
 
+        // Saves the pipeline cache too.
+        deviceInfo->pipelineCache.reset();
+
         // Run the underlying API call.
         m_vk->vkDestroyDevice(device, pAllocator);
 
@@ -1446,9 +1472,10 @@ class VkDecoderGlobalState::Impl {
 
         if (result == VK_SUCCESS) {
             std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto& bufInfo = mBufferInfo[*pBuffer];
-            bufInfo.device = device;
-            bufInfo.size = pCreateInfo->size;
+            mBufferInfo.accessOrCreate(*pBuffer, [&](BufferInfo& bufInfo) {
+                bufInfo.device = device;
+                bufInfo.size = pCreateInfo->size;
+            });
             *pBuffer = new_boxed_non_dispatchable_VkBuffer(*pBuffer);
         }
 
@@ -1466,12 +1493,26 @@ class VkDecoderGlobalState::Impl {
         mBufferInfo.erase(buffer);
     }
 
-    void setBufferMemoryBindInfoLocked(VkBuffer buffer, VkDeviceMemory memory,
-                                       VkDeviceSize memoryOffset) {
-        auto* bufferInfo = android::base::find(mBufferInfo, buffer);
-        if (!bufferInfo) return;
-        bufferInfo->memory = memory;
-        bufferInfo->memoryOffset = memoryOffset;
+    std::optional<QueueInfo> getQueueInfo(VkQueue queue) {
+        return mQueueInfo.access(queue, [](QueueInfo* queueInfo) {
+            return queueInfo ? std::make_optional(*queueInfo) : std::nullopt;
+        });
+    }
+
+    std::optional<BufferInfo> getBufferInfo(VkBuffer buffer) {
+        return mBufferInfo.access(buffer, [](BufferInfo* bufferInfo) {
+            return bufferInfo ? std::make_optional(*bufferInfo) : std::nullopt;
+        });
+    }
+
+    // Buffer infos are sharded, so this doesn't need the global lock.
+    void setBufferMemoryBindInfo(VkBuffer buffer, VkDeviceMemory memory,
+                                 VkDeviceSize memoryOffset) {
+        mBufferInfo.access(buffer, [memory, memoryOffset](BufferInfo* bufferInfo) {
+            if (!bufferInfo) return;
+            bufferInfo->memory = memory;
+            bufferInfo->memoryOffset = memoryOffset;
+        });
     }
 
     VkResult on_vkBindBufferMemory(android::base::BumpPool* pool, VkDevice boxed_device,
@@ -1484,8 +1525,7 @@ class VkDecoderGlobalState::Impl {
         VkResult result = vk->vkBindBufferMemory(device, buffer, memory, memoryOffset);
 
         if (result == VK_SUCCESS) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            setBufferMemoryBindInfoLocked(buffer, memory, memoryOffset);
+            setBufferMemoryBindInfo(buffer, memory, memoryOffset);
         }
         return result;
     }
@@ -1502,10 +1542,9 @@ class VkDecoderGlobalState::Impl {
         VkResult result = vk->vkBindBufferMemory2(device, bindInfoCount, pBindInfos);
 
         if (result == VK_SUCCESS) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
             for (uint32_t i = 0; i < bindInfoCount; ++i) {
-                setBufferMemoryBindInfoLocked(pBindInfos[i].buffer, pBindInfos[i].memory,
-                                              pBindInfos[i].memoryOffset);
+                setBufferMemoryBindInfo(pBindInfos[i].buffer, pBindInfos[i].memory,
+                                        pBindInfos[i].memoryOffset);
             }
         }
 
@@ -1524,10 +1563,9 @@ class VkDecoderGlobalState::Impl {
         VkResult result = vk->vkBindBufferMemory2KHR(device, bindInfoCount, pBindInfos);
 
         if (result == VK_SUCCESS) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
             for (uint32_t i = 0; i < bindInfoCount; ++i) {
-                setBufferMemoryBindInfoLocked(pBindInfos[i].buffer, pBindInfos[i].memory,
-                                              pBindInfos[i].memoryOffset);
+                setBufferMemoryBindInfo(pBindInfos[i].buffer, pBindInfos[i].memory,
+                                        pBindInfos[i].memoryOffset);
             }
         }
 
@@ -1826,6 +1864,9 @@ class VkDecoderGlobalState::Impl {
         auto& imageViewInfo = mImageViewInfo[*pView];
         imageViewInfo.device = device;
         imageViewInfo.needEmulatedAlpha = needEmulatedAlpha;
+        if (needEmulatedAlpha) {
+            mAnyImageViewNeedsEmulatedAlpha.store(true, std::memory_order_release);
+        }
 
         *pView = new_boxed_non_dispatchable_VkImageView(*pView);
 
@@ -1866,6 +1907,9 @@ class VkDecoderGlobalState::Impl {
              pCreateInfo->borderColor == VK_BORDER_COLOR_INT_TRANSPARENT_BLACK ||
              pCreateInfo->borderColor == VK_BORDER_COLOR_FLOAT_CUSTOM_EXT ||
              pCreateInfo->borderColor == VK_BORDER_COLOR_INT_CUSTOM_EXT);
+        if (samplerInfo.needEmulatedAlpha) {
+            mAnySamplerNeedsEmulatedAlpha.store(true, std::memory_order_release);
+        }
 
         *pSampler = new_boxed_non_dispatchable_VkSampler(*pSampler);
 
@@ -1986,16 +2030,17 @@ class VkDecoderGlobalState::Impl {
         {
             std::lock_guard<std::recursive_mutex> lock(mLock);
 
-            DCHECK(fenceReused || mFenceInfo.find(*pFence) == mFenceInfo.end());
+            DCHECK(fenceReused || !mFenceInfo.contains(*pFence));
+            VkFence boxed = new_boxed_non_dispatchable_VkFence(*pFence);
             // Create FenceInfo for *pFence.
-            auto& fenceInfo = mFenceInfo[*pFence];
-            fenceInfo.device = device;
-            fenceInfo.vk = vk;
-
-            *pFence = new_boxed_non_dispatchable_VkFence(*pFence);
-            fenceInfo.boxed = *pFence;
-            fenceInfo.external = exportSyncFd;
-            fenceInfo.state = FenceInfo::State::kNotWaitable;
+            mFenceInfo.accessOrCreate(*pFence, [&](FenceInfo& fenceInfo) {
+                fenceInfo.device = device;
+                fenceInfo.vk = vk;
+                fenceInfo.boxed = boxed;
+                fenceInfo.external = exportSyncFd;
+                setFenceState(fenceInfo, FenceInfo::State::kNotWaitable);
+            });
+            *pFence = boxed;
         }
 
         return VK_SUCCESS;
@@ -2009,20 +2054,20 @@ class VkDecoderGlobalState::Impl {
         std::vector<VkFence> cleanedFences;
         std::vector<VkFence> externalFences;
 
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            for (uint32_t i = 0; i < fenceCount; i++) {
-                if (pFences[i] == VK_NULL_HANDLE) continue;
+        for (uint32_t i = 0; i < fenceCount; i++) {
+            if (pFences[i] == VK_NULL_HANDLE) continue;
 
-                DCHECK(mFenceInfo.find(pFences[i]) != mFenceInfo.end());
-                if (mFenceInfo[pFences[i]].external) {
+            mFenceInfo.access(pFences[i], [&](FenceInfo* fenceInfo) {
+                DCHECK(fenceInfo);
+                if (!fenceInfo) return;
+                if (fenceInfo->external) {
                     externalFences.push_back(pFences[i]);
                 } else {
                     // Reset all fences' states to kNotWaitable.
                     cleanedFences.push_back(pFences[i]);
-                    mFenceInfo[pFences[i]].state = FenceInfo::State::kNotWaitable;
+                    setFenceState(*fenceInfo, FenceInfo::State::kNotWaitable);
                 }
-            }
+            });
         }
 
         VK_CHECK(vk->vkResetFences(device, (uint32_t)cleanedFences.size(), cleanedFences.data()));
@@ -2046,14 +2091,16 @@ class VkDecoderGlobalState::Impl {
                 delete_VkFence(boxed_fence);
                 set_boxed_non_dispatchable_VkFence(boxed_fence, replacement);
 
-                auto& fenceInfo = mFenceInfo[replacement];
-                fenceInfo.device = device;
-                fenceInfo.vk = vk;
-                fenceInfo.boxed = boxed_fence;
-                fenceInfo.external = true;
-                fenceInfo.state = FenceInfo::State::kNotWaitable;
+                mFenceInfo.accessOrCreate(replacement, [&](FenceInfo& fenceInfo) {
+                    fenceInfo.device = device;
+                    fenceInfo.vk = vk;
+                    fenceInfo.boxed = boxed_fence;
+                    fenceInfo.external = true;
+                    setFenceState(fenceInfo, FenceInfo::State::kNotWaitable);
+                });
 
-                mFenceInfo[fence].boxed = VK_NULL_HANDLE;
+                mFenceInfo.accessOrCreate(
+                    fence, [](FenceInfo& fenceInfo) { fenceInfo.boxed = VK_NULL_HANDLE; });
             }
         }
 
@@ -2162,11 +2209,14 @@ class VkDecoderGlobalState::Impl {
             std::lock_guard<std::recursive_mutex> lock(mLock);
             // External fences are just slated for recycling. This addresses known
             // behavior where the guest might destroy the fence prematurely. b/228221208
-            if (mFenceInfo[fence].external) {
+            const bool external = mFenceInfo.access(
+                fence, [](FenceInfo* fenceInfo) { return fenceInfo && fenceInfo->external; });
+            if (external) {
                 auto* deviceInfo = android::base::find(mDeviceInfo, device);
                 if (deviceInfo) {
                     deviceInfo->externalFencePool->add(fence);
-                    mFenceInfo[fence].boxed = VK_NULL_HANDLE;
+                    mFenceInfo.access(
+                        fence, [](FenceInfo* fenceInfo) { fenceInfo->boxed = VK_NULL_HANDLE; });
                     return;
                 }
             }
@@ -2417,6 +2467,16 @@ class VkDecoderGlobalState::Impl {
         auto device = unbox_VkDevice(boxed_device);
         auto vk = dispatch_VkDevice(boxed_device);
 
+        // The writes only need to be patched, which requires the image view and
+        // sampler infos, if an image view and a sampler both need emulated
+        // alpha. That is rare enough to not take the lock for every update.
+        if (!mAnyImageViewNeedsEmulatedAlpha.load(std::memory_order_acquire) ||
+            !mAnySamplerNeedsEmulatedAlpha.load(std::memory_order_acquire)) {
+            vk->vkUpdateDescriptorSets(device, descriptorWriteCount, pDescriptorWrites,
+                                       descriptorCopyCount, pDescriptorCopies);
+            return;
+        }
+
         std::lock_guard<std::recursive_mutex> lock(mLock);
         on_vkUpdateDescriptorSetsImpl(pool, vk, device, descriptorWriteCount, pDescriptorWrites,
                                       descriptorCopyCount, pDescriptorCopies);
@@ -2575,8 +2635,13 @@ class VkDecoderGlobalState::Impl {
         auto device = unbox_VkDevice(boxed_device);
         auto deviceDispatch = dispatch_VkDevice(boxed_device);
 
-        VkResult result =
-            deviceDispatch->vkCreatePipelineCache(device, pCreateInfo, pAllocator, pPipelineCache);
+        VkResult result;
+        if (auto* hostCache = getPipelineCache(device)) {
+            result = hostCache->createGuestCache(pCreateInfo, pAllocator, pPipelineCache);
+        } else {
+            result = deviceDispatch->vkCreatePipelineCache(device, pCreateInfo, pAllocator,
+                                                           pPipelineCache);
+        }
         if (result != VK_SUCCESS) {
             return result;
         }
@@ -2594,6 +2659,10 @@ class VkDecoderGlobalState::Impl {
     void destroyPipelineCacheLocked(VkDevice device, VulkanDispatch* deviceDispatch,
                                     VkPipelineCache pipelineCache,
                                     const VkAllocationCallbacks* pAllocator) {
+        auto* deviceInfo = android::base::find(mDeviceInfo, device);
+        if (deviceInfo && deviceInfo->pipelineCache) {
+            deviceInfo->pipelineCache->onGuestCacheDestroyed(pipelineCache);
+        }
         deviceDispatch->vkDestroyPipelineCache(device, pipelineCache, pAllocator);
 
         mPipelineCacheInfo.erase(pipelineCache);
@@ -2617,22 +2686,64 @@ class VkDecoderGlobalState::Impl {
         auto device = unbox_VkDevice(boxed_device);
         auto deviceDispatch = dispatch_VkDevice(boxed_device);
 
+        std::optional<PersistentPipelineCache::ScopedUse> hostCacheUse;
+        if (auto* hostCache = getPipelineCache(device)) {
+            hostCacheUse.emplace(hostCache->onCreatePipelines(pipelineCache));
+            pipelineCache = hostCacheUse->handle();
+        }
         VkResult result = deviceDispatch->vkCreateGraphicsPipelines(
             device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+        // Guest caches get merged into the host cache under |mLock|.
+        hostCacheUse.reset();
         if (result != VK_SUCCESS) {
             return result;
         }
 
         std::lock_guard<std::recursive_mutex> lock(mLock);
+        boxPipelinesLocked(device, createInfoCount, pPipelines);
+        return result;
+    }
+
+    VkResult on_vkCreateComputePipelines(android::base::BumpPool* pool, VkDevice boxed_device,
+                                         VkPipelineCache pipelineCache, uint32_t createInfoCount,
+                                         const VkComputePipelineCreateInfo* pCreateInfos,
+                                         const VkAllocationCallbacks* pAllocator,
+                                         VkPipeline* pPipelines) {
+        auto device = unbox_VkDevice(boxed_device);
+        auto deviceDispatch = dispatch_VkDevice(boxed_device);
 
-        for (uint32_t i = 0; i < createInfoCount; i++) {
+        std::optional<PersistentPipelineCache::ScopedUse> hostCacheUse;
+        if (auto* hostCache = getPipelineCache(device)) {
+            hostCacheUse.emplace(hostCache->onCreatePipelines(pipelineCache));
+            pipelineCache = hostCacheUse->handle();
+        }
+        VkResult result = deviceDispatch->vkCreateComputePipelines(
+            device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+        // Guest caches get merged into the host cache under |mLock|.
+        hostCacheUse.reset();
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mLock);
+        boxPipelinesLocked(device, createInfoCount, pPipelines);
+        return result;
+    }
+
+    void boxPipelinesLocked(VkDevice device, uint32_t pipelineCount, VkPipeline* pPipelines) {
+        for (uint32_t i = 0; i < pipelineCount; i++) {
             auto& pipelineInfo = mPipelineInfo[pPipelines[i]];
             pipelineInfo.device = device;
 
             pPipelines[i] = new_boxed_non_dispatchable_VkPipeline(pPipelines[i]);
         }
+    }
 
-        return result;
+    // The host's pipeline cache of |device|, which lives as long as the device does.
+    PersistentPipelineCache* getPipelineCache(VkDevice device) {
+        std::lock_guard<std::recursive_mutex> lock(mLock);
+        auto* deviceInfo = android::base::find(mDeviceInfo, device);
+        return deviceInfo ? deviceInfo->pipelineCache.get() : nullptr;
     }
 
     void destroyPipelineLocked(VkDevice device, VulkanDispatch* deviceDispatch, VkPipeline pipeline,
@@ -2699,7 +2810,7 @@ class VkDecoderGlobalState::Impl {
 
         std::lock_guard<std::recursive_mutex> lock(mLock);
         auto* imageInfo = android::base::find(mImageInfo, srcImage);
-        auto* bufferInfo = android::base::find(mBufferInfo, dstBuffer);
+        std::optional<BufferInfo> bufferInfo = getBufferInfo(dstBuffer);
         if (!imageInfo || !bufferInfo) return;
         auto* deviceInfo = android::base::find(mDeviceInfo, bufferInfo->device);
         if (!deviceInfo) return;
@@ -2813,7 +2924,7 @@ class VkDecoderGlobalState::Impl {
         std::lock_guard<std::recursive_mutex> lock(mLock);
         auto* imageInfo = android::base::find(mImageInfo, dstImage);
         if (!imageInfo) return;
-        auto* bufferInfo = android::base::find(mBufferInfo, srcBuffer);
+        std::optional<BufferInfo> bufferInfo = getBufferInfo(srcBuffer);
         if (!bufferInfo) {
             return;
         }
@@ -2827,8 +2938,7 @@ class VkDecoderGlobalState::Impl {
                                        regionCount, pRegions);
             return;
         }
-        auto* cmdBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-        if (!cmdBufferInfo) {
+        if (!mCmdBufferInfo.contains(commandBuffer)) {
             return;
         }
         CompressedImageInfo& cmpInfo = imageInfo->cmpInfo;
@@ -2904,11 +3014,14 @@ class VkDecoderGlobalState::Impl {
                                      pImageMemoryBarriers);
             return;
         }
-        std::lock_guard<std::recursive_mutex> lock(mLock);
-        CommandBufferInfo* cmdBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-        if (!cmdBufferInfo) return;
+        std::optional<VkDevice> device =
+            mCmdBufferInfo.access(commandBuffer, [](CommandBufferInfo* cmdBufferInfo) {
+                return cmdBufferInfo ? std::make_optional(cmdBufferInfo->device) : std::nullopt;
+            });
+        if (!device) return;
 
-        DeviceInfo* deviceInfo = android::base::find(mDeviceInfo, cmdBufferInfo->device);
+        std::lock_guard<std::recursive_mutex> lock(mLock);
+        DeviceInfo* deviceInfo = android::base::find(mDeviceInfo, *device);
         if (!deviceInfo) return;
 
         if (!deviceInfo->emulateTextureEtc2 && !deviceInfo->emulateTextureAstc) {
@@ -2939,19 +3052,22 @@ class VkDecoderGlobalState::Impl {
                 vk, commandBuffer, srcStageMask, dstStageMask, srcBarrier, imageBarriers);
         }
 
-        if (needRebind && cmdBufferInfo->computePipeline) {
-            // Recover pipeline bindings
-            // TODO(gregschlom): instead of doing this here again and again after each image we
-            // decompress, could we do it once before calling vkCmdDispatch?
-            vk->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                  cmdBufferInfo->computePipeline);
-            if (!cmdBufferInfo->descriptorSets.empty()) {
-                vk->vkCmdBindDescriptorSets(
-                    commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cmdBufferInfo->descriptorLayout,
-                    cmdBufferInfo->firstSet, cmdBufferInfo->descriptorSets.size(),
-                    cmdBufferInfo->descriptorSets.data(), cmdBufferInfo->dynamicOffsets.size(),
-                    cmdBufferInfo->dynamicOffsets.data());
-            }
+        if (needRebind) {
+            mCmdBufferInfo.access(commandBuffer, [&](CommandBufferInfo* cmdBufferInfo) {
+                if (!cmdBufferInfo || !cmdBufferInfo->computePipeline) return;
+                // Recover pipeline bindings
+                // TODO(gregschlom): instead of doing this here again and again after each image
+                // we decompress, could we do it once before calling vkCmdDispatch?
+                vk->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                      cmdBufferInfo->computePipeline);
+                if (!cmdBufferInfo->descriptorSets.empty()) {
+                    vk->vkCmdBindDescriptorSets(
+                        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        cmdBufferInfo->descriptorLayout, cmdBufferInfo->firstSet,
+                        cmdBufferInfo->descriptorSets.size(), cmdBufferInfo->descriptorSets.data(),
+                        cmdBufferInfo->dynamicOffsets.size(), cmdBufferInfo->dynamicOffsets.data());
+                }
+            });
         }
 
         // Apply the remaining barriers
@@ -3630,7 +3746,7 @@ class VkDecoderGlobalState::Impl {
 
         std::lock_guard<std::recursive_mutex> lock(mLock);
 
-        auto* queueInfo = android::base::find(mQueueInfo, queue);
+        std::optional<QueueInfo> queueInfo = getQueueInfo(queue);
         if (!queueInfo) return VK_ERROR_INITIALIZATION_FAILED;
 
         if (mRenderDocWithMultipleVkInstances) {
@@ -3840,13 +3956,16 @@ class VkDecoderGlobalState::Impl {
         if (!deviceInfo) return VK_ERROR_UNKNOWN;
 
         for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++) {
-            mCmdBufferInfo[pCommandBuffers[i]] = CommandBufferInfo();
-            mCmdBufferInfo[pCommandBuffers[i]].device = device;
-            mCmdBufferInfo[pCommandBuffers[i]].debugUtilsHelper = deviceInfo->debugUtilsHelper;
-            mCmdBufferInfo[pCommandBuffers[i]].cmdPool = pAllocateInfo->commandPool;
             auto boxed = new_boxed_VkCommandBuffer(pCommandBuffers[i], vk,
                                                    false /* does not own dispatch */);
-            mCmdBufferInfo[pCommandBuffers[i]].boxed = boxed;
+            mCmdBufferInfo.accessOrCreate(
+                pCommandBuffers[i], [&](CommandBufferInfo& cmdBufferInfo) {
+                    cmdBufferInfo = CommandBufferInfo();
+                    cmdBufferInfo.device = device;
+                    cmdBufferInfo.debugUtilsHelper = deviceInfo->debugUtilsHelper;
+                    cmdBufferInfo.cmdPool = pAllocateInfo->commandPool;
+                    cmdBufferInfo.boxed = boxed;
+                });
             pCommandBuffers[i] = (VkCommandBuffer)boxed;
         }
         return result;
@@ -3908,10 +4027,10 @@ class VkDecoderGlobalState::Impl {
         auto vk = dispatch_VkCommandBuffer(boxed_commandBuffer);
 
         vk->vkCmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
-        std::lock_guard<std::recursive_mutex> lock(mLock);
-        CommandBufferInfo& cmdBuffer = mCmdBufferInfo[commandBuffer];
-        cmdBuffer.subCmds.insert(cmdBuffer.subCmds.end(), pCommandBuffers,
-                                 pCommandBuffers + commandBufferCount);
+        mCmdBufferInfo.accessOrCreate(commandBuffer, [&](CommandBufferInfo& cmdBuffer) {
+            cmdBuffer.subCmds.insert(cmdBuffer.subCmds.end(), pCommandBuffers,
+                                     pCommandBuffers + commandBufferCount);
+        });
     }
 
     VkResult on_vkQueueSubmit(android::base::BumpPool* pool, VkQueue boxed_queue,
@@ -3919,43 +4038,43 @@ class VkDecoderGlobalState::Impl {
         auto queue = unbox_VkQueue(boxed_queue);
         auto vk = dispatch_VkQueue(boxed_queue);
 
-        Lock* ql;
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
+        Lock* ql = nullptr;
+        VkDevice device = VK_NULL_HANDLE;
+        mQueueInfo.access(queue, [&](QueueInfo* queueInfo) {
+            if (!queueInfo) return;
+            ql = queueInfo->lock;
+            device = queueInfo->device;
+        });
 
-            {
-                auto* queueInfo = android::base::find(mQueueInfo, queue);
-                if (queueInfo) {
-                    sBoxedHandleManager.processDelayedRemovesGlobalStateLocked(queueInfo->device);
-                }
-            }
+        // Only take the global lock when there is something to clean up, as
+        // submits from different render threads would otherwise serialize here.
+        if (ql && sBoxedHandleManager.hasDelayedRemoves()) {
+            std::lock_guard<std::recursive_mutex> lock(mLock);
+            sBoxedHandleManager.processDelayedRemovesGlobalStateLocked(device);
+        }
 
-            for (uint32_t i = 0; i < submitCount; i++) {
-                const VkSubmitInfo& submit = pSubmits[i];
-                for (uint32_t c = 0; c < submit.commandBufferCount; c++) {
-                    executePreprocessRecursive(0, submit.pCommandBuffers[c]);
-                }
+        for (uint32_t i = 0; i < submitCount; i++) {
+            const VkSubmitInfo& submit = pSubmits[i];
+            for (uint32_t c = 0; c < submit.commandBufferCount; c++) {
+                executePreprocessRecursive(0, submit.pCommandBuffers[c]);
             }
-
-            auto* queueInfo = android::base::find(mQueueInfo, queue);
-            if (!queueInfo) return VK_SUCCESS;
-            ql = queueInfo->lock;
         }
 
+        if (!ql) return VK_SUCCESS;
+
         AutoLock qlock(*ql);
         auto result = vk->vkQueueSubmit(queue, submitCount, pSubmits, fence);
 
         // After vkQueueSubmit is called, we can signal the conditional variable
         // in FenceInfo, so that other threads (e.g. SyncThread) can call
         // waitForFence() on this fence.
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto* fenceInfo = android::base::find(mFenceInfo, fence);
-            if (fenceInfo) {
-                fenceInfo->state = FenceInfo::State::kWaitable;
+        if (fence != VK_NULL_HANDLE) {
+            mFenceInfo.access(fence, [](FenceInfo* fenceInfo) {
+                if (!fenceInfo) return;
                 fenceInfo->lock.lock();
+                fenceInfo->state = FenceInfo::State::kWaitable;
                 fenceInfo->cv.signalAndUnlock(&fenceInfo->lock);
-            }
+            });
         }
 
         return result;
@@ -3967,13 +4086,9 @@ class VkDecoderGlobalState::Impl {
 
         if (!queue) return VK_SUCCESS;
 
-        Lock* ql;
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto* queueInfo = android::base::find(mQueueInfo, queue);
-            if (!queueInfo) return VK_SUCCESS;
-            ql = queueInfo->lock;
-        }
+        Lock* ql = mQueueInfo.access(
+            queue, [](QueueInfo* queueInfo) { return queueInfo ? queueInfo->lock : nullptr; });
+        if (!ql) return VK_SUCCESS;
 
         AutoLock qlock(*ql);
         return vk->vkQueueWaitIdle(queue);
@@ -3987,9 +4102,8 @@ class VkDecoderGlobalState::Impl {
 
         VkResult result = vk->vkResetCommandBuffer(commandBuffer, flags);
         if (VK_SUCCESS == result) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto& bufferInfo = mCmdBufferInfo[commandBuffer];
-            bufferInfo.reset();
+            mCmdBufferInfo.accessOrCreate(
+                commandBuffer, [](CommandBufferInfo& bufferInfo) { bufferInfo.reset(); });
         }
         return result;
     }
@@ -4004,15 +4118,19 @@ class VkDecoderGlobalState::Impl {
         vk->vkFreeCommandBuffers(device, commandPool, commandBufferCount, pCommandBuffers);
         std::lock_guard<std::recursive_mutex> lock(mLock);
         for (uint32_t i = 0; i < commandBufferCount; i++) {
-            const auto& cmdBufferInfoIt = mCmdBufferInfo.find(pCommandBuffers[i]);
-            if (cmdBufferInfoIt != mCmdBufferInfo.end()) {
-                const auto& cmdPoolInfoIt = mCmdPoolInfo.find(cmdBufferInfoIt->second.cmdPool);
+            std::optional<VkCommandPool> cmdPool =
+                mCmdBufferInfo.access(pCommandBuffers[i], [](CommandBufferInfo* cmdBufferInfo) {
+                    return cmdBufferInfo ? std::make_optional(cmdBufferInfo->cmdPool)
+                                         : std::nullopt;
+                });
+            if (cmdPool) {
+                const auto& cmdPoolInfoIt = mCmdPoolInfo.find(*cmdPool);
                 if (cmdPoolInfoIt != mCmdPoolInfo.end()) {
                     cmdPoolInfoIt->second.cmdBuffers.erase(pCommandBuffers[i]);
                 }
                 // Done in decoder
                 // delete_VkCommandBuffer(cmdBufferInfoIt->second.boxed);
-                mCmdBufferInfo.erase(cmdBufferInfoIt);
+                mCmdBufferInfo.erase(pCommandBuffers[i]);
             }
         }
     }
@@ -4282,18 +4400,17 @@ class VkDecoderGlobalState::Impl {
             return result;
         }
 
-        std::lock_guard<std::recursive_mutex> lock(mLock);
+        return mCmdBufferInfo.access(commandBuffer, [&](CommandBufferInfo* commandBufferInfo) {
+            if (!commandBufferInfo) return VK_ERROR_UNKNOWN;
+            commandBufferInfo->reset();
 
-        auto* commandBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-        if (!commandBufferInfo) return VK_ERROR_UNKNOWN;
-        commandBufferInfo->reset();
-
-        if (context.processName) {
-            commandBufferInfo->debugUtilsHelper.cmdBeginDebugLabel(commandBuffer, "Process %s",
-                                                                   context.processName);
-        }
+            if (context.processName) {
+                commandBufferInfo->debugUtilsHelper.cmdBeginDebugLabel(
+                    commandBuffer, "Process %s", context.processName);
+            }
 
-        return VK_SUCCESS;
+            return VK_SUCCESS;
+        });
     }
 
     VkResult on_vkBeginCommandBufferAsyncGOOGLE(android::base::BumpPool* pool,
@@ -4309,14 +4426,15 @@ class VkDecoderGlobalState::Impl {
         auto commandBuffer = unbox_VkCommandBuffer(boxed_commandBuffer);
         auto vk = dispatch_VkCommandBuffer(boxed_commandBuffer);
 
-        std::lock_guard<std::recursive_mutex> lock(mLock);
-
-        auto* commandBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-        if (!commandBufferInfo) return VK_ERROR_UNKNOWN;
-
-        if (context.processName) {
-            commandBufferInfo->debugUtilsHelper.cmdEndDebugLabel(commandBuffer);
-        }
+        const bool found =
+            mCmdBufferInfo.access(commandBuffer, [&](CommandBufferInfo* commandBufferInfo) {
+                if (!commandBufferInfo) return false;
+                if (context.processName) {
+                    commandBufferInfo->debugUtilsHelper.cmdEndDebugLabel(commandBuffer);
+                }
+                return true;
+            });
+        if (!found) return VK_ERROR_UNKNOWN;
 
         return vk->vkEndCommandBuffer(commandBuffer);
     }
@@ -4339,11 +4457,11 @@ class VkDecoderGlobalState::Impl {
         auto vk = dispatch_VkCommandBuffer(boxed_commandBuffer);
         vk->vkCmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
         if (pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto* cmdBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-            if (cmdBufferInfo) {
-                cmdBufferInfo->computePipeline = pipeline;
-            }
+            mCmdBufferInfo.access(commandBuffer, [pipeline](CommandBufferInfo* cmdBufferInfo) {
+                if (cmdBufferInfo) {
+                    cmdBufferInfo->computePipeline = pipeline;
+                }
+            });
         }
     }
 
@@ -4359,9 +4477,8 @@ class VkDecoderGlobalState::Impl {
                                     descriptorSetCount, pDescriptorSets, dynamicOffsetCount,
                                     pDynamicOffsets);
         if (pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            auto* cmdBufferInfo = android::base::find(mCmdBufferInfo, commandBuffer);
-            if (cmdBufferInfo) {
+            mCmdBufferInfo.access(commandBuffer, [&](CommandBufferInfo* cmdBufferInfo) {
+                if (!cmdBufferInfo) return;
                 cmdBufferInfo->descriptorLayout = layout;
 
                 if (descriptorSetCount) {
@@ -4371,7 +4488,7 @@ class VkDecoderGlobalState::Impl {
                     cmdBufferInfo->dynamicOffsets.assign(pDynamicOffsets,
                                                          pDynamicOffsets + dynamicOffsetCount);
                 }
-            }
+            });
         }
     }
 
@@ -4467,7 +4584,10 @@ class VkDecoderGlobalState::Impl {
             // Some drivers don't seem to handle stride==0 very well.
             // In fact, the spec does not say what should happen with stride==0.
             // So we just use the largest stride possible.
-            stride = mBufferInfo[dstBuffer].size - dstOffset;
+            std::optional<BufferInfo> bufferInfo = getBufferInfo(dstBuffer);
+            if (bufferInfo) {
+                stride = bufferInfo->size - dstOffset;
+            }
         }
         vk->vkCmdCopyQueryPoolResults(commandBuffer, queryPool, firstQuery, queryCount, dstBuffer,
                                       dstOffset, stride, flags);
@@ -4802,7 +4922,7 @@ class VkDecoderGlobalState::Impl {
         auto queue = unbox_VkQueue(boxed_queue);
         auto vk = dispatch_VkQueue(boxed_queue);
 
-        auto* queueInfo = android::base::find(mQueueInfo, queue);
+        std::optional<QueueInfo> queueInfo = getQueueInfo(queue);
         if (queueInfo) {
             device = queueInfo->device;
         } else {
@@ -4915,17 +5035,23 @@ class VkDecoderGlobalState::Impl {
         }
     }
 
+    static void setFenceState(FenceInfo& fenceInfo, FenceInfo::State state) {
+        fenceInfo.lock.lock();
+        fenceInfo.state = state;
+        fenceInfo.lock.unlock();
+    }
+
     VkResult waitForFence(VkFence boxed_fence, uint64_t timeout) {
         VkFence fence;
         VkDevice device;
         VulkanDispatch* vk;
-        StaticLock* fenceLock;
-        ConditionVariable* cv;
+        FenceInfo* fenceInfo;
         {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-
             fence = unbox_VkFence(boxed_fence);
-            if (fence == VK_NULL_HANDLE || mFenceInfo.find(fence) == mFenceInfo.end()) {
+            fenceInfo = fence == VK_NULL_HANDLE
+                            ? nullptr
+                            : mFenceInfo.access(fence, [](FenceInfo* info) { return info; });
+            if (!fenceInfo) {
                 // No fence, could be a semaphore.
                 // TODO: Async wait for semaphores
                 return VK_SUCCESS;
@@ -4942,29 +5068,28 @@ class VkDecoderGlobalState::Impl {
             // https://www.khronos.org/registry/vulkan/specs/1.2/html/vkspec.html#fundamentals-threadingbehavior
             // https://github.com/KhronosGroup/Vulkan-LoaderAndValidationLayers/issues/519
 
-            device = mFenceInfo[fence].device;
-            vk = mFenceInfo[fence].vk;
-            fenceLock = &mFenceInfo[fence].lock;
-            cv = &mFenceInfo[fence].cv;
+            // The info stays at the same address until the fence is destroyed,
+            // and destroying a fence that is being waited on is invalid.
+            device = fenceInfo->device;
+            vk = fenceInfo->vk;
         }
 
-        fenceLock->lock();
-        cv->wait(fenceLock, [this, fence] {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            if (mFenceInfo[fence].state == FenceInfo::State::kWaitable) {
-                mFenceInfo[fence].state = FenceInfo::State::kWaiting;
+        // |state| is only accessed with the fence lock held, so the predicate
+        // doesn't need the global lock. Taking it here used to invert the lock
+        // order of on_vkQueueSubmit().
+        fenceInfo->lock.lock();
+        fenceInfo->cv.wait(&fenceInfo->lock, [fenceInfo] {
+            if (fenceInfo->state == FenceInfo::State::kWaitable) {
+                fenceInfo->state = FenceInfo::State::kWaiting;
                 return true;
             }
             return false;
         });
-        fenceLock->unlock();
+        fenceInfo->lock.unlock();
 
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-            if (mFenceInfo.find(fence) == mFenceInfo.end()) {
-                GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER))
-                    << "Fence was destroyed before vkWaitForFences call.";
-            }
+        if (!mFenceInfo.contains(fence)) {
+            GFXSTREAM_ABORT(FatalError(ABORT_REASON_OTHER))
+                << "Fence was destroyed before vkWaitForFences call.";
         }
 
         return vk->vkWaitForFences(device, /* fenceCount */ 1u, &fence,
@@ -4972,21 +5097,20 @@ class VkDecoderGlobalState::Impl {
     }
 
     VkResult getFenceStatus(VkFence boxed_fence) {
-        VkDevice device;
-        VkFence fence;
-        VulkanDispatch* vk;
-        {
-            std::lock_guard<std::recursive_mutex> lock(mLock);
-
-            fence = unbox_VkFence(boxed_fence);
-            if (fence == VK_NULL_HANDLE || mFenceInfo.find(fence) == mFenceInfo.end()) {
-                // No fence, could be a semaphore.
-                // TODO: Async get status for semaphores
-                return VK_SUCCESS;
-            }
-
-            device = mFenceInfo[fence].device;
-            vk = mFenceInfo[fence].vk;
+        VkDevice device = VK_NULL_HANDLE;
+        VulkanDispatch* vk = nullptr;
+        VkFence fence = unbox_VkFence(boxed_fence);
+        if (fence != VK_NULL_HANDLE) {
+            mFenceInfo.access(fence, [&](FenceInfo* fenceInfo) {
+                if (!fenceInfo) return;
+                device = fenceInfo->device;
+                vk = fenceInfo->vk;
+            });
+        }
+        if (!vk) {
+            // No fence, could be a semaphore.
+            // TODO: Async get status for semaphores
+            return VK_SUCCESS;
         }
 
         return vk->vkGetFenceStatus(device, fence);
@@ -5322,8 +5446,7 @@ class VkDecoderGlobalState::Impl {
         return stream;                                                                            \
     }                                                                                             \
     type unboxed_to_boxed_##type(type unboxed) {                                                  \
-        AutoLock lock(sBoxedHandleManager.lock);                                                  \
-        return (type)sBoxedHandleManager.getBoxedFromUnboxedLocked((uint64_t)(uintptr_t)unboxed); \
+        return (type)sBoxedHandleManager.getBoxedFromUnboxed((uint64_t)(uintptr_t)unboxed);       \
     }                                                                                             \
     VulkanDispatch* dispatch_##type(type boxed) {                                                 \
         auto elt = sBoxedHandleManager.get((uint64_t)(uintptr_t)boxed);                           \
@@ -5351,8 +5474,7 @@ class VkDecoderGlobalState::Impl {
         sBoxedHandleManager.addFixed((uint64_t)boxed, item, Tag_##type);                          \
     }                                                                                             \
     type unboxed_to_boxed_non_dispatchable_##type(type unboxed) {                                 \
-        AutoLock lock(sBoxedHandleManager.lock);                                                  \
-        return (type)sBoxedHandleManager.getBoxedFromUnboxedLocked((uint64_t)(uintptr_t)unboxed); \
+        return (type)sBoxedHandleManager.getBoxedFromUnboxed((uint64_t)(uintptr_t)unboxed);       \
     }                                                                                             \
     type unbox_##type(type boxed) {                                                               \
         auto elt = sBoxedHandleManager.get((uint64_t)(uintptr_t)boxed);                           \
@@ -5508,7 +5630,7 @@ class VkDecoderGlobalState::Impl {
                 for (auto& deviceQueue : it.second) {
                     *queue = deviceQueue;
                     *queueFamilyIndex = index;
-                    *queueLock = mQueueInfo.at(deviceQueue).lock;
+                    *queueLock = getQueueInfo(deviceQueue).value().lock;
                     return true;
                 }
             }
@@ -5518,7 +5640,7 @@ class VkDecoderGlobalState::Impl {
             // Use queue family index 0.
             *queue = zeroIt->second[0];
             *queueFamilyIndex = 0;
-            *queueLock = mQueueInfo.at(zeroIt->second[0]).lock;
+            *queueLock = getQueueInfo(zeroIt->second[0]).value().lock;
             return true;
         }
 
@@ -5633,9 +5755,18 @@ class VkDecoderGlobalState::Impl {
     }
 
     void executePreprocessRecursive(int level, VkCommandBuffer cmdBuffer) {
-        auto* cmdBufferInfo = android::base::find(mCmdBufferInfo, cmdBuffer);
-        if (!cmdBufferInfo) return;
-        for (const auto& func : cmdBufferInfo->preprocessFuncs) {
+        // Most command buffers have none, so only copy them out if there are.
+        std::vector<PreprocessFunc> preprocessFuncs;
+        mCmdBufferInfo.access(cmdBuffer, [&preprocessFuncs](CommandBufferInfo* cmdBufferInfo) {
+            if (cmdBufferInfo && !cmdBufferInfo->preprocessFuncs.empty()) {
+                preprocessFuncs = cmdBufferInfo->preprocessFuncs;
+            }
+        });
+        if (preprocessFuncs.empty()) return;
+
+        // The functions expect the global state to be locked.
+        std::lock_guard<std::recursive_mutex> lock(mLock);
+        for (const auto& func : preprocessFuncs) {
             func();
         }
         // TODO: fix
@@ -5670,6 +5801,33 @@ class VkDecoderGlobalState::Impl {
         return objectsFromDevice;
     }
 
+    template <typename HandleType, typename InfoType>
+    std::vector<HandleType> findDeviceObjects(VkDevice device,
+                                              ShardedInfoMap<HandleType, InfoType>& map) {
+        std::vector<HandleType> objectsFromDevice;
+        map.forEach([device, &objectsFromDevice](HandleType objectHandle,
+                                                 const InfoType& objectInfo) {
+            if (objectInfo.device == device) {
+                objectsFromDevice.push_back(objectHandle);
+            }
+        });
+        return objectsFromDevice;
+    }
+
+    template <typename HandleType, typename InfoType, typename InfoMemberType>
+    std::vector<std::pair<HandleType, InfoMemberType>> findDeviceObjects(
+        VkDevice device, ShardedInfoMap<HandleType, InfoType>& map,
+        InfoMemberType InfoType::*member) {
+        std::vector<std::pair<HandleType, InfoMemberType>> objectsFromDevice;
+        map.forEach([device, member, &objectsFromDevice](HandleType objectHandle,
+                                                         const InfoType& objectInfo) {
+            if (objectInfo.device == device) {
+                objectsFromDevice.emplace_back(objectHandle, objectInfo.*member);
+            }
+        });
+        return objectsFromDevice;
+    }
+
     void teardownInstanceLocked(VkInstance instance) {
         std::vector<VkDevice> devicesToDestroy;
         std::vector<VulkanDispatch*> devicesToDestroyDispatches;
@@ -5956,6 +6114,8 @@ class VkDecoderGlobalState::Impl {
     bool mVerbosePrints = false;
     bool mUseOldMemoryCleanupPath = false;
     bool mGuestUsesAngle = false;
+    // Where the devices' pipeline caches are kept across devices, and runs if persisted.
+    std::unique_ptr<PersistentBlobCache> mPipelineCacheStore;
 
     std::recursive_mutex mLock;
 
@@ -6015,6 +6175,8 @@ class VkDecoderGlobalState::Impl {
         std::unique_ptr<ExternalFencePool<VulkanDispatch>> externalFencePool = nullptr;
         std::set<VkFormat> imageFormats = {};  // image formats used on this device
         std::unique_ptr<GpuDecompressionPipelineManager> decompPipelines = nullptr;
+        // The host's cache for the pipelines created on this device, if any.
+        std::unique_ptr<PersistentPipelineCache> pipelineCache = nullptr;
 
         // True if this is a compressed image that needs to be decompressed on the GPU (with our
         // compute shader)
@@ -6091,6 +6253,7 @@ class VkDecoderGlobalState::Impl {
             kNotWaitable,
             kWaiting,
         };
+        // Guarded by |lock|.
         State state = State::kNotWaitable;
 
         bool external = false;
@@ -6258,7 +6421,9 @@ class VkDecoderGlobalState::Impl {
     std::unordered_map<VkImage, ImageInfo> mImageInfo;
     std::unordered_map<VkImageView, ImageViewInfo> mImageViewInfo;
     std::unordered_map<VkSampler, SamplerInfo> mSamplerInfo;
-    std::unordered_map<VkCommandBuffer, CommandBufferInfo> mCmdBufferInfo;
+    // The infos looked up on every command buffer recording and submission are
+    // sharded and don't need |mLock|, see ShardedInfoMap.
+    ShardedInfoMap<VkCommandBuffer, CommandBufferInfo> mCmdBufferInfo;
     std::unordered_map<VkCommandPool, CommandPoolInfo> mCmdPoolInfo;
     // TODO: release CommandBufferInfo when a command pool is reset/released
 
@@ -6267,8 +6432,8 @@ class VkDecoderGlobalState::Impl {
     std::unordered_map<VkDevice, VkPhysicalDevice> mDeviceToPhysicalDevice;
     std::unordered_map<VkPhysicalDevice, VkInstance> mPhysicalDeviceToInstance;
 
-    std::unordered_map<VkQueue, QueueInfo> mQueueInfo;
-    std::unordered_map<VkBuffer, BufferInfo> mBufferInfo;
+    ShardedInfoMap<VkQueue, QueueInfo> mQueueInfo;
+    ShardedInfoMap<VkBuffer, BufferInfo> mBufferInfo;
 
     std::unordered_map<VkDeviceMemory, MemoryInfo> mMemoryInfo;
 
@@ -6279,8 +6444,17 @@ class VkDecoderGlobalState::Impl {
     std::unordered_map<VkFramebuffer, FramebufferInfo> mFramebufferInfo;
 
     std::unordered_map<VkSemaphore, SemaphoreInfo> mSemaphoreInfo;
-    std::unordered_map<VkFence, FenceInfo> mFenceInfo;
-
+    ShardedInfoMap<VkFence, FenceInfo> mFenceInfo;
+    // Set once an image view or a sampler that needs emulated alpha has been
+    // created, see on_vkUpdateDescriptorSets().
+    std::atomic<bool> mAnyImageViewNeedsEmulatedAlpha{false};
+    std::atomic<bool> mAnySamplerNeedsEmulatedAlpha{false};
+
+    // Not sharded: allocating, freeing and resetting descriptor sets, including
+    // the batched allocations of vkQueueCommitDescriptorSetUpdatesGOOGLE(),
+    // update the pool, set and set layout infos together with the boxed
+    // handles of the pool, which per-shard locks couldn't keep consistent.
+    // vkUpdateDescriptorSets() doesn't look them up.
     std::unordered_map<VkDescriptorSetLayout, DescriptorSetLayoutInfo> mDescriptorSetLayoutInfo;
     std::unordered_map<VkDescriptorPool, DescriptorPoolInfo> mDescriptorPoolInfo;
     std::unordered_map<VkDescriptorSet, DescriptorSetInfo> mDescriptorSetInfo;
@@ -6796,6 +6970,14 @@ VkResult VkDecoderGlobalState::on_vkCreateGraphicsPipelines(
                                                pCreateInfos, pAllocator, pPipelines);
 }
 
+VkResult VkDecoderGlobalState::on_vkCreateComputePipelines(
+    android::base::BumpPool* pool, VkDevice boxed_device, VkPipelineCache pipelineCache,
+    uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos,
+    const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines) {
+    return mImpl->on_vkCreateComputePipelines(pool, boxed_device, pipelineCache, createInfoCount,
+                                              pCreateInfos, pAllocator, pPipelines);
+}
+
 void VkDecoderGlobalState::on_vkDestroyPipeline(android::base::BumpPool* pool,
                                                 VkDevice boxed_device, VkPipeline pipeline,
                                                 const VkAllocationCallbacks* pAllocator) {
@@ -7462,8 +7644,7 @@ GOLDFISH_VK_LIST_NON_DISPATCHABLE_HANDLE_TYPES(DEFINE_BOXED_NON_DISPATCHABLE_HAN
         sBoxedHandleManager.remove((uint64_t)boxed);                                              \
     }                                                                                             \
     type unboxed_to_boxed_##type(type unboxed) {                                                  \
-        AutoLock lock(sBoxedHandleManager.lock);                                                  \
-        return (type)sBoxedHandleManager.getBoxedFromUnboxedLocked((uint64_t)(uintptr_t)unboxed); \
+        return (type)sBoxedHandleManager.getBoxedFromUnboxed((uint64_t)(uintptr_t)unboxed);       \
     }
 
 #define DEFINE_BOXED_NON_DISPATCHABLE_HANDLE_GLOBAL_API_DEF(type)                                 \
@@ -7488,8 +7669,7 @@ GOLDFISH_VK_LIST_NON_DISPATCHABLE_HANDLE_TYPES(DEFINE_BOXED_NON_DISPATCHABLE_HAN
         return (type)elt->underlying;                                                             \
     }                                                                                             \
     type unboxed_to_boxed_non_dispatchable_##type(type unboxed) {                                 \
-        AutoLock lock(sBoxedHandleManager.lock);                                                  \
-        return (type)sBoxedHandleManager.getBoxedFromUnboxedLocked((uint64_t)(uintptr_t)unboxed); \
+        return (type)sBoxedHandleManager.getBoxedFromUnboxed((uint64_t)(uintptr_t)unboxed);       \
     }
 
 GOLDFISH_VK_LIST_DISPATCHABLE_HANDLE_TYPES(DEFINE_BOXED_DISPATCHABLE_HANDLE_GLOBAL_API_DEF)
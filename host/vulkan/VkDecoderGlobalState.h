@@ -15,8 +15,11 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -301,6 +304,12 @@ class VkDecoderGlobalState {
                                           const VkAllocationCallbacks* pAllocator,
                                           VkPipeline* pPipelines);
 
+    VkResult on_vkCreateComputePipelines(android::base::BumpPool* pool, VkDevice device,
+                                         VkPipelineCache pipelineCache, uint32_t createInfoCount,
+                                         const VkComputePipelineCreateInfo* pCreateInfos,
+                                         const VkAllocationCallbacks* pAllocator,
+                                         VkPipeline* pPipelines);
+
     void on_vkDestroyPipeline(android::base::BumpPool* pool, VkDevice device, VkPipeline pipeline,
                               const VkAllocationCallbacks* pAllocator);
 
@@ -953,5 +962,106 @@ class ExternalFencePool {
     int mMaxSize;
 };
 
+// Info map for handles that are looked up by the hot decoding paths (command
+// buffers, queues, fences, buffers) without holding the global state lock.
+//
+// Handles are spread over |kNumShards| maps, each with its own lock, so that
+// render threads working on unrelated objects don't serialize. The lock
+// order is: global state lock, then a shard lock, then locks owned by the
+// infos themselves. Callbacks run with the shard locked, so they must not
+// take the global state lock or access another sharded map.
+template <class Handle, class Info, size_t kNumShards = 16>
+class ShardedInfoMap {
+    static_assert(kNumShards > 0 && (kNumShards & (kNumShards - 1)) == 0,
+                  "The number of shards must be a power of two");
+
+   public:
+    // Calls |func| with the info of |handle|, or nullptr if there is none,
+    // and returns what it returns.
+    template <class Func>
+    decltype(auto) access(Handle handle, Func&& func) {
+        Shard& shard = getShard(handle);
+        AutoLock lock(shard.lock);
+        auto it = shard.infos.find(handle);
+        return func(it == shard.infos.end() ? nullptr : &it->second);
+    }
+
+    // Same, but creates a default info for |handle| if there is none.
+    template <class Func>
+    decltype(auto) accessOrCreate(Handle handle, Func&& func) {
+        Shard& shard = getShard(handle);
+        AutoLock lock(shard.lock);
+        return func(shard.infos[handle]);
+    }
+
+    bool contains(Handle handle) {
+        Shard& shard = getShard(handle);
+        AutoLock lock(shard.lock);
+        return shard.infos.find(handle) != shard.infos.end();
+    }
+
+    bool erase(Handle handle) {
+        Shard& shard = getShard(handle);
+        AutoLock lock(shard.lock);
+        return shard.infos.erase(handle) > 0;
+    }
+
+    // Calls |func(handle, info)| for every info, one shard at a time.
+    template <class Func>
+    void forEach(Func&& func) {
+        for (Shard& shard : mShards) {
+            AutoLock lock(shard.lock);
+            for (auto& it : shard.infos) {
+                func(it.first, it.second);
+            }
+        }
+    }
+
+    // Erases the infos for which |pred(handle, info)| returns true.
+    template <class Pred>
+    void eraseIf(Pred&& pred) {
+        for (Shard& shard : mShards) {
+            AutoLock lock(shard.lock);
+            for (auto it = shard.infos.begin(); it != shard.infos.end();) {
+                if (pred(it->first, it->second)) {
+                    it = shard.infos.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void clear() {
+        for (Shard& shard : mShards) {
+            AutoLock lock(shard.lock);
+            shard.infos.clear();
+        }
+    }
+
+   private:
+    // Keeps the locks of neighbouring shards off the same cache line.
+    struct alignas(64) Shard {
+        Lock lock;
+        std::unordered_map<Handle, Info> infos;
+    };
+
+    static size_t getShardIndex(Handle handle) {
+        uint64_t bits;
+        if constexpr (std::is_pointer_v<Handle>) {
+            bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+        } else {
+            bits = static_cast<uint64_t>(handle);
+        }
+        // Handles are mostly allocator-aligned pointers, so use the high bits of
+        // a multiplicative hash rather than the low bits of the handle.
+        return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ull) >> 32) & (kNumShards - 1);
+    }
+
+    Shard& getShard(Handle handle) { return mShards[getShardIndex(handle)]; }
+
+    std::array<Shard, kNumShards> mShards;
+};
+
 }  // namespace vk
 }  // namespace gfxstream
@@ -0,0 +1,88 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Render threads recording their own command buffers, as the command buffer
+// info updates of vkBeginCommandBuffer() and vkCmdBindPipeline() do, with the
+// infos behind a single lock like the global state lock ("Locked"), and in a
+// ShardedInfoMap.
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+#include <unordered_map>
+
+#include "VkDecoderGlobalState.h"
+#include "aemu/base/containers/Lookup.h"
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+struct TestInfo {
+    uint64_t value = 0;
+};
+
+constexpr uint32_t kMaxThreads = 8;
+constexpr uint32_t kNumCommandBuffersPerThread = 16;
+
+VkCommandBuffer commandBuffer(int thread, uint64_t i) {
+    return reinterpret_cast<VkCommandBuffer>(static_cast<uintptr_t>(
+        (thread * kNumCommandBuffersPerThread + i % kNumCommandBuffersPerThread + 1) * 0x1000));
+}
+
+void BM_CommandBufferInfoLocked(benchmark::State& state) {
+    static std::recursive_mutex globalLock;
+    static std::unordered_map<VkCommandBuffer, TestInfo> infos;
+    if (state.thread_index() == 0) {
+        std::lock_guard<std::recursive_mutex> lock(globalLock);
+        for (uint32_t t = 0; t < kMaxThreads; ++t) {
+            for (uint32_t i = 0; i < kNumCommandBuffersPerThread; ++i) {
+                infos[commandBuffer(t, i)] = TestInfo();
+            }
+        }
+    }
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        std::lock_guard<std::recursive_mutex> lock(globalLock);
+        auto* info = android::base::find(infos, commandBuffer(state.thread_index(), i++));
+        if (info) ++info->value;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CommandBufferInfoLocked)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+void BM_CommandBufferInfoSharded(benchmark::State& state) {
+    static ShardedInfoMap<VkCommandBuffer, TestInfo> infos;
+    if (state.thread_index() == 0) {
+        for (uint32_t t = 0; t < kMaxThreads; ++t) {
+            for (uint32_t i = 0; i < kNumCommandBuffersPerThread; ++i) {
+                infos.accessOrCreate(commandBuffer(t, i), [](TestInfo&) {});
+            }
+        }
+    }
+
+    uint64_t i = 0;
+    for (auto _ : state) {
+        infos.access(commandBuffer(state.thread_index(), i++), [](TestInfo* info) {
+            if (info) ++info->value;
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CommandBufferInfoSharded)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
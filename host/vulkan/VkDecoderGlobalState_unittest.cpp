@@ -143,6 +143,60 @@ TEST_F(VkDecoderGlobalStateExternalFenceDeathTest, undestroyedFences) {
             "fences still not destroyed."));
 }
 
+struct TestInfo {
+    VkDevice device = VK_NULL_HANDLE;
+    uint64_t value = 0;
+};
+
+TEST(ShardedInfoMapTest, accessAndErase) {
+    ShardedInfoMap<VkFence, TestInfo> map;
+    VkFence fence = reinterpret_cast<VkFence>(0x1234'0000);
+
+    EXPECT_FALSE(map.contains(fence));
+    EXPECT_FALSE(map.access(fence, [](TestInfo* info) { return info != nullptr; }));
+
+    map.accessOrCreate(fence, [](TestInfo& info) { info.value = 42; });
+    EXPECT_TRUE(map.contains(fence));
+    EXPECT_EQ(42, map.access(fence, [](TestInfo* info) { return info->value; }));
+
+    EXPECT_TRUE(map.erase(fence));
+    EXPECT_FALSE(map.erase(fence));
+    EXPECT_FALSE(map.contains(fence));
+}
+
+TEST(ShardedInfoMapTest, forEachAndEraseIf) {
+    ShardedInfoMap<VkFence, TestInfo> map;
+    VkDevice device1 = reinterpret_cast<VkDevice>(0x1111'0000);
+    VkDevice device2 = reinterpret_cast<VkDevice>(0x2222'0000);
+    constexpr uint64_t kNumFences = 1000;
+    for (uint64_t i = 1; i <= kNumFences; ++i) {
+        map.accessOrCreate(reinterpret_cast<VkFence>(i * 0x100), [&](TestInfo& info) {
+            info.device = i % 2 ? device1 : device2;
+            info.value = i;
+        });
+    }
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    map.forEach([&](VkFence, const TestInfo& info) {
+        ++count;
+        sum += info.value;
+    });
+    EXPECT_EQ(kNumFences, count);
+    EXPECT_EQ(kNumFences * (kNumFences + 1) / 2, sum);
+
+    map.eraseIf([device1](VkFence, const TestInfo& info) { return info.device == device1; });
+    count = 0;
+    map.forEach([&](VkFence, const TestInfo& info) {
+        ++count;
+        EXPECT_EQ(device2, info.device);
+    });
+    EXPECT_EQ(kNumFences / 2, count);
+
+    map.clear();
+    EXPECT_FALSE(map.contains(reinterpret_cast<VkFence>(0x200)));
+}
+
 }  // namespace
 }  // namespace vk
 }  // namespace gfxstream
@@ -14,6 +14,9 @@
 
 #include "VkFormatUtils.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
 #include <unordered_map>
 
 namespace gfxstream {
@@ -197,5 +200,112 @@ bool getFormatTransferInfo(VkFormat format, uint32_t width, uint32_t height,
     return true;
 }
 
+bool getFormatTransferChunks(VkFormat format, uint32_t width, uint32_t height,
+                             VkDeviceSize maxChunkSize, std::vector<FormatTransferChunk>* outChunks) {
+    const VkRect2D wholeImage = {
+        .offset = {.x = 0, .y = 0},
+        .extent = {.width = width, .height = height},
+    };
+    return getFormatTransferChunks(format, width, height, wholeImage, maxChunkSize, outChunks);
+}
+
+bool getFormatTransferChunks(VkFormat format, uint32_t width, uint32_t height,
+                             const VkRect2D& rect, VkDeviceSize maxChunkSize,
+                             std::vector<FormatTransferChunk>* outChunks) {
+    const FormatPlaneLayouts* formatInfo = getFormatPlaneLayouts(format);
+    if (formatInfo == nullptr) {
+        ERR("Unhandled format: %s", string_VkFormat(format));
+        return false;
+    }
+
+    const bool isWholeImage = rect.offset.x == 0 && rect.offset.y == 0 &&
+                              rect.extent.width == width && rect.extent.height == height;
+    if (!isWholeImage) {
+        if (formatInfo->planeLayouts.size() != 1 || formatInfo->horizontalAlignmentPixels != 1) {
+            ERR("Unhandled subrect for format: %s", string_VkFormat(format));
+            return false;
+        }
+        if (rect.offset.x < 0 || rect.offset.y < 0 ||
+            static_cast<uint64_t>(rect.offset.x) + rect.extent.width > width ||
+            static_cast<uint64_t>(rect.offset.y) + rect.extent.height > height) {
+            ERR("Subrect (%d, %d) %ux%u out of %ux%u.", rect.offset.x, rect.offset.y,
+                rect.extent.width, rect.extent.height, width, height);
+            return false;
+        }
+    }
+
+    outChunks->clear();
+    FormatTransferChunk chunk;
+
+    const uint32_t alignedWidth =
+        alignToPower2(rect.extent.width, formatInfo->horizontalAlignmentPixels);
+    VkDeviceSize planeOffset = 0;
+    for (const FormatPlaneLayout& planeInfo : formatInfo->planeLayouts) {
+        const uint32_t planeWidth = alignedWidth / planeInfo.horizontalSubsampling;
+        const uint32_t planeHeight = rect.extent.height / planeInfo.verticalSubsampling;
+        const uint32_t planeBpp = planeInfo.sampleIncrementBytes;
+        const VkDeviceSize rowSize = static_cast<VkDeviceSize>(planeWidth) * planeBpp;
+        // bufferOffset has to be a multiple of both 4 and the texel size.
+        const VkDeviceSize offsetAlignment = std::lcm<VkDeviceSize>(4, planeBpp);
+
+        uint32_t row = 0;
+        while (row < planeHeight) {
+            const VkDeviceSize pieceOffset =
+                (chunk.stagingSize + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+            const VkDeviceSize rowsThatFit =
+                pieceOffset < maxChunkSize ? (maxChunkSize - pieceOffset) / rowSize : 0;
+            if (rowsThatFit == 0) {
+                if (chunk.pieces.empty()) {
+                    ERR("Row of %" PRIu64 " bytes does not fit in %" PRIu64 " bytes.", rowSize,
+                        maxChunkSize);
+                    return false;
+                }
+                outChunks->push_back(std::move(chunk));
+                chunk = FormatTransferChunk();
+                continue;
+            }
+            const uint32_t rows =
+                static_cast<uint32_t>(std::min<VkDeviceSize>(rowsThatFit, planeHeight - row));
+            chunk.pieces.push_back(FormatTransferPiece{
+                .contentsOffset = planeOffset + row * rowSize,
+                .size = rows * rowSize,
+                .bufferImageCopy =
+                    {
+                        .bufferOffset = pieceOffset,
+                        .bufferRowLength = planeWidth,
+                        .bufferImageHeight = 0,
+                        .imageSubresource =
+                            {
+                                .aspectMask = planeInfo.aspectMask,
+                                .mipLevel = 0,
+                                .baseArrayLayer = 0,
+                                .layerCount = 1,
+                            },
+                        .imageOffset =
+                            {
+                                .x = rect.offset.x,
+                                .y = rect.offset.y + static_cast<int32_t>(row),
+                                .z = 0,
+                            },
+                        .imageExtent =
+                            {
+                                .width = planeWidth,
+                                .height = rows,
+                                .depth = 1,
+                            },
+                    },
+            });
+            chunk.stagingSize = pieceOffset + rows * rowSize;
+            row += rows;
+        }
+        planeOffset += planeHeight * rowSize;
+    }
+    if (!chunk.pieces.empty()) {
+        outChunks->push_back(std::move(chunk));
+    }
+
+    return true;
+}
+
 }  // namespace vk
 }  // namespace gfxstream
@@ -372,6 +372,38 @@ bool getFormatTransferInfo(VkFormat format, uint32_t width, uint32_t height,
                            VkDeviceSize* outStagingBufferCopySize,
                            std::vector<VkBufferImageCopy>* outBufferImageCopies);
 
+// Part of a transfer that fits in a staging buffer slice: rows of one plane,
+// tightly packed in the source contents at |contentsOffset|.
+struct FormatTransferPiece {
+    VkDeviceSize contentsOffset = 0;
+    VkDeviceSize size = 0;
+    // |bufferOffset| is relative to the start of the slice.
+    VkBufferImageCopy bufferImageCopy = {};
+};
+
+struct FormatTransferChunk {
+    // Bytes of the slice used by the pieces, including alignment padding.
+    VkDeviceSize stagingSize = 0;
+    std::vector<FormatTransferPiece> pieces;
+};
+
+// Splits the transfer described by getFormatTransferInfo() into chunks that
+// each fit in |maxChunkSize| bytes of staging memory. Pieces are split on row
+// boundaries and their offsets in the chunk are aligned as required by
+// vkCmdCopyBufferToImage(), assuming the slice itself is aligned to
+// kFormatTransferChunkAlignment, a multiple of 4 and of every texel size.
+// Fails if a single row does not fit.
+inline constexpr VkDeviceSize kFormatTransferChunkAlignment = 768;
+bool getFormatTransferChunks(VkFormat format, uint32_t width, uint32_t height,
+                             VkDeviceSize maxChunkSize, std::vector<FormatTransferChunk>* outChunks);
+
+// Same as above for the |rect| of the image, whose contents are then the tightly
+// packed rows of |rect|. Only single plane formats without width alignment can
+// transfer less than the whole image.
+bool getFormatTransferChunks(VkFormat format, uint32_t width, uint32_t height,
+                             const VkRect2D& rect, VkDeviceSize maxChunkSize,
+                             std::vector<FormatTransferChunk>* outChunks);
+
 }  // namespace vk
 }  // namespace gfxstream
 
@@ -258,6 +258,133 @@ TEST(VkFormatUtilsTest, GetTransferInfoYV12OrYV21) {
                             })));
 }
 
+TEST(VkFormatUtilsTest, GetTransferChunksFitsInOneChunk) {
+    const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    const uint32_t width = 16;
+    const uint32_t height = 16;
+
+    std::vector<FormatTransferChunk> chunks;
+    ASSERT_THAT(getFormatTransferChunks(format, width, height, 1024, &chunks), IsTrue());
+    ASSERT_THAT(chunks.size(), Eq(1));
+    EXPECT_THAT(chunks[0].stagingSize, Eq(1024));
+    ASSERT_THAT(chunks[0].pieces.size(), Eq(1));
+    EXPECT_THAT(chunks[0].pieces[0].contentsOffset, Eq(0));
+    EXPECT_THAT(chunks[0].pieces[0].size, Eq(1024));
+
+    std::vector<VkBufferImageCopy> bufferImageCopies;
+    ASSERT_THAT(getFormatTransferInfo(format, width, height, nullptr, &bufferImageCopies),
+                IsTrue());
+    EXPECT_THAT(chunks[0].pieces[0].bufferImageCopy, EqsVkBufferImageCopy(bufferImageCopies[0]));
+}
+
+TEST(VkFormatUtilsTest, GetTransferChunksSplitsRows) {
+    const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    const uint32_t width = 16;
+    const uint32_t height = 16;
+
+    // Room for 6 rows of 64 bytes per chunk.
+    std::vector<FormatTransferChunk> chunks;
+    ASSERT_THAT(getFormatTransferChunks(format, width, height, 400, &chunks), IsTrue());
+    ASSERT_THAT(chunks.size(), Eq(3));
+
+    uint32_t expectedRow = 0;
+    for (const FormatTransferChunk& chunk : chunks) {
+        ASSERT_THAT(chunk.pieces.size(), Eq(1));
+        const FormatTransferPiece& piece = chunk.pieces[0];
+        const uint32_t rows = piece.bufferImageCopy.imageExtent.height;
+        EXPECT_THAT(piece.contentsOffset, Eq(expectedRow * 64));
+        EXPECT_THAT(piece.size, Eq(rows * 64));
+        EXPECT_THAT(piece.bufferImageCopy.bufferOffset, Eq(0));
+        EXPECT_THAT(piece.bufferImageCopy.imageOffset.y, Eq(expectedRow));
+        EXPECT_THAT(chunk.stagingSize, Eq(piece.size));
+        expectedRow += rows;
+    }
+    EXPECT_THAT(chunks[0].pieces[0].bufferImageCopy.imageExtent.height, Eq(6));
+    EXPECT_THAT(expectedRow, Eq(height));
+}
+
+TEST(VkFormatUtilsTest, GetTransferChunksSplitsPlanes) {
+    const VkFormat format = VK_FORMAT_G8_B8R8_2PLANE_420_UNORM;
+    const uint32_t width = 16;
+    const uint32_t height = 16;
+
+    // The whole Y plane, and the first 2 rows of the CbCr plane.
+    std::vector<FormatTransferChunk> chunks;
+    ASSERT_THAT(getFormatTransferChunks(format, width, height, 288, &chunks), IsTrue());
+    ASSERT_THAT(chunks.size(), Eq(2));
+
+    ASSERT_THAT(chunks[0].pieces.size(), Eq(2));
+    EXPECT_THAT(chunks[0].pieces[0].contentsOffset, Eq(0));
+    EXPECT_THAT(chunks[0].pieces[0].size, Eq(256));
+    EXPECT_THAT(chunks[0].pieces[0].bufferImageCopy.imageSubresource.aspectMask,
+                Eq(VK_IMAGE_ASPECT_PLANE_0_BIT));
+    EXPECT_THAT(chunks[0].pieces[1].contentsOffset, Eq(256));
+    EXPECT_THAT(chunks[0].pieces[1].size, Eq(32));
+    EXPECT_THAT(chunks[0].pieces[1].bufferImageCopy.bufferOffset, Eq(256));
+    EXPECT_THAT(chunks[0].pieces[1].bufferImageCopy.imageSubresource.aspectMask,
+                Eq(VK_IMAGE_ASPECT_PLANE_1_BIT));
+    EXPECT_THAT(chunks[0].pieces[1].bufferImageCopy.imageExtent.height, Eq(2));
+
+    ASSERT_THAT(chunks[1].pieces.size(), Eq(1));
+    EXPECT_THAT(chunks[1].pieces[0].contentsOffset, Eq(288));
+    EXPECT_THAT(chunks[1].pieces[0].size, Eq(96));
+    EXPECT_THAT(chunks[1].pieces[0].bufferImageCopy.imageOffset.y, Eq(2));
+    EXPECT_THAT(chunks[1].pieces[0].bufferImageCopy.imageExtent.height, Eq(6));
+}
+
+TEST(VkFormatUtilsTest, GetTransferChunksOfSubrect) {
+    const VkRect2D rect = {
+        .offset = {.x = 4, .y = 3},
+        .extent = {.width = 8, .height = 10},
+    };
+
+    // Room for 4 rows of 32 bytes per chunk.
+    std::vector<FormatTransferChunk> chunks;
+    ASSERT_THAT(getFormatTransferChunks(VK_FORMAT_R8G8B8A8_UNORM, 16, 16, rect, 128, &chunks),
+                IsTrue());
+    ASSERT_THAT(chunks.size(), Eq(3));
+
+    uint32_t expectedRow = 0;
+    for (const FormatTransferChunk& chunk : chunks) {
+        ASSERT_THAT(chunk.pieces.size(), Eq(1));
+        const FormatTransferPiece& piece = chunk.pieces[0];
+        const uint32_t rows = piece.bufferImageCopy.imageExtent.height;
+        EXPECT_THAT(piece.contentsOffset, Eq(expectedRow * 32));
+        EXPECT_THAT(piece.size, Eq(rows * 32));
+        EXPECT_THAT(piece.bufferImageCopy.bufferRowLength, Eq(8));
+        EXPECT_THAT(piece.bufferImageCopy.imageOffset.x, Eq(4));
+        EXPECT_THAT(piece.bufferImageCopy.imageOffset.y, Eq(3 + expectedRow));
+        EXPECT_THAT(piece.bufferImageCopy.imageExtent.width, Eq(8));
+        expectedRow += rows;
+    }
+    EXPECT_THAT(expectedRow, Eq(10));
+}
+
+TEST(VkFormatUtilsTest, GetTransferChunksOfUnhandledSubrect) {
+    const VkRect2D rect = {
+        .offset = {.x = 0, .y = 0},
+        .extent = {.width = 8, .height = 8},
+    };
+    std::vector<FormatTransferChunk> chunks;
+    EXPECT_THAT(getFormatTransferChunks(VK_FORMAT_G8_B8R8_2PLANE_420_UNORM, 16, 16, rect, 1024,
+                                        &chunks),
+                IsFalse());
+
+    const VkRect2D outOfBounds = {
+        .offset = {.x = 12, .y = 0},
+        .extent = {.width = 8, .height = 8},
+    };
+    EXPECT_THAT(
+        getFormatTransferChunks(VK_FORMAT_R8G8B8A8_UNORM, 16, 16, outOfBounds, 1024, &chunks),
+        IsFalse());
+}
+
+TEST(VkFormatUtilsTest, GetTransferChunksRowTooLarge) {
+    std::vector<FormatTransferChunk> chunks;
+    ASSERT_THAT(getFormatTransferChunks(VK_FORMAT_R8G8B8A8_UNORM, 16, 16, 32, &chunks),
+                IsFalse());
+}
+
 }  // namespace
 }  // namespace vk
 }  // namespace gfxstream
@@ -15,7 +15,7 @@
 
 #include <string.h>
 
-#include <unordered_map>
+#include <unordered_set>
 
 #include "FrameBuffer.h"
 #include "render-utils/IOStream.h"
@@ -39,17 +39,12 @@ namespace vk {
 
 VkReconstruction::VkReconstruction() = default;
 
-std::vector<uint64_t> typeTagSortedHandles(const std::vector<uint64_t>& handles) {
+// static
+uint64_t VkReconstruction::segmentFor(uint64_t handle, uint32_t level) {
     using EntityManagerTypeForHandles = android::base::EntityManager<32, 16, 16, int>;
 
-    std::vector<uint64_t> res = handles;
-
-    std::sort(res.begin(), res.end(), [](uint64_t lhs, uint64_t rhs) {
-        return EntityManagerTypeForHandles::getHandleType(lhs) <
-               EntityManagerTypeForHandles::getHandleType(rhs);
-    });
-
-    return res;
+    // Orders segments by level, then by handle type.
+    return (uint64_t(level) << 16) | EntityManagerTypeForHandles::getHandleType(handle);
 }
 
 void VkReconstruction::save(android::base::Stream* stream) {
@@ -59,121 +54,89 @@ void VkReconstruction::save(android::base::Stream* stream) {
     dump();
 #endif
 
-    std::unordered_map<uint64_t, uint64_t> backDeps;
+    size_t reserializedSegments = 0;
 
-    mHandleReconstructions.forEachLiveComponent_const(
-        [&backDeps](bool live, uint64_t componentHandle, uint64_t entityHandle,
-                    const HandleReconstruction& item) {
-            for (auto handle : item.childHandles) {
-                backDeps[handle] = entityHandle;
-            }
-        });
-
-    std::vector<uint64_t> topoOrder;
-
-    mHandleReconstructions.forEachLiveComponent_const(
-        [&topoOrder, &backDeps](bool live, uint64_t componentHandle, uint64_t entityHandle,
-                                const HandleReconstruction& item) {
-            // Start with populating the roots
-            if (backDeps.find(entityHandle) == backDeps.end()) {
-                DEBUG_RECON("found root: 0x%llx", (unsigned long long)entityHandle);
-                topoOrder.push_back(entityHandle);
-            }
-        });
+    for (auto& it : mSegments) {
+        TraceSegment& segment = it.second;
+        if (!segment.dirty) continue;
 
-    std::vector<uint64_t> next;
-
-    std::unordered_map<uint64_t, uint64_t> uniqApiRefsToTopoOrder;
-    std::unordered_map<uint64_t, std::vector<uint64_t>> uniqApiRefsByTopoOrder;
-    std::unordered_map<uint64_t, std::vector<uint64_t>> uniqApiRefsByTopoAndDependencyOrder;
-
-    size_t topoLevel = 0;
-
-    topoOrder = typeTagSortedHandles(topoOrder);
-
-    while (!topoOrder.empty()) {
-        next.clear();
-
-        for (auto handle : topoOrder) {
-            auto item = mHandleReconstructions.get(handle);
+        std::vector<uint64_t> apis;
+        apis.reserve(segment.apis.size());
+        for (const auto& api : segment.apis) {
+            apis.push_back(api.second);
+        }
+        serialize(&segment, apis);
+        ++reserializedSegments;
+    }
 
-            for (auto apiHandle : item->apiRefs) {
-                if (uniqApiRefsToTopoOrder.find(apiHandle) == uniqApiRefsToTopoOrder.end()) {
-                    DEBUG_RECON("level %zu: 0x%llx api ref: 0x%llx", topoLevel,
-                                (unsigned long long)handle, (unsigned long long)apiHandle);
-                    auto& refs = uniqApiRefsByTopoOrder[topoLevel];
-                    refs.push_back(apiHandle);
-                }
+    if (mModifySegment.dirty) {
+        serialize(&mModifySegment, getOrderedUniqueModifyApis());
+        ++reserializedSegments;
+    }
 
-                uniqApiRefsToTopoOrder[apiHandle] = topoLevel;
-            }
+    DEBUG_RECON("reserialized %zu of %zu segments", reserializedSegments, mSegments.size() + 1);
 
-            for (auto childHandle : item->childHandles) {
-                next.push_back(childHandle);
-            }
-        }
+    uint32_t createdHandleBufferSize = mModifySegment.createdHandles.size() * sizeof(uint64_t);
+    uint32_t apiTraceBufferSize = mModifySegment.trace.size();
+    for (const auto& it : mSegments) {
+        createdHandleBufferSize += it.second.createdHandles.size() * sizeof(uint64_t);
+        apiTraceBufferSize += it.second.trace.size();
+    }
 
-        next = typeTagSortedHandles(next);
+    DEBUG_RECON("created handle buffer size: %u trace: %u", createdHandleBufferSize,
+                apiTraceBufferSize);
 
-        topoOrder = next;
-        ++topoLevel;
+    // Same as android::base::saveBufferRaw() of the segments concatenated.
+    stream->putBe32(createdHandleBufferSize);
+    for (const auto& it : mSegments) {
+        stream->write(it.second.createdHandles.data(),
+                      it.second.createdHandles.size() * sizeof(uint64_t));
     }
+    stream->write(mModifySegment.createdHandles.data(),
+                  mModifySegment.createdHandles.size() * sizeof(uint64_t));
 
-    uniqApiRefsByTopoOrder[topoLevel] = getOrderedUniqueModifyApis();
-    ++topoLevel;
+    stream->putBe32(apiTraceBufferSize);
+    for (const auto& it : mSegments) {
+        stream->write(it.second.trace.data(), it.second.trace.size());
+    }
+    stream->write(mModifySegment.trace.data(), mModifySegment.trace.size());
+}
 
-    size_t totalApiTraceSize = 0;  // 4 bytes to store size of created handles
+void VkReconstruction::serialize(TraceSegment* segment, const std::vector<uint64_t>& apis) {
+    segment->createdHandles.clear();
+    segment->trace.clear();
 
-    for (size_t i = 0; i < topoLevel; ++i) {
-        for (auto apiHandle : uniqApiRefsByTopoOrder[i]) {
-            auto item = mApiTrace.get(apiHandle);
-            totalApiTraceSize += 4;                 // opcode
-            totalApiTraceSize += 4;                 // buffer size of trace
-            totalApiTraceSize += item->traceBytes;  // the actual trace
-        }
+    size_t traceSize = 0;
+    for (auto apiHandle : apis) {
+        auto item = mApiTrace.get(apiHandle);
+        traceSize += 4;                 // opcode
+        traceSize += 4;                 // buffer size of trace
+        traceSize += item->traceBytes;  // the actual trace
     }
+    segment->trace.resize(traceSize);
 
-    DEBUG_RECON("total api trace size: %zu", totalApiTraceSize);
-
-    std::vector<uint64_t> createdHandleBuffer;
+    uint8_t* apiTracePtr = segment->trace.data();
 
-    for (size_t i = 0; i < topoLevel; ++i) {
-        for (auto apiHandle : uniqApiRefsByTopoOrder[i]) {
-            auto item = mApiTrace.get(apiHandle);
-            for (auto createdHandle : item->createdHandles) {
-                DEBUG_RECON("save handle: 0x%llx\n", createdHandle);
-                createdHandleBuffer.push_back(createdHandle);
-            }
+    for (auto apiHandle : apis) {
+        auto item = mApiTrace.get(apiHandle);
+        for (auto createdHandle : item->createdHandles) {
+            DEBUG_RECON("save handle: 0x%llx\n", createdHandle);
+            segment->createdHandles.push_back(createdHandle);
         }
-    }
 
-    std::vector<uint8_t> apiTraceBuffer;
-    apiTraceBuffer.resize(totalApiTraceSize);
-
-    uint8_t* apiTracePtr = apiTraceBuffer.data();
-
-    for (size_t i = 0; i < topoLevel; ++i) {
-        for (auto apiHandle : uniqApiRefsByTopoOrder[i]) {
-            auto item = mApiTrace.get(apiHandle);
-            // 4 bytes for opcode, and 4 bytes for saveBufferRaw's size field
-            memcpy(apiTracePtr, &item->opCode, sizeof(uint32_t));
-            apiTracePtr += 4;
-            uint32_t traceBytesForSnapshot = item->traceBytes + 8;
-            memcpy(apiTracePtr, &traceBytesForSnapshot,
-                   sizeof(uint32_t));  // and 8 bytes for 'self' struct of { opcode, packetlen } as
-                                       // that is what decoder expects
-            apiTracePtr += 4;
-            memcpy(apiTracePtr, item->trace.data(), item->traceBytes);
-            apiTracePtr += item->traceBytes;
-        }
+        // 4 bytes for opcode, and 4 bytes for saveBufferRaw's size field
+        memcpy(apiTracePtr, &item->opCode, sizeof(uint32_t));
+        apiTracePtr += 4;
+        uint32_t traceBytesForSnapshot = item->traceBytes + 8;
+        memcpy(apiTracePtr, &traceBytesForSnapshot,
+               sizeof(uint32_t));  // and 8 bytes for 'self' struct of { opcode, packetlen } as
+                                   // that is what decoder expects
+        apiTracePtr += 4;
+        memcpy(apiTracePtr, item->trace.data(), item->traceBytes);
+        apiTracePtr += item->traceBytes;
     }
 
-    DEBUG_RECON("created handle buffer size: %zu trace: %zu", createdHandleBuffer.size(),
-                apiTraceBuffer.size());
-
-    android::base::saveBufferRaw(stream, (char*)(createdHandleBuffer.data()),
-                                 createdHandleBuffer.size() * sizeof(uint64_t));
-    android::base::saveBufferRaw(stream, (char*)(apiTraceBuffer.data()), apiTraceBuffer.size());
+    segment->dirty = false;
 }
 
 class TrivialStream : public IOStream {
@@ -224,6 +187,8 @@ void VkReconstruction::load(android::base::Stream* stream, emugl::GfxApiLogger&
     DEBUG_RECON("start. assuming VkDecoderGlobalState has been cleared for loading already");
     mApiTrace.clear();
     mHandleReconstructions.clear();
+    mSegments.clear();
+    mModifySegment = TraceSegment();
 
     std::vector<uint8_t> createdHandleBuffer;
     std::vector<uint8_t> apiTraceBuffer;
@@ -267,7 +232,10 @@ void VkReconstruction::load(android::base::Stream* stream, emugl::GfxApiLogger&
 }
 
 VkReconstruction::ApiHandle VkReconstruction::createApiInfo() {
-    auto handle = mApiTrace.add(ApiInfo(), 1);
+    ApiInfo info;
+    info.segment = kNoSegment;
+    info.sequence = mNextApiSequence++;
+    auto handle = mApiTrace.add(std::move(info), 1);
     return handle;
 }
 
@@ -276,6 +244,8 @@ void VkReconstruction::destroyApiInfo(VkReconstruction::ApiHandle h) {
 
     if (!item) return;
 
+    unplaceApi(h);
+
     item->traceBytes = 0;
     item->createdHandles.clear();
 
@@ -292,6 +262,91 @@ void VkReconstruction::setApiTrace(VkReconstruction::ApiInfo* apiInfo, uint32_t
     apiInfo->opCode = opCode;
     memcpy(apiInfo->trace.data(), traceBegin, traceBytes);
     apiInfo->traceBytes = traceBytes;
+    markSegmentDirty(apiInfo->segment);
+}
+
+void VkReconstruction::placeApi(ApiHandle apiHandle, uint64_t segment) {
+    auto item = mApiTrace.get(apiHandle);
+
+    if (!item) return;
+
+    // An API creating several handles is replayed with the first of them.
+    if (item->segment != kNoSegment && item->segment <= segment) return;
+
+    unplaceApi(apiHandle);
+
+    TraceSegment& traceSegment = mSegments[segment];
+    traceSegment.apis[item->sequence] = apiHandle;
+    traceSegment.dirty = true;
+    item->segment = segment;
+}
+
+void VkReconstruction::unplaceApi(ApiHandle apiHandle) {
+    auto item = mApiTrace.get(apiHandle);
+
+    if (!item || item->segment == kNoSegment) return;
+
+    markSegmentDirty(item->segment);
+
+    auto it = mSegments.find(item->segment);
+    if (it != mSegments.end()) {
+        it->second.apis.erase(item->sequence);
+        if (it->second.apis.empty()) {
+            mSegments.erase(it);
+        }
+    }
+
+    item->segment = kNoSegment;
+}
+
+void VkReconstruction::markSegmentDirty(uint64_t segment) {
+    if (segment == kNoSegment) return;
+
+    if (segment == kModifySegment) {
+        mModifySegment.dirty = true;
+        return;
+    }
+
+    auto it = mSegments.find(segment);
+    if (it != mSegments.end()) {
+        it->second.dirty = true;
+    }
+}
+
+void VkReconstruction::updateLevel(uint64_t handle) {
+    auto item = mHandleReconstructions.get(handle);
+
+    if (!item) return;
+
+    // Replayed after the earliest of its parents.
+    bool hasParent = false;
+    uint32_t level = 0;
+    for (auto parentHandle : item->parentHandles) {
+        auto parent = mHandleReconstructions.get(parentHandle);
+        if (!parent) continue;
+        if (!hasParent || parent->level + 1 < level) {
+            level = parent->level + 1;
+        }
+        hasParent = true;
+    }
+
+    if (level == item->level) return;
+
+    DEBUG_RECON("0x%llx moves from level %u to %u", (unsigned long long)handle, item->level,
+                level);
+
+    const bool raised = level > item->level;
+    item->level = level;
+
+    for (auto apiHandle : item->apiRefs) {
+        if (raised) unplaceApi(apiHandle);
+        placeApi(apiHandle, segmentFor(handle, level));
+    }
+
+    const std::vector<uint64_t> children(item->childHandles.begin(), item->childHandles.end());
+    for (auto childHandle : children) {
+        updateLevel(childHandle);
+    }
 }
 
 void VkReconstruction::dump() {
@@ -359,11 +414,17 @@ void VkReconstruction::removeHandles(const uint64_t* toRemove, uint32_t count) {
 
         if (!item) continue;
 
-        mHandleReconstructions.remove(toRemove[i]);
+        for (auto parentHandle : item->parentHandles) {
+            auto parent = mHandleReconstructions.get(parentHandle);
+            if (parent) parent->childHandles.erase(toRemove[i]);
+        }
+
+        const std::vector<uint64_t> children(item->childHandles.begin(),
+                                             item->childHandles.end());
 
-        removeHandles(item->childHandles.data(), item->childHandles.size());
+        mHandleReconstructions.remove(toRemove[i]);
 
-        item->childHandles.clear();
+        removeHandles(children.data(), children.size());
     }
 }
 
@@ -377,6 +438,7 @@ void VkReconstruction::forEachHandleAddApi(const uint64_t* toProcess, uint32_t c
         if (!item) continue;
 
         item->apiRefs.push_back(apiHandle);
+        placeApi(apiHandle, segmentFor(toProcess[i], item->level));
     }
 }
 
@@ -399,6 +461,7 @@ void VkReconstruction::forEachHandleDeleteApi(const uint64_t* toProcess, uint32_
         if (!modifyItem) continue;
 
         modifyItem->apiRefs.clear();
+        mModifySegment.dirty = true;
     }
 }
 
@@ -411,7 +474,12 @@ void VkReconstruction::addHandleDependency(const uint64_t* handles, uint32_t cou
     if (!item) return;
 
     for (uint32_t i = 0; i < count; ++i) {
-        item->childHandles.push_back(handles[i]);
+        auto child = mHandleReconstructions.get(handles[i]);
+
+        if (!child || !item->childHandles.insert(handles[i]).second) continue;
+
+        child->parentHandles.push_back(parentHandle);
+        updateLevel(handles[i]);
     }
 }
 
@@ -440,6 +508,12 @@ void VkReconstruction::forEachHandleAddModifyApi(const uint64_t* toProcess, uint
         if (!item) continue;
 
         item->apiRefs.push_back(apiHandle);
+        mModifySegment.dirty = true;
+
+        auto apiInfo = mApiTrace.get(apiHandle);
+        if (apiInfo && apiInfo->segment == kNoSegment) {
+            apiInfo->segment = kModifySegment;
+        }
     }
 }
 
@@ -13,6 +13,10 @@
 // limitations under the License.
 #pragma once
 
+#include <map>
+#include <unordered_set>
+#include <vector>
+
 #include "VulkanHandleMapping.h"
 #include "VulkanHandles.h"
 #include "aemu/base/containers/EntityManager.h"
@@ -26,6 +30,12 @@ namespace vk {
 
 // A class that captures all important data structures for
 // reconstructing a Vulkan system state via trimmed API record and replay.
+//
+// The APIs are replayed by level of the handle dependency graph, the handles each
+// API creates being created after the handles they depend on, then by handle type
+// within a level. The graph and that order are maintained as handles are added and
+// removed, and the serialized trace is kept per level and type, so that saving only
+// serializes again what changed since the previous save.
 class VkReconstruction {
    public:
     VkReconstruction();
@@ -41,6 +51,10 @@ class VkReconstruction {
         size_t traceBytes = 0;
         // Book-keeping for which handles were created by this API
         std::vector<uint64_t> createdHandles;
+        // The trace segment the API is replayed in, or kNoSegment.
+        uint64_t segment = 0;
+        // Orders the APIs within a segment by when they were recorded.
+        uint64_t sequence = 0;
     };
 
     using ApiTrace = android::base::EntityManager<32, 16, 16, ApiInfo>;
@@ -48,7 +62,10 @@ class VkReconstruction {
 
     struct HandleReconstruction {
         std::vector<ApiHandle> apiRefs;
-        std::vector<uint64_t> childHandles;
+        std::unordered_set<uint64_t> childHandles;
+        std::vector<uint64_t> parentHandles;
+        // Distance from the roots of the dependency graph, through the closest parent.
+        uint32_t level = 0;
     };
 
     using HandleReconstructions =
@@ -87,13 +104,39 @@ class VkReconstruction {
     void setModifiedHandlesForApi(uint64_t apiHandle, const uint64_t* modified, uint32_t count);
 
    private:
+    static constexpr uint64_t kNoSegment = ~0ull;
+    static constexpr uint64_t kModifySegment = kNoSegment - 1;
+
+    // The serialized APIs of a level and handle type, up to date unless |dirty|.
+    struct TraceSegment {
+        // By ApiInfo::sequence.
+        std::map<uint64_t, ApiHandle> apis;
+        bool dirty = true;
+        std::vector<uint64_t> createdHandles;
+        std::vector<uint8_t> trace;
+    };
+
+    static uint64_t segmentFor(uint64_t handle, uint32_t level);
+
+    void placeApi(ApiHandle apiHandle, uint64_t segment);
+    void unplaceApi(ApiHandle apiHandle);
+    void markSegmentDirty(uint64_t segment);
+    void updateLevel(uint64_t handle);
+    void serialize(TraceSegment* segment, const std::vector<uint64_t>& apis);
+
     std::vector<uint64_t> getOrderedUniqueModifyApis() const;
 
     ApiTrace mApiTrace;
+    uint64_t mNextApiSequence = 0;
 
     HandleReconstructions mHandleReconstructions;
     HandleModifications mHandleModifications;
 
+    // By level then handle type, which is the order they are replayed in.
+    std::map<uint64_t, TraceSegment> mSegments;
+    // The modify APIs, replayed after every other.
+    TraceSegment mModifySegment;
+
     std::vector<uint8_t> mLoadedTrace;
 };
 
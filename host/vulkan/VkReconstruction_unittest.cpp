@@ -0,0 +1,204 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "VkReconstruction.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "aemu/base/files/MemStream.h"
+
+namespace gfxstream {
+namespace vk {
+namespace {
+
+using HandleTypes = android::base::EntityManager<32, 16, 16, int>;
+
+// Handle types, in the order their handles are replayed within a level.
+enum : uint32_t {
+    kInstance = 1,
+    kDevice = 2,
+    kCommandBuffer = 3,
+    kCommandPool = 4,
+    kImage = 5,
+    kBuffer = 6,
+};
+
+uint64_t makeHandle(uint32_t index, uint32_t type) {
+    return HandleTypes::makeHandle(index, 1, type);
+}
+
+// Records an API creating |handles| the way VkDecoderSnapshot does, with the opcode as its trace.
+void recordCreate(VkReconstruction& reconstruction, uint32_t opCode,
+                  const std::vector<uint64_t>& handles, uint64_t parent = 0) {
+    reconstruction.addHandles(handles.data(), handles.size());
+    if (parent) {
+        reconstruction.addHandleDependency(handles.data(), handles.size(), parent);
+    }
+    auto apiHandle = reconstruction.createApiInfo();
+    auto apiInfo = reconstruction.getApiInfo(apiHandle);
+    reconstruction.setApiTrace(apiInfo, opCode, reinterpret_cast<const uint8_t*>(&opCode),
+                               sizeof(opCode));
+    reconstruction.forEachHandleAddApi(handles.data(), handles.size(), apiHandle);
+    reconstruction.setCreatedHandlesForApi(apiHandle, handles.data(), handles.size());
+}
+
+void recordModify(VkReconstruction& reconstruction, uint32_t opCode, uint64_t handle) {
+    auto apiHandle = reconstruction.createApiInfo();
+    auto apiInfo = reconstruction.getApiInfo(apiHandle);
+    reconstruction.setApiTrace(apiInfo, opCode, reinterpret_cast<const uint8_t*>(&opCode),
+                               sizeof(opCode));
+    reconstruction.forEachHandleAddModifyApi(&handle, 1, apiHandle);
+}
+
+struct Saved {
+    std::vector<uint64_t> createdHandles;
+    std::vector<uint32_t> opCodes;
+    std::vector<char> bytes;
+};
+
+Saved save(VkReconstruction& reconstruction) {
+    android::base::MemStream stream;
+    reconstruction.save(&stream);
+
+    Saved saved;
+    saved.bytes = stream.buffer();
+
+    saved.createdHandles.resize(stream.getBe32() / sizeof(uint64_t));
+    stream.read(saved.createdHandles.data(), saved.createdHandles.size() * sizeof(uint64_t));
+
+    std::vector<uint8_t> trace(stream.getBe32());
+    stream.read(trace.data(), trace.size());
+    for (size_t offset = 0; offset < trace.size();) {
+        uint32_t opCode;
+        uint32_t traceBytes;
+        memcpy(&opCode, trace.data() + offset, sizeof(opCode));
+        memcpy(&traceBytes, trace.data() + offset + 4, sizeof(traceBytes));
+        saved.opCodes.push_back(opCode);
+        offset += traceBytes;
+    }
+    return saved;
+}
+
+TEST(VkReconstructionTest, ReplaysByLevelThenType) {
+    VkReconstruction reconstruction;
+    const uint64_t instance = makeHandle(0, kInstance);
+    const uint64_t device = makeHandle(1, kDevice);
+    const uint64_t buffer = makeHandle(2, kBuffer);
+    const uint64_t image = makeHandle(3, kImage);
+    const uint64_t pool = makeHandle(4, kCommandPool);
+    const uint64_t commandBuffers[] = {makeHandle(5, kCommandBuffer),
+                                       makeHandle(6, kCommandBuffer)};
+
+    recordCreate(reconstruction, 10, {instance});
+    recordCreate(reconstruction, 11, {device}, instance);
+    recordCreate(reconstruction, 12, {buffer}, device);
+    recordCreate(reconstruction, 13, {image}, device);
+    recordCreate(reconstruction, 14, {pool}, device);
+    recordCreate(reconstruction, 15, {commandBuffers[0], commandBuffers[1]}, pool);
+    recordModify(reconstruction, 16, buffer);
+
+    Saved saved = save(reconstruction);
+    EXPECT_EQ((std::vector<uint32_t>{10, 11, 14, 13, 12, 15, 16}), saved.opCodes);
+    EXPECT_EQ((std::vector<uint64_t>{instance, device, pool, image, buffer, commandBuffers[0],
+                                     commandBuffers[1]}),
+              saved.createdHandles);
+}
+
+TEST(VkReconstructionTest, ReplaysWithTheClosestParent) {
+    VkReconstruction reconstruction;
+    const uint64_t instance = makeHandle(0, kInstance);
+    const uint64_t device = makeHandle(1, kDevice);
+    const uint64_t pool = makeHandle(2, kCommandPool);
+    const uint64_t commandBuffer = makeHandle(3, kCommandBuffer);
+
+    recordCreate(reconstruction, 10, {instance});
+    recordCreate(reconstruction, 11, {device}, instance);
+    recordCreate(reconstruction, 12, {pool}, device);
+    recordCreate(reconstruction, 13, {commandBuffer}, pool);
+    EXPECT_EQ((std::vector<uint32_t>{10, 11, 12, 13}), save(reconstruction).opCodes);
+
+    // A dependency on the device replays it with the pool, command buffers first.
+    reconstruction.addHandleDependency(&commandBuffer, 1, device);
+    EXPECT_EQ((std::vector<uint32_t>{10, 11, 13, 12}), save(reconstruction).opCodes);
+}
+
+TEST(VkReconstructionTest, RemovesDependentHandles) {
+    VkReconstruction reconstruction;
+    const uint64_t device = makeHandle(0, kDevice);
+    const uint64_t pool = makeHandle(1, kCommandPool);
+    const uint64_t commandBuffer = makeHandle(2, kCommandBuffer);
+    const uint64_t buffer = makeHandle(3, kBuffer);
+
+    recordCreate(reconstruction, 10, {device});
+    recordCreate(reconstruction, 11, {pool}, device);
+    recordCreate(reconstruction, 12, {commandBuffer}, pool);
+    recordCreate(reconstruction, 13, {buffer}, device);
+    recordModify(reconstruction, 14, buffer);
+
+    reconstruction.removeHandles(&pool, 1);
+    EXPECT_EQ((std::vector<uint32_t>{10, 13, 14}), save(reconstruction).opCodes);
+
+    reconstruction.removeHandles(&device, 1);
+    Saved saved = save(reconstruction);
+    EXPECT_TRUE(saved.opCodes.empty());
+    EXPECT_TRUE(saved.createdHandles.empty());
+}
+
+TEST(VkReconstructionTest, SavesChangesLikeFromScratch) {
+    const uint64_t device = makeHandle(0, kDevice);
+    std::vector<uint64_t> buffers;
+    std::vector<uint64_t> images;
+    for (uint32_t i = 0; i < 8; i++) {
+        buffers.push_back(makeHandle(100 + i, kBuffer));
+        images.push_back(makeHandle(200 + i, kImage));
+    }
+
+    VkReconstruction incremental;
+    recordCreate(incremental, 1, {device});
+    for (uint32_t i = 0; i < 4; i++) {
+        recordCreate(incremental, 100 + i, {buffers[i]}, device);
+        recordCreate(incremental, 200 + i, {images[i]}, device);
+    }
+    save(incremental);
+
+    // Destroys some, creates others and maps some, between saves.
+    incremental.removeHandles(&buffers[1], 1);
+    for (uint32_t i = 4; i < 8; i++) {
+        recordCreate(incremental, 100 + i, {buffers[i]}, device);
+    }
+    save(incremental);
+    incremental.removeHandles(&images[0], 1);
+    recordModify(incremental, 300, buffers[2]);
+    recordCreate(incremental, 204, {images[4]}, device);
+    const Saved saved = save(incremental);
+
+    VkReconstruction fromScratch;
+    recordCreate(fromScratch, 1, {device});
+    for (uint32_t i = 0; i < 8; i++) {
+        if (i != 1) recordCreate(fromScratch, 100 + i, {buffers[i]}, device);
+    }
+    for (uint32_t i = 1; i < 5; i++) {
+        recordCreate(fromScratch, 200 + i, {images[i]}, device);
+    }
+    recordModify(fromScratch, 300, buffers[2]);
+
+    EXPECT_EQ(save(fromScratch).bytes, saved.bytes);
+    EXPECT_EQ(saved.bytes, save(incremental).bytes);
+}
+
+}  // namespace
+}  // namespace vk
+}  // namespace gfxstream
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "aemu/base/HealthMonitor.h"
+#include "compressedTextureFormats/DecompressedTextureCache.h"
 #include "host-common/logging.h"
 #include "host/vulkan/vk_util.h"
 
@@ -168,15 +169,10 @@ void AstcTexture::on_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, uint8
     mSuccess = false;
     size_t decompSize = 0;  // How many bytes we need to hold the decompressed data
 
-    // Holds extra data about the region
-    struct RegionInfo {
-        uint32_t width;           // actual width (ie: mipmap width)
-        uint32_t height;          // actual height (ie: mipmap height)
-        uint32_t compressedSize;  // size of ASTC data for that region
-    };
-
-    std::vector<RegionInfo> regionInfos;
-    regionInfos.reserve(regionCount);
+    // The image to decompress for each region. The output pointers are set once the buffer holding
+    // the decompressed data is created.
+    std::vector<AstcCpuDecompressor::Image> images;
+    images.reserve(regionCount);
 
     // Make a copy of the regions and update the buffer offset of each to reflect the
     // correct location of the decompressed data
@@ -201,7 +197,13 @@ void AstcTexture::on_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, uint8
 
         decompRegion.bufferOffset = decompSize;
         decompSize += width * height * 4;
-        regionInfos.push_back({width, height, compressedSize});
+        images.push_back({
+            .width = width,
+            .height = height,
+            .astcData = srcAstcData + compressedDataOffset,
+            .astcDataLength = compressedSize,
+            .output = nullptr,
+        });
     }
 
     // Create a new VkBuffer to hold the decompressed data
@@ -211,17 +213,34 @@ void AstcTexture::on_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, uint8
         return;
     }
 
-    // Decompress each region
-    for (int i = 0; i < regionCount; i++) {
-        const auto& compRegion = pRegions[i];
-        const auto& decompRegion = decompRegions[i];
-        const auto& regionInfo = regionInfos[i];
+    for (uint32_t i = 0; i < regionCount; i++) {
+        images[i].output = decompData + decompRegions[i].bufferOffset;
+    }
 
-        int32_t status = mDecompressor->decompress(
-            regionInfo.width, regionInfo.height, mBlockWidth, mBlockHeight,
-            srcAstcData + compRegion.bufferOffset, regionInfo.compressedSize,
-            decompData + decompRegion.bufferOffset);
+    // Skip the images that were decompressed before, by this or any other texture.
+    DecompressedTextureCache& cache = DecompressedTextureCache::get();
+    std::vector<DecompressedTextureCache::Key> missedKeys;
+    if (cache.isEnabled()) {
+        const uint32_t format = DecompressedTextureCache::astcFormat(mBlockWidth, mBlockHeight);
+        std::vector<AstcCpuDecompressor::Image> missedImages;
+        for (const auto& image : images) {
+            const auto key =
+                DecompressedTextureCache::makeKey(format, image.width, image.height,
+                                                  image.astcData, image.astcDataLength,
+                                                  size_t(image.width) * image.height * 4);
+            if (!cache.lookup(key, image.astcData, image.output)) {
+                missedKeys.push_back(key);
+                missedImages.push_back(image);
+            }
+        }
+        images = std::move(missedImages);
+    }
 
+    // Decompress all the regions at once, so that the decompressor can spread the levels of the mip
+    // chain across its threads.
+    if (!images.empty()) {
+        int32_t status = mDecompressor->decompressImages(mBlockWidth, mBlockHeight, images.data(),
+                                                         images.size());
         if (status != 0) {
             WARN("ASTC CPU decompression failed: %s.", mDecompressor->getStatusString(status));
             mVk->vkUnmapMemory(mDevice, mDecompBufferMemory);
@@ -229,6 +248,10 @@ void AstcTexture::on_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, uint8
             return;
         }
     }
+    // This reads back the mapped memory, which may be uncached, but only for new textures.
+    for (size_t i = 0; i < missedKeys.size(); i++) {
+        cache.insert(missedKeys[i], images[i].astcData, images[i].output);
+    }
 
     mVk->vkUnmapMemory(mDevice, mDecompBufferMemory);
 
@@ -104,6 +104,120 @@ struct stream_renderer_resource_info {
 VG_EXPORT int stream_renderer_resource_get_info(int res_handle,
                                                 struct stream_renderer_resource_info* info);
 
+// Per-opcode statistics of the commands executed by the render threads, to tell which guest calls
+// take the most host time. Collecting them reads the clock twice per command, so it is off until
+// enabled with stream_renderer_set_decode_stats_enabled().
+#define STREAM_RENDERER_DECODE_STATS_NUM_BUCKETS 32
+
+struct stream_renderer_decode_stats_entry {
+    // The opcode of the command in the protocol of its API. Opcode 0 gathers the commands of
+    // threads that executed too many different opcodes to tell them apart.
+    uint32_t opcode;
+    uint32_t padding;
+    // How many times it was executed, and for how long in total.
+    uint64_t count;
+    uint64_t total_ns;
+    // latency_buckets[i] counts the executions that took [2^i, 2^(i+1)) nanoseconds. The last
+    // bucket also counts the longer ones.
+    uint64_t latency_buckets[STREAM_RENDERER_DECODE_STATS_NUM_BUCKETS];
+};
+
+// Starts or stops collecting statistics. Stopping keeps the ones collected so far.
+VG_EXPORT void stream_renderer_set_decode_stats_enabled(int enabled);
+
+// Forgets the statistics collected so far.
+VG_EXPORT void stream_renderer_reset_decode_stats(void);
+
+// Fills |entries| with the statistics of up to |*num_entries| opcodes, those that took the most
+// time first, and sets |*num_entries| to how many opcodes have statistics. |entries| can be null
+// to only get that number.
+VG_EXPORT int stream_renderer_get_decode_stats(struct stream_renderer_decode_stats_entry* entries,
+                                               uint32_t* num_entries);
+
+// Content-addressed cache of the textures the host decompresses on the CPU, the GLES ETC2, EAC,
+// RGTC and ASTC ones and the Vulkan ASTC ones, so that uploading a texture that was uploaded
+// before, from any context, skips decompressing it again. It is disabled until given a size.
+struct stream_renderer_decompressed_texture_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t num_entries;
+    // The memory used by the cache, and how much it may use.
+    uint64_t size_bytes;
+    uint64_t max_bytes;
+};
+
+// Sets how much memory the cache may use. 0 empties and disables it.
+VG_EXPORT void stream_renderer_set_decompressed_texture_cache_size(uint64_t max_bytes);
+
+// Gets the statistics of the cache. The hit rate is hits / (hits + misses).
+VG_EXPORT int stream_renderer_get_decompressed_texture_cache_stats(
+    struct stream_renderer_decompressed_texture_cache_stats* stats);
+
+// Progress of restoring the GLES textures of the last snapshot loaded. They are restored in the
+// background after loading, those backing the color buffers first, as the first frames show them.
+struct stream_renderer_texture_restore_stats {
+    uint64_t num_textures;
+    uint64_t num_restored;
+    uint64_t num_prioritized;
+    uint64_t num_prioritized_restored;
+    // How long restoring the prioritized textures, and all of them, took, or has taken so far.
+    uint64_t prioritized_restore_ms;
+    uint64_t restore_ms;
+    int in_progress;
+};
+
+VG_EXPORT int stream_renderer_get_texture_restore_stats(
+    struct stream_renderer_texture_restore_stats* stats);
+
+// Copies of color buffer contents from GLES to Vulkan, for color buffers whose GLES and Vulkan
+// backings don't share memory. Only the parts GLES wrote since the previous copy are copied, and
+// bytes_avoided counts what copying whole color buffers would have added. The counters only grow;
+// sample them each frame and take the differences.
+struct stream_renderer_color_buffer_sync_stats {
+    uint64_t num_syncs;
+    uint64_t bytes_copied;
+    uint64_t bytes_avoided;
+};
+
+VG_EXPORT int stream_renderer_get_color_buffer_sync_stats(
+    struct stream_renderer_color_buffer_sync_stats* stats);
+
+// How the render threads wait for the guest to send more commands. They spin for a while before
+// parking until the guest signals, which costs a wakeup. The counters only grow and cover all
+// render threads; sample them and take the differences.
+struct stream_renderer_ring_wait_stats {
+    // Reads that got their data while spinning, and after parking.
+    uint64_t spin_waits;
+    uint64_t parked_waits;
+    // How many times the render threads parked.
+    uint64_t parks;
+    // Time spent spinning before the data arrived or the thread parked.
+    uint64_t spin_time_us;
+    // Sleeps while the guest wasn't reading the replies.
+    uint64_t commit_backoffs;
+};
+
+VG_EXPORT int stream_renderer_get_ring_wait_stats(struct stream_renderer_ring_wait_stats* stats);
+
+// How long the render threads of each guest process waited for the Vulkan commands the process
+// sent over other threads before them to execute. The statistics of a process are kept until it
+// exits.
+struct stream_renderer_sequence_number_stats_entry {
+    // The unique id of the guest process.
+    uint64_t process_id;
+    // Commands that weren't next when they were decoded, and those of them that had to sleep.
+    uint64_t waits;
+    uint64_t parked_waits;
+    uint64_t total_wait_us;
+    uint64_t max_wait_us;
+};
+
+// Fills |entries| with the statistics of up to |*num_entries| processes, and sets |*num_entries|
+// to how many processes have statistics. |entries| can be null to only get that number.
+VG_EXPORT int stream_renderer_get_sequence_number_stats(
+    struct stream_renderer_sequence_number_stats_entry* entries, uint32_t* num_entries);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -165,6 +165,7 @@ def gen_functions_header(entries, prefix_name, verbatim, filename, with_args):
         "eglUseOsEglApi",
         "eglFillUsages",
         "eglSetMaxGLESVersion",
+        "eglFlushShaderCache",
     ]
 
     need_decls = []
@@ -14,4 +14,5 @@
  * limitations under the License.
  */
 
-// This file is reserved for upstreaming the GfxApiLogger implementation.
+// GfxApiLogger is implemented in its header, so that builds that only add
+// utils/include to the include paths can use it.
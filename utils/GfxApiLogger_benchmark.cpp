@@ -0,0 +1,62 @@
+// Copyright (C) 2023 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Recording a packet and the start of its execution, compared to only copying
+// the prefix of the packet that the logger keeps ("CopyPrefix").
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "utils/GfxApiLogger.h"
+
+namespace emugl {
+namespace {
+
+std::vector<unsigned char> makePacket(uint32_t opcode, uint32_t size) {
+    std::vector<unsigned char> packet(size, static_cast<unsigned char>(opcode));
+    memcpy(packet.data(), &opcode, sizeof(opcode));
+    memcpy(packet.data() + 4, &size, sizeof(size));
+    return packet;
+}
+
+void BM_CopyPrefix(benchmark::State& state) {
+    const std::vector<unsigned char> packet = makePacket(20000, state.range(0));
+    std::vector<unsigned char> sink(GfxApiLogger::kMaxPayloadSize + 8);
+    for (auto _ : state) {
+        const size_t size = std::min(packet.size(), sink.size());
+        memcpy(sink.data(), packet.data(), size);
+        benchmark::DoNotOptimize(sink.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CopyPrefix)->Arg(16)->Arg(64)->Arg(256)->Arg(4096);
+
+void BM_Record(benchmark::State& state) {
+    const std::vector<unsigned char> packet = makePacket(20000, state.range(0));
+    GfxApiLogger logger;
+    for (auto _ : state) {
+        logger.record(packet.data(), packet.size());
+        logger.recordCommandExecution();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Record)->Arg(16)->Arg(64)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace emugl
@@ -12,4 +12,127 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// This file is reserved for upstreaming the GfxApiLogger unit tests.
+#include <gtest/gtest.h>
+
+#include "utils/GfxApiLogger.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace emugl {
+namespace {
+
+// A packet of |size| bytes whose payload is derived from |opcode|.
+std::vector<unsigned char> makePacket(uint32_t opcode, uint32_t size) {
+    std::vector<unsigned char> packet(size);
+    memcpy(packet.data(), &opcode, sizeof(opcode));
+    memcpy(packet.data() + 4, &size, sizeof(size));
+    for (uint32_t i = 8; i < size; ++i) {
+        packet[i] = static_cast<unsigned char>(opcode * 31 + i);
+    }
+    return packet;
+}
+
+void expectPayload(const GfxApiLogger::Command& command) {
+    for (size_t i = 0; i < command.data.size(); ++i) {
+        ASSERT_EQ(static_cast<unsigned char>(command.opcode * 31 + i + 8), command.data[i])
+            << "opcode " << command.opcode << " at " << i;
+    }
+}
+
+TEST(GfxApiLoggerTest, RecordsCommands) {
+    GfxApiLogger logger;
+    EXPECT_TRUE(logger.getRecentCommands(10).empty());
+
+    const auto small = makePacket(20001, 28);
+    const auto large = makePacket(20002, 4096);
+    logger.record(small.data(), small.size());
+    logger.recordCommandExecution();
+    logger.record(large.data(), large.size());
+    // Only part of the packet is available.
+    logger.record(large.data(), 40);
+
+    const auto commands = logger.getRecentCommands(10);
+    ASSERT_EQ(4, commands.size());
+
+    EXPECT_EQ(20001, commands[0].opcode);
+    EXPECT_EQ(28, commands[0].originalSize);
+    EXPECT_EQ(20, commands[0].data.size());
+    expectPayload(commands[0]);
+
+    EXPECT_EQ(OP_gfxApiLoggerBeginCommandExecution, commands[1].opcode);
+    EXPECT_TRUE(commands[1].data.empty());
+
+    EXPECT_EQ(20002, commands[2].opcode);
+    EXPECT_EQ(4096, commands[2].originalSize);
+    EXPECT_EQ(GfxApiLogger::kMaxPayloadSize, commands[2].data.size());
+    expectPayload(commands[2]);
+
+    EXPECT_EQ(4096, commands[3].originalSize);
+    EXPECT_EQ(32, commands[3].data.size());
+
+    for (size_t i = 1; i < commands.size(); ++i) {
+        EXPECT_LE(commands[i - 1].timestampUs, commands[i].timestampUs);
+    }
+
+    const auto lastTwo = logger.getRecentCommands(2);
+    ASSERT_EQ(2, lastTwo.size());
+    EXPECT_EQ(20002, lastTwo[0].opcode);
+    EXPECT_EQ(32, lastTwo[1].data.size());
+}
+
+TEST(GfxApiLoggerTest, KeepsTheMostRecentCommands) {
+    GfxApiLogger logger;
+    // Several times the size of the ring, with sizes that don't divide it.
+    constexpr uint32_t kNumPackets = 20000;
+    for (uint32_t i = 0; i < kNumPackets; ++i) {
+        const auto packet = makePacket(i, 8 + (i * 7) % 200);
+        logger.record(packet.data(), packet.size());
+    }
+
+    const auto commands = logger.getRecentCommands(kNumPackets);
+    ASSERT_GT(commands.size(), GfxApiLogger::kDataSize / (24 + GfxApiLogger::kMaxPayloadSize));
+    ASSERT_LT(commands.size(), kNumPackets);
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const uint32_t opcode = kNumPackets - commands.size() + i;
+        ASSERT_EQ(opcode, commands[i].opcode);
+        ASSERT_EQ(8 + (opcode * 7) % 200, commands[i].originalSize);
+        expectPayload(commands[i]);
+    }
+
+    const std::string dump = logger.dumpRecentCommands(1);
+    EXPECT_EQ(0, dump.rfind(std::to_string(kNumPackets - 1) + ":", 0)) << dump;
+}
+
+TEST(GfxApiLoggerTest, ReadWhileRecording) {
+    GfxApiLogger logger;
+    std::atomic<bool> done{false};
+    std::thread recorder([&logger, &done] {
+        for (uint32_t i = 0; i < 500000; ++i) {
+            const auto newPacket = makePacket(i, 8 + i % (GfxApiLogger::kMaxPayloadSize + 1));
+            logger.record(newPacket.data(), newPacket.size());
+        }
+        done = true;
+    });
+
+    // Whatever the reader gets must be whole commands, in order.
+    size_t numReads = 0;
+    while (!done || numReads == 0) {
+        const auto commands = logger.getRecentCommands(64);
+        for (size_t i = 0; i < commands.size(); ++i) {
+            ASSERT_EQ(8 + commands[i].opcode % (GfxApiLogger::kMaxPayloadSize + 1),
+                      commands[i].originalSize);
+            ASSERT_EQ(commands[i].originalSize - 8, commands[i].data.size());
+            expectPayload(commands[i]);
+            if (i > 0) {
+                ASSERT_EQ(commands[i - 1].opcode + 1, commands[i].opcode);
+            }
+        }
+        ++numReads;
+    }
+    recorder.join();
+}
+
+}  // namespace
+}  // namespace emugl
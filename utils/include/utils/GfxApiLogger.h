@@ -16,14 +16,242 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aemu/base/threads/Thread.h"
+
 #define OP_gfxApiLoggerBeginCommandExecution 90000
 
 namespace emugl {
-// TODO(kaiyili): complete the implementation in
-// https://r.android.com/c/device/generic/vulkan-cereal/+/2165168.
+
+// A flight recorder of the packets a render thread decodes.
+//
+// Each render thread owns one, and records the opcode, size and the first
+// bytes of the payload of every packet into a fixed-size ring, overwriting the
+// oldest ones. Recording only copies a few dozen bytes: there are no locks nor
+// allocations, so it stays on in production builds.
+//
+// The ring can be read back from another thread, for instance to annotate a
+// hang report, with getRecentCommands(). It is also laid out so that it can be
+// recovered from a crash dump: scripts/print_gfx_logs finds it by looking for
+// the signature of its header. Keep the layout in sync with that script.
 class GfxApiLogger {
    public:
-    void record(const unsigned char* buf, size_t len) {}
-    void recordCommandExecution() {};
+    // Size of the ring of records.
+    static constexpr uint32_t kDataSize = 128 * 1024;
+    // Payload bytes kept from each packet, after the opcode and size.
+    static constexpr uint32_t kMaxPayloadSize = 128;
+
+    struct Command {
+        // Unix time when the command was recorded, in microseconds.
+        uint64_t timestampUs;
+        uint32_t opcode;
+        // Size of the packet, including its opcode and size.
+        uint32_t originalSize;
+        // The first bytes of the payload.
+        std::vector<uint8_t> data;
+    };
+
+    GfxApiLogger() : mStorage(new uint8_t[sizeof(Header) + kDataSize]()) {
+        Header* header = getHeader();
+        memcpy(header->signature, kSignature, sizeof(kSignature));
+        header->version = kVersion;
+        header->threadId = static_cast<uint32_t>(android::base::getCurrentThreadId());
+        header->captureId = sNextCaptureId.fetch_add(1, std::memory_order_relaxed);
+        header->dataSize = kDataSize;
+    }
+    GfxApiLogger(const GfxApiLogger&) = delete;
+    GfxApiLogger& operator=(const GfxApiLogger&) = delete;
+
+    // Records the packet at |buf|, which starts with its opcode and size.
+    // |len| is how many bytes of it are available.
+    void record(const unsigned char* buf, size_t len) {
+        if (len < 8) {
+            return;
+        }
+        uint32_t opcode;
+        uint32_t packetLen;
+        memcpy(&opcode, buf, sizeof(opcode));
+        memcpy(&packetLen, buf + 4, sizeof(packetLen));
+        const size_t payloadSize =
+            std::min({len - 8, size_t(std::max(packetLen, 8u) - 8), size_t(kMaxPayloadSize)});
+        write(opcode, packetLen, buf + 8, static_cast<uint32_t>(payloadSize));
+    }
+
+    // Marks that the last recorded packet started executing, as opposed to
+    // waiting for its turn.
+    void recordCommandExecution() { write(OP_gfxApiLoggerBeginCommandExecution, 8, nullptr, 0); }
+
+    // Returns up to |maxCommands| of the most recent commands, oldest first.
+    // Can be called from any thread; commands that get overwritten while they
+    // are being read are left out.
+    std::vector<Command> getRecentCommands(size_t maxCommands) const {
+        std::vector<uint8_t> data(kDataSize);
+        const uint64_t end = mCommitted.load(std::memory_order_acquire);
+        memcpy(data.data(), getData(), kDataSize);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t reserved = mReserved.load(std::memory_order_relaxed);
+        // Anything before this could have been overwritten during the copy.
+        const uint64_t begin = reserved > kDataSize ? reserved - kDataSize : 0;
+
+        auto readAt = [&data](uint64_t position, void* dst, size_t size) {
+            const size_t offset = position % kDataSize;
+            const size_t firstPart = std::min(size, size_t(kDataSize - offset));
+            memcpy(dst, data.data() + offset, firstPart);
+            memcpy(static_cast<uint8_t*>(dst) + firstPart, data.data(), size - firstPart);
+        };
+
+        std::vector<Command> commands;
+        uint64_t position = end;
+        while (commands.size() < maxCommands && position >= begin + sizeof(uint32_t)) {
+            uint32_t recordSize;
+            readAt(position - sizeof(uint32_t), &recordSize, sizeof(recordSize));
+            if (recordSize < kRecordHeaderSize ||
+                position - sizeof(uint32_t) < begin + recordSize) {
+                break;
+            }
+            position -= sizeof(uint32_t) + recordSize;
+
+            RecordHeader recordHeader;
+            readAt(position, &recordHeader, sizeof(recordHeader));
+            Command command = {
+                .timestampUs = recordHeader.timestampUs,
+                .opcode = recordHeader.opcode,
+                .originalSize = recordHeader.originalSize,
+                .data = std::vector<uint8_t>(recordSize - kRecordHeaderSize),
+            };
+            readAt(position + kRecordHeaderSize, command.data.data(), command.data.size());
+            commands.push_back(std::move(command));
+        }
+        std::reverse(commands.begin(), commands.end());
+        return commands;
+    }
+
+    // One line per command for hang reports: the opcode, the packet size and
+    // how long before |nowUs| the command was recorded.
+    std::string dumpRecentCommands(size_t maxCommands, uint64_t nowUs = getUnixTimeUs()) const {
+        std::string dump;
+        char line[64];
+        for (const Command& command : getRecentCommands(maxCommands)) {
+            const uint64_t ageUs = nowUs > command.timestampUs ? nowUs - command.timestampUs : 0;
+            snprintf(line, sizeof(line), "%u:%u:-%" PRIu64 "us\n", command.opcode,
+                     command.originalSize, ageUs);
+            dump += line;
+        }
+        return dump;
+    }
+
+   private:
+    // Must match the Header of scripts/print_gfx_logs/print_gfx_logs.py.
+    struct Header {
+        char signature[10];
+        uint16_t version;
+        uint32_t threadId;
+        // Unix time of the last record, in microseconds.
+        uint64_t lastWrittenTime;
+        // Where the record being written starts, and where the last complete
+        // one ends.
+        uint32_t writeIndex;
+        uint32_t committedIndex;
+        uint64_t captureId;
+        uint32_t dataSize;
+    };
+    static_assert(offsetof(Header, lastWrittenTime) == 16 && offsetof(Header, captureId) == 32 &&
+                      sizeof(Header) == 48,
+                  "Header must match the layout print_gfx_logs expects");
+
+    // Each record is a RecordHeader followed by the payload and by the size of
+    // both, so that the ring can be read backwards from its end.
+    struct RecordHeader {
+        uint64_t timestampUs;
+        uint32_t opcode;
+        uint32_t originalSize;
+    };
+    static constexpr uint32_t kRecordHeaderSize = sizeof(RecordHeader);
+    static_assert(kRecordHeaderSize == 16);
+
+    static constexpr char kSignature[10] = "GFXAPILOG";
+    static constexpr uint16_t kVersion = 3;
+
+    // The timestamps are only there to tell how long ago a command was
+    // recorded, so a coarse clock will do, and it is several times cheaper
+    // than a precise one.
+    static uint64_t getUnixTimeUs() {
+#if defined(__linux__)
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        return uint64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    Header* getHeader() { return reinterpret_cast<Header*>(mStorage.get()); }
+    uint8_t* getData() { return mStorage.get() + sizeof(Header); }
+    const uint8_t* getData() const { return mStorage.get() + sizeof(Header); }
+
+    void writeAt(uint64_t position, const uint8_t* src, size_t size) {
+        const size_t offset = position % kDataSize;
+        const size_t firstPart = std::min(size, size_t(kDataSize - offset));
+        memcpy(getData() + offset, src, firstPart);
+        if (firstPart < size) {
+            memcpy(getData(), src + firstPart, size - firstPart);
+        }
+    }
+
+    // Only called from the thread that owns this logger. Readers on other
+    // threads check |mReserved| after copying the ring to know which records
+    // they may have read while they were being overwritten.
+    void write(uint32_t opcode, uint32_t originalSize, const uint8_t* payload,
+               uint32_t payloadSize) {
+        const RecordHeader recordHeader = {
+            .timestampUs = getUnixTimeUs(),
+            .opcode = opcode,
+            .originalSize = originalSize,
+        };
+        const uint32_t recordSize = kRecordHeaderSize + payloadSize;
+
+        const uint64_t begin = mCommitted.load(std::memory_order_relaxed);
+        const uint64_t end = begin + recordSize + sizeof(uint32_t);
+        mReserved.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Header* header = getHeader();
+        header->writeIndex = begin % kDataSize;
+        writeAt(begin, reinterpret_cast<const uint8_t*>(&recordHeader), sizeof(recordHeader));
+        if (payloadSize > 0) {
+            writeAt(begin + kRecordHeaderSize, payload, payloadSize);
+        }
+        writeAt(begin + recordSize, reinterpret_cast<const uint8_t*>(&recordSize),
+                sizeof(recordSize));
+        header->committedIndex = end % kDataSize;
+        header->lastWrittenTime = recordHeader.timestampUs;
+
+        mCommitted.store(end, std::memory_order_release);
+    }
+
+    static inline std::atomic<uint64_t> sNextCaptureId{1};
+
+    // The Header, immediately followed by the ring.
+    std::unique_ptr<uint8_t[]> mStorage;
+    // Bytes written since the creation of the logger, when the last record
+    // was completed and including the one being written.
+    std::atomic<uint64_t> mCommitted{0};
+    std::atomic<uint64_t> mReserved{0};
 };
-}  // namespace emugl
\ No newline at end of file
+
+}  // namespace emugl